@@ -1,26 +1,54 @@
 # Add commands for the tests
-add_executable(dyn_array_test_exe ${CMAKE_CURRENT_LIST_DIR}/tests/dyn_array_test.cpp)
+# Tests of app code list the sources they need after SOURCES, relative to src/, and what those link after LIBRARIES.
+function(proto_add_unit_test name)
+	cmake_parse_arguments(PARSE_ARGV 1 TEST "" "" "SOURCES;LIBRARIES")
+	list(TRANSFORM TEST_SOURCES PREPEND ${CMAKE_CURRENT_LIST_DIR}/src/)
 
-if(clang_tidy_FOUND)
-	set_property(TARGET dyn_array_test_exe PROPERTY CXX_CLANG_TIDY ${clang_tidy_FOUND})
-endif()
+	add_executable(${name}_exe ${CMAKE_CURRENT_LIST_DIR}/tests/${name}.cpp ${TEST_SOURCES})
 
-# Build options and libraries
+	if(clang_tidy_FOUND)
+		set_property(TARGET ${name}_exe PROPERTY CXX_CLANG_TIDY ${clang_tidy_FOUND})
+	endif()
 
-target_include_directories(dyn_array_test_exe PUBLIC ${CMAKE_CURRENT_LIST_DIR}/include/stl ${catch2_SOURCE_DIR})
-target_compile_options(dyn_array_test_exe PRIVATE ${CompilerFlags})
-target_link_options(dyn_array_test_exe PRIVATE ${LinkerFlags})
-target_link_libraries(
-	dyn_array_test_exe
+	# Build options and libraries
 
-	PUBLIC 
+	target_include_directories(${name}_exe PUBLIC ${CMAKE_CURRENT_LIST_DIR}/include/stl ${CMAKE_CURRENT_LIST_DIR}/include ${catch2_SOURCE_DIR})
+	target_compile_options(${name}_exe PRIVATE ${CompilerFlags})
+	target_link_options(${name}_exe PRIVATE ${LinkerFlags})
+	target_link_libraries(
+		${name}_exe
 
-	Catch2::Catch2WithMain
-	gsl::gsl-lite
-	gsl::gsl-lite-v0
-	gsl::gsl-lite-v1
-)
+		PUBLIC
 
-# Create tests
+		Catch2::Catch2WithMain
+		gsl::gsl-lite
+		gsl::gsl-lite-v0
+		gsl::gsl-lite-v1
+		${TEST_LIBRARIES}
+	)
 
-add_test(NAME dyn_array_test COMMAND dyn_array_test_exe)
\ No newline at end of file
+	# Create tests
+
+	add_test(NAME ${name} COMMAND ${name}_exe)
+endfunction()
+
+proto_add_unit_test(dyn_array_test)
+proto_add_unit_test(sparse_set_test)
+proto_add_unit_test(registry_test)
+proto_add_unit_test(flat_hash_map_test)
+proto_add_unit_test(parallel_test)
+proto_add_unit_test(bit_grid_test)
+proto_add_unit_test(segmented_array_test)
+proto_add_unit_test(rect_packer_test)
+proto_add_unit_test(pixel_convert_test)
+proto_add_unit_test(mipmap_test)
+proto_add_unit_test(base64_test)
+proto_add_unit_test(cell_delta_test)
+proto_add_unit_test(spatial_grid_test)
+proto_add_unit_test(region_labels_test)
+proto_add_unit_test(autotile_test)
+proto_add_unit_test(procgen_test)
+proto_add_unit_test(wfc_test)
+proto_add_unit_test(tmx_test SOURCES TmxExport.cpp TmxImport.cpp TileMap.cpp MappedFile.cpp LIBRARIES glm::glm tinyxml2::tinyxml2 ZLIB::ZLIB)
+proto_add_unit_test(pmap_test SOURCES Pmap.cpp TileMap.cpp MappedFile.cpp LIBRARIES glm::glm ZLIB::ZLIB)
+proto_add_unit_test(journal_test SOURCES Journal.cpp TileMap.cpp LIBRARIES ZLIB::ZLIB)
@@ -0,0 +1,112 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef PROTO_AUTO_TILER_HPP
+#define PROTO_AUTO_TILER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <sol/forward.hpp>
+
+#include <TileMap.hpp>
+#include <stl/autotile.hpp>
+
+namespace proto
+{
+	class Scene;
+
+	/*
+		Picks edge and corner tiles for painted terrain.
+
+		A terrain is a table of 256 tiles, one per combination of its eight neighbours being the same terrain or not,
+		compiled from rules when it is loaded. A tile belongs to the terrain whose table holds it. Painting sets the
+		cells and then re-tiles only the cells around them, each with eight lookups into the layer and one into the
+		table. Cells off the map count as the same terrain, so terrain that runs off an edge has no border there.
+
+		Terrains come from .ini and .lua files. In an INI file each section is a terrain:
+
+			[grass]
+			; Or edges4. The standard layout starts at tile 'first'.
+			mode = blob47
+			first = 33
+
+		or, instead of 'first', rules that are tried in order, each a pattern and a tile:
+
+			rule = *1* 1.1 *0*, 40
+			rule = *** *.* ***, 41
+
+		Patterns are rows of neighbours, north-west first: 1 for the same terrain, 0 for anything else, * for either.
+		'fallback' is the tile for masks no rule matches, the last rule's tile by default. A Lua file returns a table
+		of terrains by name with the same fields, and its rules as { pattern, tile } pairs.
+	*/
+	class AutoTiler
+	{
+	public:
+		static constexpr size_t NoTerrain = ~size_t{0u};
+
+		struct Terrain
+		{
+			std::string name;
+			autotile_lut lut;
+		};
+
+		// Loads every .ini and .lua file in 'dir' and returns how many terrains they held.
+		size_t LoadDirectory(const std::filesystem::path& dir, sol::state_view& lua);
+		[[nodiscard]] bool LoadIni(const std::filesystem::path& file);
+		[[nodiscard]] bool LoadLua(const std::filesystem::path& file, sol::state_view& lua);
+
+		// Replaces any terrain of the same name, and returns its index.
+		size_t AddTerrain(std::string name, const autotile_lut& lut);
+		[[nodiscard]] std::optional<size_t> FindTerrain(std::string_view name) const;
+		[[nodiscard]] std::span<const Terrain> Terrains() const { return _terrains; }
+
+		[[nodiscard]] size_t TerrainOf(TileId tile) const { return tile < _terrainOf.size() ? _terrainOf[tile] : NoTerrain; }
+
+		/*
+			These return how many cells they changed. Writes are part of the journal's open edit if there is one,
+			otherwise dabs painted in quick succession undo as one stroke. Nothing changes while the scene's generator
+			is busy.
+		*/
+
+		// Paints 'terrain' on 'cells', or clears the terrain tiles among them with NoTerrain, and re-tiles around them.
+		size_t Paint(Scene& scene, size_t layer, size_t terrain, std::span<const glm::uvec2> cells);
+
+		// Re-tiles the cells next to and under 'dirty', after they were changed some other way.
+		size_t Retile(Scene& scene, size_t layer, std::span<const glm::uvec2> dirty);
+
+		void Clear();
+
+	private:
+		// Changes to the cells in 'counted', sorted keys as in _cells, are not counted again.
+		size_t RetileCells(Scene& scene, size_t layer, std::span<const glm::uvec2> dirty, std::span<const uint64_t> counted = {});
+
+		std::vector<Terrain> _terrains;
+		std::vector<size_t> _terrainOf; // By tile id.
+		std::vector<uint64_t> _cells;
+		std::vector<uint64_t> _painted;
+	};
+}
+
+#endif
@@ -0,0 +1,97 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef PROTO_AUTOSAVE_HPP
+#define PROTO_AUTOSAVE_HPP
+
+#include <chrono>
+#include <filesystem>
+#include <future>
+#include <vector>
+
+#include <Pmap.hpp>
+#include <Scene.hpp>
+#include <Stopwatch.hpp>
+#include <TileMap.hpp>
+
+namespace proto
+{
+	/*
+		Saves the scene to a .pmap file in the background while it is being edited.
+
+		Update() runs on the editing thread once a frame. When a save is due it takes a snapshot: a copy of the map,
+		which shares every chunk with the scene, and a copy of the map objects. Nothing is saved if the snapshot
+		equals the last one. Otherwise the snapshot goes to the thread pool, where the PmapFile compresses and writes
+		the chunks that changed since the last save. Edits made meanwhile clone the chunks they touch, so the editor
+		never waits on the disk. Only one save runs at a time, a save that comes due meanwhile waits for it.
+	*/
+	class Autosave
+	{
+	public:
+		static constexpr auto DefaultInterval = std::chrono::seconds{ 60 };
+
+		struct Stats
+		{
+			std::chrono::microseconds snapshot{}; // On the editing thread, the only cost an edit ever sees.
+			PmapFile::Stats write;
+			double throughput = 0.0; // MiB/s written, over the whole background save.
+		};
+
+		Autosave(std::filesystem::path file, std::chrono::seconds interval = DefaultInterval, PmapFile::Compression compression = PmapFile::Compression::Zlib);
+		Autosave(const Autosave&) = delete;
+		Autosave(Autosave&&) = delete;
+		Autosave& operator=(const Autosave&) = delete;
+		Autosave& operator=(Autosave&&) = delete;
+		~Autosave();
+
+		/*
+			Loads the last autosave into the scene, if there is one that reads back intact. The file then holds the
+			scene's chunks, so the next save only appends what was edited since.
+		*/
+		bool Restore(Scene& scene);
+
+		// Collects a finished save, and starts the next one once the interval has passed.
+		void Update(Scene& scene);
+
+		// Starts a save now, unless one is running or nothing changed since the last one.
+		bool Save(Scene& scene);
+
+		// Blocks until the save in flight, if any, is on disk.
+		void Finish();
+
+		[[nodiscard]] bool Busy() const { return _pending.valid(); }
+		[[nodiscard]] const Stats& LastSave() const { return _lastSave; }
+		[[nodiscard]] const std::filesystem::path& File() const { return _file; }
+
+	private:
+		void Collect();
+
+		std::filesystem::path _file;
+		std::chrono::seconds _interval;
+		Stopwatch _sinceSave;
+
+		// Owned by the save in flight while _pending is valid, the editing thread only touches them in between.
+		PmapFile _pmap;
+		TileMap _savedMap;
+		std::vector<MapObject> _savedObjects;
+		std::future<bool> _pending;
+
+		Stats _lastSave, _current;
+	};
+}
+
+#endif
@@ -0,0 +1,77 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef PROTO_COMPONENTS_HPP
+#define PROTO_COMPONENTS_HPP
+
+#include <cstdint>
+#include <string>
+
+#include <glm/glm.hpp>
+
+namespace proto
+{
+	/*
+		Plain data components for the objects placed on a map. Keep these small, they are stored in
+		contiguous columns and copied around when entities are removed.
+	*/
+
+	struct Transform
+	{
+		glm::vec2 pos{};
+		float rotation = 0.f;
+
+		bool operator==(const Transform&) const = default;
+	};
+
+	// A named point of interest, used for notes and waypoints.
+	struct Marker
+	{
+		std::string label;
+
+		bool operator==(const Marker&) const = default;
+	};
+
+	struct SpawnPoint
+	{
+		uint32_t group = 0u;
+		uint32_t capacity = 1u;
+
+		bool operator==(const SpawnPoint&) const = default;
+	};
+
+	// An NPC that walks towards its current goal.
+	struct Agent
+	{
+		glm::vec2 velocity{};
+		glm::vec2 goal{};
+		float speed = 1.f;
+
+		bool operator==(const Agent&) const = default;
+	};
+
+	// An axis aligned region, centered on the entity's Transform.
+	struct Trigger
+	{
+		glm::vec2 halfExtent{};
+		uint32_t id = 0u;
+
+		bool operator==(const Trigger&) const = default;
+	};
+}
+
+#endif
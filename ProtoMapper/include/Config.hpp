@@ -8,7 +8,9 @@ namespace proto
     [[nodiscard]] constexpr std::string GetTextDir() { return TEXT_DIR; }
     [[nodiscard]] constexpr std::string GetProfileDir() { return PROFILE_DIR; }
     [[nodiscard]] constexpr std::string GetUIDir() { return UI_DIR; }
+    [[nodiscard]] constexpr std::string GetAutotileDir() { return AUTOTILE_DIR; }
     [[nodiscard]] constexpr std::string GetAssetDir() { return ASSETS_DIR; }
+    [[nodiscard]] constexpr std::string GetCacheDir() { return CACHE_DIR; }
 }
 
 #endif // !PROTOMAPPER_CONFIG_HPP
@@ -19,12 +19,16 @@
 #define PROTO_FONT_HPP
 
 #include <filesystem>
-#include <unordered_map> 
+#include <memory>
+#include <vector>
+
+#include <stl/flat_hash_map.hpp>
 
 extern "C"
 {
     struct nk_font;
     struct nk_font_atlas;
+    struct nk_user_font;
 }
 
 namespace proto
@@ -42,6 +46,12 @@ namespace proto
         ItalicUnderlined = Italic | Underlined,
     };
 
+    enum class FontRender : uint8_t
+    {
+        Coverage,       // Sharpest at the baked size.
+        DistanceField,  // Scales to any height without a re-bake. Draw it with Renderer::GetDistanceFieldShader().
+    };
+
     class FontAtlas 
     {
     public:
@@ -58,20 +68,67 @@ namespace proto
         std::shared_ptr<struct nk_font_atlas> _atlas;
     };
         
+    /*
+        Each style is baked into its own single-channel atlas. Baked atlases and their glyph tables are cached on
+        disk, keyed by a hash of the font file, the pixel size, the glyph ranges and the render mode, and later runs
+        map the cache file straight into memory instead of rasterising again.
+
+        A style can have both a coverage font, used by the UI at its baked size, and a distance field font, used
+        when text has to scale (e.g. map labels under zoom).
+
+        Fonts are loaded lazily: AddFont only records where a style comes from, and the style is loaded the first
+        time something asks for it. Every style has its own atlas, so loading one never re-bakes the others.
+    */
     class FontGroup
     {
     public:
-        void Create();
-        void Finalize(unsigned int id);
-        void AddFont(FontStyle styleMask, float size, const std::filesystem::path& filename);
+        FontGroup();
+        FontGroup(const FontGroup&) = delete;
+        FontGroup(FontGroup&&) = delete;
+        FontGroup& operator=(const FontGroup&) = delete;
+        FontGroup& operator=(FontGroup&&) = delete;
+        ~FontGroup();
+
+        // Where baked atlases are cached. An empty path disables the cache.
+        void SetCacheDir(const std::filesystem::path& dir) { _cacheDir = dir; }
 
+        // Registers a style, replacing any earlier font for it. Nothing is read from disk until the style is first used.
+        void AddFont(FontStyle styleMask, float size, const std::filesystem::path& filename, FontRender render = FontRender::Coverage);
+
+        /*
+            The coverage font for a style, or the distance field one if that is all there is. The first call for a
+            style loads or bakes it and uploads its atlas, so this must be called on the thread that owns the GL
+            context.
+        */
         [[nodiscard]] nk_font* GetFont(FontStyle mask);
-        [[nodiscard]] const nk_font* GetFont(FontStyle mask) const;
-        [[nodiscard]] auto* GetAtlas(this auto&& self) { return self._atlas.Get(); }
+
+        /*
+            A handle that draws the style at 'height' pixels, preferring the distance field font. Handles are
+            created on first use and stay valid for the lifetime of the FontGroup.
+        */
+        [[nodiscard]] const nk_user_font* GetFontAtHeight(FontStyle mask, float height);
+
+        // True if the texture belongs to a distance field font and needs the distance field shader.
+        [[nodiscard]] bool IsDistanceField(uint32_t textureId) const;
 
     private:
-        FontAtlas _atlas;
-        std::unordered_map<FontStyle, struct nk_font*> _fonts;
+        struct LoadedFont;
+
+        struct FontDescriptor
+        {
+            std::filesystem::path filename;
+            float size = 0.0f;
+            bool failed = false;
+        };
+
+        // Loads a registered style on first use. Returns nullptr if it was never registered or could not be loaded.
+        [[nodiscard]] LoadedFont* Find(FontStyle mask, FontRender render);
+        [[nodiscard]] std::unique_ptr<LoadedFont> Load(const FontDescriptor& descriptor, FontRender render) const;
+
+        std::filesystem::path _cacheDir;
+        std::vector<std::unique_ptr<LoadedFont>> _loaded;
+        flat_hash_map<FontStyle, LoadedFont*> _fonts, _distanceFields;
+        flat_hash_map<FontStyle, FontDescriptor> _fontFiles, _distanceFieldFiles;
     };
 }
 
@@ -0,0 +1,169 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef PROTO_GENERATOR_HPP
+#define PROTO_GENERATOR_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <variant>
+#include <vector>
+
+#include <sol/forward.hpp>
+
+#include <Stopwatch.hpp>
+#include <TileMap.hpp>
+#include <stl/procgen.hpp>
+#include <stl/wfc.hpp>
+
+namespace proto
+{
+	class Scene;
+
+	/*
+		Fills a tile layer procedurally in the background: fractal noise cut into bands of tiles, cellular-automaton
+		caves, BSP dungeons or Wave Function Collapse.
+
+		The layer is split into its chunks and the chunks are generated on the thread pool. All randomness is hashed
+		from the seed and what is being decided, so a seed gives the same layer bit for bit whatever the number of
+		threads. Finished chunks wait in a queue that Update() hands to the map a few at a time, so the layer fills
+		in on screen while the rest is still being worked on. WFC is solved as a whole first, and only its output
+		is streamed.
+
+		A generation is one undo step. Its journal edit stays open until the last chunk is in, and until then the
+		fill and paint tools and Scene::Undo() change nothing.
+	*/
+	class Generator
+	{
+	public:
+		// Chunks handed to the map per Update().
+		static constexpr size_t ChunksPerUpdate = 64uz;
+
+		// Cells whose noise is below 'below' get 'tile', the first band that fits wins.
+		struct NoiseBand
+		{
+			float below = 1.f;
+			TileId tile = EmptyTile;
+		};
+
+		struct NoiseSettings
+		{
+			noise_settings noise;
+			std::vector<NoiseBand> bands;
+		};
+
+		struct CaveSettings
+		{
+			float wallChance = 0.45f;
+			uint32_t steps = 5u;
+			uint32_t birth = 5u, survive = 4u;
+			TileId floor = EmptyTile, wall = 1u;
+		};
+
+		struct DungeonSettings
+		{
+			dungeon_settings layout;
+			TileId floor = 1u, wall = EmptyTile;
+		};
+
+		/*
+			Tiles and the rules for placing them are learned from 'sampleLayer': every pair of neighbours painted
+			there may be neighbours in the output, and tiles turn up about as often as they do in the sample.
+		*/
+		struct WfcSettings
+		{
+			size_t sampleLayer = 0uz;
+			uint32_t backtracks = 1000u, attempts = 8u;
+			bool keepPainted = false; // Cells that already hold a sampled tile stay as they are.
+		};
+
+		using Settings = std::variant<NoiseSettings, CaveSettings, DungeonSettings, WfcSettings>;
+
+		// WFC keeps a support counter per cell, direction and tile, layers that would need more refuse to start.
+		static constexpr size_t MaxWfcBytes = 512uz << 20uz;
+
+		Generator() = default;
+		Generator(const Generator&) = delete;
+		Generator(Generator&&) = delete;
+		Generator& operator=(const Generator&) = delete;
+		Generator& operator=(Generator&&) = delete;
+		~Generator();
+
+		// Starts replacing every cell of layer 'layer'. Throws if a generation or another edit is already open.
+		void Start(Scene& scene, size_t layer, uint64_t seed, Settings settings);
+
+		// Hands finished chunks to the map. Call it every frame, it does nothing while idle.
+		void Update(Scene& scene);
+
+		// Stops early. The chunks already on the map stay and undo as one step.
+		void Cancel(Scene& scene);
+
+		// Stops without touching the map or the journal, for when both are about to be replaced.
+		void Stop();
+
+		[[nodiscard]] bool Busy() const { return _busy; }
+
+		// Fraction of the layer's chunks on the map.
+		[[nodiscard]] float Progress() const { return _total != 0uz ? static_cast<float>(_adopted) / static_cast<float>(_total) : 0.f; }
+
+		// Counts and timings of the last WFC run to finish.
+		[[nodiscard]] const wfc_stats& GetWfcStats() const { return _wfcStats; }
+
+		/*
+			Adds a Generate table to 'lua' that starts generators on 'scene', with layers given by name:
+
+				Generate.Noise("ground", seed, { scale = 64, octaves = 4, bands = { { 0.4, 1 }, { 1.0, 2 } } })
+				Generate.Caves("ground", seed, { fill = 0.45, steps = 5, floor = 0, wall = 1 })
+				Generate.Dungeon("ground", seed, { min_leaf = 16, min_room = 4, floor = 1, wall = 0 })
+				Generate.Wfc("ground", seed, { sample = "examples", keep = true })
+
+			Each returns whether it started. Generate.Busy(), Generate.Progress() and Generate.Cancel() follow the
+			running one.
+		*/
+		void BindLua(Scene& scene, sol::state_view& lua);
+
+	private:
+		struct Chunk
+		{
+			uint32_t cx, cy;
+			TileLayer::ChunkPtr tiles;
+		};
+
+		void Generate(uint64_t seed, const Settings& settings, uint32_t width, uint32_t height);
+		void Finish(Scene& scene, const char* outcome);
+
+		std::future<void> _work;
+		std::atomic<bool> _cancel = false;
+
+		std::mutex _lock;
+		std::vector<Chunk> _ready;
+		std::vector<Chunk> _adopting;
+
+		size_t _layer = 0uz, _total = 0uz, _adopted = 0uz;
+		bool _busy = false;
+		Stopwatch _timer;
+
+		std::unique_ptr<wfc_solver> _solver;
+		wfc_stats _wfcStats;
+	};
+}
+
+#endif
@@ -20,13 +20,54 @@
 
 #include <cstdint>
 #include <filesystem>
+#include <memory>
 #include <vector>
 #include <span>
 
+#include <MappedFile.hpp>
+
 namespace proto
 {
-    /*
-		Image container class.
+	/*
+		A read-only window onto RGBA8 pixels, possibly a sub-rectangle of a larger image. A view holds a
+		reference to the storage it looks at, so it stays valid after the Image it came from is gone.
+	*/
+	class ImageView
+	{
+	public:
+		static constexpr uint32_t BytesPerPixel = 4u;
+
+		ImageView() = default;
+		ImageView(std::shared_ptr<const void> owner, const uint8_t* pixels, uint32_t w, uint32_t h, size_t stride);
+
+		[[nodiscard]] uint32_t Width() const { return _width; }
+		[[nodiscard]] uint32_t Height() const { return _height; }
+		[[nodiscard]] size_t Stride() const { return _stride; }
+		[[nodiscard]] bool Empty() const { return _pixels == nullptr; }
+
+		// True if the rows follow each other with no gap, i.e. Bytes() covers exactly the view.
+		[[nodiscard]] bool Contiguous() const { return _stride == size_t{_width} * BytesPerPixel; }
+
+		// Every byte from the first pixel to the last, including the rest of each row when not Contiguous().
+		[[nodiscard]] std::span<const uint8_t> Bytes() const;
+		[[nodiscard]] std::span<const uint8_t> Row(uint32_t y) const;
+
+		// A sub-rectangle of this view, clipped to its bounds.
+		[[nodiscard]] ImageView Sub(uint32_t x, uint32_t y, uint32_t w, uint32_t h) const;
+
+	private:
+		std::shared_ptr<const void> _owner;
+		const uint8_t* _pixels = nullptr;
+		uint32_t _width = 0u, _height = 0u;
+		size_t _stride = 0uz;
+	};
+
+	/*
+		Image container class. Pixels are always RGBA8, stored top row first.
+
+		The pixels live in shared storage: a buffer adopted from the decoder, a memory-mapped file or a plain
+		heap buffer. Copying an Image shares that storage rather than the pixels, use Clone() for an independent
+		copy. A const Image only hands out const pixels.
 	*/
 	class Image
 	{
@@ -35,21 +76,55 @@ namespace proto
 		Image(const std::filesystem::path& filename);
 		Image(uint32_t w, uint32_t h, std::span<uint8_t> dataIn);
 
-		// Load a fresh image from a file.
+		// Shallow: the copy shares the pixels, so writes through one Image's Data() show up in the other.
+		Image(const Image&) = default;
+		Image& operator=(const Image&) = default;
+		Image(Image&&) noexcept = default;
+		Image& operator=(Image&&) noexcept = default;
+		~Image() = default;
+
+		/*
+			Load a fresh image from a file. PNGs are decoded, and the decoder's buffer becomes the storage
+			without a copy (RGB PNGs are expanded to RGBA within it). Binary PAM files (.pam, RGB_ALPHA, 8 bit) are mapped and used in place.
+		*/
 		[[nodiscard]] bool Load(const std::filesystem::path& filename);
 
+		// Maps a headerless file of w * h RGBA8 pixels and uses it in place.
+		[[nodiscard]] bool LoadRaw(const std::filesystem::path& filename, uint32_t w, uint32_t h);
+
 		// Copy image data from an existing memory buffer.
 		// This will erase any data already contained in the Image buffer.
 		[[nodiscard]] bool LoadCopy(uint32_t w, uint32_t h, std::span<uint8_t> dataIn);
 
-		[[nodiscard]] constexpr auto Data(this auto&& self) { return std::span<uint8_t>(self._data.begin(), self._data.end()); }
+		// Takes ownership of 'pixels', which 'owner' keeps alive. Nothing is copied.
+		void Adopt(uint32_t w, uint32_t h, std::span<uint8_t> pixels, std::shared_ptr<void> owner);
+
+		[[nodiscard]] Image Clone() const;
+		void Clear();
+
+		// Converts the pixels to premultiplied alpha in place. Copies sharing the storage see the change too.
+		void PremultiplyAlpha();
+
+		[[nodiscard]] ImageView View() const;
+		[[nodiscard]] ImageView View(uint32_t x, uint32_t y, uint32_t w, uint32_t h) const { return View().Sub(x, y, w, h); }
+
+		// True if the pixels are backed by a mapped file rather than the heap.
+		[[nodiscard]] bool IsMapped() const { return _mapped; }
+
+		[[nodiscard]] std::span<uint8_t> Data() { return _data; }
+		[[nodiscard]] std::span<const uint8_t> Data() const { return _data; }
 		[[nodiscard]] constexpr auto&& Width(this auto&& self) { return self._width; }
 		[[nodiscard]] constexpr auto&& Height(this auto&& self) { return self._height; }
 		[[nodiscard("The boolean returned from Image::Empty() has been ignored.")]] bool Empty() const { return _data.empty(); }
 
 	private:
+		[[nodiscard]] bool LoadPam(const std::filesystem::path& filename);
+		[[nodiscard]] bool AdoptMapping(MappedFile&& file, uint32_t w, uint32_t h, size_t offset);
+
 		uint32_t _width{}, _height{};
-		std::vector<uint8_t> _data;
+		std::span<uint8_t> _data;
+		std::shared_ptr<void> _storage;
+		bool _mapped = false;
 
 	};
 }
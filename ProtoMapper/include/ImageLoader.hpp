@@ -0,0 +1,104 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef PROTO_IMAGE_LOADER_HPP
+#define PROTO_IMAGE_LOADER_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include <Image.hpp>
+#include <stl/parallel.hpp>
+
+namespace proto
+{
+	/*
+		Decodes image files on the shared thread pool and hands the results back to the thread that owns the
+		GL context, which is the only one allowed to upload them.
+
+		Decoded Images own the decoder's buffer directly and drop it as soon as the upload callback returns. A
+		callback that wants to keep the pixels can copy the Image, the copy shares the buffer.
+	*/
+	class ImageLoader
+	{
+	public:
+		using UploadFunc = std::function<void(const std::filesystem::path&, Image&)>;
+
+		struct Timing
+		{
+			std::filesystem::path file;
+			std::chrono::microseconds decode{};
+			bool loaded = false;
+		};
+
+		explicit ImageLoader(thread_pool& pool = thread_pool::shared());
+		ImageLoader(const ImageLoader&) = delete;
+		ImageLoader(ImageLoader&&) = delete;
+		ImageLoader& operator=(const ImageLoader&) = delete;
+		ImageLoader& operator=(ImageLoader&&) = delete;
+
+		// Waits for in-flight decodes, they still reference the loader.
+		~ImageLoader();
+
+		void Queue(const std::filesystem::path& file);
+
+		// Queues every file in 'dir' with the given extension. Returns the number of files queued.
+		size_t QueueDirectory(const std::filesystem::path& dir, std::string_view extension = ".png");
+
+		// Calls upload() for every image decoded so far, on the calling thread. Returns how many were handed over.
+		size_t Poll(const UploadFunc& upload);
+
+		// Blocks until every queued file has been decoded and handed to upload().
+		void Finish(const UploadFunc& upload);
+
+		[[nodiscard]] size_t Pending() const;
+		[[nodiscard]] std::span<const Timing> Timings() const { return _timings; }
+
+		// Prints the decode time of each file, then the total.
+		void Report() const;
+
+	private:
+		struct Decoded
+		{
+			std::filesystem::path file;
+			std::unique_ptr<Image> image;
+			std::chrono::microseconds decode{};
+			bool loaded = false;
+		};
+
+		[[nodiscard]] std::unique_ptr<Image> Acquire();
+		size_t Drain(std::unique_lock<std::mutex>& lock, const UploadFunc& upload);
+
+		thread_pool& _pool;
+
+		mutable std::mutex _lock;
+		std::condition_variable _signal;
+		std::vector<Decoded> _done;
+		std::vector<std::unique_ptr<Image>> _free;
+		std::vector<Timing> _timings;
+		size_t _inFlight = 0uz;
+	};
+}
+
+#endif
@@ -0,0 +1,140 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef PROTO_JOURNAL_HPP
+#define PROTO_JOURNAL_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <TileMap.hpp>
+#include <stl/flat_hash_map.hpp>
+
+namespace proto
+{
+	/*
+		Undo and redo for tile edits.
+
+		An edit runs from Begin() to Commit(). Every write in between goes through Set(), WritableChunk() or
+		AdoptChunk(). The first write to a chunk keeps a share of it as it was, and because the layer then copies
+		the chunk instead of writing in place, recording costs nothing per cell. Commit() compares each touched
+		chunk with its old state and stores the cells that changed as runs, with the old and new values run-length
+		encoded. A flood fill or a brush stroke ends up as a few bytes per chunk, and undoing it rewrites only those
+		runs.
+
+		Edits with the same label that are committed within CoalesceWindow of each other undo as one, so a brush
+		stroke made of many dabs is one step. Once the history outgrows its memory budget the oldest edits are
+		compressed into the spill file, and read back if they are ever undone. Without a spill file, or once
+		spilling fails, they are forgotten instead, together with everything older.
+
+		Cells are recorded by layer index, so clear the journal whenever layers are added, removed or reordered.
+	*/
+	class Journal
+	{
+	public:
+		static constexpr size_t DefaultBudget = 64uz << 20uz;
+		static constexpr auto CoalesceWindow = std::chrono::milliseconds{ 500 };
+
+		struct Stats
+		{
+			size_t entries = 0uz, undoable = 0uz;
+			size_t memoryBytes = 0uz, spilledEntries = 0uz;
+			uint64_t spilledBytes = 0u;
+		};
+
+		Journal() = default;
+		Journal(const Journal&) = delete;
+		Journal(Journal&&) = default;
+		Journal& operator=(const Journal&) = delete;
+		Journal& operator=(Journal&&) = default;
+		~Journal();
+
+		// Clears the history. An empty 'spillFile' forgets edits past the budget instead of spilling them.
+		void Configure(size_t budget, std::filesystem::path spillFile);
+
+		// Opens an edit on 'map', which must outlive it. One-shot tools such as fills pass coalesce = false.
+		void Begin(TileMap& map, std::string label, bool coalesce = true);
+
+		// Records and writes one cell of the open edit.
+		void Set(size_t layer, uint32_t x, uint32_t y, TileId tile);
+
+		// Records a whole chunk of the open edit, for tools that write many cells at once.
+		[[nodiscard]] std::span<TileId> WritableChunk(size_t layer, uint32_t cx, uint32_t cy);
+
+		// Records a chunk of the open edit and hands it 'tiles', as TileLayer::AdoptChunk() does.
+		void AdoptChunk(size_t layer, uint32_t cx, uint32_t cy, TileLayer::ChunkPtr tiles);
+
+		// Closes the open edit. An edit that changed nothing leaves no entry.
+		void Commit();
+
+		// Closes the open edit and puts back every chunk it touched.
+		void Cancel();
+
+		bool Undo(TileMap& map);
+		bool Redo(TileMap& map);
+
+		[[nodiscard]] bool CanUndo() const { return _position > 0uz; }
+		[[nodiscard]] bool CanRedo() const { return _position < _entries.size(); }
+		[[nodiscard]] bool Recording() const { return _open; }
+
+		void Clear();
+
+		[[nodiscard]] Stats GetStats() const;
+
+	private:
+		struct Entry
+		{
+			std::string label;
+			std::vector<uint8_t> data; // Empty once spilled.
+			uint64_t offset = 0u;      // Where the compressed data starts in the spill file.
+			uint32_t stored = 0u, size = 0u;
+			bool spilled = false;
+		};
+
+		void Touch(size_t layer, uint32_t cx, uint32_t cy);
+		[[nodiscard]] std::vector<uint8_t> Encode() const;
+		[[nodiscard]] bool Apply(TileMap& map, const Entry& entry, bool redo);
+		void Truncate(size_t count);
+		void Spill(Entry& entry);
+		void EnforceBudget();
+		void StopCoalescing();
+
+		TileMap* _map = nullptr;
+		std::string _label;
+		flat_hash_map<uint64_t, TileLayer::ChunkPtr> _before;
+		uint64_t _lastKey = ~uint64_t{0u};
+		bool _open = false, _merging = false;
+
+		// After a Commit() the old chunks are kept for as long as the next edit may still be merged into it.
+		bool _coalesce = false;
+		std::chrono::steady_clock::time_point _lastCommit;
+
+		std::vector<Entry> _entries;
+		size_t _position = 0uz, _memoryBytes = 0uz, _budget = DefaultBudget;
+
+		std::filesystem::path _spillFile;
+		std::fstream _spill;
+		uint64_t _spillEnd = 0u;
+	};
+}
+
+#endif
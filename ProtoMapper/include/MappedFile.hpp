@@ -0,0 +1,74 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef PROTO_MAPPED_FILE_HPP
+#define PROTO_MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+
+namespace proto
+{
+	/*
+		A memory mapping of a whole file. Pages are faulted in by the OS as they are touched, so opening a large
+		file costs nothing until its bytes are read.
+
+		The file stays open to writers while it is mapped, PmapFile appends to the file it loaded from.
+	*/
+	class MappedFile
+	{
+	public:
+		enum class Access : uint8_t
+		{
+			ReadOnly,
+			CopyOnWrite, // Writable, but writes stay private to the process and never reach the file.
+		};
+
+		MappedFile() = default;
+		explicit MappedFile(const std::filesystem::path& filename, Access access = Access::ReadOnly);
+		MappedFile(const MappedFile&) = delete;
+		MappedFile(MappedFile&& other) noexcept;
+		MappedFile& operator=(const MappedFile&) = delete;
+		MappedFile& operator=(MappedFile&& other) noexcept;
+		~MappedFile();
+
+		// Maps 'filename', replacing any current mapping. Returns false if the file is missing or empty.
+		[[nodiscard]] bool Open(const std::filesystem::path& filename, Access access = Access::ReadOnly);
+		void Close();
+
+		[[nodiscard]] bool IsOpen() const { return _data != nullptr; }
+		[[nodiscard]] std::span<const std::byte> Bytes() const { return { _data, _size }; }
+		[[nodiscard]] size_t Size() const { return _size; }
+
+		// Empty unless the file was opened with Access::CopyOnWrite.
+		[[nodiscard]] std::span<std::byte> WritableBytes() { return _writable ? std::span<std::byte>{ _data, _size } : std::span<std::byte>{}; }
+
+	private:
+		std::byte* _data = nullptr;
+		size_t _size = 0uz;
+		bool _writable = false;
+
+#ifdef _WIN32
+		void* _file = nullptr;
+		void* _mapping = nullptr;
+#endif
+	};
+}
+
+#endif
@@ -0,0 +1,124 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef PROTO_PMAP_HPP
+#define PROTO_PMAP_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include <Components.hpp>
+#include <Registry.hpp>
+#include <TileMap.hpp>
+#include <stl/flat_hash_map.hpp>
+
+namespace proto
+{
+	// A map object copied out of the Registry, so it can be saved away from the thread that edits the scene.
+	struct MapObject
+	{
+		Transform transform;
+		std::optional<Marker> marker;
+		std::optional<SpawnPoint> spawn;
+		std::optional<Trigger> trigger;
+		std::optional<Agent> agent;
+
+		bool operator==(const MapObject&) const = default;
+	};
+
+	// Every entity with a Transform, in pool order.
+	[[nodiscard]] std::vector<MapObject> CaptureObjects(Registry& registry);
+
+	// Clears 'registry' and creates one entity per object.
+	void RestoreObjects(std::span<const MapObject> objects, Registry& registry);
+
+	/*
+		ProtoMapper's own map format, for fast day-to-day saves of large maps.
+
+		A header, then the payload of every allocated chunk, then the layers, tilesets and objects, then a directory
+		with the offset, size and checksum of each chunk. Uncompressed payloads start on a page boundary and are
+		used straight from the memory mapping, so Load() only reads the header, the metadata and the directory, and
+		the OS faults tiles in as they are touched. Compressed payloads are inflated on the thread pool.
+
+		The file remembers the chunks it last loaded or saved, and keeps a share of each so that edits copy them
+		instead of writing in place. A Save() to the same file then appends only the chunks that changed, followed
+		by a new directory, and writes the header last, so a save that is cut short leaves the last one readable.
+		The file is rewritten from scratch once more than half of it is dead payloads.
+	*/
+	class PmapFile
+	{
+	public:
+		enum class Compression : uint8_t
+		{
+			None,
+			Zlib, // Per chunk, and only where it at least halves the payload.
+		};
+
+		struct Stats
+		{
+			size_t chunksWritten = 0uz, chunksReused = 0uz, bytesWritten = 0uz;
+			std::chrono::microseconds time{};
+			bool rewritten = false;
+		};
+
+		PmapFile() = default;
+		PmapFile(const PmapFile&) = delete;
+		PmapFile(PmapFile&&) = default;
+		PmapFile& operator=(const PmapFile&) = delete;
+		PmapFile& operator=(PmapFile&&) = default;
+		~PmapFile() = default;
+
+		/*
+			Replaces 'map' and the contents of 'registry' with the file's, and leaves both untouched if it fails.
+			Compressed chunks are always checked against their checksum, mapped ones only with 'verify', which reads
+			every page of the file.
+		*/
+		[[nodiscard]] bool Load(const std::filesystem::path& file, TileMap& map, Registry& registry, bool verify = false);
+
+		// Safe to call from any thread, as long as no other call on this PmapFile runs at the same time.
+		[[nodiscard]] bool Save(const std::filesystem::path& file, const TileMap& map, std::span<const MapObject> objects);
+
+		void SetCompression(Compression compression) { _compression = compression; }
+		[[nodiscard]] Compression GetCompression() const { return _compression; }
+
+		[[nodiscard]] const Stats& LastSave() const { return _lastSave; }
+		[[nodiscard]] const std::filesystem::path& Path() const { return _path; }
+
+		struct Stored
+		{
+			uint64_t offset = 0u;
+			uint32_t size = 0u, checksum = 0u;
+			Compression compression = Compression::None;
+		};
+
+	private:
+		[[nodiscard]] bool Write(const std::filesystem::path& file, const TileMap& map, std::span<const MapObject> objects, bool append);
+
+		std::filesystem::path _path;
+		flat_hash_map<const TileId*, Stored> _stored;
+		std::vector<TileLayer::ChunkPtr> _held;
+		uint64_t _fileSize = 0u, _liveBytes = 0u;
+		Compression _compression = Compression::None;
+		Stats _lastSave;
+	};
+}
+
+#endif
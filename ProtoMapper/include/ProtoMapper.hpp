@@ -27,9 +27,11 @@
 #include <SimpleIni.h>
 #include <sol/sol.hpp>
 
+#include <Autosave.hpp>
 #include <UIContainer.hpp>
 #include <Scene.hpp>
 #include <Renderer.hpp>
+#include <VirtualTexture.hpp>
 #include <Window.hpp>
 
 namespace proto
@@ -56,6 +58,7 @@ namespace proto
 	    [[nodiscard]] Renderer* GetRenderer();
 	    [[nodiscard]] UIContainer* UI() { return _ui.get(); }
 	    [[nodiscard]] auto* GetFont(this auto&& self, FontStyle style) { return self._fonts.GetFont(style); }
+	    [[nodiscard]] const nk_user_font* GetFontAtHeight(FontStyle style, float height) { return _fonts.GetFontAtHeight(style, height); }
 
 	    // GLFW input event callbacks.
 	    
@@ -75,6 +78,8 @@ namespace proto
 	    bool _appRunning = true, _fullscreen = false, _configUpdate = false;
 
 	    std::unique_ptr<Scene> _scene;
+	    std::unique_ptr<Autosave> _autosave;
+	    std::unique_ptr<VirtualTexture> _background;
 	    std::shared_ptr<UIContainer> _ui;
 	    std::unique_ptr<Renderer> _renderer;
 
@@ -0,0 +1,65 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef PROTO_REGIONS_HPP
+#define PROTO_REGIONS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <Scene.hpp>
+#include <TileMap.hpp>
+#include <stl/region_labels.hpp>
+
+namespace proto
+{
+	/*
+		Bucket fill and connected regions on tile layers. Cells connect to their four neighbours when they hold the
+		same tile, empty cells included.
+
+		Fills are scanline fills over the layer's chunks and never recurse, so any area a map can hold is fine.
+		Labelling runs over the chunks in parallel and keeps one label for chunks that are a single region, which
+		makes it cheap to keep a set of labels around for reachability checks and fill previews while nothing edits
+		the layer.
+	*/
+
+	// Part of one row, as fills and regions are reported.
+	struct TileRun
+	{
+		uint32_t x = 0u, y = 0u, length = 0u;
+	};
+
+	// The cells a bucket fill at (x, y) would cover, without changing anything.
+	[[nodiscard]] std::vector<TileRun> FillArea(const TileLayer& layer, uint32_t x, uint32_t y);
+
+	[[nodiscard]] region_labels LabelRegions(const TileLayer& layer);
+
+	/*
+		These write 'tile' over an area of layer 'layer' and return how many cells they changed. The write is one
+		undo step, or part of the journal's open edit if there is one. They change nothing while the scene's
+		generator is busy.
+	*/
+	size_t FloodFill(Scene& scene, size_t layer, uint32_t x, uint32_t y, TileId tile);
+	size_t FillRuns(Scene& scene, size_t layer, std::span<const TileRun> runs, TileId tile);
+
+	// 'labels' must come from the layer as it is now.
+	size_t FillRegion(Scene& scene, size_t layer, const region_labels& labels, region_labels::label_type label, TileId tile);
+}
+
+#endif
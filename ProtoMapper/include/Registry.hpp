@@ -0,0 +1,235 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef PROTO_REGISTRY_HPP
+#define PROTO_REGISTRY_HPP
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+#include <stl/parallel.hpp>
+#include <stl/sparse_set.hpp>
+
+namespace proto
+{
+	using Entity = entity_type;
+	inline constexpr Entity NullEntity = null_entity;
+
+	/*
+		Iterates every entity that owns all of the requested components. The smallest pool leads the iteration
+		so the membership tests are paid for as few entities as possible.
+	*/
+	template <typename... Components>
+	class View
+	{
+	public:
+		explicit View(component_pool<Components>*... pools)
+			: _pools(pools...)
+		{
+			_lead = std::min({ static_cast<const sparse_set*>(pools)... }, [](const sparse_set* lhs, const sparse_set* rhs) { return lhs->size() < rhs->size(); });
+		}
+
+		[[nodiscard]] size_t SizeHint() const { return _lead->size(); }
+
+		// Calls func(entity, components&...) for each matching entity.
+		template <typename Func>
+		void Each(Func&& func) const
+		{
+			EachRange(0uz, _lead->size(), func);
+		}
+
+		/*
+			Splits the lead pool into contiguous chunks and runs them on the shared thread pool. The function must
+			only touch the components it is handed, adding or removing components while this runs is undefined.
+		*/
+		template <typename Func>
+		void ParallelEach(Func&& func, size_t minChunk = DefaultChunk) const
+		{
+			parallel_for(_lead->size(), [this, &func](size_t first, size_t last) { EachRange(first, last, func); }, minChunk);
+		}
+
+		static constexpr size_t DefaultChunk = 4096uz;
+
+	private:
+		template <typename Func>
+		void EachRange(size_t first, size_t last, Func& func) const
+		{
+			const auto entities = _lead->entities();
+
+			if constexpr (sizeof...(Components) == 1uz)
+			{
+				// A single pool is its own lead, so we can walk the column directly.
+				auto column = std::get<0>(_pools)->components();
+
+				for(auto i = first; i < last; ++i)
+				{
+					func(entities[i], column[i]);
+				}
+			}
+			else
+			{
+				for(auto i = first; i < last; ++i)
+				{
+					const auto e = entities[i];
+
+					if(std::apply([e](auto*... pools) { return (pools->contains(e) && ...); }, _pools))
+					{
+						std::apply([e, &func](auto*... pools) { func(e, pools->get(e)...); }, _pools);
+					}
+				}
+			}
+		}
+
+		std::tuple<component_pool<Components>*...> _pools;
+		const sparse_set* _lead = nullptr;
+	};
+
+	class Registry
+	{
+	public:
+		// The largest index is never handed out, free slots use it to mark the end of the free list.
+		static constexpr Entity FreeListEnd = entity_index_mask;
+		static constexpr size_t MaxEntities = FreeListEnd;
+
+		// Throws std::length_error once every index is alive.
+		[[nodiscard]] Entity Create()
+		{
+			if(_freeHead != NullEntity)
+			{
+				const auto index = _freeHead;
+				const auto next = entity_index(_entities[index]);
+
+				_freeHead = (next == FreeListEnd) ? NullEntity : next;
+				_entities[index] = make_entity(index, entity_version(_entities[index]));
+				return _entities[index];
+			}
+
+			if(_entities.size() >= MaxEntities) { throw std::length_error("Registry has run out of entity indices."); }
+
+			const auto e = make_entity(static_cast<Entity>(_entities.size()), 0u);
+			_entities.push_back(e);
+			return e;
+		}
+
+		void Destroy(Entity e)
+		{
+			if(!Valid(e)) { return; }
+
+			for(auto& pool : _pools)
+			{
+				if(pool) { pool->erase(e); }
+			}
+
+			// The slot stores the next free index and the bumped version.
+			const auto index = entity_index(e);
+			_entities[index] = make_entity(_freeHead == NullEntity ? FreeListEnd : _freeHead, entity_version(e) + 1u);
+			_freeHead = index;
+		}
+
+		[[nodiscard]] bool Valid(Entity e) const
+		{
+			const auto index = entity_index(e);
+			return index < _entities.size() && _entities[index] == e;
+		}
+
+		// The live entity at 'index', or NullEntity if the index is free.
+		[[nodiscard]] Entity EntityAt(entity_type index) const
+		{
+			if(index >= _entities.size()) { return NullEntity; }
+
+			// A free slot holds the next free index instead of its own.
+			const auto e = _entities[index];
+			return entity_index(e) == index ? e : NullEntity;
+		}
+
+		template <typename T, typename... Args>
+		T& Emplace(Entity e, Args&&... args) { return Pool<T>().emplace(e, std::forward<Args>(args)...); }
+
+		template <typename T>
+		void Remove(Entity e) { Pool<T>().erase(e); }
+
+		template <typename T>
+		[[nodiscard]] bool Has(Entity e) { return Pool<T>().contains(e); }
+
+		template <typename T>
+		[[nodiscard]] T& Get(Entity e) { return Pool<T>().get(e); }
+
+		template <typename T>
+		[[nodiscard]] T* TryGet(Entity e) { return Pool<T>().try_get(e); }
+
+		template <typename... Components>
+		[[nodiscard]] View<Components...> ViewOf() { return View<Components...>{ &Pool<Components>()... }; }
+
+		template <typename T>
+		[[nodiscard]] component_pool<T>& Pool()
+		{
+			const auto id = TypeIndex<T>();
+
+			if(id >= _pools.size()) { _pools.resize(id + 1uz); }
+			if(!_pools[id]) { _pools[id] = std::make_unique<component_pool<T>>(); }
+
+			return static_cast<component_pool<T>&>(*_pools[id]);
+		}
+
+		void Clear()
+		{
+			_pools.clear();
+			_entities.clear();
+			_freeHead = NullEntity;
+		}
+
+	private:
+		// Each component type gets a small sequential id, so pools are found with an index instead of a hash.
+		[[nodiscard]] static size_t NextTypeIndex()
+		{
+			static size_t counter = 0uz;
+			return counter++;
+		}
+
+		template <typename T>
+		[[nodiscard]] static size_t TypeIndex()
+		{
+			static const size_t id = NextTypeIndex();
+			return id;
+		}
+
+		std::vector<std::unique_ptr<sparse_set>> _pools;
+		std::vector<Entity> _entities;
+		Entity _freeHead = NullEntity;
+	};
+
+	/*
+		Systems are run by the Scene once per tick, in the order they were added.
+	*/
+	class System
+	{
+	public:
+		System() = default;
+		System(const System&) = delete;
+		System(System&&) = delete;
+		System& operator=(const System&) = delete;
+		System& operator=(System&&) = delete;
+		virtual ~System() = default;
+
+		virtual void Update(Registry& registry, float dt) = 0;
+	};
+}
+
+#endif
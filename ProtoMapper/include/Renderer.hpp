@@ -27,6 +27,7 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include <Texture.hpp>
+#include <TextureUploader.hpp>
 #include <Shader.hpp>
 
 namespace proto
@@ -39,6 +40,7 @@ namespace proto
 		int32_t elemCount = 0;
 		uint32_t offset = 0u;
 		std::optional<Texture2D> texture = std::nullopt;
+		std::optional<Shader> shader = std::nullopt;
 	};
 	
 	class Renderer
@@ -67,6 +69,12 @@ namespace proto
 		[[nodiscard]] constexpr auto GetRenderY(this auto&& self) { return self._vY; }
 		[[nodiscard]] constexpr auto GetDefaultTexture(this auto&& self) { return self._defaultTexture; }
 
+		// Draws signed distance field text, see FontRender::DistanceField.
+		[[nodiscard]] constexpr auto GetDistanceFieldShader(this auto&& self) { return self._distanceFieldShader; }
+
+		// Queued uploads are issued at the start of each frame, see TextureUploader.
+		[[nodiscard]] constexpr auto& GetUploader(this auto&& self) { return self._uploads; }
+
 		void SetUniforms(const std::function<void()>& uniforms);
 		void SetViewport(int x, int y, int w, int h);
 		void SetRenderMode(mode m);
@@ -76,6 +84,7 @@ namespace proto
 		void PushDrawCallRange(const std::span<DrawCall>& range);
 
 	private:
+		static bool LoadProgram(Shader& shader, const std::filesystem::path& vs, const std::filesystem::path& fs);
 
 		template<typename IndexType, typename OffsetType>
 		void Draw(unsigned int vertexArray, int numInds, OffsetType offset = 0u, unsigned int drawMode = GL_TRIANGLES)
@@ -119,8 +128,9 @@ namespace proto
 
 		std::optional<Texture2D> _currentTexture;
 		std::optional<Shader> _currentShader;
-		Shader _defaultShader;
+		Shader _defaultShader, _distanceFieldShader;
 		Texture2D _defaultTexture;
+		TextureUploader _uploads;
 
 		std::function<void()> _uniforms = []() {};
 		std::queue<DrawCall> _drawQueue;
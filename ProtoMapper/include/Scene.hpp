@@ -18,29 +18,106 @@
 #ifndef PROTO_SCENE_HPP
 #define PROTO_SCENE_HPP
 
+#include <filesystem>
 #include <memory>
 #include <span>
+#include <vector>
 
+#include <glm/glm.hpp>
+#include <sol/forward.hpp>
+
+#include <AutoTiler.hpp>
+#include <Generator.hpp>
+#include <Journal.hpp>
 #include <UIContainer.hpp>
+#include <Registry.hpp>
+#include <TileMap.hpp>
+#include <stl/spatial_grid.hpp>
 
 namespace proto
 {
-
-	class System;
-	
 	class Scene
 	{
 	public:
+		// World units per object index cell, a few tiles across.
+		static constexpr float ObjectCellSize = 128.f;
+
 		Scene(std::shared_ptr<UIContainer> ui);
 
 		void Update(float dt);
 		void Cleanup();
 
+		// Call after the map and its objects were replaced as a whole. Drops the undo history and re-indexes objects.
+		void MapLoaded();
+
+		/*
+			Adds a Map table to 'lua' for saving and loading this scene's map, with files relative to 'dir':
+
+				Map.ExportTmx("level.tmx")
+				Map.ImportTmx("level.tmx")
+
+			Each returns whether it succeeded. Also binds the generator's Generate table.
+		*/
+		void BindLua(sol::state_view& lua, const std::filesystem::path& dir);
+
+		// Systems are updated in the order they are added.
+		template <typename T, typename... Args>
+		T& AddSystem(Args&&... args)
+		{
+			auto& system = _systems.emplace_back(std::make_unique<T>(std::forward<Args>(args)...));
+			return static_cast<T&>(*system);
+		}
+
+		// Map objects: markers, spawn points, agents and triggers.
+		[[nodiscard]] auto& GetRegistry(this auto&& self) { return self._registry; }
+
+		// Tile layers and the tilesets they draw from.
+		[[nodiscard]] auto& GetMap(this auto&& self) { return self._map; }
+
+		// Undo history for tile edits made to the map.
+		[[nodiscard]] auto& GetJournal(this auto&& self) { return self._journal; }
+
+		// Steps the map through its undo history. Refused while the generator is streaming into the map.
+		bool Undo();
+		bool Redo();
+
+		// Terrain rules for painting, they outlive maps.
+		[[nodiscard]] auto& GetAutoTiler(this auto&& self) { return self._autoTiler; }
+
+		// Procedural layers, streamed into the map by Update().
+		[[nodiscard]] auto& GetGenerator(this auto&& self) { return self._generator; }
+
+		/*
+			Objects by position. Agents are kept up to date by Update(), anything else that creates, moves, resizes
+			or destroys an object has to pass it to RefreshObjects() afterwards.
+		*/
+		void RefreshObjects(std::span<const Entity> entities);
+		void RebuildObjectIndex();
+
+		// These fill 'out' with entities and return how many matched, which may be more than fit.
+		[[nodiscard]] size_t ObjectsIn(const spatial_box& area, std::span<Entity> out) const;
+		[[nodiscard]] size_t ObjectsNear(glm::vec2 point, float radius, std::span<Entity> out) const;
+		[[nodiscard]] size_t ObjectsAlong(glm::vec2 origin, glm::vec2 direction, float maxT, std::span<ray_hit> out) const;
+
+		[[nodiscard]] const spatial_grid& GetObjectIndex() const { return _objectIndex; }
+
 		[[nodiscard]] constexpr auto GetUIDrawCalls(this auto&& self) { return self._uiDrawCalls; }
 
 	private:
 		std::span<DrawCall> _uiDrawCalls;
 		std::weak_ptr<UIContainer> _uiSystem;
+
+		Registry _registry;
+		TileMap _map;
+		Journal _journal;
+		AutoTiler _autoTiler;
+		Generator _generator;
+
+		spatial_grid _objectIndex{ ObjectCellSize };
+		std::vector<spatial_grid::id_type> _indexIds;
+		std::vector<spatial_box> _indexBoxes;
+
+		std::vector<std::unique_ptr<System>> _systems;
 	};
 }
 
@@ -0,0 +1,47 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef PROTO_STOPWATCH_HPP
+#define PROTO_STOPWATCH_HPP
+
+#include <chrono>
+
+namespace proto
+{
+	/*
+		Measures wall time from construction, or the last Reset(), using the steady clock.
+	*/
+	class Stopwatch
+	{
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		Stopwatch() = default;
+
+		void Reset() { _start = Clock::now(); }
+
+		template <typename Duration = std::chrono::microseconds>
+		[[nodiscard]] Duration Elapsed() const { return std::chrono::duration_cast<Duration>(Clock::now() - _start); }
+
+		[[nodiscard]] double Milliseconds() const { return std::chrono::duration<double, std::milli>(Clock::now() - _start).count(); }
+
+	private:
+		Clock::time_point _start = Clock::now();
+	};
+}
+
+#endif
@@ -0,0 +1,33 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef PROTO_SYSTEMS_HPP
+#define PROTO_SYSTEMS_HPP
+
+#include <Registry.hpp>
+
+namespace proto
+{
+	// Moves every Agent towards its goal. Runs in parallel chunks over the Agent column.
+	class AgentSystem : public System
+	{
+	public:
+		void Update(Registry& registry, float dt) override;
+	};
+}
+
+#endif
@@ -22,10 +22,20 @@
 
 #include <glad/glad.h>
 #include <Image.hpp>
+#include <stl/mipmap.hpp>
 namespace proto
 {
     inline constexpr auto TextureWhite = 0xFFFFFFFF;
 
+    // Filtering presets, from cheapest to best looking when the texture is drawn smaller than its size.
+    enum class Sampling : uint8_t
+    {
+	Nearest,	// Hard texel edges, for pixel art at whole zoom levels.
+	Bilinear,	// The default. Without mip levels it shimmers once zoomed out.
+	Trilinear,	// Blends the two nearest mip levels. Needs a mip chain, see WriteMipmapped().
+	Anisotropic,	// Trilinear with extra samples along the squashed axis, for stretched or tilted views.
+    };
+
     struct Texture2D
     {
 	using IDType = uint32_t;
@@ -55,9 +65,29 @@ namespace proto
 	void Destroy();
 	static void Unbind();
 	Texture2D& WriteImage(Image& img);
+
+	// Uploads a view in place, rows of a sub-rectangle are read with GL_UNPACK_ROW_LENGTH instead of being copied out.
+	Texture2D& WriteImage(const ImageView& view);
 	Texture2D& WriteData(const void* data, int width, int height);
+
+	// Uploads one byte per texel as GL_R8, swizzled to read back as (r, r, r, r): white with alpha r, premultiplied.
+	Texture2D& WriteAlpha(const void* data, int width, int height);
 	Texture2D& GenerateBlank(int w, int h, uint32_t colorValue = TextureWhite);
 
+	/*
+	    Allocates immutable storage for 'levels' mip levels with glTexStorage2D. The size and format can no longer
+	    change, so the Write* functions that call glTexImage2D fail on it: fill it with glTexSubImage2D instead.
+	*/
+	Texture2D& Allocate(int width, int height, int levels = 1, GLenum format = GL_RGBA8);
+
+	// Allocates a full mip chain and uploads the view with every level below it, filtered on the CPU.
+	Texture2D& WriteMipmapped(const ImageView& view, mip_filter filter = mip_filter::box);
+
+	Texture2D& SetSampling(Sampling preset);
+
+	// The most samples Sampling::Anisotropic takes, 1 if the driver has no anisotropic filtering.
+	[[nodiscard]] static float MaxAnisotropy();
+
 	[[nodiscard]] static constexpr IDType Target() { return GL_TEXTURE_2D; }
 
     };
@@ -0,0 +1,96 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef PROTO_TEXTURE_ATLAS_HPP
+#define PROTO_TEXTURE_ATLAS_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <future>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <Texture.hpp>
+#include <stl/flat_hash_map.hpp>
+#include <stl/rect_packer.hpp>
+
+namespace proto
+{
+	struct AtlasRegion
+	{
+		uint32_t page = 0u;
+		packed_rect rect;
+	};
+
+	/*
+		Packs many small images into a few large textures so the UI can draw them without switching textures.
+
+		Packing happens on the thread pool: Begin() starts it and Finish() waits for it and uploads the pages,
+		so Finish() must run on the thread that owns the GL context. The packed pages are written to a cache file
+		keyed by a hash of every source file, and later runs load that file instead of decoding and packing.
+	*/
+	class TextureAtlas
+	{
+	public:
+		static constexpr uint32_t MaxPageSize = 2048u;
+		static constexpr uint32_t Padding = 1u;
+
+		TextureAtlas() = default;
+		TextureAtlas(const TextureAtlas&) = delete;
+		TextureAtlas(TextureAtlas&&) = delete;
+		TextureAtlas& operator=(const TextureAtlas&) = delete;
+		TextureAtlas& operator=(TextureAtlas&&) = delete;
+		~TextureAtlas();
+
+		// Regions are named after each file's stem, e.g. "iconClose".
+		void Begin(std::vector<std::filesystem::path> files, std::filesystem::path cacheFile);
+
+		// Returns false if nothing could be packed.
+		[[nodiscard]] bool Finish();
+
+		[[nodiscard]] const AtlasRegion* Find(const hashed_string& name) const;
+		[[nodiscard]] Texture2D PageTexture(uint32_t page) const { return _textures.at(page); }
+		[[nodiscard]] uint32_t PageWidth(uint32_t page) const { return _pages.at(page).width; }
+		[[nodiscard]] uint32_t PageHeight(uint32_t page) const { return _pages.at(page).height; }
+		[[nodiscard]] size_t PageCount() const { return _textures.size(); }
+		[[nodiscard]] bool FromCache() const { return _fromCache; }
+
+	private:
+		struct Page
+		{
+			uint32_t width = 0u, height = 0u;
+			std::vector<uint8_t> pixels;
+		};
+
+		// Runs on a worker thread.
+		void Build(const std::vector<std::filesystem::path>& files, const std::filesystem::path& cacheFile);
+		void Pack(const std::vector<std::filesystem::path>& files);
+		[[nodiscard]] bool LoadCache(const std::filesystem::path& cacheFile, uint64_t key);
+		void SaveCache(const std::filesystem::path& cacheFile, uint64_t key) const;
+
+		[[nodiscard]] static uint64_t ContentKey(const std::vector<std::filesystem::path>& files);
+
+		std::future<void> _pending;
+		flat_hash_map<std::string, AtlasRegion> _regions;
+		std::vector<Page> _pages;
+		std::vector<Texture2D> _textures;
+		bool _fromCache = false;
+	};
+}
+
+#endif
@@ -0,0 +1,131 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef PROTO_TEXTURE_UPLOADER_HPP
+#define PROTO_TEXTURE_UPLOADER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <optional>
+
+#include <glad/glad.h>
+
+#include <Image.hpp>
+#include <Texture.hpp>
+
+namespace proto
+{
+	/*
+		Uploads textures without stalling the frame they are queued in.
+
+		Pixels are copied into a staging ring, one pixel buffer object that stays mapped for the uploader's
+		lifetime, and glTexSubImage2D reads them from there while the frame goes on. A fence after each frame's
+		copies tells us when the GPU is done with that part of the ring so it can be reused. Process() copies at
+		most FrameBudget() bytes per call, larger images are cut into bands of rows spread over several frames.
+
+		An upload completes once its last band is issued: GL runs commands in order, so anything drawn after
+		that sees the whole texture, and the source pixels are no longer needed.
+
+		Upload() can be called from any thread. Everything else, and the callbacks, run on the thread that owns
+		the GL context.
+	*/
+	class TextureUploader
+	{
+	public:
+		static constexpr size_t DefaultRingSize = 64uz << 20uz;
+		static constexpr size_t DefaultFrameBudget = 16uz << 20uz;
+
+		// Runs on the GL thread once the texture holds the pixels.
+		using Callback = std::function<void(Texture2D)>;
+
+		explicit TextureUploader(size_t ringSize = DefaultRingSize);
+		TextureUploader(const TextureUploader&) = delete;
+		TextureUploader(TextureUploader&&) = delete;
+		TextureUploader& operator=(const TextureUploader&) = delete;
+		TextureUploader& operator=(TextureUploader&&) = delete;
+
+		// Waits for the GPU to finish with the ring. Uploads still queued break their futures.
+		~TextureUploader();
+
+		/*
+			Queues 'view' for upload into a new texture of its size. The view keeps its pixels alive until they
+			have been copied. The future is ready, and onDone called, when the texture can be drawn.
+		*/
+		std::future<Texture2D> Upload(ImageView view, Callback onDone = {});
+
+		// Queues 'view' for upload into an existing texture at (x, y). The texture must already have storage.
+		std::future<Texture2D> Upload(ImageView view, Texture2D target, int x, int y, Callback onDone = {});
+
+		// Recycles ring space the GPU is done with and issues queued uploads. Call once per frame.
+		void Process();
+
+		// Issues everything queued so far, waiting on the GPU whenever the ring fills up.
+		void Finish();
+
+		// Uploads queued or partly issued.
+		[[nodiscard]] size_t Pending() const;
+
+		void SetFrameBudget(size_t bytes) { _frameBudget = bytes; }
+		[[nodiscard]] size_t FrameBudget() const { return _frameBudget; }
+
+		// False if the ring could not be created, uploads then go straight from client memory.
+		[[nodiscard]] bool Valid() const { return _buffer != 0u; }
+
+	private:
+		struct Request
+		{
+			ImageView view;
+			Texture2D target;
+			int x = 0, y = 0;
+			uint32_t nextRow = 0u;
+			bool createTarget = false;
+			std::promise<Texture2D> done;
+			Callback onDone;
+		};
+
+		// A frame's stretch of the ring, which the GPU may still be reading.
+		struct InFlight
+		{
+			GLsync fence = nullptr;
+			size_t end = 0uz, bytes = 0uz;
+		};
+
+		// Returns the ring offset of 'bytes' free bytes, or nothing if the GPU still holds too much of the ring.
+		[[nodiscard]] std::optional<size_t> Reserve(size_t bytes);
+		void Retire(bool wait);
+
+		// Copies and issues as many rows of 'request' as fit. Returns false if it ran out of ring or budget.
+		[[nodiscard]] bool Stage(Request& request, size_t& budget);
+		void Direct(Request& request) const;
+
+		GLuint _buffer = 0u;
+		std::byte* _ring = nullptr;
+		size_t _ringSize = 0uz, _head = 0uz, _tail = 0uz, _used = 0uz, _frameBytes = 0uz;
+		size_t _frameBudget = DefaultFrameBudget;
+
+		mutable std::mutex _lock;
+		std::deque<Request> _queued; // Shared with other threads, everything below belongs to the GL thread.
+		std::deque<Request> _active;
+		std::deque<InFlight> _inFlight;
+	};
+}
+
+#endif
@@ -0,0 +1,151 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef PROTO_TILE_MAP_HPP
+#define PROTO_TILE_MAP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace proto
+{
+	// A global tile id, as in Tiled: the tileset's firstGid plus the tile's index in it. 0 is an empty cell.
+	using TileId = uint32_t;
+	inline constexpr TileId EmptyTile = 0u;
+
+	/*
+		One grid of tiles, stored as ChunkSize x ChunkSize chunks in row order. Chunks that were never written are
+		not allocated and read as empty.
+
+		Copying a layer is cheap, the copy shares every chunk and a chunk is only cloned when one side writes to it
+		while the other still holds it. Snapshots for saving and undo rely on this, so never write through a chunk
+		pointer that did not come from WritableChunk().
+	*/
+	class TileLayer
+	{
+	public:
+		static constexpr uint32_t ChunkSize = 64u;
+		static constexpr size_t ChunkArea = size_t{ChunkSize} * size_t{ChunkSize};
+
+		using ChunkPtr = std::shared_ptr<TileId[]>;
+
+		TileLayer() = default;
+		TileLayer(std::string name, uint32_t width, uint32_t height);
+
+		[[nodiscard]] TileId Get(uint32_t x, uint32_t y) const;
+		void Set(uint32_t x, uint32_t y, TileId tile);
+
+		// A whole chunk, empty if it was never allocated. Cells past the right and bottom edges are always empty.
+		[[nodiscard]] std::span<const TileId> Chunk(uint32_t cx, uint32_t cy) const;
+
+		// Allocates the chunk, or clones it if a snapshot shares it.
+		[[nodiscard]] std::span<TileId> WritableChunk(uint32_t cx, uint32_t cy);
+
+		// Replaces a chunk with ChunkArea tiles that the layer takes a share of, or frees it if 'tiles' is null.
+		void AdoptChunk(uint32_t cx, uint32_t cy, ChunkPtr tiles);
+		[[nodiscard]] const ChunkPtr& SharedChunk(uint32_t cx, uint32_t cy) const { return _chunks[(size_t{cy} * _chunksX) + cx]; }
+
+		// Copies row 'y' into 'out', which must hold Width() tiles.
+		void ReadRow(uint32_t y, std::span<TileId> out) const;
+
+		// Frees every chunk.
+		void Clear();
+
+		[[nodiscard]] const std::string& Name() const { return _name; }
+		void SetName(std::string name) { _name = std::move(name); }
+
+		[[nodiscard]] uint32_t Width() const { return _width; }
+		[[nodiscard]] uint32_t Height() const { return _height; }
+		[[nodiscard]] uint32_t ChunksX() const { return _chunksX; }
+		[[nodiscard]] uint32_t ChunksY() const { return _chunksY; }
+		[[nodiscard]] size_t AllocatedChunks() const;
+
+		// Compares chunk pointers, not tiles: a layer equals its copy until either side writes to it.
+		bool operator==(const TileLayer&) const = default;
+
+		bool visible = true;
+		float opacity = 1.f;
+
+	private:
+		std::string _name;
+		uint32_t _width = 0u, _height = 0u, _chunksX = 0u, _chunksY = 0u;
+		std::vector<ChunkPtr> _chunks;
+	};
+
+	// An image of tiles, either embedded in the map or kept in an external .tsx file.
+	struct Tileset
+	{
+		TileId firstGid = 1u;
+		std::string name;
+		std::filesystem::path source; // The .tsx file, empty for an embedded tileset.
+		std::filesystem::path image;
+		uint32_t imageWidth = 0u, imageHeight = 0u;
+		uint32_t tileWidth = 0u, tileHeight = 0u;
+		uint32_t tileCount = 0u, columns = 0u;
+		uint32_t spacing = 0u, margin = 0u;
+
+		bool operator==(const Tileset&) const = default;
+	};
+
+	/*
+		The tile content of a scene: an orthogonal grid with any number of layers, drawn bottom to top, and the
+		tilesets their ids refer to. Map objects live in the Scene's Registry instead.
+	*/
+	class TileMap
+	{
+	public:
+		// Far beyond any map we make, it only keeps a corrupt file from allocating the world.
+		static constexpr uint32_t MaxExtent = 1u << 16u;
+
+		TileMap() = default;
+		TileMap(uint32_t width, uint32_t height, uint32_t tileWidth, uint32_t tileHeight);
+
+		// Drops every layer and tileset and starts over at the given size.
+		void Reset(uint32_t width, uint32_t height, uint32_t tileWidth, uint32_t tileHeight);
+		void Clear() { Reset(0u, 0u, 0u, 0u); }
+
+		// References to layers are invalidated by the next AddLayer().
+		TileLayer& AddLayer(std::string name);
+		[[nodiscard]] auto& Layers(this auto&& self) { return self._layers; }
+		[[nodiscard]] TileLayer* FindLayer(std::string_view name);
+
+		[[nodiscard]] auto& Tilesets(this auto&& self) { return self._tilesets; }
+
+		[[nodiscard]] uint32_t Width() const { return _width; }
+		[[nodiscard]] uint32_t Height() const { return _height; }
+		[[nodiscard]] uint32_t TileWidth() const { return _tileWidth; }
+		[[nodiscard]] uint32_t TileHeight() const { return _tileHeight; }
+		[[nodiscard]] bool Empty() const { return _width == 0u || _height == 0u; }
+
+		// Layers compare by chunk pointer, so this tells a snapshot from an edited map without reading any tiles.
+		bool operator==(const TileMap&) const = default;
+
+	private:
+		uint32_t _width = 0u, _height = 0u, _tileWidth = 0u, _tileHeight = 0u;
+		std::vector<TileLayer> _layers;
+		std::vector<Tileset> _tilesets;
+	};
+}
+
+#endif
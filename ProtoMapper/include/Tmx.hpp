@@ -0,0 +1,54 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef PROTO_TMX_HPP
+#define PROTO_TMX_HPP
+
+#include <chrono>
+#include <filesystem>
+#include <optional>
+
+#include <Registry.hpp>
+#include <TileMap.hpp>
+
+namespace proto
+{
+	/*
+		Tiled's TMX format, the level format our games load.
+
+		Maps are written as finite orthogonal maps. Each layer's tiles are zlib compressed and base64 encoded, and
+		everything is streamed to the file as it is produced, the document is never built in memory. Objects with a
+		Transform become one object group, triggers as rectangles and everything else as points.
+
+		Imports read finite orthogonal maps with base64 (uncompressed, zlib or gzip) or CSV layer data. Layers are
+		decoded on the thread pool, one per task, and inflated straight into their chunks.
+	*/
+
+	// Where an import spent its time: building the XML document, base64 decoding, then inflating into chunks.
+	struct TmxTimings
+	{
+		std::chrono::microseconds parse{}, decode{}, fill{};
+	};
+
+	// Writes through a temporary file, so a failed export never leaves a truncated map behind.
+	[[nodiscard]] bool ExportTmx(const TileMap& map, Registry& registry, const std::filesystem::path& file);
+
+	// Replaces 'map' and the contents of 'registry' with the file's, and leaves both untouched if it fails.
+	[[nodiscard]] std::optional<TmxTimings> ImportTmx(const std::filesystem::path& file, TileMap& map, Registry& registry);
+}
+
+#endif
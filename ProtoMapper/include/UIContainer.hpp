@@ -21,6 +21,7 @@
 #include <filesystem>
 #include <map>
 #include <memory>
+#include <optional>
 #include <sol/forward.hpp>
 #include <sol/environment.hpp>
 
@@ -35,10 +36,12 @@
 #include <nuklear.h>
 
 #include <Texture.hpp>
+#include <TextureAtlas.hpp>
 #include <Renderer.hpp>
 #include <Font.hpp>
 #include <Vertex.hpp>
 #include <gsl/gsl-lite.hpp>
+#include <stl/flat_hash_map.hpp>
 
 namespace proto
 {
@@ -53,6 +56,9 @@ namespace proto
 
 		[[nodiscard]] nk_context *Context() { return _ctx.get(); }
 
+		// Looks up an icon by its file stem, e.g. "iconClose". The image covers the icon's region of the UI atlas.
+		[[nodiscard]] std::optional<struct nk_image> GetIcon(const hashed_string& name) const;
+
 		// Calls each UI Lua function and reports any errors.
 		void Update();
 
@@ -68,7 +74,9 @@ namespace proto
 		sol::environment _env;
 
 		std::map<std::string, std::string> _luaFunctions;
-		std::map<std::string, std::shared_ptr<Texture2D>> _icons;
+		TextureAtlas _atlas;
+		FontGroup* _fonts;
+		Shader _distanceFieldShader;
 		std::vector<DrawCall> _drawCalls;
 		
 		/*
@@ -79,7 +87,6 @@ namespace proto
 		struct nk_convert_config _configurator;
 		struct nk_buffer _cmds, _verts, _inds;
 		struct nk_draw_null_texture _nullTexture;
-		Texture2D _fontTexture;
 		
 		Buffer<Vertex2D> _nkBuffer;
 		
@@ -0,0 +1,141 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#ifndef PROTO_VIRTUAL_TEXTURE_HPP
+#define PROTO_VIRTUAL_TEXTURE_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <future>
+#include <optional>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <MappedFile.hpp>
+#include <Renderer.hpp>
+#include <Texture.hpp>
+#include <TextureUploader.hpp>
+#include <Vertex.hpp>
+#include <stl/flat_hash_map.hpp>
+
+namespace proto
+{
+	/*
+		Draws images far larger than one texture can hold, e.g. the 16k-32k concept maps used as tracing
+		backgrounds.
+
+		Begin() cuts the image into tiles for every level of a mip pyramid on the thread pool and writes them to a
+		cache file, which later runs reuse. The cache is memory-mapped, and each frame Update() queues the tiles the
+		view needs on a TextureUploader, which stages them into one fixed-size page texture without stalling the
+		frame. No more than UploadBudget() tiles are queued per frame. Tiles that are not resident yet, or still on
+		their way, are drawn from the nearest coarser level that is. The coarsest level is always resident once the
+		first frame's uploads are in.
+	*/
+	class VirtualTexture
+	{
+	public:
+		static constexpr uint32_t TileSize = 256u;
+		static constexpr uint32_t TileBorder = 1u; // Copied from the neighbouring tiles so filtering is seamless.
+		static constexpr uint32_t SlotSize = TileSize + (2u * TileBorder);
+		static constexpr uint32_t PageSlots = 16u; // Per side, so 256 tiles are resident at once.
+		static constexpr uint32_t PageExtent = PageSlots * SlotSize;
+		static constexpr uint32_t DefaultUploadBudget = 8u;
+
+		// Tiles are uploaded through 'uploads', which must outlive the VirtualTexture.
+		explicit VirtualTexture(TextureUploader& uploads);
+		VirtualTexture(const VirtualTexture&) = delete;
+		VirtualTexture(VirtualTexture&&) = delete;
+		VirtualTexture& operator=(const VirtualTexture&) = delete;
+		VirtualTexture& operator=(VirtualTexture&&) = delete;
+		~VirtualTexture();
+
+		// Starts building, or finding, the tile cache for 'source' in 'cacheDir'.
+		void Begin(std::filesystem::path source, std::filesystem::path cacheDir);
+
+		/*
+			Streams in the tiles covering 'visible', a rectangle of the image in pixels (x, y, w, h), at the level
+			where one texel is closest to 'texelsPerPixel' image pixels per screen pixel. Does nothing until the
+			cache is ready, and must run on the thread that owns the GL context.
+		*/
+		void Update(const glm::vec4& visible, float texelsPerPixel);
+
+		// One quad per visible tile, in image pixels with the top left of the image at the origin.
+		[[nodiscard]] std::optional<DrawCall> Compile();
+
+		void SetUploadBudget(uint32_t tilesPerFrame) { _uploadBudget = tilesPerFrame; }
+		[[nodiscard]] uint32_t UploadBudget() const { return _uploadBudget; }
+
+		[[nodiscard]] bool Ready() const { return _page.Valid(); }
+		[[nodiscard]] uint32_t Width() const { return _width; }
+		[[nodiscard]] uint32_t Height() const { return _height; }
+		[[nodiscard]] size_t LevelCount() const { return _levels.size(); }
+		[[nodiscard]] size_t ResidentTiles() const { return _resident.size(); }
+
+		// Visible tiles still waiting for a slot or for upload budget.
+		[[nodiscard]] size_t PendingTiles() const { return _requests.size(); }
+
+		struct Level
+		{
+			uint32_t width = 0u, height = 0u, tilesX = 0u, tilesY = 0u, first = 0u;
+		};
+
+	private:
+		struct Slot
+		{
+			uint32_t tile = NoTile;
+			uint64_t lastUsed = 0u;
+			bool pinned = false;
+			bool loading = false; // Queued on the uploader, not drawable and not evictable yet.
+		};
+
+		struct TileRef
+		{
+			uint32_t level = 0u, x = 0u, y = 0u;
+		};
+
+		static constexpr uint32_t NoTile = ~0u;
+
+		[[nodiscard]] bool Open(const std::filesystem::path& cacheFile);
+		[[nodiscard]] uint32_t TileIndex(const TileRef& ref) const { return _levels[ref.level].first + (ref.y * _levels[ref.level].tilesX) + ref.x; }
+		[[nodiscard]] std::optional<uint32_t> FindSlot() const;
+		void Upload(uint32_t tile, uint32_t slot, bool pinned = false);
+
+		// The tile itself if it is resident and uploaded, otherwise its nearest ancestor that is.
+		[[nodiscard]] std::optional<TileRef> ResidentAncestor(TileRef ref) const;
+
+		TextureUploader* _uploads = nullptr;
+		std::future<std::filesystem::path> _pending;
+		MappedFile _cache;
+		size_t _dataOffset = 0uz;
+		uint32_t _width = 0u, _height = 0u;
+
+		std::vector<Level> _levels;
+		std::vector<Slot> _slots;
+		flat_hash_map<uint32_t, uint32_t> _resident; // Tile index to slot.
+		std::vector<TileRef> _visible, _requests;
+		uint64_t _frame = 0u;
+		uint32_t _uploadBudget = DefaultUploadBudget;
+
+		Texture2D _page;
+		Buffer<Vertex2D> _quads;
+		std::vector<Vertex2D> _vertices;
+		std::vector<uint32_t> _indices;
+	};
+}
+
+#endif
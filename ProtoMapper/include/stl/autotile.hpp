@@ -0,0 +1,209 @@
+#ifndef PROTO_AUTOTILE_HPP
+#define PROTO_AUTOTILE_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+
+/**
+ * @brief Bitmask auto-tiling: picking a terrain's edge and corner tiles from which of a cell's eight neighbours are
+ * the same terrain.
+ *
+ * Rules are compiled once into a 256-entry table indexed by the raw neighbour mask, so tiling a cell costs eight
+ * neighbour tests and one load, whatever the rules were.
+ */
+namespace proto
+{
+    // Neighbour bits, clockwise from north.
+    inline constexpr uint8_t autotile_n = 1u << 0u;
+    inline constexpr uint8_t autotile_ne = 1u << 1u;
+    inline constexpr uint8_t autotile_e = 1u << 2u;
+    inline constexpr uint8_t autotile_se = 1u << 3u;
+    inline constexpr uint8_t autotile_s = 1u << 4u;
+    inline constexpr uint8_t autotile_sw = 1u << 5u;
+    inline constexpr uint8_t autotile_w = 1u << 6u;
+    inline constexpr uint8_t autotile_nw = 1u << 7u;
+
+    inline constexpr uint8_t autotile_edges = autotile_n | autotile_e | autotile_s | autotile_w;
+
+    enum class autotile_mode : uint8_t
+    {
+        edges4, // 16 tiles, corners are ignored.
+        blob47  // 47 tiles, a corner only counts when both edges next to it do.
+    };
+
+    // The mask the rules of 'mode' see for a raw neighbour mask.
+    [[nodiscard]] constexpr uint8_t autotile_canonical(autotile_mode mode, uint8_t mask)
+    {
+        if(mode == autotile_mode::edges4) { return mask & autotile_edges; }
+
+        auto out = static_cast<uint8_t>(mask & autotile_edges);
+
+        for(const auto [corner, a, b] : { std::array{ autotile_ne, autotile_n, autotile_e }, std::array{ autotile_se, autotile_s, autotile_e },
+                                          std::array{ autotile_sw, autotile_s, autotile_w }, std::array{ autotile_nw, autotile_n, autotile_w } })
+        {
+            if((mask & (corner | a | b)) == (corner | a | b)) { out |= corner; }
+        }
+
+        return out;
+    }
+
+    // The 47 canonical blob masks in ascending order, a tile's offset in the standard blob layout is its index here.
+    inline constexpr auto autotile_blob_masks = []() {
+        auto masks = std::array<uint8_t, 47uz>{};
+        auto count = 0uz;
+
+        for(auto mask = 0u; mask < 256u; ++mask)
+        {
+            if(autotile_canonical(autotile_mode::blob47, static_cast<uint8_t>(mask)) == mask) { masks[count++] = static_cast<uint8_t>(mask); }
+        }
+
+        return masks;
+    }();
+
+    /**
+     * @brief One rule: neighbours in 'same' must be the same terrain and neighbours in 'other' must not be, the rest
+     * may be either.
+     */
+    struct autotile_rule
+    {
+        uint8_t same{}, other{};
+        uint32_t tile{};
+
+        [[nodiscard]] constexpr bool matches(uint8_t mask) const { return (mask & same) == same && (mask & other) == 0u; }
+    };
+
+    /**
+     * @brief Parses a 3x3 neighbour pattern in rows, north-west first: '1' for the same terrain, '0' for anything
+     * else and '*' for either. The centre is the cell itself and may be '.', '*' or '1'. Whitespace and slashes
+     * between the rows are skipped, so "*1* 1.1 *0*" is a cell on the south edge of its terrain.
+     */
+    [[nodiscard]] constexpr std::optional<autotile_rule> parse_autotile_rule(std::string_view pattern, uint32_t tile)
+    {
+        constexpr auto bits = std::array<uint8_t, 9uz>{ autotile_nw, autotile_n, autotile_ne, autotile_w, 0u, autotile_e, autotile_sw, autotile_s, autotile_se };
+
+        auto rule = autotile_rule{ .same = 0u, .other = 0u, .tile = tile };
+        auto cell = 0uz;
+
+        for(const auto c : pattern)
+        {
+            if(c == ' ' || c == '\t' || c == '/') { continue; }
+            if(cell == bits.size()) { return std::nullopt; }
+
+            if(cell == 4uz)
+            {
+                if(c != '.' && c != '*' && c != '1') { return std::nullopt; }
+            }
+            else if(c == '1') { rule.same |= bits[cell]; }
+            else if(c == '0') { rule.other |= bits[cell]; }
+            else if(c != '*') { return std::nullopt; }
+
+            ++cell;
+        }
+
+        if(cell != bits.size()) { return std::nullopt; }
+
+        return rule;
+    }
+
+    /**
+     * @brief A tile for every raw neighbour mask, for one terrain.
+     */
+    class autotile_lut
+    {
+    public:
+        autotile_lut() = default;
+
+        /**
+         * @brief The usual tileset layouts, starting at tile 'first'. edges4 holds 16 tiles indexed by N | E << 1 |
+         * S << 2 | W << 3, blob47 holds one tile per entry of autotile_blob_masks.
+         */
+        [[nodiscard]] static constexpr autotile_lut standard(autotile_mode mode, uint32_t first)
+        {
+            auto lut = autotile_lut{};
+            lut._mode = mode;
+
+            for(auto mask = 0u; mask < 256u; ++mask)
+            {
+                const auto canonical = autotile_canonical(mode, static_cast<uint8_t>(mask));
+                auto offset = 0u;
+
+                if(mode == autotile_mode::edges4)
+                {
+                    offset = ((canonical & autotile_n) != 0u ? 1u : 0u) | ((canonical & autotile_e) != 0u ? 2u : 0u) |
+                             ((canonical & autotile_s) != 0u ? 4u : 0u) | ((canonical & autotile_w) != 0u ? 8u : 0u);
+                }
+                else
+                {
+                    while(autotile_blob_masks[offset] != canonical) { ++offset; }
+                }
+
+                lut._tiles[mask] = first + offset;
+            }
+
+            return lut;
+        }
+
+        /**
+         * @brief Rules are tried in order against the canonical mask and the first match wins. Masks that no rule
+         * matches get 'fallback'.
+         */
+        [[nodiscard]] static constexpr autotile_lut compile(autotile_mode mode, std::span<const autotile_rule> rules, uint32_t fallback)
+        {
+            auto lut = autotile_lut{};
+            lut._mode = mode;
+
+            for(auto mask = 0u; mask < 256u; ++mask)
+            {
+                const auto canonical = autotile_canonical(mode, static_cast<uint8_t>(mask));
+                lut._tiles[mask] = fallback;
+
+                for(const auto& rule : rules)
+                {
+                    if(rule.matches(canonical))
+                    {
+                        lut._tiles[mask] = rule.tile;
+                        break;
+                    }
+                }
+            }
+
+            return lut;
+        }
+
+        [[nodiscard]] constexpr uint32_t operator[](uint8_t mask) const { return _tiles[mask]; }
+        [[nodiscard]] constexpr std::span<const uint32_t, 256uz> tiles() const { return _tiles; }
+        [[nodiscard]] constexpr autotile_mode mode() const { return _mode; }
+
+        // The tile for a cell surrounded by its own terrain.
+        [[nodiscard]] constexpr uint32_t interior() const { return _tiles[255u]; }
+
+    private:
+        std::array<uint32_t, 256uz> _tiles{};
+        autotile_mode _mode = autotile_mode::blob47;
+    };
+
+    /**
+     * @brief The neighbour mask of cell (x, y), where same(nx, ny) tells whether a neighbour is the same terrain.
+     * Neighbours off the grid are left to 'same' as well.
+     */
+    template <typename Same>
+    [[nodiscard]] constexpr uint8_t autotile_mask(int64_t x, int64_t y, Same&& same)
+    {
+        constexpr auto offsets = std::array<std::array<int64_t, 2uz>, 8uz>{ { { 0, -1 }, { 1, -1 }, { 1, 0 }, { 1, 1 }, { 0, 1 }, { -1, 1 }, { -1, 0 }, { -1, -1 } } };
+
+        auto mask = uint8_t{0u};
+
+        for(auto bit = 0uz; bit < offsets.size(); ++bit)
+        {
+            if(same(x + offsets[bit][0], y + offsets[bit][1])) { mask |= static_cast<uint8_t>(1u << bit); }
+        }
+
+        return mask;
+    }
+}
+
+#endif
@@ -0,0 +1,161 @@
+#ifndef PROTO_BASE64_HPP
+#define PROTO_BASE64_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Standard base64 (RFC 4648, with padding), as used by TMX layer data.
+ */
+namespace proto
+{
+    namespace detail
+    {
+        inline constexpr std::string_view base64_alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+        inline constexpr uint8_t base64_skip = 64u;    // Whitespace, XML text is usually indented.
+        inline constexpr uint8_t base64_pad = 65u;
+        inline constexpr uint8_t base64_invalid = 255u;
+
+        inline constexpr auto base64_values = []() {
+            auto table = std::array<uint8_t, 256uz>{};
+            table.fill(base64_invalid);
+
+            for(auto i = 0uz; i < base64_alphabet.size(); ++i) { table[static_cast<uint8_t>(base64_alphabet[i])] = static_cast<uint8_t>(i); }
+
+            for(const auto c : { ' ', '\t', '\n', '\r' }) { table[static_cast<uint8_t>(c)] = base64_skip; }
+            table[static_cast<uint8_t>('=')] = base64_pad;
+
+            return table;
+        }();
+    }
+
+    [[nodiscard]] constexpr size_t base64_encoded_size(size_t bytes) { return ((bytes + 2uz) / 3uz) * 4uz; }
+
+    // An upper bound, whitespace and padding make the real size smaller.
+    [[nodiscard]] constexpr size_t base64_decoded_size(size_t chars) { return ((chars + 3uz) / 4uz) * 3uz; }
+
+    /**
+     * @brief Encodes 'src' into 'dst', which must hold base64_encoded_size(src.size()) characters. Returns the
+     * number of characters written.
+     *
+     * Only the last call of a stream may pass a size that is not a multiple of 3, or padding ends up in the middle.
+     *
+     * @throws std::invalid_argument if dst is too small.
+     */
+    inline size_t base64_encode(std::span<const uint8_t> src, std::span<char> dst)
+    {
+        const auto size = base64_encoded_size(src.size());
+        if(dst.size() < size) { throw std::invalid_argument("Base64 output buffer is too small."); }
+
+        const auto& alphabet = detail::base64_alphabet;
+        auto i = 0uz, o = 0uz;
+
+        for(; i + 3uz <= src.size(); i += 3uz, o += 4uz)
+        {
+            const auto bits = (uint32_t{src[i]} << 16u) | (uint32_t{src[i + 1uz]} << 8u) | uint32_t{src[i + 2uz]};
+
+            dst[o] = alphabet[(bits >> 18u) & 63u];
+            dst[o + 1uz] = alphabet[(bits >> 12u) & 63u];
+            dst[o + 2uz] = alphabet[(bits >> 6u) & 63u];
+            dst[o + 3uz] = alphabet[bits & 63u];
+        }
+
+        if(const auto left = src.size() - i; left > 0uz)
+        {
+            const auto bits = (uint32_t{src[i]} << 16u) | (left == 2uz ? uint32_t{src[i + 1uz]} << 8u : 0u);
+
+            dst[o] = alphabet[(bits >> 18u) & 63u];
+            dst[o + 1uz] = alphabet[(bits >> 12u) & 63u];
+            dst[o + 2uz] = left == 2uz ? alphabet[(bits >> 6u) & 63u] : '=';
+            dst[o + 3uz] = '=';
+        }
+
+        return size;
+    }
+
+    [[nodiscard]] inline std::string base64_encode(std::span<const uint8_t> src)
+    {
+        auto out = std::string(base64_encoded_size(src.size()), '\0');
+        base64_encode(src, out);
+        return out;
+    }
+
+    /**
+     * @brief Decodes 'src' into 'dst', skipping whitespace. Returns the number of bytes written, or nothing if src
+     * holds anything but base64 and whitespace, is cut short or does not fit in dst.
+     */
+    [[nodiscard]] inline std::optional<size_t> base64_decode(std::string_view src, std::span<uint8_t> dst)
+    {
+        const auto& values = detail::base64_values;
+
+        auto bits = uint32_t{0u};
+        auto count = 0uz, o = 0uz, padding = 0uz;
+
+        for(auto i = 0uz; i < src.size(); ++i)
+        {
+            // Whole groups of plain characters skip the bookkeeping below, which only whitespace and padding need.
+            while(count == 0uz && padding == 0uz && i + 4uz <= src.size() && o + 3uz <= dst.size())
+            {
+                const auto a = values[static_cast<uint8_t>(src[i])], b = values[static_cast<uint8_t>(src[i + 1uz])];
+                const auto c = values[static_cast<uint8_t>(src[i + 2uz])], d = values[static_cast<uint8_t>(src[i + 3uz])];
+
+                if((a | b | c | d) >= 64u) { break; }
+
+                const auto group = (uint32_t{a} << 18u) | (uint32_t{b} << 12u) | (uint32_t{c} << 6u) | uint32_t{d};
+                dst[o] = static_cast<uint8_t>(group >> 16u);
+                dst[o + 1uz] = static_cast<uint8_t>(group >> 8u);
+                dst[o + 2uz] = static_cast<uint8_t>(group);
+
+                i += 4uz;
+                o += 3uz;
+            }
+
+            if(i == src.size()) { break; }
+
+            const auto value = values[static_cast<uint8_t>(src[i])];
+
+            if(value == detail::base64_skip) { continue; }
+            if(value == detail::base64_invalid) { return std::nullopt; }
+
+            if(value == detail::base64_pad)
+            {
+                ++padding;
+                bits <<= 6u;
+            }
+            else
+            {
+                if(padding > 0uz) { return std::nullopt; } // Data after padding.
+                bits = (bits << 6u) | value;
+            }
+
+            if(++count == 4uz)
+            {
+                const auto bytes = 3uz - padding;
+                if(padding > 2uz || o + bytes > dst.size()) { return std::nullopt; }
+
+                dst[o] = static_cast<uint8_t>(bits >> 16u);
+                if(bytes > 1uz) { dst[o + 1uz] = static_cast<uint8_t>(bits >> 8u); }
+                if(bytes > 2uz) { dst[o + 2uz] = static_cast<uint8_t>(bits); }
+
+                o += bytes;
+                bits = 0u;
+                count = 0uz;
+
+                if(padding > 0uz) { padding = 3uz; } // Only whitespace may follow.
+            }
+        }
+
+        if(count != 0uz) { return std::nullopt; }
+
+        return o;
+    }
+}
+
+#endif
@@ -0,0 +1,494 @@
+#ifndef PROTO_BIT_GRID_HPP
+#define PROTO_BIT_GRID_HPP
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__AVX2__)
+#define PROTO_BIT_GRID_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace proto
+{
+    // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    /**
+     * @brief A 2D grid with one bit per cell, such as walkability or occupancy.
+     *
+     * Every row starts on a 32-byte boundary and is padded to a multiple of four 64-bit words, so whole-grid
+     * operations can run four words at a time. Bit x of a row lives in word x / 64 at bit x % 64. Padding bits
+     * past the width are always kept clear.
+     *
+     * The AVX2 paths are compiled in when the translation unit is built with AVX2 enabled (PROTO_ENABLE_AVX2),
+     * otherwise the scalar paths are used.
+     */
+    class bit_grid
+    {
+    public:
+        using word_type = uint64_t;
+
+        static constexpr size_t npos = ~size_t{};
+        static constexpr size_t word_bits = 64uz;
+        static constexpr size_t row_word_multiple = 4uz;
+        static constexpr size_t row_alignment = 32uz;
+
+        bit_grid() = default;
+
+        bit_grid(size_t width, size_t height, bool value = false)
+        : _width(width), _height(height), _rowWords(padded_words(width)), _words(allocate(_rowWords * height))
+        {
+            fill(value);
+        }
+
+        bit_grid(const bit_grid& other)
+        : _width(other._width), _height(other._height), _rowWords(other._rowWords), _words(allocate(other.word_count()))
+        {
+            if(other.word_count() > 0uz) { std::memcpy(_words.get(), other._words.get(), other.word_count() * sizeof(word_type)); }
+        }
+
+        bit_grid(bit_grid&& other) noexcept
+        : _width(std::exchange(other._width, 0uz)), _height(std::exchange(other._height, 0uz)),
+          _rowWords(std::exchange(other._rowWords, 0uz)), _words(std::move(other._words))
+        {
+        }
+
+        bit_grid& operator=(const bit_grid& other)
+        {
+            if(this == &other) { return *this; }
+
+            auto temp = bit_grid{other};
+            *this = std::move(temp);
+            return *this;
+        }
+
+        bit_grid& operator=(bit_grid&& other) noexcept
+        {
+            if(this == &other) { return *this; }
+
+            _width = std::exchange(other._width, 0uz);
+            _height = std::exchange(other._height, 0uz);
+            _rowWords = std::exchange(other._rowWords, 0uz);
+            _words = std::move(other._words);
+            return *this;
+        }
+
+        ~bit_grid() = default;
+
+        [[nodiscard]] size_t width() const { return _width; }
+        [[nodiscard]] size_t height() const { return _height; }
+        [[nodiscard]] size_t words_per_row() const { return _rowWords; }
+        [[nodiscard]] size_t word_count() const { return _rowWords * _height; }
+        [[nodiscard]] bool empty() const { return _width == 0uz || _height == 0uz; }
+
+        [[nodiscard]] std::span<word_type> row(size_t y) { return { _words.get() + (y * _rowWords), _rowWords }; }
+        [[nodiscard]] std::span<const word_type> row(size_t y) const { return { _words.get() + (y * _rowWords), _rowWords }; }
+        [[nodiscard]] std::span<word_type> words() { return { _words.get(), word_count() }; }
+        [[nodiscard]] std::span<const word_type> words() const { return { _words.get(), word_count() }; }
+
+        [[nodiscard]] bool test(size_t x, size_t y) const
+        {
+            return ((word_at(x, y) >> (x % word_bits)) & 1u) != 0u;
+        }
+
+        [[nodiscard]] bool at(size_t x, size_t y) const
+        {
+            if(x >= _width || y >= _height) { throw std::out_of_range("Cell out of range."); }
+            return test(x, y);
+        }
+
+        void set(size_t x, size_t y, bool value = true)
+        {
+            const auto mask = word_type{1u} << (x % word_bits);
+            auto& word = word_at(x, y);
+            word = value ? (word | mask) : (word & ~mask);
+        }
+
+        void reset(size_t x, size_t y) { set(x, y, false); }
+        void flip(size_t x, size_t y) { word_at(x, y) ^= word_type{1u} << (x % word_bits); }
+
+        void fill(bool value)
+        {
+            if(word_count() == 0uz) { return; }
+
+            std::memset(_words.get(), value ? 0xFF : 0x00, word_count() * sizeof(word_type));
+            if(value) { clear_padding(); }
+        }
+
+        // Sets or clears every cell in [x, x + w) x [y, y + h). The rectangle is clipped to the grid.
+        void fill_rect(size_t x, size_t y, size_t w, size_t h, bool value)
+        {
+            const auto x1 = std::min(x + w, _width), y1 = std::min(y + h, _height);
+            if(x >= x1 || y >= y1) { return; }
+
+            for(auto r = y; r < y1; ++r)
+            {
+                for_span_words(x, x1, [&](size_t word, word_type mask) {
+                    auto& target = _words[(r * _rowWords) + word];
+                    target = value ? (target | mask) : (target & ~mask);
+                });
+            }
+        }
+
+        // Number of set cells.
+        [[nodiscard]] size_t count() const { return popcount(_words.get(), word_count()); }
+
+        [[nodiscard]] size_t count_row(size_t y) const { return popcount(_words.get() + (y * _rowWords), _rowWords); }
+
+        // Number of set cells in [x, x + w) x [y, y + h), clipped to the grid.
+        [[nodiscard]] size_t count_rect(size_t x, size_t y, size_t w, size_t h) const
+        {
+            const auto x1 = std::min(x + w, _width), y1 = std::min(y + h, _height);
+            if(x >= x1 || y >= y1) { return 0uz; }
+
+            auto total = 0uz;
+
+            for(auto r = y; r < y1; ++r)
+            {
+                for_span_words(x, x1, [&](size_t word, word_type mask) {
+                    total += static_cast<size_t>(std::popcount(_words[(r * _rowWords) + word] & mask));
+                });
+            }
+
+            return total;
+        }
+
+        // Fraction of cells that are set, in [0, 1].
+        [[nodiscard]] double density() const
+        {
+            return empty() ? 0.0 : static_cast<double>(count()) / (static_cast<double>(_width) * static_cast<double>(_height));
+        }
+
+        bit_grid& operator|=(const bit_grid& other) { combine(other, bit_op::bit_or); return *this; }
+        bit_grid& operator&=(const bit_grid& other) { combine(other, bit_op::bit_and); return *this; }
+        bit_grid& operator^=(const bit_grid& other) { combine(other, bit_op::bit_xor); return *this; }
+
+        // Clears every cell that is set in 'other'.
+        bit_grid& and_not(const bit_grid& other) { combine(other, bit_op::bit_and_not); return *this; }
+
+        void invert()
+        {
+            for(auto i = 0uz; i < word_count(); ++i) { _words[i] = ~_words[i]; }
+            clear_padding();
+        }
+
+        [[nodiscard]] bool operator==(const bit_grid& other) const
+        {
+            return _width == other._width && _height == other._height &&
+                (word_count() == 0uz || std::memcmp(_words.get(), other._words.get(), word_count() * sizeof(word_type)) == 0);
+        }
+
+        /**
+         * @brief Grows the set cells by 'radius' in every direction (a square structuring element), e.g. inflating
+         * obstacles by an agent's radius. Cells outside the grid count as clear.
+         */
+        void dilate(size_t radius) { morph(radius, false); }
+
+        /**
+         * @brief Shrinks the set cells by 'radius' in every direction. Cells outside the grid count as set, so the
+         * grid border does not eat into regions that touch it.
+         */
+        void erode(size_t radius) { morph(radius, true); }
+
+        // First set cell at or after x in row y, or npos.
+        [[nodiscard]] size_t next_set(size_t x, size_t y) const { return scan_row(x, y, 0u); }
+
+        // First clear cell at or after x in row y, or npos.
+        [[nodiscard]] size_t next_clear(size_t x, size_t y) const { return scan_row(x, y, ~word_type{}); }
+
+        // First set cell at or below y in column x, or npos.
+        [[nodiscard]] size_t next_set_in_column(size_t x, size_t y) const { return scan_column(x, y, true); }
+
+        // First clear cell at or below y in column x, or npos.
+        [[nodiscard]] size_t next_clear_in_column(size_t x, size_t y) const { return scan_column(x, y, false); }
+
+    private:
+        struct aligned_delete
+        {
+            void operator()(word_type* ptr) const { ::operator delete(ptr, std::align_val_t{row_alignment}); }
+        };
+
+        using storage = std::unique_ptr<word_type[], aligned_delete>; // NOLINT(cppcoreguidelines-avoid-c-arrays)
+
+        [[nodiscard]] static size_t padded_words(size_t width)
+        {
+            const auto words = (width + word_bits - 1uz) / word_bits;
+            return ((words + row_word_multiple - 1uz) / row_word_multiple) * row_word_multiple;
+        }
+
+        [[nodiscard]] static storage allocate(size_t words)
+        {
+            if(words == 0uz) { return storage{}; }
+            return storage{ static_cast<word_type*>(::operator new(words * sizeof(word_type), std::align_val_t{row_alignment})) };
+        }
+
+        [[nodiscard]] word_type& word_at(size_t x, size_t y) { return _words[(y * _rowWords) + (x / word_bits)]; }
+        [[nodiscard]] const word_type& word_at(size_t x, size_t y) const { return _words[(y * _rowWords) + (x / word_bits)]; }
+
+        // Mask of the valid bits in the last used word of a row. All ones when the width is a multiple of 64.
+        [[nodiscard]] word_type tail_mask() const
+        {
+            const auto bits = _width % word_bits;
+            return (bits == 0uz) ? ~word_type{} : ((word_type{1u} << bits) - 1u);
+        }
+
+        void clear_padding()
+        {
+            const auto used = (_width + word_bits - 1uz) / word_bits;
+            if(used == 0uz) { return; }
+
+            for(auto y = 0uz; y < _height; ++y)
+            {
+                auto* r = _words.get() + (y * _rowWords);
+                r[used - 1uz] &= tail_mask();
+                std::fill(r + used, r + _rowWords, word_type{});
+            }
+        }
+
+        // Calls func(wordIndex, mask) for each word overlapping the cells [x0, x1) of a row.
+        template <typename Func>
+        static void for_span_words(size_t x0, size_t x1, Func&& func)
+        {
+            const auto first = x0 / word_bits, last = (x1 - 1uz) / word_bits;
+
+            for(auto w = first; w <= last; ++w)
+            {
+                auto mask = ~word_type{};
+                if(w == first) { mask &= ~word_type{} << (x0 % word_bits); }
+                if(w == last && (x1 % word_bits) != 0uz) { mask &= (word_type{1u} << (x1 % word_bits)) - 1u; }
+
+                func(w, mask);
+            }
+        }
+
+        [[nodiscard]] static size_t popcount(const word_type* words, size_t count)
+        {
+            auto total = 0uz, i = 0uz;
+
+#ifdef PROTO_BIT_GRID_AVX2
+            // Nibble lookup popcount, summed per 64-bit lane with SAD.
+            const auto lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+            const auto low = _mm256_set1_epi8(0x0F);
+            auto acc = _mm256_setzero_si256();
+
+            for(; i + 4uz <= count; i += 4uz)
+            {
+                const auto v = _mm256_load_si256(reinterpret_cast<const __m256i*>(words + i)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+                const auto lo = _mm256_shuffle_epi8(lookup, _mm256_and_si256(v, low));
+                const auto hi = _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(v, 4), low));
+                acc = _mm256_add_epi64(acc, _mm256_sad_epu8(_mm256_add_epi8(lo, hi), _mm256_setzero_si256()));
+            }
+
+            total += static_cast<size_t>(_mm256_extract_epi64(acc, 0) + _mm256_extract_epi64(acc, 1) + _mm256_extract_epi64(acc, 2) + _mm256_extract_epi64(acc, 3));
+#endif
+
+            for(; i < count; ++i) { total += static_cast<size_t>(std::popcount(words[i])); }
+
+            return total;
+        }
+
+        enum class bit_op : uint8_t { bit_or, bit_and, bit_xor, bit_and_not };
+
+        [[nodiscard]] static word_type apply(bit_op op, word_type a, word_type b)
+        {
+            switch(op)
+            {
+                case bit_op::bit_or: return a | b;
+                case bit_op::bit_and: return a & b;
+                case bit_op::bit_xor: return a ^ b;
+                case bit_op::bit_and_not: return a & ~b;
+            }
+
+            return a;
+        }
+
+#ifdef PROTO_BIT_GRID_AVX2
+        [[nodiscard]] static __m256i apply(bit_op op, __m256i a, __m256i b)
+        {
+            switch(op)
+            {
+                case bit_op::bit_or: return _mm256_or_si256(a, b);
+                case bit_op::bit_and: return _mm256_and_si256(a, b);
+                case bit_op::bit_xor: return _mm256_xor_si256(a, b);
+                case bit_op::bit_and_not: return _mm256_andnot_si256(b, a);
+            }
+
+            return a;
+        }
+#endif
+
+        void combine(const bit_grid& other, bit_op op)
+        {
+            if(other._width != _width || other._height != _height) { throw std::invalid_argument("bit_grid sizes do not match."); }
+
+            auto* dst = _words.get();
+            const auto* src = other._words.get();
+            const auto count = word_count();
+            auto i = 0uz;
+
+#ifdef PROTO_BIT_GRID_AVX2
+            for(; i + 4uz <= count; i += 4uz)
+            {
+                const auto a = _mm256_load_si256(reinterpret_cast<const __m256i*>(dst + i)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+                const auto b = _mm256_load_si256(reinterpret_cast<const __m256i*>(src + i)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+                _mm256_store_si256(reinterpret_cast<__m256i*>(dst + i), apply(op, a, b)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+            }
+#endif
+
+            for(; i < count; ++i) { dst[i] = apply(op, dst[i], src[i]); }
+        }
+
+        /*
+            The square structuring element is separable: a horizontal pass over each row, then a vertical pass
+            that combines 2r + 1 rows. Dilation ORs, erosion ANDs.
+        */
+        void morph(size_t radius, bool shrink)
+        {
+            if(radius == 0uz || empty()) { return; }
+
+            const auto used = (_width + word_bits - 1uz) / word_bits;
+            auto horizontal = bit_grid{*this};
+
+            // Bits shifted in from outside the grid: clear for dilation, set for erosion.
+            const word_type outside = shrink ? ~word_type{} : word_type{};
+
+            for(auto y = 0uz; y < _height; ++y)
+            {
+                auto* src = _words.get() + (y * _rowWords);
+                auto* dst = horizontal._words.get() + (y * _rowWords);
+
+                // Pad the bits past the width so they behave as outside cells during the shifts.
+                if(shrink) { src[used - 1uz] |= ~tail_mask(); }
+
+                for(auto w = 0uz; w < used; ++w)
+                {
+                    auto acc = src[w];
+
+                    for(auto k = 1uz; k <= radius; ++k)
+                    {
+                        const auto left = shift_toward_high(src, used, w, k, outside);
+                        const auto right = shift_toward_low(src, used, w, k, outside);
+                        acc = shrink ? (acc & left & right) : (acc | left | right);
+                    }
+
+                    dst[w] = acc;
+                }
+
+                if(shrink) { src[used - 1uz] &= tail_mask(); }
+            }
+
+            horizontal.clear_padding();
+
+            for(auto y = 0uz; y < _height; ++y)
+            {
+                auto* dst = _words.get() + (y * _rowWords);
+                std::memcpy(dst, horizontal._words.get() + (y * _rowWords), _rowWords * sizeof(word_type));
+
+                const auto top = (y >= radius) ? y - radius : 0uz;
+                const auto bottom = std::min(y + radius, _height - 1uz);
+
+                // Rows past the grid edge only matter for erosion, where they are all set and so change nothing.
+                for(auto r = top; r <= bottom; ++r)
+                {
+                    if(r == y) { continue; }
+
+                    const auto* src = horizontal._words.get() + (r * _rowWords);
+                    vertical_op(dst, src, shrink);
+                }
+            }
+
+            clear_padding();
+        }
+
+        // Combines two whole rows. Rows are padded to four words and 32-byte aligned, so AVX2 needs no tail loop.
+        void vertical_op(word_type* dst, const word_type* src, bool shrink) const
+        {
+#ifdef PROTO_BIT_GRID_AVX2
+            for(auto i = 0uz; i < _rowWords; i += 4uz)
+            {
+                const auto a = _mm256_load_si256(reinterpret_cast<const __m256i*>(dst + i)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+                const auto b = _mm256_load_si256(reinterpret_cast<const __m256i*>(src + i)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+                _mm256_store_si256(reinterpret_cast<__m256i*>(dst + i), apply(shrink ? bit_op::bit_and : bit_op::bit_or, a, b)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+            }
+#else
+            for(auto i = 0uz; i < _rowWords; ++i) { dst[i] = shrink ? (dst[i] & src[i]) : (dst[i] | src[i]); }
+#endif
+        }
+
+        [[nodiscard]] static word_type fetch(const word_type* row, size_t used, ptrdiff_t index, word_type outside)
+        {
+            return (index < 0 || static_cast<size_t>(index) >= used) ? outside : row[index];
+        }
+
+        // Cell x receives the bit of cell x - k.
+        [[nodiscard]] static word_type shift_toward_high(const word_type* row, size_t used, size_t w, size_t k, word_type outside)
+        {
+            const auto words = static_cast<ptrdiff_t>(k / word_bits);
+            const auto bits = k % word_bits;
+            const auto index = static_cast<ptrdiff_t>(w) - words;
+            const auto cur = fetch(row, used, index, outside), prev = fetch(row, used, index - 1, outside);
+
+            return (bits == 0uz) ? cur : ((cur << bits) | (prev >> (word_bits - bits)));
+        }
+
+        // Cell x receives the bit of cell x + k.
+        [[nodiscard]] static word_type shift_toward_low(const word_type* row, size_t used, size_t w, size_t k, word_type outside)
+        {
+            const auto words = static_cast<ptrdiff_t>(k / word_bits);
+            const auto bits = k % word_bits;
+            const auto index = static_cast<ptrdiff_t>(w) + words;
+            const auto cur = fetch(row, used, index, outside), next = fetch(row, used, index + 1, outside);
+
+            return (bits == 0uz) ? cur : ((cur >> bits) | (next << (word_bits - bits)));
+        }
+
+        [[nodiscard]] size_t scan_row(size_t x, size_t y, word_type invert) const
+        {
+            if(x >= _width || y >= _height) { return npos; }
+
+            const auto* r = _words.get() + (y * _rowWords);
+            const auto used = (_width + word_bits - 1uz) / word_bits;
+            auto w = x / word_bits;
+            auto bits = (r[w] ^ invert) & (~word_type{} << (x % word_bits));
+
+            while(true)
+            {
+                if(bits != 0u)
+                {
+                    const auto found = (w * word_bits) + static_cast<size_t>(std::countr_zero(bits));
+                    return (found < _width) ? found : npos;
+                }
+
+                if(++w >= used) { return npos; }
+                bits = r[w] ^ invert;
+            }
+        }
+
+        [[nodiscard]] size_t scan_column(size_t x, size_t y, bool value) const
+        {
+            if(x >= _width) { return npos; }
+
+            const auto word = x / word_bits, bit = x % word_bits;
+
+            for(auto r = y; r < _height; ++r)
+            {
+                if((((_words[(r * _rowWords) + word] >> bit) & 1u) != 0u) == value) { return r; }
+            }
+
+            return npos;
+        }
+
+        size_t _width{}, _height{}, _rowWords{};
+        storage _words;
+    };
+    // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+}
+
+#endif
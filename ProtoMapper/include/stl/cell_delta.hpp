@@ -0,0 +1,147 @@
+#ifndef PROTO_CELL_DELTA_HPP
+#define PROTO_CELL_DELTA_HPP
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/**
+ * @brief The compact before/after encoding the undo journal stores edits in.
+ *
+ * Numbers are LEB128 varints. A delta between two equally sized blocks of cells is a list of runs, one per stretch
+ * of cells that changed: the cells skipped since the previous run, the run's length, then its old values and its
+ * new values, each as (value, count) pairs. A fill writes a handful of bytes however many cells it covers, and
+ * applying either side only rewrites the cells inside the runs.
+ */
+namespace proto
+{
+    inline void put_varint(std::vector<uint8_t>& out, uint64_t value)
+    {
+        for(; value >= 0x80u; value >>= 7u) { out.push_back(static_cast<uint8_t>(value | 0x80u)); }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    /**
+     * @brief Reads back what put_varint() wrote. Running out of data, or a value past 64 bits, fails the reader for
+     * good and every later next() returns 0.
+     */
+    class varint_reader
+    {
+    public:
+        explicit varint_reader(std::span<const uint8_t> data) : _data(data) {}
+
+        [[nodiscard]] uint64_t next()
+        {
+            auto value = uint64_t{0u};
+
+            for(auto shift = 0u; !_failed; shift += 7u)
+            {
+                if(_pos == _data.size() || shift > 63u) { break; }
+
+                const auto byte = _data[_pos++];
+                value |= uint64_t{byte & 0x7Fu} << shift;
+
+                if((byte & 0x80u) == 0u) { return value; }
+            }
+
+            _failed = true;
+            return 0u;
+        }
+
+        [[nodiscard]] bool done() const { return _failed || _pos == _data.size(); }
+        [[nodiscard]] bool failed() const { return _failed; }
+
+    private:
+        std::span<const uint8_t> _data;
+        size_t _pos = 0uz;
+        bool _failed = false;
+    };
+
+    // Appends 'cells' as (value, count) pairs.
+    template <std::unsigned_integral T>
+    void put_value_runs(std::vector<uint8_t>& out, std::span<const T> cells)
+    {
+        for(auto i = 0uz; i < cells.size();)
+        {
+            auto end = i + 1uz;
+            while(end < cells.size() && cells[end] == cells[i]) { ++end; }
+
+            put_varint(out, cells[i]);
+            put_varint(out, end - i);
+            i = end;
+        }
+    }
+
+    /**
+     * @brief Appends the runs where 'before' and 'after' differ and returns how many there were. Nothing is appended
+     * when they are equal. Both spans must be the same size.
+     */
+    template <std::unsigned_integral T>
+    size_t put_cell_delta(std::vector<uint8_t>& out, std::span<const T> before, std::span<const T> after)
+    {
+        const auto size = std::min(before.size(), after.size());
+        auto count = 0uz, last = 0uz;
+
+        for(auto i = 0uz; i < size;)
+        {
+            if(before[i] == after[i]) { ++i; continue; }
+
+            auto end = i + 1uz;
+            while(end < size && before[end] != after[end]) { ++end; }
+
+            put_varint(out, i - last);
+            put_varint(out, end - i);
+            put_value_runs(out, before.subspan(i, end - i));
+            put_value_runs(out, after.subspan(i, end - i));
+
+            ++count;
+            last = i = end;
+        }
+
+        return count;
+    }
+
+    /**
+     * @brief Reads 'runs' runs written by put_cell_delta() and writes their old values into 'cells', or their new
+     * ones with 'redo'. Returns false if the data is cut short or a run falls outside 'cells', which may then be
+     * partly written.
+     */
+    template <std::unsigned_integral T>
+    [[nodiscard]] bool apply_cell_delta(varint_reader& reader, uint64_t runs, std::span<T> cells, bool redo)
+    {
+        auto cell = 0uz;
+
+        for(auto run = uint64_t{0u}; run < runs && !reader.failed(); ++run)
+        {
+            cell += reader.next();
+            const auto length = reader.next();
+
+            if(cell > cells.size() || length > cells.size() - cell) { return false; }
+
+            // Old values first, then new ones. Only one side is written, the other is skipped.
+            for(const auto side : { false, true })
+            {
+                for(auto at = cell, left = static_cast<size_t>(length); left > 0uz;)
+                {
+                    const auto value = static_cast<T>(reader.next());
+                    const auto count = reader.next();
+
+                    if(count == 0u || count > left) { return false; }
+                    if(side == redo) { std::fill_n(cells.begin() + static_cast<std::ptrdiff_t>(at), count, value); }
+
+                    at += count;
+                    left -= count;
+                }
+            }
+
+            cell += length;
+        }
+
+        return !reader.failed();
+    }
+}
+
+#endif
@@ -0,0 +1,528 @@
+#ifndef PROTO_FLAT_HASH_MAP_HPP
+#define PROTO_FLAT_HASH_MAP_HPP
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PROTO_HASH_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#include <hash.hpp>
+
+namespace proto
+{
+    namespace detail
+    {
+        /*
+            One control byte per slot. The high bit marks a slot as not in use, a full slot stores the low 7 bits
+            of the key's hash, so most mismatches are rejected without touching the slot itself.
+        */
+        using ctrl_t = int8_t;
+
+        inline constexpr ctrl_t ctrl_empty = -128; // 0b10000000
+        inline constexpr ctrl_t ctrl_deleted = -2; // 0b11111110
+        inline constexpr size_t group_width = 16uz;
+
+        // A set of slot positions inside a group, one bit per slot.
+        class group_mask
+        {
+        public:
+            constexpr explicit group_mask(uint32_t mask) : _mask(mask) {}
+
+            [[nodiscard]] constexpr explicit operator bool() const { return _mask != 0u; }
+            [[nodiscard]] constexpr size_t lowest() const { return static_cast<size_t>(std::countr_zero(_mask)); }
+            constexpr void pop() { _mask &= (_mask - 1u); }
+
+        private:
+            uint32_t _mask;
+        };
+
+        // Scans 16 control bytes at a time. Falls back to a plain loop when SSE2 is not available.
+        class group
+        {
+        public:
+            explicit group(const ctrl_t* pos)
+            {
+#ifdef PROTO_HASH_SSE2
+                _ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+#else
+                std::memcpy(_ctrl, pos, group_width);
+#endif
+            }
+
+            [[nodiscard]] group_mask match(ctrl_t h2) const
+            {
+#ifdef PROTO_HASH_SSE2
+                return group_mask{static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), _ctrl)))};
+#else
+                return scalar_match([h2](ctrl_t c) { return c == h2; });
+#endif
+            }
+
+            [[nodiscard]] group_mask match_empty() const
+            {
+#ifdef PROTO_HASH_SSE2
+                return match(ctrl_empty);
+#else
+                return scalar_match([](ctrl_t c) { return c == ctrl_empty; });
+#endif
+            }
+
+            // Empty and deleted slots both have the high bit set.
+            [[nodiscard]] group_mask match_free() const
+            {
+#ifdef PROTO_HASH_SSE2
+                return group_mask{static_cast<uint32_t>(_mm_movemask_epi8(_ctrl))};
+#else
+                return scalar_match([](ctrl_t c) { return c < 0; });
+#endif
+            }
+
+        private:
+#ifdef PROTO_HASH_SSE2
+            __m128i _ctrl;
+#else
+            template <typename Pred>
+            [[nodiscard]] group_mask scalar_match(Pred pred) const
+            {
+                uint32_t mask = 0u;
+
+                for(auto i = 0uz; i < group_width; ++i)
+                {
+                    if(pred(_ctrl[i])) { mask |= (1u << i); }
+                }
+
+                return group_mask{mask};
+            }
+
+            ctrl_t _ctrl[group_width]; // NOLINT(cppcoreguidelines-avoid-c-arrays)
+#endif
+        };
+    }
+
+    // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    /**
+     * @brief An open addressing hash map in the style of Swiss tables. Slots live in one flat array next to a
+     * control byte array that is probed a 16-byte group at a time.
+     *
+     * Pointers and iterators are invalidated whenever the table grows. Lookups are heterogeneous when the
+     * hasher is transparent, see proto::hash<std::string>.
+     *
+     * @tparam K The key type.
+     * @tparam V The mapped type.
+     */
+    template <typename K, typename V, typename Hash = proto::hash<K>, typename Eq = std::equal_to<>>
+    class flat_hash_map
+    {
+    public:
+        using key_type = K;
+        using mapped_type = V;
+        using value_type = std::pair<const K, V>;
+
+        template <bool Const>
+        class basic_iterator
+        {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using difference_type = std::ptrdiff_t;
+            using value_type = flat_hash_map::value_type;
+            using reference = std::conditional_t<Const, const value_type&, value_type&>;
+            using pointer = std::conditional_t<Const, const value_type*, value_type*>;
+
+            constexpr basic_iterator() = default;
+            constexpr basic_iterator(const detail::ctrl_t* ctrl, value_type* slot, const detail::ctrl_t* end)
+            : _ctrl(ctrl), _slot(slot), _end(end)
+            {
+                skip_free();
+            }
+
+            // Allows iterator -> const_iterator.
+            constexpr basic_iterator(const basic_iterator<!Const>& other) requires Const // NOLINT(google-explicit-constructor)
+            : _ctrl(other._ctrl), _slot(other._slot), _end(other._end)
+            {
+            }
+
+            constexpr reference operator*() const { return *_slot; }
+            constexpr pointer operator->() const { return _slot; }
+
+            constexpr basic_iterator& operator++()
+            {
+                ++_ctrl;
+                ++_slot;
+                skip_free();
+                return *this;
+            }
+
+            constexpr basic_iterator operator++(int) // NOLINT
+            {
+                auto temp = *this;
+                ++(*this);
+                return temp;
+            }
+
+            constexpr bool operator==(const basic_iterator& other) const { return _ctrl == other._ctrl; }
+
+        private:
+            friend class flat_hash_map;
+            friend class basic_iterator<true>;
+
+            constexpr void skip_free()
+            {
+                while(_ctrl != _end && *_ctrl < 0)
+                {
+                    ++_ctrl;
+                    ++_slot;
+                }
+            }
+
+            const detail::ctrl_t* _ctrl = nullptr;
+            value_type* _slot = nullptr;
+            const detail::ctrl_t* _end = nullptr;
+        };
+
+        using iterator = basic_iterator<false>;
+        using const_iterator = basic_iterator<true>;
+
+        flat_hash_map() = default;
+
+        explicit flat_hash_map(size_t capacity) { reserve(capacity); }
+
+        flat_hash_map(std::initializer_list<value_type> init)
+        {
+            reserve(init.size());
+
+            for(const auto& item : init) { try_emplace(item.first, item.second); }
+        }
+
+        flat_hash_map(const flat_hash_map& other)
+        {
+            reserve(other.size());
+
+            for(const auto& item : other) { try_emplace(item.first, item.second); }
+        }
+
+        flat_hash_map(flat_hash_map&& other) noexcept
+        : _ctrl(std::exchange(other._ctrl, nullptr)), _slots(std::exchange(other._slots, nullptr)),
+          _capacity(std::exchange(other._capacity, 0uz)), _size(std::exchange(other._size, 0uz)),
+          _growthLeft(std::exchange(other._growthLeft, 0uz))
+        {
+        }
+
+        flat_hash_map& operator=(const flat_hash_map& other)
+        {
+            if(this == &other) { return *this; }
+
+            auto temp = flat_hash_map{other};
+            swap(temp);
+            return *this;
+        }
+
+        flat_hash_map& operator=(flat_hash_map&& other) noexcept
+        {
+            if(this == &other) { return *this; }
+
+            destroy();
+            swap(other);
+            return *this;
+        }
+
+        ~flat_hash_map() { destroy(); }
+
+        void swap(flat_hash_map& other) noexcept
+        {
+            std::swap(_ctrl, other._ctrl);
+            std::swap(_slots, other._slots);
+            std::swap(_capacity, other._capacity);
+            std::swap(_size, other._size);
+            std::swap(_growthLeft, other._growthLeft);
+        }
+
+        [[nodiscard]] iterator begin() { return iterator{_ctrl, _slots, _ctrl + _capacity}; }
+        [[nodiscard]] iterator end() { return iterator{_ctrl + _capacity, _slots + _capacity, _ctrl + _capacity}; }
+        [[nodiscard]] const_iterator begin() const { return const_iterator{_ctrl, _slots, _ctrl + _capacity}; }
+        [[nodiscard]] const_iterator end() const { return const_iterator{_ctrl + _capacity, _slots + _capacity, _ctrl + _capacity}; }
+        [[nodiscard]] const_iterator cbegin() const { return begin(); }
+        [[nodiscard]] const_iterator cend() const { return end(); }
+
+        [[nodiscard]] size_t size() const { return _size; }
+        [[nodiscard]] size_t capacity() const { return _capacity; }
+        [[nodiscard]] bool empty() const { return _size == 0uz; }
+
+        template <typename Q>
+        [[nodiscard]] iterator find(const Q& key)
+        {
+            const auto pos = find_index(key, Hash{}(key));
+            return (pos == npos) ? end() : iterator_at(pos);
+        }
+
+        template <typename Q>
+        [[nodiscard]] const_iterator find(const Q& key) const
+        {
+            const auto pos = find_index(key, Hash{}(key));
+            return (pos == npos) ? end() : const_iterator{iterator_at(pos)};
+        }
+
+        template <typename Q>
+        [[nodiscard]] bool contains(const Q& key) const { return find_index(key, Hash{}(key)) != npos; }
+
+        template <typename Q>
+        [[nodiscard]] V& at(const Q& key)
+        {
+            const auto pos = find_index(key, Hash{}(key));
+            if(pos == npos) { throw std::out_of_range("Key not found in flat_hash_map."); }
+            return _slots[pos].second;
+        }
+
+        template <typename Q>
+        [[nodiscard]] const V& at(const Q& key) const
+        {
+            const auto pos = find_index(key, Hash{}(key));
+            if(pos == npos) { throw std::out_of_range("Key not found in flat_hash_map."); }
+            return _slots[pos].second;
+        }
+
+        V& operator[](const K& key) { return try_emplace(key).first->second; }
+
+        template <typename Q, typename... Args>
+        std::pair<iterator, bool> try_emplace(Q&& key, Args&&... args)
+        {
+            const auto hash = Hash{}(key);
+
+            if(const auto pos = find_index(key, hash); pos != npos)
+            {
+                return { iterator_at(pos), false };
+            }
+
+            const auto pos = prepare_insert(hash);
+            std::construct_at(_slots + pos, std::piecewise_construct, std::forward_as_tuple(K(std::forward<Q>(key))), std::forward_as_tuple(std::forward<Args>(args)...));
+
+            return { iterator_at(pos), true };
+        }
+
+        template <typename Q, typename M>
+        std::pair<iterator, bool> insert_or_assign(Q&& key, M&& value)
+        {
+            auto result = try_emplace(std::forward<Q>(key), std::forward<M>(value));
+
+            if(!result.second) { result.first->second = std::forward<M>(value); }
+
+            return result;
+        }
+
+        template <typename Q>
+        size_t erase(const Q& key)
+        {
+            const auto pos = find_index(key, Hash{}(key));
+            if(pos == npos) { return 0uz; }
+
+            erase_at(pos);
+            return 1uz;
+        }
+
+        iterator erase(iterator it) { return erase(const_iterator{it}); }
+
+        iterator erase(const_iterator it)
+        {
+            const auto pos = static_cast<size_t>(it._ctrl - _ctrl);
+            erase_at(pos);
+
+            auto next = iterator_at(pos);
+            next.skip_free();
+            return next;
+        }
+
+        void clear()
+        {
+            for(auto i = 0uz; i < _capacity; ++i)
+            {
+                if(_ctrl[i] >= 0) { std::destroy_at(_slots + i); }
+            }
+
+            if(_capacity > 0uz) { std::memset(_ctrl, detail::ctrl_empty, _capacity); }
+
+            _size = 0uz;
+            _growthLeft = max_load(_capacity);
+        }
+
+        // Makes room for at least 'count' elements without another rehash.
+        void reserve(size_t count)
+        {
+            auto wanted = detail::group_width;
+
+            while(max_load(wanted) < count) { wanted *= 2uz; }
+
+            if(wanted > _capacity) { rehash(wanted); }
+        }
+
+    private:
+        static constexpr size_t npos = ~size_t{};
+
+        // Tables are kept at most 7/8 full.
+        [[nodiscard]] static constexpr size_t max_load(size_t capacity) { return capacity - (capacity / 8uz); }
+
+        [[nodiscard]] static constexpr size_t h1(uint64_t hash) { return static_cast<size_t>(hash >> 7u); }
+        [[nodiscard]] static constexpr detail::ctrl_t h2(uint64_t hash) { return static_cast<detail::ctrl_t>(hash & 0x7Fu); }
+
+        [[nodiscard]] iterator iterator_at(size_t pos) const
+        {
+            auto it = iterator{};
+            it._ctrl = _ctrl + pos;
+            it._slot = _slots + pos;
+            it._end = _ctrl + _capacity;
+            return it;
+        }
+
+        /*
+            Probing moves between whole groups with a triangular step, which visits every group exactly once
+            because the group count is a power of two. A group with an empty slot ends the search.
+        */
+        template <typename Q>
+        [[nodiscard]] size_t find_index(const Q& key, uint64_t hash) const
+        {
+            if(_capacity == 0uz) { return npos; }
+
+            const auto groupMask = (_capacity / detail::group_width) - 1uz;
+            auto index = h1(hash) & groupMask;
+            const auto tag = h2(hash);
+
+            for(auto step = 1uz; step <= groupMask + 1uz; ++step)
+            {
+                const auto base = index * detail::group_width;
+                const auto g = detail::group{_ctrl + base};
+
+                for(auto m = g.match(tag); m; m.pop())
+                {
+                    const auto pos = base + m.lowest();
+                    if(Eq{}(_slots[pos].first, key)) { return pos; }
+                }
+
+                if(g.match_empty()) { return npos; }
+
+                index = (index + step) & groupMask;
+            }
+
+            return npos;
+        }
+
+        [[nodiscard]] size_t find_free(uint64_t hash) const
+        {
+            const auto groupMask = (_capacity / detail::group_width) - 1uz;
+            auto index = h1(hash) & groupMask;
+
+            for(auto step = 1uz;; ++step)
+            {
+                const auto base = index * detail::group_width;
+
+                if(auto m = detail::group{_ctrl + base}.match_free(); m)
+                {
+                    return base + m.lowest();
+                }
+
+                index = (index + step) & groupMask;
+            }
+        }
+
+        [[nodiscard]] size_t prepare_insert(uint64_t hash)
+        {
+            if(_growthLeft == 0uz)
+            {
+                // Mostly tombstones means a same-size rehash is enough to clean them up.
+                rehash((_size * 2uz <= max_load(_capacity)) ? std::max(_capacity, detail::group_width) : std::max(_capacity * 2uz, detail::group_width));
+            }
+
+            const auto pos = find_free(hash);
+
+            if(_ctrl[pos] == detail::ctrl_empty) { --_growthLeft; }
+
+            _ctrl[pos] = h2(hash);
+            ++_size;
+
+            return pos;
+        }
+
+        void erase_at(size_t pos)
+        {
+            std::destroy_at(_slots + pos);
+            --_size;
+
+            /*
+                If the group still has an empty slot, no probe has ever walked past it, so the slot can go
+                straight back to empty instead of leaving a tombstone.
+            */
+            const auto base = pos - (pos % detail::group_width);
+
+            if(detail::group{_ctrl + base}.match_empty())
+            {
+                _ctrl[pos] = detail::ctrl_empty;
+                ++_growthLeft;
+            }
+            else
+            {
+                _ctrl[pos] = detail::ctrl_deleted;
+            }
+        }
+
+        void rehash(size_t newCapacity)
+        {
+            auto* oldCtrl = _ctrl;
+            auto* oldSlots = _slots;
+            const auto oldCapacity = _capacity;
+
+            _ctrl = static_cast<detail::ctrl_t*>(::operator new(newCapacity));
+            _slots = static_cast<value_type*>(::operator new(newCapacity * sizeof(value_type), std::align_val_t{alignof(value_type)}));
+            _capacity = newCapacity;
+            _growthLeft = max_load(newCapacity) - _size;
+
+            std::memset(_ctrl, detail::ctrl_empty, newCapacity);
+
+            for(auto i = 0uz; i < oldCapacity; ++i)
+            {
+                if(oldCtrl[i] < 0) { continue; }
+
+                const auto hash = Hash{}(oldSlots[i].first);
+                const auto pos = find_free(hash);
+
+                _ctrl[pos] = h2(hash);
+                std::construct_at(_slots + pos, std::move(oldSlots[i]));
+                std::destroy_at(oldSlots + i);
+            }
+
+            release(oldCtrl, oldSlots);
+        }
+
+        void destroy()
+        {
+            clear();
+            release(_ctrl, _slots);
+
+            _ctrl = nullptr;
+            _slots = nullptr;
+            _capacity = 0uz;
+            _growthLeft = 0uz;
+        }
+
+        static void release(detail::ctrl_t* ctrl, value_type* slots)
+        {
+            ::operator delete(ctrl);
+            if(slots != nullptr) { ::operator delete(slots, std::align_val_t{alignof(value_type)}); }
+        }
+
+        detail::ctrl_t* _ctrl = nullptr;
+        value_type* _slots = nullptr;
+        size_t _capacity{}, _size{}, _growthLeft{};
+    };
+    // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+}
+
+#endif
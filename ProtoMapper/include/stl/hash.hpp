@@ -0,0 +1,167 @@
+#ifndef PROTO_HASH_HPP
+#define PROTO_HASH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace proto
+{
+    /**
+     * @brief Final avalanche step from MurmurHash3. Open addressing tables use both the low and high bits of a hash,
+     * so integer keys must be mixed before they are used.
+     */
+    [[nodiscard]] constexpr uint64_t hash_mix(uint64_t key)
+    {
+        key ^= key >> 33u;
+        key *= 0xff51afd7ed558ccdull;
+        key ^= key >> 33u;
+        key *= 0xc4ceb9fe1a85ec53ull;
+        key ^= key >> 33u;
+
+        return key;
+    }
+
+    // Folds another hash into a running seed. Order matters: combine(a, b) != combine(b, a).
+    [[nodiscard]] constexpr uint64_t hash_combine(uint64_t seed, uint64_t value)
+    {
+        return hash_mix(seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6u) + (seed >> 2u)));
+    }
+
+    namespace detail
+    {
+        // Little-endian read of 'Width' bytes. Byte assembly when constant evaluated, a single load otherwise.
+        template <typename Word>
+        [[nodiscard]] constexpr Word load_word(std::string_view str, size_t pos)
+        {
+            Word word = 0u;
+
+            if consteval
+            {
+                for(auto b = 0uz; b < sizeof(Word); ++b)
+                {
+                    word |= static_cast<Word>(static_cast<Word>(static_cast<uint8_t>(str[pos + b])) << (8uz * b));
+                }
+            }
+            else
+            {
+                std::memcpy(&word, str.data() + pos, sizeof(Word)); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            }
+
+            return word;
+        }
+    }
+
+    /**
+     * @brief Hashes a string eight bytes at a time. Usable in constant expressions, so string keys known at compile
+     * time cost nothing to hash. Runtime loads assume a little-endian target.
+     */
+    [[nodiscard]] constexpr uint64_t hash_string(std::string_view str)
+    {
+        constexpr uint64_t multiplier = 0xbf58476d1ce4e5b9ull;
+
+        const auto size = str.size();
+        auto hash = 0x9e3779b97f4a7c15ull ^ (static_cast<uint64_t>(size) * multiplier);
+        auto pos = 0uz;
+
+        for(; pos + 8uz <= size; pos += 8uz)
+        {
+            hash = (hash ^ detail::load_word<uint64_t>(str, pos)) * multiplier;
+            hash ^= hash >> 29u;
+        }
+
+        // The last 0-7 bytes are read as two overlapping words, or byte by byte when there are fewer than four.
+        const auto rest = size - pos;
+        uint64_t tail = 0u;
+
+        if(rest >= 4uz)
+        {
+            tail = detail::load_word<uint32_t>(str, pos) | (static_cast<uint64_t>(detail::load_word<uint32_t>(str, size - 4uz)) << 32u);
+        }
+        else if(rest > 0uz)
+        {
+            tail = (static_cast<uint64_t>(static_cast<uint8_t>(str[pos])) << 16u)
+                 | (static_cast<uint64_t>(static_cast<uint8_t>(str[pos + (rest / 2uz)])) << 8u)
+                 | static_cast<uint64_t>(static_cast<uint8_t>(str[size - 1uz]));
+        }
+
+        hash = (hash ^ tail) * multiplier;
+
+        return hash_mix(hash);
+    }
+
+    /**
+     * @brief A string view paired with its precomputed hash.
+     *
+     * Declare these as constexpr and the table lookup skips hashing entirely:
+     *      constexpr auto key = proto::hashed_string{"iconClose"};
+     */
+    class hashed_string
+    {
+    public:
+        constexpr hashed_string() = default;
+        constexpr hashed_string(const char* str) : _str(str), _hash(hash_string(_str)) {} // NOLINT(google-explicit-constructor)
+        constexpr hashed_string(std::string_view str) : _str(str), _hash(hash_string(_str)) {} // NOLINT(google-explicit-constructor)
+
+        [[nodiscard]] constexpr uint64_t hash() const { return _hash; }
+        [[nodiscard]] constexpr std::string_view view() const { return _str; }
+        constexpr operator std::string_view() const { return _str; } // NOLINT(google-explicit-constructor)
+
+        friend constexpr bool operator==(const hashed_string& lhs, std::string_view rhs) { return lhs._str == rhs; }
+
+    private:
+        std::string_view _str;
+        uint64_t _hash = hash_string({});
+    };
+
+    namespace literals
+    {
+        [[nodiscard]] consteval hashed_string operator""_hs(const char* str, size_t len) { return hashed_string{std::string_view{str, len}}; }
+    }
+
+    /*
+        Default hasher for the proto containers. Strings are transparent: std::string, std::string_view, const char*
+        and hashed_string all look up the same entry, and hashed_string never rehashes.
+    */
+    template <typename T>
+    struct hash
+    {
+        [[nodiscard]] constexpr uint64_t operator()(const T& key) const
+        {
+            if constexpr (std::is_enum_v<T>)
+            {
+                return hash_mix(static_cast<uint64_t>(static_cast<std::underlying_type_t<T>>(key)));
+            }
+            else if constexpr (std::is_integral_v<T>)
+            {
+                return hash_mix(static_cast<uint64_t>(key));
+            }
+            else if constexpr (std::is_pointer_v<T>)
+            {
+                return hash_mix(reinterpret_cast<uintptr_t>(key)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+            }
+            else
+            {
+                return hash_mix(static_cast<uint64_t>(std::hash<T>{}(key)));
+            }
+        }
+    };
+
+    template <>
+    struct hash<std::string>
+    {
+        using is_transparent = void;
+
+        [[nodiscard]] constexpr uint64_t operator()(std::string_view key) const { return hash_string(key); }
+        [[nodiscard]] constexpr uint64_t operator()(const char* key) const { return hash_string(key); }
+        [[nodiscard]] constexpr uint64_t operator()(const hashed_string& key) const { return key.hash(); }
+    };
+
+    template <>
+    struct hash<std::string_view> : hash<std::string> {};
+}
+
+#endif
@@ -0,0 +1,398 @@
+#ifndef PROTO_MIPMAP_HPP
+#define PROTO_MIPMAP_HPP
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include <parallel.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define PROTO_MIPMAP_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define PROTO_MIPMAP_NEON 1
+#include <arm_neon.h>
+#endif
+
+/**
+ * @brief CPU mip chain generation for RGBA8 images.
+ *
+ * Levels follow the GL sizing rule, each one is max(1, floor(previous / 2)) on both axes, so a chain can be handed
+ * straight to glTexStorage2D. The filters work on the stored values: premultiply an image with alpha first or the
+ * colour of transparent texels bleeds into the levels.
+ */
+namespace proto
+{
+    // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    enum class mip_filter : uint8_t
+    {
+        box,    // 2x2 average. Fast, softens a little and lets some aliasing through.
+        kaiser, // 8 tap Kaiser windowed sinc. Keeps detail and aliases far less, costs several times the box.
+    };
+
+    struct mip_level
+    {
+        uint32_t width = 0u, height = 0u;
+        std::vector<uint8_t> pixels;
+    };
+
+    /**
+     * @brief The number of levels in a full chain, down to and including 1x1.
+     */
+    [[nodiscard]] constexpr uint32_t mip_level_count(uint32_t width, uint32_t height)
+    {
+        return static_cast<uint32_t>(std::bit_width(std::max(width, height)));
+    }
+
+    [[nodiscard]] constexpr uint32_t mip_extent(uint32_t extent) { return std::max(extent / 2u, 1u); }
+
+    namespace detail
+    {
+        inline constexpr size_t mip_bytes_per_pixel = 4uz;
+
+        inline void check_mip_sizes(size_t src, uint32_t width, uint32_t height, size_t dst)
+        {
+            const auto expected = size_t{width} * size_t{height} * mip_bytes_per_pixel;
+            const auto next = size_t{mip_extent(width)} * size_t{mip_extent(height)} * mip_bytes_per_pixel;
+
+            if(width == 0u || height == 0u || src != expected || dst != next)
+            {
+                throw std::invalid_argument("Mip level sizes do not match.");
+            }
+        }
+
+        // Averages two rows of pixel pairs into 'count' pixels, rounding to nearest. Needs 2 * count source pixels.
+        inline void box_row(const uint8_t* top, const uint8_t* bottom, uint8_t* out, size_t count)
+        {
+            auto x = 0uz;
+
+#if defined(PROTO_MIPMAP_SSE2)
+            const auto zero = _mm_setzero_si128();
+            const auto two = _mm_set1_epi16(2);
+
+            // Eight source pixels in, four out.
+            for(; x + 4uz <= count; x += 4uz)
+            {
+                const auto sum = [&](size_t offset) {
+                    const auto a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(top + (x * 8uz) + offset)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+                    const auto b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bottom + (x * 8uz) + offset)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+
+                    // Rows added per channel, then neighbouring pixels added by pairing the 64-bit halves.
+                    const auto low = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+                    const auto high = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+                    const auto total = _mm_add_epi16(_mm_unpacklo_epi64(low, high), _mm_unpackhi_epi64(low, high));
+
+                    return _mm_srli_epi16(_mm_add_epi16(total, two), 2);
+                };
+
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + (x * 4uz)), _mm_packus_epi16(sum(0uz), sum(16uz))); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+            }
+#elif defined(PROTO_MIPMAP_NEON)
+            // Eight source pixels in, four out. vld2 splits even and odd pixels.
+            for(; x + 4uz <= count; x += 4uz)
+            {
+                const auto a = vld2q_u32(reinterpret_cast<const uint32_t*>(top + (x * 8uz))); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+                const auto b = vld2q_u32(reinterpret_cast<const uint32_t*>(bottom + (x * 8uz))); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+
+                const auto half = [](uint8x8_t p, uint8x8_t q, uint8x8_t r, uint8x8_t s) {
+                    return vrshrn_n_u16(vaddq_u16(vaddl_u8(p, q), vaddl_u8(r, s)), 2);
+                };
+
+                const auto ae = vreinterpretq_u8_u32(a.val[0]), ao = vreinterpretq_u8_u32(a.val[1]);
+                const auto be = vreinterpretq_u8_u32(b.val[0]), bo = vreinterpretq_u8_u32(b.val[1]);
+
+                vst1q_u8(out + (x * 4uz), vcombine_u8(half(vget_low_u8(ae), vget_low_u8(ao), vget_low_u8(be), vget_low_u8(bo)),
+                                                      half(vget_high_u8(ae), vget_high_u8(ao), vget_high_u8(be), vget_high_u8(bo))));
+            }
+#endif
+
+            for(; x < count; ++x)
+            {
+                for(auto c = 0uz; c < mip_bytes_per_pixel; ++c)
+                {
+                    const auto left = (x * 8uz) + c, right = left + mip_bytes_per_pixel;
+                    const auto sum = uint32_t{top[left]} + uint32_t{top[right]} + uint32_t{bottom[left]} + uint32_t{bottom[right]};
+                    out[(x * mip_bytes_per_pixel) + c] = static_cast<uint8_t>((sum + 2u) >> 2u);
+                }
+            }
+        }
+
+        inline constexpr size_t kaiser_taps = 8uz;
+        inline constexpr int kaiser_bits = 14;     // Weight precision.
+        inline constexpr int kaiser_carry_bits = 6; // Fraction kept between the horizontal and vertical passes.
+
+        /*
+            A level is always exactly half the one above, so every output texel sits on the same phase: its taps are
+            the source texels 3.5, 2.5, 1.5 and 0.5 away on either side, and one set of weights serves the whole image.
+            The weights are fixed point and sum exactly to 1, which keeps the result identical on every target.
+        */
+        [[nodiscard]] inline std::array<int32_t, kaiser_taps> kaiser_weights()
+        {
+            constexpr auto alpha = 4.0, radius = 4.0, pi = 3.14159265358979323846;
+
+            // Zeroth order modified Bessel function of the first kind, by its power series.
+            const auto bessel = [](double x) {
+                auto sum = 1.0, term = 1.0;
+                for(auto k = 1; k < 32; ++k)
+                {
+                    term *= (x / (2.0 * k)) * (x / (2.0 * k));
+                    sum += term;
+                }
+                return sum;
+            };
+
+            auto real = std::array<double, kaiser_taps>{};
+            auto total = 0.0;
+
+            for(auto i = 0uz; i < kaiser_taps; ++i)
+            {
+                const auto d = static_cast<double>(i) - 3.5;
+                const auto x = pi * d / 2.0;
+                const auto ratio = d / radius;
+
+                real[i] = (std::sin(x) / x) * bessel(alpha * std::sqrt(1.0 - (ratio * ratio))) / bessel(alpha);
+                total += real[i];
+            }
+
+            auto weights = std::array<int32_t, kaiser_taps>{};
+            auto sum = 0;
+
+            for(auto i = 0uz; i < kaiser_taps; ++i)
+            {
+                weights[i] = static_cast<int32_t>(std::lround(real[i] / total * (1 << kaiser_bits)));
+                sum += weights[i];
+            }
+
+            // Rounding error goes to the two centre taps, keeping the kernel symmetric.
+            const auto error = (1 << kaiser_bits) - sum;
+            weights[3] += error / 2;
+            weights[4] += error - (error / 2);
+
+            return weights;
+        }
+
+        // One output pixel of the horizontal pass from the eight source pixels at 'taps', no edge handling.
+        inline void kaiser_horizontal(const uint8_t* taps, const std::array<int32_t, kaiser_taps>& weights, int16_t* out)
+        {
+            constexpr auto shift = kaiser_bits - kaiser_carry_bits;
+
+#if defined(PROTO_MIPMAP_SSE2)
+            const auto zero = _mm_setzero_si128();
+            auto sum = _mm_set1_epi32(1 << (shift - 1));
+
+            // madd works on pairs, so the channels of neighbouring pixels are interleaved: r0 r1 g0 g1 b0 b1 a0 a1.
+            const auto pair = [&](__m128i pixels, size_t k) {
+                const auto interleaved = _mm_unpacklo_epi8(_mm_unpacklo_epi8(pixels, _mm_srli_si128(pixels, 4)), zero);
+                const auto weight = _mm_set1_epi32(static_cast<int32_t>((static_cast<uint32_t>(weights[k + 1uz]) << 16u) | static_cast<uint16_t>(weights[k])));
+                sum = _mm_add_epi32(sum, _mm_madd_epi16(interleaved, weight));
+            };
+
+            const auto low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(taps)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+            const auto high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(taps + 16)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+
+            pair(low, 0uz);
+            pair(_mm_srli_si128(low, 8), 2uz);
+            pair(high, 4uz);
+            pair(_mm_srli_si128(high, 8), 6uz);
+
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_packs_epi32(_mm_srai_epi32(sum, shift), zero)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+#else
+            auto sum = std::array<int32_t, mip_bytes_per_pixel>{};
+
+            for(auto k = 0uz; k < kaiser_taps; ++k)
+            {
+                for(auto c = 0uz; c < mip_bytes_per_pixel; ++c) { sum[c] += weights[k] * taps[(k * mip_bytes_per_pixel) + c]; }
+            }
+
+            for(auto c = 0uz; c < mip_bytes_per_pixel; ++c) { out[c] = static_cast<int16_t>((sum[c] + (1 << (shift - 1))) >> shift); }
+#endif
+        }
+
+        // One output row of the vertical pass from the eight intermediate rows in 'rows'.
+        inline void kaiser_vertical(const std::array<const int16_t*, kaiser_taps>& rows, const std::array<int32_t, kaiser_taps>& weights, uint8_t* out, size_t count)
+        {
+            constexpr auto shift = kaiser_bits + kaiser_carry_bits;
+            auto i = 0uz;
+
+#if defined(PROTO_MIPMAP_SSE2)
+            for(; i + 8uz <= count; i += 8uz)
+            {
+                auto low = _mm_set1_epi32(1 << (shift - 1)), high = low;
+
+                for(auto k = 0uz; k < kaiser_taps; k += 2uz)
+                {
+                    const auto a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[k] + i)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+                    const auto b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[k + 1uz] + i)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+                    const auto weight = _mm_set1_epi32(static_cast<int32_t>((static_cast<uint32_t>(weights[k + 1uz]) << 16u) | static_cast<uint16_t>(weights[k])));
+
+                    low = _mm_add_epi32(low, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), weight));
+                    high = _mm_add_epi32(high, _mm_madd_epi16(_mm_unpackhi_epi16(a, b), weight));
+                }
+
+                const auto words = _mm_packs_epi32(_mm_srai_epi32(low, shift), _mm_srai_epi32(high, shift));
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(words, words)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+            }
+#endif
+
+            for(; i < count; ++i)
+            {
+                auto sum = int32_t{1 << (shift - 1)};
+                for(auto k = 0uz; k < kaiser_taps; ++k) { sum += weights[k] * rows[k][i]; }
+
+                out[i] = static_cast<uint8_t>(std::clamp(sum >> shift, 0, 255));
+            }
+        }
+
+        inline void downsample_kaiser(std::span<const uint8_t> src, uint32_t width, uint32_t height, std::span<uint8_t> dst)
+        {
+            static const auto weights = kaiser_weights();
+
+            const auto outWidth = mip_extent(width), outHeight = mip_extent(height);
+            const auto rowValues = size_t{outWidth} * mip_bytes_per_pixel;
+            const auto tap = [](size_t out, size_t k, uint32_t extent) {
+                const auto at = static_cast<int64_t>(out * 2uz) + static_cast<int64_t>(k) - 3;
+                return static_cast<size_t>(std::clamp(at, int64_t{0}, int64_t{extent} - 1));
+            };
+
+            // Output pixels whose taps all fall inside the row, the rest gather clamped taps first.
+            const auto interiorFirst = 2uz;
+            const auto interiorLast = width >= 5u ? ((size_t{width} - 5uz) / 2uz) + 1uz : 0uz;
+
+            // Horizontal pass over every source row, kept with kaiser_carry_bits of fraction.
+            auto columns = std::vector<int16_t>(rowValues * height);
+
+            parallel_for(height, [&](size_t first, size_t last) {
+                auto gathered = std::array<uint8_t, kaiser_taps * mip_bytes_per_pixel>{};
+
+                for(auto y = first; y < last; ++y)
+                {
+                    const auto* row = src.data() + (y * width * mip_bytes_per_pixel);
+                    auto* out = columns.data() + (y * rowValues);
+
+                    for(auto x = 0uz; x < outWidth; ++x)
+                    {
+                        if(x >= interiorFirst && x < interiorLast)
+                        {
+                            kaiser_horizontal(row + (((x * 2uz) - 3uz) * mip_bytes_per_pixel), weights, out + (x * mip_bytes_per_pixel));
+                            continue;
+                        }
+
+                        for(auto k = 0uz; k < kaiser_taps; ++k)
+                        {
+                            std::copy_n(row + (tap(x, k, width) * mip_bytes_per_pixel), mip_bytes_per_pixel, gathered.begin() + static_cast<std::ptrdiff_t>(k * mip_bytes_per_pixel));
+                        }
+
+                        kaiser_horizontal(gathered.data(), weights, out + (x * mip_bytes_per_pixel));
+                    }
+                }
+            }, 16uz);
+
+            // Vertical pass, a row at a time so the taps run over contiguous values.
+            parallel_for(outHeight, [&](size_t first, size_t last) {
+                for(auto y = first; y < last; ++y)
+                {
+                    auto rows = std::array<const int16_t*, kaiser_taps>{};
+                    for(auto k = 0uz; k < kaiser_taps; ++k) { rows[k] = columns.data() + (tap(y, k, height) * rowValues); }
+
+                    kaiser_vertical(rows, weights, dst.data() + (y * rowValues), rowValues);
+                }
+            }, 16uz);
+        }
+    }
+
+    /**
+     * @brief Averages each 2x2 block of an RGBA8 image into 'dst', which must be mip_extent(width) by
+     * mip_extent(height). Edges of odd sized images are dropped, 1 pixel wide axes are repeated.
+     *
+     * @throws std::invalid_argument if the sizes do not match.
+     */
+    inline void downsample_box(std::span<const uint8_t> src, uint32_t width, uint32_t height, std::span<uint8_t> dst)
+    {
+        detail::check_mip_sizes(src.size(), width, height, dst.size());
+
+        const auto outWidth = mip_extent(width), outHeight = mip_extent(height);
+        const auto stride = size_t{width} * detail::mip_bytes_per_pixel;
+
+        parallel_for(outHeight, [&](size_t first, size_t last) {
+            // A single column is widened to a pair so box_row can treat it like any other.
+            auto pair = std::vector<uint8_t>(width == 1u ? 2uz * 2uz * detail::mip_bytes_per_pixel : 0uz);
+
+            for(auto y = first; y < last; ++y)
+            {
+                const auto* top = src.data() + (std::min(y * 2uz, size_t{height} - 1uz) * stride);
+                const auto* bottom = src.data() + (std::min((y * 2uz) + 1uz, size_t{height} - 1uz) * stride);
+                auto* out = dst.data() + (y * size_t{outWidth} * detail::mip_bytes_per_pixel);
+
+                if(width == 1u)
+                {
+                    std::copy_n(top, 4uz, pair.begin());
+                    std::copy_n(top, 4uz, pair.begin() + 4);
+                    std::copy_n(bottom, 4uz, pair.begin() + 8);
+                    std::copy_n(bottom, 4uz, pair.begin() + 12);
+
+                    top = pair.data();
+                    bottom = pair.data() + 8;
+                }
+
+                detail::box_row(top, bottom, out, outWidth);
+            }
+        }, 16uz);
+    }
+
+    /**
+     * @brief Halves an RGBA8 image like downsample_box, with a Kaiser windowed sinc instead of a box.
+     *
+     * @throws std::invalid_argument if the sizes do not match.
+     */
+    inline void downsample_kaiser(std::span<const uint8_t> src, uint32_t width, uint32_t height, std::span<uint8_t> dst)
+    {
+        detail::check_mip_sizes(src.size(), width, height, dst.size());
+        detail::downsample_kaiser(src, width, height, dst);
+    }
+
+    /**
+     * @brief Builds every level below 'src', down to 1x1 or until 'max_levels' levels (src included) exist.
+     * Each level is filtered from the one above it. The rows of a level are spread over the shared thread pool.
+     *
+     * @throws std::invalid_argument if src is not width * height RGBA8 pixels.
+     */
+    [[nodiscard]] inline std::vector<mip_level> build_mip_chain(std::span<const uint8_t> src, uint32_t width, uint32_t height,
+                                                                mip_filter filter = mip_filter::box, uint32_t max_levels = UINT32_MAX)
+    {
+        if(width == 0u || height == 0u || src.size() != size_t{width} * size_t{height} * detail::mip_bytes_per_pixel)
+        {
+            throw std::invalid_argument("Mip chain source has the wrong size.");
+        }
+
+        const auto count = std::min(mip_level_count(width, height), std::max(max_levels, 1u));
+        auto levels = std::vector<mip_level>{};
+        levels.reserve(count - 1u);
+
+        auto previous = src;
+
+        for(auto level = 1u; level < count; ++level)
+        {
+            auto next = mip_level{ .width = mip_extent(width), .height = mip_extent(height), .pixels = {} };
+            next.pixels.resize(size_t{next.width} * size_t{next.height} * detail::mip_bytes_per_pixel);
+
+            if(filter == mip_filter::kaiser) { downsample_kaiser(previous, width, height, next.pixels); }
+            else { downsample_box(previous, width, height, next.pixels); }
+
+            width = next.width;
+            height = next.height;
+            previous = levels.emplace_back(std::move(next)).pixels;
+        }
+
+        return levels;
+    }
+    // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+}
+
+#endif
@@ -0,0 +1,396 @@
+#ifndef PROTO_PARALLEL_HPP
+#define PROTO_PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace proto
+{
+    inline constexpr size_t cache_line_size = 64uz;
+
+    /**
+     * @brief A fixed set of worker threads pulling from one FIFO queue.
+     *
+     * Use thread_pool::shared() rather than creating pools of your own, every parallel helper below runs on it.
+     */
+    class thread_pool
+    {
+    public:
+        using task_type = std::move_only_function<void()>;
+
+        explicit thread_pool(size_t threads = default_thread_count())
+        {
+            _workers.reserve(threads);
+
+            for(auto i = 0uz; i < threads; ++i)
+            {
+                _workers.emplace_back([this]() { worker_loop(); });
+            }
+        }
+
+        thread_pool(const thread_pool&) = delete;
+        thread_pool(thread_pool&&) = delete;
+        thread_pool& operator=(const thread_pool&) = delete;
+        thread_pool& operator=(thread_pool&&) = delete;
+
+        // Finishes every queued task before the workers are joined.
+        ~thread_pool()
+        {
+            {
+                auto lock = std::scoped_lock{_lock};
+                _stopping = true;
+            }
+
+            _signal.notify_all();
+            _workers.clear();
+        }
+
+        [[nodiscard]] static thread_pool& shared()
+        {
+            static thread_pool pool;
+            return pool;
+        }
+
+        // The calling thread takes part in the fork-join helpers, so one core is left for it.
+        [[nodiscard]] static size_t default_thread_count()
+        {
+            return std::max(std::thread::hardware_concurrency(), 2u) - 1uz;
+        }
+
+        [[nodiscard]] size_t size() const { return _workers.size(); }
+
+        void submit(task_type task)
+        {
+            {
+                auto lock = std::scoped_lock{_lock};
+                _tasks.push_back(std::move(task));
+            }
+
+            _signal.notify_one();
+        }
+
+        template <typename Func>
+        [[nodiscard]] auto async(Func&& func) -> std::future<std::invoke_result_t<Func>>
+        {
+            auto task = std::packaged_task<std::invoke_result_t<Func>()>{std::forward<Func>(func)};
+            auto future = task.get_future();
+
+            submit([task = std::move(task)]() mutable { task(); });
+
+            return future;
+        }
+
+        // Runs one queued task on the calling thread. Used while waiting so nested parallel calls can not deadlock.
+        bool try_run_one()
+        {
+            task_type task;
+
+            {
+                auto lock = std::scoped_lock{_lock};
+                if(_tasks.empty()) { return false; }
+
+                task = std::move(_tasks.front());
+                _tasks.pop_front();
+            }
+
+            task();
+            return true;
+        }
+
+    private:
+        void worker_loop()
+        {
+            while(true)
+            {
+                task_type task;
+
+                {
+                    auto lock = std::unique_lock{_lock};
+                    _signal.wait(lock, [this]() { return _stopping || !_tasks.empty(); });
+
+                    if(_tasks.empty()) { return; }
+
+                    task = std::move(_tasks.front());
+                    _tasks.pop_front();
+                }
+
+                task();
+            }
+        }
+
+        std::mutex _lock;
+        std::condition_variable _signal;
+        std::deque<task_type> _tasks;
+        bool _stopping = false;
+        std::vector<std::jthread> _workers;
+    };
+
+    namespace detail
+    {
+        // Anything with contiguous data() and size(): std::span, dyn_array, std::vector.
+        template <typename R>
+        concept contiguous_data = requires(R& r) {
+            { r.data() } -> std::convertible_to<const void*>;
+            { r.size() } -> std::convertible_to<size_t>;
+        };
+
+        template <contiguous_data R>
+        [[nodiscard]] auto as_span(R& range)
+        {
+            return std::span{ range.data(), range.size() };
+        }
+
+        /*
+            Calls func(chunk) for every chunk in [0, chunks). Chunk 0 runs on the calling thread, the rest go to the
+            shared pool. While waiting, the caller drains the pool's queue instead of sleeping. The first exception
+            thrown by any chunk is rethrown here once every chunk has finished.
+
+            The counter is shared with the tasks: the caller can see it reach zero and return before the last
+            worker's notify_all, so it must outlive this frame.
+        */
+        template <typename Func>
+        void fork_join(size_t chunks, Func& func)
+        {
+            auto& pool = thread_pool::shared();
+
+            const auto remaining = std::make_shared<std::atomic<size_t>>(chunks - 1uz);
+            std::exception_ptr error;
+            std::mutex errorLock;
+
+            auto guarded = [&](size_t chunk) {
+                try
+                {
+                    func(chunk);
+                }
+                catch(...)
+                {
+                    auto lock = std::scoped_lock{errorLock};
+                    if(!error) { error = std::current_exception(); }
+                }
+            };
+
+            for(auto chunk = 1uz; chunk < chunks; ++chunk)
+            {
+                // Nothing on the caller's stack may be touched once the counter is decremented.
+                pool.submit([&guarded, remaining, chunk]() {
+                    guarded(chunk);
+
+                    if(remaining->fetch_sub(1uz, std::memory_order_acq_rel) == 1uz) { remaining->notify_all(); }
+                });
+            }
+
+            guarded(0uz);
+
+            for(auto left = remaining->load(std::memory_order_acquire); left != 0uz; left = remaining->load(std::memory_order_acquire))
+            {
+                if(!pool.try_run_one()) { remaining->wait(left, std::memory_order_acquire); }
+            }
+
+            if(error) { std::rethrow_exception(error); }
+        }
+
+        // A few chunks per thread evens out uneven work without drowning the queue.
+        inline constexpr size_t chunks_per_thread = 4uz;
+
+        [[nodiscard]] inline size_t chunk_length(size_t count, size_t grain)
+        {
+            const auto threads = thread_pool::shared().size() + 1uz;
+            return std::max(grain, (count + (threads * chunks_per_thread) - 1uz) / (threads * chunks_per_thread));
+        }
+
+        /*
+            Chunk boundaries for a span. Each boundary past the first is moved forward to the next element that
+            starts a cache line, so two threads never write to the same line.
+        */
+        template <typename T>
+        [[nodiscard]] std::vector<size_t> aligned_boundaries(std::span<T> range, size_t grain)
+        {
+            const auto count = range.size();
+            const auto chunk = chunk_length(count, grain);
+
+            size_t perLine = 1uz, head = 0uz;
+
+            if constexpr (sizeof(T) < cache_line_size && (cache_line_size % sizeof(T)) == 0uz)
+            {
+                perLine = cache_line_size / sizeof(T);
+
+                const auto address = reinterpret_cast<uintptr_t>(range.data()); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+                if(address % sizeof(T) == 0uz)
+                {
+                    head = ((cache_line_size - (address % cache_line_size)) % cache_line_size) / sizeof(T);
+                }
+            }
+
+            auto bounds = std::vector<size_t>{0uz};
+
+            for(auto next = chunk; next < count; next += chunk)
+            {
+                // Round up to the next index whose address is line aligned.
+                const auto aligned = next + ((head + perLine - (next % perLine)) % perLine);
+
+                if(aligned >= count) { break; }
+                if(aligned > bounds.back()) { bounds.push_back(aligned); }
+            }
+
+            bounds.push_back(count);
+            return bounds;
+        }
+    }
+
+    /**
+     * @brief Calls func(first, last) over sub-ranges of [0, count). Runs inline when count is below two grains.
+     */
+    template <typename Func>
+        requires std::invocable<Func&, size_t, size_t>
+    void parallel_for(size_t count, Func&& func, size_t grain = 1024uz)
+    {
+        if(count == 0uz) { return; }
+
+        if(count < grain * 2uz || thread_pool::shared().size() == 0uz)
+        {
+            func(0uz, count);
+            return;
+        }
+
+        const auto chunk = detail::chunk_length(count, grain);
+        const auto chunks = (count + chunk - 1uz) / chunk;
+
+        auto body = [&func, chunk, count](size_t index) {
+            const auto first = index * chunk;
+            func(first, std::min(first + chunk, count));
+        };
+
+        detail::fork_join(chunks, body);
+    }
+
+    /**
+     * @brief Calls func(element) for every element of a span or dyn_array. Chunks are cut on cache line boundaries.
+     */
+    template <typename Range, typename Func>
+        requires (!std::integral<std::remove_cvref_t<Range>>)
+    void parallel_for(Range&& range, Func&& func, size_t grain = 1024uz)
+    {
+        auto items = detail::as_span(range);
+
+        if(items.size() < grain * 2uz || thread_pool::shared().size() == 0uz)
+        {
+            for(auto& item : items) { func(item); }
+            return;
+        }
+
+        const auto bounds = detail::aligned_boundaries(items, grain);
+
+        auto body = [&func, &bounds, items](size_t index) {
+            for(auto& item : items.subspan(bounds[index], bounds[index + 1uz] - bounds[index])) { func(item); }
+        };
+
+        detail::fork_join(bounds.size() - 1uz, body);
+    }
+
+    /**
+     * @brief Reduces transform(element) with op. Partial results are combined in chunk order, so op must be
+     * associative but need not be commutative. Floating point sums can differ slightly with the thread count.
+     */
+    template <typename Range, typename T, typename Op, typename Transform = std::identity>
+    [[nodiscard]] T parallel_reduce(Range&& range, T init, Op op, Transform transform = {}, size_t grain = 1024uz)
+    {
+        auto items = detail::as_span(range);
+
+        auto fold = [&op, &transform](auto sub) {
+            auto acc = std::optional<T>{};
+
+            for(auto& item : sub)
+            {
+                acc = acc ? T(op(std::move(*acc), transform(item))) : T(transform(item));
+            }
+
+            return acc;
+        };
+
+        if(items.size() < grain * 2uz || thread_pool::shared().size() == 0uz)
+        {
+            auto result = fold(items);
+            return result ? T(op(std::move(init), std::move(*result))) : init;
+        }
+
+        const auto bounds = detail::aligned_boundaries(items, grain);
+        auto partials = std::vector<std::optional<T>>(bounds.size() - 1uz);
+
+        auto body = [&](size_t index) {
+            partials[index] = fold(items.subspan(bounds[index], bounds[index + 1uz] - bounds[index]));
+        };
+
+        detail::fork_join(partials.size(), body);
+
+        for(auto& partial : partials)
+        {
+            if(partial) { init = op(std::move(init), std::move(*partial)); }
+        }
+
+        return init;
+    }
+
+    /**
+     * @brief Sorts chunks in parallel, then merges neighbouring runs pairwise until one run is left. Not stable.
+     */
+    template <typename Range, typename Compare = std::less<>>
+    void parallel_sort(Range&& range, Compare comp = {}, size_t grain = 4096uz)
+    {
+        auto items = detail::as_span(range);
+
+        if(items.size() < grain * 2uz || thread_pool::shared().size() == 0uz)
+        {
+            std::sort(items.begin(), items.end(), comp);
+            return;
+        }
+
+        auto bounds = detail::aligned_boundaries(items, grain);
+
+        auto sortChunk = [&](size_t index) {
+            std::sort(items.begin() + static_cast<ptrdiff_t>(bounds[index]), items.begin() + static_cast<ptrdiff_t>(bounds[index + 1uz]), comp);
+        };
+
+        detail::fork_join(bounds.size() - 1uz, sortChunk);
+
+        // Each pass merges runs [0,1], [2,3], ... and drops every other boundary.
+        while(bounds.size() > 2uz)
+        {
+            const auto pairs = (bounds.size() - 1uz) / 2uz;
+
+            auto mergePair = [&](size_t pair) {
+                const auto first = items.begin() + static_cast<ptrdiff_t>(bounds[pair * 2uz]);
+                const auto middle = items.begin() + static_cast<ptrdiff_t>(bounds[(pair * 2uz) + 1uz]);
+                const auto last = items.begin() + static_cast<ptrdiff_t>(bounds[(pair * 2uz) + 2uz]);
+
+                std::inplace_merge(first, middle, last, comp);
+            };
+
+            detail::fork_join(pairs, mergePair);
+
+            auto merged = std::vector<size_t>{};
+            merged.reserve((bounds.size() / 2uz) + 1uz);
+
+            for(auto i = 0uz; i < bounds.size(); i += 2uz) { merged.push_back(bounds[i]); }
+            if(merged.back() != bounds.back()) { merged.push_back(bounds.back()); }
+
+            bounds = std::move(merged);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,395 @@
+#ifndef PROTO_PIXEL_CONVERT_HPP
+#define PROTO_PIXEL_CONVERT_HPP
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+
+#if defined(__AVX2__)
+#define PROTO_PIXEL_AVX2 1
+#include <immintrin.h>
+#elif defined(__SSSE3__)
+#define PROTO_PIXEL_SSSE3 1
+#include <tmmintrin.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define PROTO_PIXEL_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#define PROTO_PIXEL_NEON 1
+#include <arm_neon.h>
+#endif
+
+/**
+ * @brief Conversions between the 8-bit pixel layouts Image deals with.
+ *
+ * Every kernel takes a source and a destination span, which may be the same span for the conversions that keep the
+ * pixel size. The SIMD paths are picked at compile time from the target: AVX2 (PROTO_ENABLE_AVX2), SSSE3 or SSE2 on
+ * x86 and NEON on AArch64, and each one gives exactly the same bytes as the scalar versions in proto::reference.
+ */
+namespace proto
+{
+    // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    namespace reference
+    {
+        // round(c * a / 255) for any two bytes, without a division.
+        [[nodiscard]] constexpr uint8_t mul_div_255(uint32_t c, uint32_t a)
+        {
+            const auto t = (c * a) + 128u;
+            return static_cast<uint8_t>((t + (t >> 8u)) >> 8u);
+        }
+
+        inline void rgb_to_rgba(std::span<const uint8_t> src, std::span<uint8_t> dst, uint8_t alpha = 255u)
+        {
+            for(auto i = 0uz, o = 0uz; i < src.size(); i += 3uz, o += 4uz)
+            {
+                dst[o] = src[i];
+                dst[o + 1uz] = src[i + 1uz];
+                dst[o + 2uz] = src[i + 2uz];
+                dst[o + 3uz] = alpha;
+            }
+        }
+
+        inline void premultiply_alpha(std::span<const uint8_t> src, std::span<uint8_t> dst)
+        {
+            for(auto i = 0uz; i < src.size(); i += 4uz)
+            {
+                const auto a = src[i + 3uz];
+                dst[i] = mul_div_255(src[i], a);
+                dst[i + 1uz] = mul_div_255(src[i + 1uz], a);
+                dst[i + 2uz] = mul_div_255(src[i + 2uz], a);
+                dst[i + 3uz] = a;
+            }
+        }
+
+        inline void swizzle_rgba(std::span<const uint8_t> src, std::span<uint8_t> dst, std::array<uint8_t, 4uz> order)
+        {
+            for(auto i = 0uz; i < src.size(); i += 4uz)
+            {
+                const auto pixel = std::array<uint8_t, 4uz>{ src[i], src[i + 1uz], src[i + 2uz], src[i + 3uz] };
+
+                for(auto c = 0uz; c < 4uz; ++c) { dst[i + c] = pixel[order[c]]; }
+            }
+        }
+    }
+
+    namespace detail
+    {
+        inline void check_sizes(size_t src, size_t dst, size_t srcPixel, size_t dstPixel)
+        {
+            if(src % srcPixel != 0uz || (src / srcPixel) * dstPixel != dst)
+            {
+                throw std::invalid_argument("Pixel buffer sizes do not match.");
+            }
+        }
+
+        // Encoded sRGB byte to linear byte, rounded to nearest.
+        inline const std::array<uint8_t, 256uz> srgb_to_linear_table = []() {
+            auto table = std::array<uint8_t, 256uz>{};
+
+            for(auto i = 0uz; i < table.size(); ++i)
+            {
+                const auto c = static_cast<double>(i) / 255.0;
+                const auto linear = (c <= 0.04045) ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4);
+                table[i] = static_cast<uint8_t>(std::lround(linear * 255.0));
+            }
+
+            return table;
+        }();
+
+#if defined(PROTO_PIXEL_AVX2) || defined(PROTO_PIXEL_SSSE3)
+        // Spreads four packed RGB pixels at 'offset' bytes into a register over four RGBA slots, alpha left zero.
+        [[nodiscard]] inline __m128i rgb_expand_mask(int offset)
+        {
+            constexpr auto zero = static_cast<char>(0x80);
+            const auto o = static_cast<char>(offset);
+
+            return _mm_setr_epi8(o, static_cast<char>(o + 1), static_cast<char>(o + 2), zero,
+                                 static_cast<char>(o + 3), static_cast<char>(o + 4), static_cast<char>(o + 5), zero,
+                                 static_cast<char>(o + 6), static_cast<char>(o + 7), static_cast<char>(o + 8), zero,
+                                 static_cast<char>(o + 9), static_cast<char>(o + 10), static_cast<char>(o + 11), zero);
+        }
+
+        [[nodiscard]] inline __m128i swizzle_mask(std::array<uint8_t, 4uz> order)
+        {
+            auto bytes = std::array<char, 16uz>{};
+
+            for(auto i = 0uz; i < 16uz; ++i) { bytes[i] = static_cast<char>(((i / 4uz) * 4uz) + order[i % 4uz]); }
+
+            return _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes.data())); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+        }
+#endif
+
+        /*
+            Expands 16 pixels. Every load happens before any store, which is what lets rgb_to_rgba_in_place walk
+            backwards over a buffer it is overwriting. Loads stay inside the 48 source bytes.
+        */
+        inline void rgb_to_rgba_16(const uint8_t* src, uint8_t* dst, uint8_t alpha)
+        {
+#if defined(PROTO_PIXEL_AVX2)
+            const auto lowMask = rgb_expand_mask(0), highMask = rgb_expand_mask(4);
+            const auto maskA = _mm256_set_m128i(lowMask, lowMask), maskB = _mm256_set_m128i(highMask, lowMask);
+            const auto alphas = _mm256_set1_epi32(static_cast<int>(static_cast<uint32_t>(alpha) << 24u));
+
+            const auto a = _mm256_set_m128i(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 12)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(src))); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+            const auto b = _mm256_set_m128i(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 32)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 24))); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), _mm256_or_si256(_mm256_shuffle_epi8(a, maskA), alphas)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 32), _mm256_or_si256(_mm256_shuffle_epi8(b, maskB), alphas)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+#elif defined(PROTO_PIXEL_SSSE3)
+            const auto lowMask = rgb_expand_mask(0), highMask = rgb_expand_mask(4);
+            const auto alphas = _mm_set1_epi32(static_cast<int>(static_cast<uint32_t>(alpha) << 24u));
+
+            const auto p0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+            const auto p1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 12)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+            const auto p2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 24)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+            const auto p3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 32)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_or_si128(_mm_shuffle_epi8(p0, lowMask), alphas)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 16), _mm_or_si128(_mm_shuffle_epi8(p1, lowMask), alphas)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 32), _mm_or_si128(_mm_shuffle_epi8(p2, lowMask), alphas)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 48), _mm_or_si128(_mm_shuffle_epi8(p3, highMask), alphas)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+#elif defined(PROTO_PIXEL_NEON)
+            const auto rgb = vld3q_u8(src);
+            vst4q_u8(dst, uint8x16x4_t{ { rgb.val[0], rgb.val[1], rgb.val[2], vdupq_n_u8(alpha) } });
+#else
+            auto block = std::array<uint8_t, 48uz>{};
+            std::memcpy(block.data(), src, block.size());
+            reference::rgb_to_rgba(block, std::span{ dst, 64uz }, alpha);
+#endif
+        }
+
+#if defined(PROTO_PIXEL_SSE2)
+        // Premultiplies four pixels held as bytes. The alpha lane is multiplied by 255, which leaves it unchanged.
+        [[nodiscard]] inline __m128i premultiply_4(__m128i pixels)
+        {
+            const auto zero = _mm_setzero_si128();
+            const auto keepAlpha = _mm_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255);
+            const auto colorLanes = _mm_setr_epi16(-1, -1, -1, 0, -1, -1, -1, 0);
+            const auto half = _mm_set1_epi16(128);
+
+            const auto scale = [&](__m128i wide) {
+                auto alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(wide, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+                alpha = _mm_or_si128(_mm_and_si128(alpha, colorLanes), keepAlpha);
+
+                const auto t = _mm_add_epi16(_mm_mullo_epi16(wide, alpha), half);
+                return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+            };
+
+            return _mm_packus_epi16(scale(_mm_unpacklo_epi8(pixels, zero)), scale(_mm_unpackhi_epi8(pixels, zero)));
+        }
+#endif
+
+#if defined(PROTO_PIXEL_AVX2)
+        [[nodiscard]] inline __m256i premultiply_8(__m256i pixels)
+        {
+            const auto zero = _mm256_setzero_si256();
+            const auto keepAlpha = _mm256_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255);
+            const auto colorLanes = _mm256_setr_epi16(-1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1, 0);
+            const auto half = _mm256_set1_epi16(128);
+
+            const auto scale = [&](__m256i wide) {
+                auto alpha = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(wide, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+                alpha = _mm256_or_si256(_mm256_and_si256(alpha, colorLanes), keepAlpha);
+
+                const auto t = _mm256_add_epi16(_mm256_mullo_epi16(wide, alpha), half);
+                return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+            };
+
+            // Unpack and pack both work within 128-bit lanes, so the pixel order comes back unchanged.
+            return _mm256_packus_epi16(scale(_mm256_unpacklo_epi8(pixels, zero)), scale(_mm256_unpackhi_epi8(pixels, zero)));
+        }
+#endif
+
+#if defined(PROTO_PIXEL_NEON)
+        [[nodiscard]] inline uint8x8_t mul_div_255(uint8x8_t c, uint8x8_t a)
+        {
+            const auto t = vaddq_u16(vmull_u8(c, a), vdupq_n_u16(128));
+            return vshrn_n_u16(vsraq_n_u16(t, t, 8), 8);
+        }
+
+        [[nodiscard]] inline uint8x16_t mul_div_255(uint8x16_t c, uint8x16_t a)
+        {
+            return vcombine_u8(mul_div_255(vget_low_u8(c), vget_low_u8(a)), mul_div_255(vget_high_u8(c), vget_high_u8(a)));
+        }
+#endif
+    }
+
+    /**
+     * @brief Expands packed RGB to RGBA with a constant alpha. dst must hold four bytes for every three in src.
+     *
+     * @throws std::invalid_argument if the sizes do not match.
+     */
+    inline void rgb_to_rgba(std::span<const uint8_t> src, std::span<uint8_t> dst, uint8_t alpha = 255u)
+    {
+        detail::check_sizes(src.size(), dst.size(), 3uz, 4uz);
+
+        const auto pixels = src.size() / 3uz;
+        const auto blocks = pixels / 16uz;
+
+        for(auto b = 0uz; b < blocks; ++b)
+        {
+            detail::rgb_to_rgba_16(src.data() + (b * 48uz), dst.data() + (b * 64uz), alpha);
+        }
+
+        reference::rgb_to_rgba(src.subspan(blocks * 48uz), dst.subspan(blocks * 64uz), alpha);
+    }
+
+    /**
+     * @brief Expands 'pixels' RGB pixels packed at the start of 'buffer' to RGBA in place, for decoders that hand
+     * back three channels in a buffer that already has room for four.
+     *
+     * @throws std::invalid_argument if the buffer is smaller than pixels * 4 bytes.
+     */
+    inline void rgb_to_rgba_in_place(std::span<uint8_t> buffer, size_t pixels, uint8_t alpha = 255u)
+    {
+        if(buffer.size() < pixels * 4uz) { throw std::invalid_argument("Pixel buffer is too small to expand in place."); }
+
+        // Back to front: a block always reads source bytes below anything written after it.
+        const auto blocks = pixels / 16uz;
+
+        for(auto p = pixels; p > blocks * 16uz; --p)
+        {
+            const auto i = (p - 1uz) * 3uz, o = (p - 1uz) * 4uz;
+            const auto r = buffer[i], g = buffer[i + 1uz], b = buffer[i + 2uz];
+
+            buffer[o] = r;
+            buffer[o + 1uz] = g;
+            buffer[o + 2uz] = b;
+            buffer[o + 3uz] = alpha;
+        }
+
+        for(auto b = blocks; b > 0uz; --b)
+        {
+            detail::rgb_to_rgba_16(buffer.data() + ((b - 1uz) * 48uz), buffer.data() + ((b - 1uz) * 64uz), alpha);
+        }
+    }
+
+    /**
+     * @brief Converts straight alpha RGBA to premultiplied alpha, rounding to nearest. src and dst may be the same.
+     *
+     * @throws std::invalid_argument if the sizes do not match.
+     */
+    inline void premultiply_alpha(std::span<const uint8_t> src, std::span<uint8_t> dst)
+    {
+        detail::check_sizes(src.size(), dst.size(), 4uz, 4uz);
+
+        auto i = 0uz;
+
+#if defined(PROTO_PIXEL_AVX2)
+        for(; i + 32uz <= src.size(); i += 32uz)
+        {
+            const auto pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src.data() + i)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst.data() + i), detail::premultiply_8(pixels)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+        }
+#endif
+
+#if defined(PROTO_PIXEL_SSE2)
+        for(; i + 16uz <= src.size(); i += 16uz)
+        {
+            const auto pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src.data() + i)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst.data() + i), detail::premultiply_4(pixels)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+        }
+#elif defined(PROTO_PIXEL_NEON)
+        for(; i + 64uz <= src.size(); i += 64uz)
+        {
+            auto pixels = vld4q_u8(src.data() + i);
+
+            pixels.val[0] = detail::mul_div_255(pixels.val[0], pixels.val[3]);
+            pixels.val[1] = detail::mul_div_255(pixels.val[1], pixels.val[3]);
+            pixels.val[2] = detail::mul_div_255(pixels.val[2], pixels.val[3]);
+
+            vst4q_u8(dst.data() + i, pixels);
+        }
+#endif
+
+        reference::premultiply_alpha(src.subspan(i), dst.subspan(i));
+    }
+
+    inline void premultiply_alpha(std::span<uint8_t> pixels) { premultiply_alpha(pixels, pixels); }
+
+    /**
+     * @brief Reorders the channels of every RGBA pixel: dst channel c is src channel order[c], so {2, 1, 0, 3}
+     * turns BGRA into RGBA and back. src and dst may be the same.
+     *
+     * @throws std::invalid_argument if the sizes do not match or an index is above 3.
+     */
+    inline void swizzle_rgba(std::span<const uint8_t> src, std::span<uint8_t> dst, std::array<uint8_t, 4uz> order)
+    {
+        detail::check_sizes(src.size(), dst.size(), 4uz, 4uz);
+
+        for(const auto index : order)
+        {
+            if(index > 3u) { throw std::invalid_argument("Swizzle index out of range."); }
+        }
+
+        auto i = 0uz;
+
+#if defined(PROTO_PIXEL_AVX2)
+        const auto mask = _mm256_broadcastsi128_si256(detail::swizzle_mask(order));
+
+        for(; i + 32uz <= src.size(); i += 32uz)
+        {
+            const auto pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src.data() + i)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst.data() + i), _mm256_shuffle_epi8(pixels, mask)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+        }
+#elif defined(PROTO_PIXEL_SSSE3)
+        const auto mask = detail::swizzle_mask(order);
+
+        for(; i + 16uz <= src.size(); i += 16uz)
+        {
+            const auto pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src.data() + i)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst.data() + i), _mm_shuffle_epi8(pixels, mask)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+        }
+#elif defined(PROTO_PIXEL_NEON)
+        auto bytes = std::array<uint8_t, 16uz>{};
+        for(auto b = 0uz; b < 16uz; ++b) { bytes[b] = static_cast<uint8_t>(((b / 4uz) * 4uz) + order[b % 4uz]); }
+        const auto mask = vld1q_u8(bytes.data());
+
+        for(; i + 16uz <= src.size(); i += 16uz)
+        {
+            vst1q_u8(dst.data() + i, vqtbl1q_u8(vld1q_u8(src.data() + i), mask));
+        }
+#endif
+
+        reference::swizzle_rgba(src.subspan(i), dst.subspan(i), order);
+    }
+
+    inline void swizzle_rgba(std::span<uint8_t> pixels, std::array<uint8_t, 4uz> order) { swizzle_rgba(pixels, pixels, order); }
+
+    /**
+     * @brief Decodes the sRGB colour channels of RGBA pixels to linear, alpha is left alone. src and dst may be the
+     * same.
+     *
+     * A byte-to-byte lookup table beats any arithmetic here, and a gather does not pay for itself on 256 entries,
+     * so this one has no SIMD path.
+     *
+     * @throws std::invalid_argument if the sizes do not match.
+     */
+    inline void srgb_to_linear(std::span<const uint8_t> src, std::span<uint8_t> dst)
+    {
+        detail::check_sizes(src.size(), dst.size(), 4uz, 4uz);
+
+        const auto& table = detail::srgb_to_linear_table;
+
+        for(auto i = 0uz; i < src.size(); i += 4uz)
+        {
+            dst[i] = table[src[i]];
+            dst[i + 1uz] = table[src[i + 1uz]];
+            dst[i + 2uz] = table[src[i + 2uz]];
+            dst[i + 3uz] = src[i + 3uz];
+        }
+    }
+
+    inline void srgb_to_linear(std::span<uint8_t> pixels) { srgb_to_linear(pixels, pixels); }
+    // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+}
+
+#endif
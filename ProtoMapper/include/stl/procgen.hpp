@@ -0,0 +1,467 @@
+#ifndef PROTO_PROCGEN_HPP
+#define PROTO_PROCGEN_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <parallel.hpp>
+
+#if defined(__AVX2__)
+#define PROTO_PROCGEN_AVX2 1
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#define PROTO_PROCGEN_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define PROTO_PROCGEN_NEON 1
+#include <arm_neon.h>
+#endif
+
+/**
+ * @brief Building blocks for procedural maps: value noise, cellular-automaton caves and BSP dungeons.
+ *
+ * Randomness comes from a counter-based generator, a hash of the seed and of what is being decided (a cell, a
+ * lattice point, a tree node) rather than a stream that is drawn from in order. Any part of the output can be
+ * computed on its own, on any thread and in any order, and comes out bit-identical for the same seed however the
+ * work was split.
+ */
+namespace proto
+{
+    // SplitMix64's finalizer, every output bit depends on every input bit.
+    [[nodiscard]] constexpr uint64_t mix64(uint64_t z)
+    {
+        z = (z ^ (z >> 30u)) * 0xBF58476D1CE4E5B9u;
+        z = (z ^ (z >> 27u)) * 0x94D049BB133111EBu;
+        return z ^ (z >> 31u);
+    }
+
+    // The 'counter'th random number of 'seed'.
+    [[nodiscard]] constexpr uint64_t random_u64(uint64_t seed, uint64_t counter)
+    {
+        return mix64(mix64(seed) ^ (counter * 0x9E3779B97F4A7C15u));
+    }
+
+    // Random bits for cell (x, y). Different streams give unrelated numbers for the same cell.
+    [[nodiscard]] constexpr uint64_t random_at(uint64_t seed, uint32_t x, uint32_t y, uint32_t stream = 0u)
+    {
+        return random_u64(seed + (uint64_t{stream} * 0xD6E8FEB86659FD93u), (uint64_t{y} << 32u) | x);
+    }
+
+    // The top 24 bits as a float in [0, 1).
+    [[nodiscard]] constexpr float random_unit(uint64_t bits)
+    {
+        return static_cast<float>(bits >> 40u) * 0x1p-24f;
+    }
+
+    /**
+     * @brief A counter-based generator for code that draws several numbers for one decision. Its numbers depend
+     * only on the seed and how many came before from this generator, never on other generators or threads.
+     */
+    class counter_rng
+    {
+    public:
+        constexpr explicit counter_rng(uint64_t seed, uint64_t counter = 0u) : _seed(seed), _counter(counter) {}
+
+        [[nodiscard]] constexpr uint64_t next() { return random_u64(_seed, _counter++); }
+        [[nodiscard]] constexpr float unit() { return random_unit(next()); }
+
+        // Uniform in [0, bound), bound must not be 0.
+        [[nodiscard]] constexpr uint32_t below(uint32_t bound) { return static_cast<uint32_t>(((next() >> 32u) * bound) >> 32u); }
+
+        // Uniform in [low, high].
+        [[nodiscard]] constexpr uint32_t between(uint32_t low, uint32_t high) { return low + below(high - low + 1u); }
+
+    private:
+        uint64_t _seed, _counter;
+    };
+
+    // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    namespace detail
+    {
+        /**
+         * @brief out[i] += base + slope * t[i]. Kept as a multiply and then an add, never fused, so that every
+         * path rounds the same way.
+         */
+        inline void add_affine(float* out, const float* t, float base, float slope, size_t count)
+        {
+            auto i = 0uz;
+
+#if defined(PROTO_PROCGEN_AVX2)
+            const auto b = _mm256_set1_ps(base), s = _mm256_set1_ps(slope);
+            for(; i + 8uz <= count; i += 8uz)
+            {
+                const auto step = _mm256_add_ps(_mm256_mul_ps(s, _mm256_loadu_ps(t + i)), b);
+                _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_loadu_ps(out + i), step));
+            }
+#elif defined(PROTO_PROCGEN_SSE2)
+            const auto b = _mm_set1_ps(base), s = _mm_set1_ps(slope);
+            for(; i + 4uz <= count; i += 4uz)
+            {
+                const auto step = _mm_add_ps(_mm_mul_ps(s, _mm_loadu_ps(t + i)), b);
+                _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), step));
+            }
+#elif defined(PROTO_PROCGEN_NEON)
+            const auto b = vdupq_n_f32(base), s = vdupq_n_f32(slope);
+            for(; i + 4uz <= count; i += 4uz)
+            {
+                const auto step = vaddq_f32(vmulq_f32(s, vld1q_f32(t + i)), b);
+                vst1q_f32(out + i, vaddq_f32(vld1q_f32(out + i), step));
+            }
+#endif
+
+            for(; i < count; ++i)
+            {
+                // Separate statements, so the compiler may not contract them into a fused multiply-add.
+                auto step = slope * t[i];
+                step += base;
+                out[i] += step;
+            }
+        }
+
+        [[nodiscard]] constexpr float smooth(float t) { return t * t * (3.f - (2.f * t)); }
+    }
+    // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+    struct noise_settings
+    {
+        float scale = 64.f;       // Cells per lattice step of the first octave.
+        uint32_t octaves = 4u;
+        float persistence = 0.5f; // Amplitude of each octave relative to the one before.
+        float lacunarity = 2.f;   // Frequency of each octave relative to the one before.
+    };
+
+    /**
+     * @brief Fills 'out' with fractal value noise in [0, 1) for the width x height cells starting at (x0, y0), in
+     * row order. A cell's value depends only on the seed, the settings and its coordinates.
+     *
+     * Cells between two lattice columns share their corner values, so each octave adds a whole span of cells as
+     * base + slope * t with the vector kernel above, and hashes only a handful of lattice points per row.
+     */
+    inline void value_noise(uint64_t seed, const noise_settings& settings, uint32_t x0, uint32_t y0, uint32_t width, uint32_t height, std::span<float> out)
+    {
+        if(out.size() < size_t{width} * height) { throw std::invalid_argument("value_noise: output is smaller than the area."); }
+        if(width == 0u || height == 0u) { return; }
+
+        std::fill_n(out.begin(), size_t{width} * height, 0.f);
+
+        struct span_start { uint32_t first; int64_t column; };
+
+        auto t = std::vector<float>(width);
+        auto spans = std::vector<span_start>{};
+        auto top = std::vector<float>{}, bottom = std::vector<float>{}, columns = std::vector<float>{};
+
+        auto frequency = 1.f / std::max(settings.scale, 1e-3f);
+        auto amplitude = 1.f, total = 0.f;
+
+        for(auto octave = 0u; octave < std::max(settings.octaves, 1u); ++octave)
+        {
+            // Lattice columns and the smoothed offsets between them are the same on every row.
+            spans.clear();
+            for(auto i = 0u; i < width; ++i)
+            {
+                const auto u = static_cast<float>(x0 + i) * frequency;
+                const auto column = std::floor(u);
+
+                t[i] = detail::smooth(u - column);
+                if(spans.empty() || spans.back().column != static_cast<int64_t>(column)) { spans.push_back({ i, static_cast<int64_t>(column) }); }
+            }
+
+            const auto firstColumn = spans.front().column;
+            const auto columnCount = static_cast<size_t>(spans.back().column - firstColumn) + 2uz;
+
+            top.resize(columnCount);
+            bottom.resize(columnCount);
+            columns.resize(columnCount);
+
+            auto row = int64_t{-1};
+
+            for(auto y = 0u; y < height; ++y)
+            {
+                const auto v = static_cast<float>(y0 + y) * frequency;
+                const auto lattice = std::floor(v);
+                const auto ty = detail::smooth(v - lattice);
+
+                // Rows between the same two lattice rows reuse their hashes.
+                if(static_cast<int64_t>(lattice) != row)
+                {
+                    row = static_cast<int64_t>(lattice);
+
+                    for(auto c = 0uz; c < columnCount; ++c)
+                    {
+                        const auto lx = static_cast<uint32_t>(firstColumn + static_cast<int64_t>(c));
+                        top[c] = random_unit(random_at(seed, lx, static_cast<uint32_t>(row), octave));
+                        bottom[c] = random_unit(random_at(seed, lx, static_cast<uint32_t>(row + 1), octave));
+                    }
+                }
+
+                for(auto c = 0uz; c < columnCount; ++c) { columns[c] = top[c] + ((bottom[c] - top[c]) * ty); }
+
+                auto* cells = out.data() + (size_t{y} * width);
+
+                for(auto s = 0uz; s < spans.size(); ++s)
+                {
+                    const auto first = spans[s].first, last = s + 1uz < spans.size() ? spans[s + 1uz].first : width;
+                    const auto c = static_cast<size_t>(spans[s].column - firstColumn);
+
+                    const auto base = amplitude * columns[c];
+                    const auto slope = amplitude * (columns[c + 1uz] - columns[c]);
+
+                    detail::add_affine(cells + first, t.data() + first, base, slope, last - first); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+                }
+            }
+
+            total += amplitude;
+            amplitude *= settings.persistence;
+            frequency *= settings.lacunarity;
+        }
+
+        const auto scale = 1.f / total;
+        for(auto& cell : out.first(size_t{width} * height)) { cell = std::min(cell * scale, 0x1.fffffep-1f); }
+    }
+
+    /**
+     * @brief Caves grown by a cellular automaton on a byte grid, 1 for wall and 0 for floor. Cells start as walls
+     * with a given chance, then each step turns a floor cell into wall when at least 'birth' of its eight
+     * neighbours are walls, and keeps a wall when at least 'survive' are. Cells off the grid count as walls.
+     *
+     * Steps read one generation and write the next, with rows split across the thread pool.
+     */
+    class cave_automaton
+    {
+    public:
+        cave_automaton() = default;
+        cave_automaton(uint32_t width, uint32_t height) : _width(width), _height(height), _cells(size_t{width} * height), _next(_cells.size()) {}
+
+        void seed(uint64_t seed, float wall_chance)
+        {
+            parallel_for(_height, [&](size_t first, size_t last) {
+                for(auto y = first; y < last; ++y)
+                {
+                    for(auto x = 0u; x < _width; ++x)
+                    {
+                        const auto roll = random_unit(random_at(seed, x, static_cast<uint32_t>(y)));
+                        _cells[(y * _width) + x] = roll < wall_chance ? 1u : 0u;
+                    }
+                }
+            }, 16uz);
+        }
+
+        void step(uint32_t birth = 5u, uint32_t survive = 4u)
+        {
+            const auto walls = std::vector<uint8_t>(_width, 1u);
+
+            parallel_for(_height, [&](size_t first, size_t last) {
+                // Walls in each column of the three rows, with a wall column either side of the grid.
+                auto sums = std::vector<uint8_t>(_width + 2uz, 3u);
+
+                for(auto y = first; y < last; ++y)
+                {
+                    const auto* up = y > 0uz ? row(y - 1uz).data() : walls.data();
+                    const auto* mid = row(y).data();
+                    const auto* down = y + 1uz < _height ? row(y + 1uz).data() : walls.data();
+                    auto* next = _next.data() + (y * _width);
+
+                    for(auto x = 0uz; x < _width; ++x) { sums[x + 1uz] = static_cast<uint8_t>(up[x] + mid[x] + down[x]); }
+
+                    for(auto x = 0uz; x < _width; ++x)
+                    {
+                        const auto count = uint32_t{sums[x]} + sums[x + 1uz] + sums[x + 2uz] - mid[x];
+                        next[x] = count >= (mid[x] != 0u ? survive : birth) ? 1u : 0u;
+                    }
+                }
+            }, 16uz);
+
+            std::swap(_cells, _next);
+        }
+
+        [[nodiscard]] uint8_t at(uint32_t x, uint32_t y) const { return _cells[(size_t{y} * _width) + x]; }
+        [[nodiscard]] std::span<const uint8_t> row(size_t y) const { return std::span{ _cells }.subspan(y * _width, _width); }
+        [[nodiscard]] std::span<const uint8_t> cells() const { return _cells; }
+
+        [[nodiscard]] uint32_t width() const { return _width; }
+        [[nodiscard]] uint32_t height() const { return _height; }
+
+    private:
+        uint32_t _width = 0u, _height = 0u;
+        std::vector<uint8_t> _cells, _next;
+    };
+
+    struct dungeon_settings
+    {
+        uint32_t min_leaf = 16u;  // Smallest side a split may leave.
+        uint32_t max_depth = 12u;
+        uint32_t min_room = 4u;   // Smallest side of a room.
+        uint32_t margin = 1u;     // Wall kept between a room and the edge of its leaf.
+    };
+
+    /**
+     * @brief Rooms and corridors from binary space partitioning: the map is split in two at random until the
+     * pieces are small, each leaf gets a room, and the two halves of every split are joined by an L-shaped
+     * corridor between a room on either side. Every room is reachable from every other.
+     *
+     * The tree takes its random numbers from its node index, and rasterize() draws any area on its own, so areas
+     * can be drawn in parallel.
+     */
+    class bsp_dungeon
+    {
+    public:
+        struct rect
+        {
+            uint32_t x, y, w, h;
+
+            [[nodiscard]] constexpr bool overlaps(uint32_t ax, uint32_t ay, uint32_t aw, uint32_t ah) const
+            {
+                return x < ax + aw && ax < x + w && y < ay + ah && ay < y + h;
+            }
+        };
+
+        void build(uint64_t seed, uint32_t width, uint32_t height, const dungeon_settings& settings = {})
+        {
+            _rooms.clear();
+            _corridors.clear();
+            _bins.clear();
+
+            if(width < settings.min_room + (2u * settings.margin) || height < settings.min_room + (2u * settings.margin)) { return; }
+
+            struct node { rect area; uint32_t depth; uint32_t left = 0u, right = 0u; uint32_t room = 0u; };
+
+            auto nodes = std::vector<node>{ { .area = { 0u, 0u, width, height }, .depth = 0u } };
+            const auto minLeaf = std::max(settings.min_leaf, (settings.min_room + (2u * settings.margin)) + 1u);
+
+            // Children always come after their parent, so one pass splits the whole tree.
+            for(auto i = 0uz; i < nodes.size(); ++i)
+            {
+                auto rng = counter_rng{ seed, uint64_t{i} << 8u };
+                const auto area = nodes[i].area;
+
+                const auto canSplitX = area.w >= 2u * minLeaf, canSplitY = area.h >= 2u * minLeaf;
+                if(nodes[i].depth == settings.max_depth || (!canSplitX && !canSplitY))
+                {
+                    // A room somewhere inside the leaf, at least min_room on a side.
+                    const auto roomW = rng.between(std::min(settings.min_room, area.w - (2u * settings.margin)), area.w - (2u * settings.margin));
+                    const auto roomH = rng.between(std::min(settings.min_room, area.h - (2u * settings.margin)), area.h - (2u * settings.margin));
+                    const auto roomX = area.x + settings.margin + rng.below(area.w - (2u * settings.margin) - roomW + 1u);
+                    const auto roomY = area.y + settings.margin + rng.below(area.h - (2u * settings.margin) - roomH + 1u);
+
+                    nodes[i].room = static_cast<uint32_t>(_rooms.size());
+                    _rooms.push_back({ roomX, roomY, roomW, roomH });
+                    continue;
+                }
+
+                // Long pieces are cut across, square ones either way.
+                auto splitX = canSplitX;
+                if(canSplitX && canSplitY)
+                {
+                    if(area.w * 4u > area.h * 5u) { splitX = true; }
+                    else if(area.h * 4u > area.w * 5u) { splitX = false; }
+                    else { splitX = (rng.next() & 1u) != 0u; }
+                }
+
+                auto first = area, second = area;
+                if(splitX)
+                {
+                    first.w = rng.between(minLeaf, area.w - minLeaf);
+                    second.x += first.w;
+                    second.w -= first.w;
+                }
+                else
+                {
+                    first.h = rng.between(minLeaf, area.h - minLeaf);
+                    second.y += first.h;
+                    second.h -= first.h;
+                }
+
+                nodes[i].left = static_cast<uint32_t>(nodes.size());
+                nodes[i].right = nodes[i].left + 1u;
+                nodes.push_back({ .area = first, .depth = nodes[i].depth + 1u });
+                nodes.push_back({ .area = second, .depth = nodes[i].depth + 1u });
+            }
+
+            // Bottom up, each split joins a room from either half and passes one of them up.
+            for(auto i = nodes.size(); i-- > 0uz;)
+            {
+                auto& parent = nodes[i];
+                if(parent.left == 0u) { continue; }
+
+                auto rng = counter_rng{ seed, (uint64_t{i} << 8u) | 0x80u };
+                const auto a = center(_rooms[nodes[parent.left].room]), b = center(_rooms[nodes[parent.right].room]);
+
+                if((rng.next() & 1u) != 0u)
+                {
+                    _corridors.push_back({ std::min(a.first, b.first), a.second, std::max(a.first, b.first) - std::min(a.first, b.first) + 1u, 1u });
+                    _corridors.push_back({ b.first, std::min(a.second, b.second), 1u, std::max(a.second, b.second) - std::min(a.second, b.second) + 1u });
+                }
+                else
+                {
+                    _corridors.push_back({ a.first, std::min(a.second, b.second), 1u, std::max(a.second, b.second) - std::min(a.second, b.second) + 1u });
+                    _corridors.push_back({ std::min(a.first, b.first), b.second, std::max(a.first, b.first) - std::min(a.first, b.first) + 1u, 1u });
+                }
+
+                parent.room = (rng.next() & 1u) != 0u ? nodes[parent.left].room : nodes[parent.right].room;
+            }
+
+            // Rooms first, then corridors, so a drawn area only looks at what is near it.
+            _bins_x = (width + bin_size - 1u) / bin_size;
+            _bins.assign(size_t{_bins_x} * ((height + bin_size - 1u) / bin_size), {});
+
+            for(auto i = 0uz; i < _rooms.size() + _corridors.size(); ++i)
+            {
+                const auto& r = i < _rooms.size() ? _rooms[i] : _corridors[i - _rooms.size()];
+
+                for(auto by = r.y / bin_size; by <= (r.y + r.h - 1u) / bin_size; ++by)
+                {
+                    for(auto bx = r.x / bin_size; bx <= (r.x + r.w - 1u) / bin_size; ++bx) { _bins[(size_t{by} * _bins_x) + bx].push_back(static_cast<uint32_t>(i)); }
+                }
+            }
+        }
+
+        // Sets the floor cells of the w x h area at (x0, y0) to 1 in 'out', in row order. Other cells are left as they are.
+        void rasterize(uint32_t x0, uint32_t y0, uint32_t w, uint32_t h, std::span<uint8_t> out) const
+        {
+            if(out.size() < size_t{w} * h) { throw std::invalid_argument("bsp_dungeon: output is smaller than the area."); }
+
+            const auto draw = [&](const rect& r) {
+                if(!r.overlaps(x0, y0, w, h)) { return; }
+
+                const auto left = std::max(r.x, x0) - x0, right = std::min(r.x + r.w, x0 + w) - x0;
+                const auto top = std::max(r.y, y0) - y0, bottom = std::min(r.y + r.h, y0 + h) - y0;
+
+                for(auto y = top; y < bottom; ++y) { std::fill(out.begin() + (size_t{y} * w) + left, out.begin() + (size_t{y} * w) + right, uint8_t{1u}); }
+            };
+
+            if(_bins.empty() || w == 0u || h == 0u) { return; }
+
+            const auto binsY = static_cast<uint32_t>(_bins.size() / _bins_x);
+            const auto lastX = std::min((x0 + w - 1u) / bin_size, _bins_x - 1u), lastY = std::min((y0 + h - 1u) / bin_size, binsY - 1u);
+
+            // A rect in several bins is drawn more than once, which does no harm.
+            for(auto by = y0 / bin_size; by <= lastY; ++by)
+            {
+                for(auto bx = x0 / bin_size; bx <= lastX; ++bx)
+                {
+                    for(const auto i : _bins[(size_t{by} * _bins_x) + bx]) { draw(i < _rooms.size() ? _rooms[i] : _corridors[i - _rooms.size()]); }
+                }
+            }
+        }
+
+        [[nodiscard]] std::span<const rect> rooms() const { return _rooms; }
+        [[nodiscard]] std::span<const rect> corridors() const { return _corridors; }
+
+    private:
+        [[nodiscard]] static constexpr std::pair<uint32_t, uint32_t> center(const rect& r) { return { r.x + (r.w / 2u), r.y + (r.h / 2u) }; }
+
+        static constexpr uint32_t bin_size = 64u;
+
+        std::vector<rect> _rooms, _corridors;
+        std::vector<std::vector<uint32_t>> _bins;
+        uint32_t _bins_x = 0u;
+    };
+}
+
+#endif
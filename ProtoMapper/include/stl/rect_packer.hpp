@@ -0,0 +1,197 @@
+#ifndef PROTO_RECT_PACKER_HPP
+#define PROTO_RECT_PACKER_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace proto
+{
+    struct packed_rect
+    {
+        uint32_t x = 0u, y = 0u, w = 0u, h = 0u;
+
+        bool operator==(const packed_rect&) const = default;
+    };
+
+    /**
+     * @brief Bottom-left skyline rectangle packer.
+     *
+     * The packed area is tracked as a list of horizontal segments (the skyline). Each rectangle goes where its
+     * top edge ends up lowest, ties broken by the narrowest segment. Space below the skyline is never reused,
+     * which costs a little density but keeps every insert linear in the number of segments.
+     */
+    class skyline_packer
+    {
+    public:
+        skyline_packer(uint32_t width, uint32_t height) : _width(width), _height(height) { reset(); }
+
+        void reset()
+        {
+            _skyline.assign(1uz, segment{ 0u, 0u, _width });
+            _usedArea = 0uz;
+        }
+
+        [[nodiscard]] uint32_t width() const { return _width; }
+        [[nodiscard]] uint32_t height() const { return _height; }
+        [[nodiscard]] size_t used_area() const { return _usedArea; }
+
+        // Fraction of the page covered by packed rectangles.
+        [[nodiscard]] double occupancy() const
+        {
+            return static_cast<double>(_usedArea) / (static_cast<double>(_width) * static_cast<double>(_height));
+        }
+
+        // Places a w x h rectangle, or returns nothing if it does not fit anywhere.
+        [[nodiscard]] std::optional<packed_rect> insert(uint32_t w, uint32_t h)
+        {
+            auto best = _skyline.size();
+            uint32_t bestTop = ~0u, bestWidth = ~0u, bestY = 0u;
+
+            for(auto i = 0uz; i < _skyline.size(); ++i)
+            {
+                if(const auto y = fit(i, w, h); y && (*y + h < bestTop || (*y + h == bestTop && _skyline[i].w < bestWidth)))
+                {
+                    best = i;
+                    bestTop = *y + h;
+                    bestWidth = _skyline[i].w;
+                    bestY = *y;
+                }
+            }
+
+            if(best == _skyline.size()) { return std::nullopt; }
+
+            const auto rect = packed_rect{ _skyline[best].x, bestY, w, h };
+            place(best, rect);
+            _usedArea += size_t{w} * size_t{h};
+
+            return rect;
+        }
+
+    private:
+        struct segment
+        {
+            uint32_t x, y, w;
+        };
+
+        // The y a w x h rectangle would rest at if its left edge sits on segment i.
+        [[nodiscard]] std::optional<uint32_t> fit(size_t i, uint32_t w, uint32_t h) const
+        {
+            const auto x = _skyline[i].x;
+            if(x + w > _width) { return std::nullopt; }
+
+            auto y = 0u;
+            auto remaining = static_cast<int64_t>(w);
+
+            for(auto j = i; remaining > 0; ++j)
+            {
+                y = std::max(y, _skyline[j].y);
+                if(y + h > _height) { return std::nullopt; }
+
+                remaining -= _skyline[j].w;
+            }
+
+            return y;
+        }
+
+        void place(size_t i, const packed_rect& rect)
+        {
+            _skyline.insert(_skyline.begin() + static_cast<ptrdiff_t>(i), segment{ rect.x, rect.y + rect.h, rect.w });
+
+            // Trim or drop the segments now hidden under the new one.
+            const auto right = rect.x + rect.w;
+
+            for(auto j = i + 1uz; j < _skyline.size();)
+            {
+                auto& seg = _skyline[j];
+                if(seg.x >= right) { break; }
+
+                const auto end = seg.x + seg.w;
+
+                if(end <= right)
+                {
+                    _skyline.erase(_skyline.begin() + static_cast<ptrdiff_t>(j));
+                    continue;
+                }
+
+                seg.w = end - right;
+                seg.x = right;
+                break;
+            }
+
+            // Merge neighbours of equal height.
+            for(auto j = 0uz; j + 1uz < _skyline.size();)
+            {
+                if(_skyline[j].y == _skyline[j + 1uz].y)
+                {
+                    _skyline[j].w += _skyline[j + 1uz].w;
+                    _skyline.erase(_skyline.begin() + static_cast<ptrdiff_t>(j + 1uz));
+                }
+                else
+                {
+                    ++j;
+                }
+            }
+        }
+
+        uint32_t _width, _height;
+        size_t _usedArea = 0uz;
+        std::vector<segment> _skyline;
+    };
+
+    struct page_placement
+    {
+        size_t page = 0uz;
+        packed_rect rect;
+    };
+
+    /**
+     * @brief Packs every size into as few page_width x page_height pages as it can. Sizes are placed tallest
+     * first, each one on the first page it fits, and the result is in the order of 'sizes'.
+     *
+     * @throws std::invalid_argument if a size is larger than a page.
+     */
+    [[nodiscard]] inline std::vector<page_placement> pack_rects(std::span<const packed_rect> sizes, uint32_t page_width, uint32_t page_height)
+    {
+        auto order = std::vector<size_t>(sizes.size());
+        std::iota(order.begin(), order.end(), 0uz);
+        std::ranges::stable_sort(order, [&sizes](size_t a, size_t b) {
+            return (sizes[a].h != sizes[b].h) ? sizes[a].h > sizes[b].h : sizes[a].w > sizes[b].w;
+        });
+
+        auto pages = std::vector<skyline_packer>{};
+        auto result = std::vector<page_placement>(sizes.size());
+
+        for(const auto index : order)
+        {
+            const auto& size = sizes[index];
+            if(size.w > page_width || size.h > page_height) { throw std::invalid_argument("Rectangle is larger than an atlas page."); }
+
+            auto placed = false;
+
+            for(auto page = 0uz; page < pages.size() && !placed; ++page)
+            {
+                if(auto rect = pages[page].insert(size.w, size.h))
+                {
+                    result[index] = page_placement{ page, *rect };
+                    placed = true;
+                }
+            }
+
+            if(!placed)
+            {
+                auto& page = pages.emplace_back(page_width, page_height);
+                result[index] = page_placement{ pages.size() - 1uz, *page.insert(size.w, size.h) };
+            }
+        }
+
+        return result;
+    }
+}
+
+#endif
@@ -0,0 +1,780 @@
+#ifndef PROTO_REGION_LABELS_HPP
+#define PROTO_REGION_LABELS_HPP
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <parallel.hpp>
+
+#if defined(__AVX2__)
+#define PROTO_REGION_AVX2 1
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#define PROTO_REGION_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define PROTO_REGION_NEON 1
+#include <arm_neon.h>
+#endif
+
+/**
+ * @brief Flood fill and connected-component labelling over grids of 32-bit values, such as tile layers.
+ *
+ * Grids are read the way TileLayer stores them: chunk_size x chunk_size chunks in row order, where
+ * source(cx, cy) returns a chunk's cells in row order, or an empty span for a chunk that holds 'fill' everywhere.
+ * Cells past the right and bottom edges of the grid are never read. Cells connect to their four neighbours when
+ * they hold the same value.
+ *
+ * Rows are scanned as runs of equal values, and the run searches compare a whole vector of cells at a time: AVX2
+ * (PROTO_ENABLE_AVX2) or SSE2 on x86 and NEON on AArch64, with a scalar fallback.
+ */
+namespace proto
+{
+    // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    namespace detail
+    {
+        // The first index in [first, last) that does not hold 'value', or last.
+        [[nodiscard]] inline size_t run_end(const uint32_t* cells, size_t first, size_t last, uint32_t value)
+        {
+            auto i = first;
+
+#if defined(PROTO_REGION_AVX2)
+            const auto wanted = _mm256_set1_epi32(static_cast<int>(value));
+            for(; i + 8uz <= last; i += 8uz)
+            {
+                const auto equal = _mm256_cmpeq_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(cells + i)), wanted); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+                if(_mm256_movemask_epi8(equal) != -1) { break; }
+            }
+#elif defined(PROTO_REGION_SSE2)
+            const auto wanted = _mm_set1_epi32(static_cast<int>(value));
+            for(; i + 4uz <= last; i += 4uz)
+            {
+                const auto equal = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(cells + i)), wanted); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+                if(_mm_movemask_epi8(equal) != 0xFFFF) { break; }
+            }
+#elif defined(PROTO_REGION_NEON)
+            const auto wanted = vdupq_n_u32(value);
+            for(; i + 4uz <= last; i += 4uz)
+            {
+                if(vminvq_u32(vceqq_u32(vld1q_u32(cells + i), wanted)) == 0u) { break; }
+            }
+#endif
+
+            // The vector loops stop on the block with the first mismatch, this finds it.
+            for(; i < last && cells[i] == value; ++i) {}
+            return i;
+        }
+
+        // The first index in [first, last) that holds 'value', or last.
+        [[nodiscard]] inline size_t find_value(const uint32_t* cells, size_t first, size_t last, uint32_t value)
+        {
+            auto i = first;
+
+#if defined(PROTO_REGION_AVX2)
+            const auto wanted = _mm256_set1_epi32(static_cast<int>(value));
+            for(; i + 8uz <= last; i += 8uz)
+            {
+                const auto equal = _mm256_cmpeq_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(cells + i)), wanted); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+                if(_mm256_movemask_epi8(equal) != 0) { break; }
+            }
+#elif defined(PROTO_REGION_SSE2)
+            const auto wanted = _mm_set1_epi32(static_cast<int>(value));
+            for(; i + 4uz <= last; i += 4uz)
+            {
+                const auto equal = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(cells + i)), wanted); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+                if(_mm_movemask_epi8(equal) != 0) { break; }
+            }
+#elif defined(PROTO_REGION_NEON)
+            const auto wanted = vdupq_n_u32(value);
+            for(; i + 4uz <= last; i += 4uz)
+            {
+                if(vmaxvq_u32(vceqq_u32(vld1q_u32(cells + i), wanted)) != 0u) { break; }
+            }
+#endif
+
+            for(; i < last && cells[i] != value; ++i) {}
+            return i;
+        }
+
+        // The lowest index i in [first, last] such that every cell in [i, last) holds 'value'.
+        [[nodiscard]] inline size_t run_begin(const uint32_t* cells, size_t first, size_t last, uint32_t value)
+        {
+            auto i = last;
+
+#if defined(PROTO_REGION_AVX2)
+            const auto wanted = _mm256_set1_epi32(static_cast<int>(value));
+            for(; i >= first + 8uz; i -= 8uz)
+            {
+                const auto equal = _mm256_cmpeq_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(cells + i - 8uz)), wanted); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+                if(_mm256_movemask_epi8(equal) != -1) { break; }
+            }
+#elif defined(PROTO_REGION_SSE2)
+            const auto wanted = _mm_set1_epi32(static_cast<int>(value));
+            for(; i >= first + 4uz; i -= 4uz)
+            {
+                const auto equal = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(cells + i - 4uz)), wanted); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+                if(_mm_movemask_epi8(equal) != 0xFFFF) { break; }
+            }
+#elif defined(PROTO_REGION_NEON)
+            const auto wanted = vdupq_n_u32(value);
+            for(; i >= first + 4uz; i -= 4uz)
+            {
+                if(vminvq_u32(vceqq_u32(vld1q_u32(cells + i - 4uz), wanted)) == 0u) { break; }
+            }
+#endif
+
+            for(; i > first && cells[i - 1uz] == value; --i) {}
+            return i;
+        }
+
+        // Union-find where the lower id always becomes the root, so labels come out in scan order.
+        class union_find
+        {
+        public:
+            void clear() { _parent.clear(); }
+            void reset(size_t count)
+            {
+                _parent.resize(count);
+                std::iota(_parent.begin(), _parent.end(), uint32_t{0u});
+            }
+
+            uint32_t add()
+            {
+                const auto id = static_cast<uint32_t>(_parent.size());
+                _parent.push_back(id);
+                return id;
+            }
+
+            [[nodiscard]] uint32_t find(uint32_t id)
+            {
+                // Path halving keeps the trees flat without recursion.
+                while(_parent[id] != id)
+                {
+                    _parent[id] = _parent[_parent[id]];
+                    id = _parent[id];
+                }
+
+                return id;
+            }
+
+            void unite(uint32_t a, uint32_t b)
+            {
+                a = find(a);
+                b = find(b);
+
+                if(a < b) { _parent[b] = a; }
+                else if(b < a) { _parent[a] = b; }
+            }
+
+            [[nodiscard]] size_t size() const { return _parent.size(); }
+
+        private:
+            std::vector<uint32_t> _parent;
+        };
+
+        template <typename Source>
+        concept chunk_source = std::invocable<Source&, uint32_t, uint32_t> &&
+            std::convertible_to<std::invoke_result_t<Source&, uint32_t, uint32_t>, std::span<const uint32_t>>;
+
+        // Row by row access to a chunked grid, with runs that carry on across chunk edges.
+        template <typename Source>
+        class chunk_rows
+        {
+        public:
+            chunk_rows(uint32_t width, uint32_t height, uint32_t chunkSize, Source& source, uint32_t fill)
+            : _width(width), _height(height), _chunkSize(chunkSize), _fill(fill), _source(source)
+            {
+            }
+
+            // Row y of chunk column cx, or nullptr if that chunk holds the fill value everywhere.
+            [[nodiscard]] const uint32_t* row(uint32_t cx, uint32_t y) const
+            {
+                const auto chunk = std::span<const uint32_t>{ _source(cx, y / _chunkSize) };
+                return chunk.empty() ? nullptr : chunk.data() + (size_t{y % _chunkSize} * _chunkSize);
+            }
+
+            [[nodiscard]] uint32_t at(uint32_t x, uint32_t y) const
+            {
+                const auto* cells = row(x / _chunkSize, y);
+                return cells == nullptr ? _fill : cells[x % _chunkSize];
+            }
+
+            // One past the end of the run of 'value' that starts at x.
+            [[nodiscard]] uint32_t right(uint32_t x, uint32_t y, uint32_t value) const
+            {
+                while(x < _width)
+                {
+                    const auto base = x - (x % _chunkSize);
+                    const auto end = std::min(_width, base + _chunkSize);
+                    const auto* cells = row(base / _chunkSize, y);
+
+                    if(cells == nullptr)
+                    {
+                        if(_fill != value) { return x; }
+                    }
+                    else if(const auto stop = base + static_cast<uint32_t>(run_end(cells, x - base, end - base, value)); stop < end)
+                    {
+                        return stop;
+                    }
+
+                    x = end;
+                }
+
+                return _width;
+            }
+
+            // The start of the run of 'value' that ends at x, which must hold it.
+            [[nodiscard]] uint32_t left(uint32_t x, uint32_t y, uint32_t value) const
+            {
+                auto end = x + 1u;
+
+                while(end > 0u)
+                {
+                    const auto base = (end - 1u) - ((end - 1u) % _chunkSize);
+                    const auto* cells = row(base / _chunkSize, y);
+
+                    if(cells == nullptr)
+                    {
+                        if(_fill != value) { return end; }
+                    }
+                    else if(const auto start = base + static_cast<uint32_t>(run_begin(cells, 0uz, end - base, value)); start > base)
+                    {
+                        return start;
+                    }
+
+                    end = base;
+                }
+
+                return 0u;
+            }
+
+            // The first cell in [x, last) of row y that holds 'value', or last.
+            [[nodiscard]] uint32_t find(uint32_t x, uint32_t last, uint32_t y, uint32_t value) const
+            {
+                while(x < last)
+                {
+                    const auto base = x - (x % _chunkSize);
+                    const auto end = std::min(last, base + _chunkSize);
+                    const auto* cells = row(base / _chunkSize, y);
+
+                    if(cells == nullptr)
+                    {
+                        if(_fill == value) { return x; }
+                    }
+                    else if(const auto found = base + static_cast<uint32_t>(find_value(cells, x - base, end - base, value)); found < end)
+                    {
+                        return found;
+                    }
+
+                    x = end;
+                }
+
+                return last;
+            }
+
+            [[nodiscard]] uint32_t width() const { return _width; }
+            [[nodiscard]] uint32_t height() const { return _height; }
+
+        private:
+            uint32_t _width, _height, _chunkSize, _fill;
+            Source& _source;
+        };
+
+        // One bit per cell, allocated a chunk at a time so a small fill on a huge map stays small.
+        class chunk_bits
+        {
+        public:
+            chunk_bits(uint32_t width, uint32_t height, uint32_t chunkSize)
+            : _chunkSize(chunkSize), _chunksX((width + chunkSize - 1u) / chunkSize), _rowWords((chunkSize + 63u) / 64u),
+              _chunks(size_t{_chunksX} * ((height + chunkSize - 1u) / chunkSize))
+            {
+            }
+
+            [[nodiscard]] bool test(uint32_t x, uint32_t y) const
+            {
+                const auto& bits = _chunks[index(x, y)];
+                if(!bits) { return false; }
+
+                const auto lx = x % _chunkSize;
+                return ((bits[word(lx, y % _chunkSize)] >> (lx % 64u)) & 1u) != 0u;
+            }
+
+            // Sets [first, last) of row y.
+            void set(uint32_t first, uint32_t last, uint32_t y)
+            {
+                while(first < last)
+                {
+                    const auto base = first - (first % _chunkSize);
+                    const auto end = std::min(last, base + _chunkSize);
+
+                    auto& bits = _chunks[index(first, y)];
+                    if(!bits) { bits = std::make_unique<uint64_t[]>(size_t{_rowWords} * _chunkSize); }
+
+                    for(auto lx = first - base; lx < end - base;)
+                    {
+                        const auto count = std::min(64u - (lx % 64u), (end - base) - lx);
+                        const auto mask = (count == 64u ? ~uint64_t{0u} : ((uint64_t{1u} << count) - 1u)) << (lx % 64u);
+
+                        bits[word(lx, y % _chunkSize)] |= mask;
+                        lx += count;
+                    }
+
+                    first = end;
+                }
+            }
+
+        private:
+            [[nodiscard]] size_t index(uint32_t x, uint32_t y) const { return (size_t{y / _chunkSize} * _chunksX) + (x / _chunkSize); }
+            [[nodiscard]] size_t word(uint32_t lx, uint32_t ly) const { return (size_t{ly} * _rowWords) + (lx / 64u); }
+
+            uint32_t _chunkSize, _chunksX, _rowWords;
+            std::vector<std::unique_ptr<uint64_t[]>> _chunks;
+        };
+    }
+
+    /**
+     * @brief Calls emit(x, y, length) for every row run of the 4-connected area of equal cells around (x, y), and
+     * returns the number of cells in it.
+     *
+     * A scanline fill: it keeps a stack of row spans still to be searched rather than recursing, so the stack grows
+     * with the outline of the area and not its size. The grid is only read, which makes this usable for previews.
+     * Write the runs back once it returns, not from inside emit().
+     */
+    template <typename Source, typename Emit>
+        requires detail::chunk_source<Source> && std::invocable<Emit&, uint32_t, uint32_t, uint32_t>
+    size_t scanline_fill(uint32_t width, uint32_t height, uint32_t chunk_size, Source&& source, uint32_t x, uint32_t y, Emit&& emit, uint32_t fill = 0u)
+    {
+        if(chunk_size == 0u) { throw std::invalid_argument("Chunk size must not be zero."); }
+        if(x >= width || y >= height) { return 0uz; }
+
+        const auto rows = detail::chunk_rows<std::remove_reference_t<Source>>{ width, height, chunk_size, source, fill };
+        const auto value = rows.at(x, y);
+        auto visited = detail::chunk_bits{ width, height, chunk_size };
+
+        // A span of a row to search, found from the row 'y - dy'.
+        struct pending_span
+        {
+            uint32_t y, first, last;
+            int dy;
+        };
+
+        auto pending = std::vector<pending_span>{};
+        auto filled = 0uz;
+
+        auto push = [&](uint32_t row, uint32_t first, uint32_t last, int dy) {
+            const auto next = static_cast<int64_t>(row) + dy;
+            if(first < last && next >= 0 && next < static_cast<int64_t>(height))
+            {
+                pending.push_back(pending_span{ static_cast<uint32_t>(next), first, last, dy });
+            }
+        };
+
+        auto take = [&](uint32_t row, uint32_t first, uint32_t last) {
+            visited.set(first, last, row);
+            emit(first, row, last - first);
+            filled += last - first;
+        };
+
+        const auto seedFirst = rows.left(x, y, value), seedLast = rows.right(x, y, value);
+        take(y, seedFirst, seedLast);
+        push(y, seedFirst, seedLast, -1);
+        push(y, seedFirst, seedLast, 1);
+
+        while(!pending.empty())
+        {
+            const auto span = pending.back();
+            pending.pop_back();
+
+            for(auto cx = rows.find(span.first, span.last, span.y, value); cx < span.last; cx = rows.find(cx, span.last, span.y, value))
+            {
+                if(visited.test(cx, span.y))
+                {
+                    cx = rows.right(cx, span.y, value);
+                    continue;
+                }
+
+                const auto first = rows.left(cx, span.y, value), last = rows.right(cx, span.y, value);
+                take(span.y, first, last);
+
+                // Onwards in full, back towards the row it came from only where the run overhangs that row's span.
+                push(span.y, first, last, span.dy);
+                push(span.y, first, std::min(last, span.first), -span.dy);
+                push(span.y, std::max(first, span.last), last, -span.dy);
+
+                cx = last;
+            }
+        }
+
+        return filled;
+    }
+
+    /**
+     * @brief Labels every 4-connected area of equal cells in a chunked grid, with labels numbered in scan order.
+     *
+     * build() labels each chunk on its own in parallel, as runs joined through a union-find, then joins the chunks
+     * along their edges and renumbers everything in a second pass. A chunk that is one area stores a single label
+     * instead of one per cell, so empty and solid chunks cost next to nothing. Two cells are connected exactly when
+     * they have the same label, which makes a built set of labels a cheap reachability test and fill preview.
+     */
+    class region_labels
+    {
+    public:
+        using value_type = uint32_t;
+        using label_type = uint32_t;
+
+        static constexpr label_type no_label = ~label_type{0u};
+
+        // Bounds are inclusive.
+        struct region
+        {
+            value_type value{};
+            size_t area{};
+            uint32_t min_x{}, min_y{}, max_x{}, max_y{};
+        };
+
+        region_labels() = default;
+
+        template <typename Source>
+            requires detail::chunk_source<Source>
+        void build(uint32_t width, uint32_t height, uint32_t chunk_size, Source&& source, value_type fill = 0u)
+        {
+            if(chunk_size == 0u) { throw std::invalid_argument("Chunk size must not be zero."); }
+
+            _width = width;
+            _height = height;
+            _chunkSize = chunk_size;
+            _chunksX = (width + chunk_size - 1u) / chunk_size;
+            _chunksY = (height + chunk_size - 1u) / chunk_size;
+
+            const auto count = size_t{_chunksX} * _chunksY;
+
+            _chunks.clear();
+            _chunks.resize(count);
+            _regions.clear();
+
+            auto cells = std::vector<std::span<const value_type>>(count);
+            auto locals = std::vector<std::vector<region>>(count);
+
+            parallel_for(count, [&](size_t first, size_t last) {
+                auto work = scratch{};
+
+                for(auto i = first; i < last; ++i)
+                {
+                    cells[i] = source(static_cast<uint32_t>(i % _chunksX), static_cast<uint32_t>(i / _chunksX));
+                    label_chunk(i, cells[i], fill, work, locals[i]);
+                }
+            }, 1uz);
+
+            merge(cells, locals, fill);
+        }
+
+        // The label of a cell, no_label outside the grid.
+        [[nodiscard]] label_type at(uint32_t x, uint32_t y) const
+        {
+            if(x >= _width || y >= _height) { return no_label; }
+
+            const auto& chunk = _chunks[(size_t{y / _chunkSize} * _chunksX) + (x / _chunkSize)];
+            return chunk.cells ? chunk.cells[(size_t{y % _chunkSize} * _chunkSize) + (x % _chunkSize)] : chunk.uniform;
+        }
+
+        [[nodiscard]] bool connected(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1) const
+        {
+            const auto label = at(x0, y0);
+            return label != no_label && label == at(x1, y1);
+        }
+
+        [[nodiscard]] const region& get(label_type label) const
+        {
+            if(label >= _regions.size()) { throw std::out_of_range("Region label is out of range."); }
+            return _regions[label];
+        }
+
+        [[nodiscard]] std::span<const region> regions() const { return _regions; }
+        [[nodiscard]] size_t size() const { return _regions.size(); }
+        [[nodiscard]] bool empty() const { return _regions.empty(); }
+
+        [[nodiscard]] uint32_t width() const { return _width; }
+        [[nodiscard]] uint32_t height() const { return _height; }
+
+        /**
+         * @brief Calls func(x, y, length) for every row run of a region, top to bottom. Only the chunks inside the
+         * region's bounds are read.
+         */
+        template <typename Func>
+            requires std::invocable<Func&, uint32_t, uint32_t, uint32_t>
+        void for_each_run(label_type label, Func&& func) const
+        {
+            const auto& area = get(label);
+
+            for(auto y = area.min_y; y <= area.max_y; ++y)
+            {
+                const auto ly = y % _chunkSize;
+                auto first = 0u, last = 0u;
+
+                auto extend = [&](uint32_t from, uint32_t to) {
+                    if(last == from && last > first)
+                    {
+                        last = to;
+                        return;
+                    }
+
+                    if(last > first) { func(first, y, last - first); }
+                    first = from;
+                    last = to;
+                };
+
+                for(auto cx = area.min_x / _chunkSize; cx <= area.max_x / _chunkSize; ++cx)
+                {
+                    const auto base = cx * _chunkSize;
+                    const auto from = std::max(area.min_x, base) - base, to = std::min(area.max_x + 1u, base + _chunkSize) - base;
+                    const auto& chunk = _chunks[(size_t{y / _chunkSize} * _chunksX) + cx];
+
+                    if(!chunk.cells)
+                    {
+                        if(chunk.uniform == label) { extend(base + from, base + to); }
+                        continue;
+                    }
+
+                    const auto* row = chunk.cells.get() + (size_t{ly} * _chunkSize);
+
+                    for(auto x = detail::find_value(row, from, to, label); x < to; x = detail::find_value(row, x, to, label))
+                    {
+                        const auto end = detail::run_end(row, x, to, label);
+                        extend(base + static_cast<uint32_t>(x), base + static_cast<uint32_t>(end));
+                        x = end;
+                    }
+                }
+
+                if(last > first) { func(first, y, last - first); }
+            }
+        }
+
+    private:
+        struct chunk_labels
+        {
+            std::unique_ptr<label_type[]> cells; // Null when the whole chunk is one region.
+            label_type uniform = 0u;
+        };
+
+        // A run of equal cells in one row of a chunk, its index in scratch::runs is its label until the chunk is renumbered.
+        struct run
+        {
+            uint32_t first, last, y;
+            value_type value;
+        };
+
+        // Per thread buffers for label_chunk(), kept across the chunks a thread labels.
+        struct scratch
+        {
+            detail::union_find sets;
+            std::vector<run> runs;
+            std::vector<label_type> remap;
+        };
+
+        static void include(region& into, const region& other)
+        {
+            into.area += other.area;
+            into.min_x = std::min(into.min_x, other.min_x);
+            into.min_y = std::min(into.min_y, other.min_y);
+            into.max_x = std::max(into.max_x, other.max_x);
+            into.max_y = std::max(into.max_y, other.max_y);
+        }
+
+        // Labels one chunk from 0 and lists its regions in 'out'.
+        void label_chunk(size_t index, std::span<const value_type> cells, value_type fill, scratch& work, std::vector<region>& out)
+        {
+            const auto x0 = static_cast<uint32_t>(index % _chunksX) * _chunkSize, y0 = static_cast<uint32_t>(index / _chunksX) * _chunkSize;
+            const auto w = std::min(_chunkSize, _width - x0), h = std::min(_chunkSize, _height - y0);
+            const auto stride = size_t{_chunkSize};
+
+            auto& chunk = _chunks[index];
+            const auto first = cells.empty() ? fill : cells[0];
+
+            auto uniform = true;
+            for(auto ly = 0uz; uniform && !cells.empty() && ly < h; ++ly) { uniform = detail::run_end(cells.data() + (ly * stride), 0uz, w, first) == w; }
+
+            if(uniform)
+            {
+                out.push_back(region{ first, size_t{w} * h, x0, y0, x0 + w - 1u, y0 + h - 1u });
+                return;
+            }
+
+            chunk.cells = std::make_unique_for_overwrite<label_type[]>(stride * stride);
+
+            work.sets.clear();
+            work.runs.clear();
+
+            for(auto ly = 0u, above = 0u; ly < h; ++ly)
+            {
+                const auto* row = cells.data() + (ly * stride);
+                auto* labels = chunk.cells.get() + (ly * stride);
+                const auto current = static_cast<uint32_t>(work.runs.size());
+
+                for(auto x = 0u; x < w;)
+                {
+                    const auto value = row[x];
+                    const auto end = static_cast<uint32_t>(detail::run_end(row, x + 1u, w, value));
+
+                    std::fill(labels + x, labels + end, work.sets.add());
+                    work.runs.push_back(run{ x, end, ly, value });
+
+                    x = end;
+                }
+
+                // Runs that overlap a run of the same value in the row above join it.
+                for(auto a = above, b = current; a < current && b < work.runs.size();)
+                {
+                    const auto& up = work.runs[a];
+                    const auto& down = work.runs[b];
+
+                    if(up.value == down.value && up.first < down.last && down.first < up.last) { work.sets.unite(a, b); }
+
+                    if(up.last < down.last) { ++a; }
+                    else { ++b; }
+                }
+
+                above = current;
+            }
+
+            // Roots come before the runs they absorbed, so one pass numbers them in scan order.
+            work.remap.resize(work.runs.size());
+
+            for(auto id = 0u; id < work.runs.size(); ++id)
+            {
+                const auto root = work.sets.find(id);
+                const auto& piece = work.runs[id];
+                const auto area = region{ piece.value, size_t{piece.last - piece.first}, x0 + piece.first, y0 + piece.y, x0 + piece.last - 1u, y0 + piece.y };
+
+                if(root == id)
+                {
+                    work.remap[id] = static_cast<label_type>(out.size());
+                    out.push_back(area);
+                }
+                else
+                {
+                    work.remap[id] = work.remap[root];
+                    include(out[work.remap[id]], area);
+                }
+            }
+
+            for(auto ly = 0uz; ly < h; ++ly)
+            {
+                auto* labels = chunk.cells.get() + (ly * stride);
+                for(auto x = 0uz; x < w; ++x) { labels[x] = work.remap[labels[x]]; }
+            }
+        }
+
+        // Joins the chunk labels along chunk edges and renumbers them into one set of regions.
+        void merge(std::span<const std::span<const value_type>> cells, std::span<const std::vector<region>> locals, value_type fill)
+        {
+            const auto count = locals.size();
+
+            auto bases = std::vector<label_type>(count + 1uz);
+            for(auto i = 0uz; i < count; ++i) { bases[i + 1uz] = bases[i] + static_cast<label_type>(locals[i].size()); }
+
+            auto sets = detail::union_find{};
+            sets.reset(bases.back());
+
+            auto cell = [&](size_t chunk, uint32_t lx, uint32_t ly) {
+                const auto offset = (size_t{ly} * _chunkSize) + lx;
+                const auto& labels = _chunks[chunk];
+
+                return std::pair{ cells[chunk].empty() ? fill : cells[chunk][offset], bases[chunk] + (labels.cells ? labels.cells[offset] : labels.uniform) };
+            };
+
+            // Walks the cells either side of an edge and joins the labels of every equal pair.
+            auto join = [&](size_t a, size_t b, uint32_t length, bool vertical) {
+                auto last = std::pair{ no_label, no_label };
+                const auto edge = _chunkSize - 1u;
+
+                for(auto i = 0u; i < length; ++i)
+                {
+                    const auto [va, la] = vertical ? cell(a, edge, i) : cell(a, i, edge);
+                    const auto [vb, lb] = vertical ? cell(b, 0u, i) : cell(b, i, 0u);
+
+                    if(va == vb && std::pair{ la, lb } != last)
+                    {
+                        sets.unite(la, lb);
+                        last = { la, lb };
+                    }
+
+                    // Both sides are one region, every other pair is the same.
+                    if(!_chunks[a].cells && !_chunks[b].cells) { break; }
+                }
+            };
+
+            for(auto cy = 0u; cy < _chunksY; ++cy)
+            {
+                for(auto cx = 0u; cx < _chunksX; ++cx)
+                {
+                    const auto i = (size_t{cy} * _chunksX) + cx;
+                    const auto w = std::min(_chunkSize, _width - (cx * _chunkSize)), h = std::min(_chunkSize, _height - (cy * _chunkSize));
+
+                    if(cx + 1u < _chunksX) { join(i, i + 1uz, h, true); }
+                    if(cy + 1u < _chunksY) { join(i, i + _chunksX, w, false); }
+                }
+            }
+
+            auto renumbered = std::vector<label_type>(bases.back());
+            _regions.reserve(bases.back());
+
+            for(auto chunk = 0uz; chunk < count; ++chunk)
+            {
+                for(auto local = 0u; local < locals[chunk].size(); ++local)
+                {
+                    const auto id = bases[chunk] + local;
+                    const auto root = sets.find(id);
+
+                    if(root == id)
+                    {
+                        renumbered[id] = static_cast<label_type>(_regions.size());
+                        _regions.push_back(locals[chunk][local]);
+                    }
+                    else
+                    {
+                        renumbered[id] = renumbered[root];
+                        include(_regions[renumbered[id]], locals[chunk][local]);
+                    }
+                }
+            }
+
+            parallel_for(count, [&](size_t first, size_t last) {
+                for(auto i = first; i < last; ++i)
+                {
+                    auto& chunk = _chunks[i];
+                    const auto* renumber = renumbered.data() + bases[i];
+
+                    if(!chunk.cells)
+                    {
+                        chunk.uniform = renumber[0];
+                        continue;
+                    }
+
+                    const auto w = std::min(_chunkSize, _width - (static_cast<uint32_t>(i % _chunksX) * _chunkSize));
+                    const auto h = std::min(_chunkSize, _height - (static_cast<uint32_t>(i / _chunksX) * _chunkSize));
+
+                    for(auto ly = 0uz; ly < h; ++ly)
+                    {
+                        auto* labels = chunk.cells.get() + (ly * _chunkSize);
+                        for(auto x = 0uz; x < w; ++x) { labels[x] = renumber[labels[x]]; }
+                    }
+                }
+            }, 1uz);
+        }
+
+        uint32_t _width{}, _height{}, _chunkSize{ 1u }, _chunksX{}, _chunksY{};
+        std::vector<chunk_labels> _chunks;
+        std::vector<region> _regions;
+    };
+    // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+}
+
+#endif
@@ -0,0 +1,377 @@
+#ifndef PROTO_SEGMENTED_ARRAY_HPP
+#define PROTO_SEGMENTED_ARRAY_HPP
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <compare>
+#include <concepts>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace proto
+{
+    /**
+     * @brief Requirements for a segment allocation policy. Segments are raw, uninitialized storage; the array
+     * constructs and destroys the elements itself.
+     */
+    template <typename P, typename T>
+    concept segment_policy = requires(P& policy, T* ptr, size_t count) {
+        { P::first_segment_shift } -> std::convertible_to<size_t>;
+        { policy.allocate_segment(count) } -> std::same_as<T*>;
+        { policy.deallocate_segment(ptr, count) } noexcept;
+    };
+
+    /**
+     * @brief Allocates each segment from the global heap. The first segment holds roughly a kilobyte of elements.
+     */
+    template <typename T>
+    struct default_segment_policy
+    {
+        static constexpr size_t first_segment_shift = std::bit_width(std::max(1024uz / sizeof(T), 8uz)) - 1uz;
+
+        [[nodiscard]] T* allocate_segment(size_t count)
+        {
+            return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t{alignof(T)}));
+        }
+
+        void deallocate_segment(T* ptr, size_t count) noexcept
+        {
+            ::operator delete(ptr, count * sizeof(T), std::align_val_t{alignof(T)});
+        }
+    };
+
+    // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    /**
+     * @brief An append-only friendly array that grows without ever moving its elements.
+     *
+     * Storage is a list of segments of B, B, 2B, 4B, ... elements, where B = 2^Policy::first_segment_shift. The
+     * segment holding index i is found with a single bit scan, and pointers and references to elements stay valid
+     * until the element itself is popped or the array is cleared.
+     *
+     * Use for_each_segment() for the tightest loops, it hands out each segment as a contiguous span.
+     *
+     * @tparam T The type of the data contained.
+     * @tparam Policy Where segment memory comes from, see segment_policy.
+     */
+    template <typename T, typename Policy = default_segment_policy<T>>
+        requires segment_policy<Policy, T>
+    class segmented_array
+    {
+        static constexpr size_t shift = Policy::first_segment_shift;
+        static constexpr size_t base = 1uz << shift;
+        static constexpr size_t max_segments = (sizeof(size_t) * 8uz) - shift;
+
+        template <bool Const>
+        class basic_iterator
+        {
+        public:
+            friend class segmented_array;
+
+            using iterator_concept = std::random_access_iterator_tag;
+            using iterator_category = std::random_access_iterator_tag;
+            using difference_type = ptrdiff_t;
+            using value_type = T;
+            using pointer = std::conditional_t<Const, const T*, T*>;
+            using reference = std::conditional_t<Const, const T&, T&>;
+            using owner_type = std::conditional_t<Const, const segmented_array, segmented_array>;
+
+            basic_iterator() = default;
+
+            basic_iterator(const basic_iterator<!Const>& other) requires Const // NOLINT(google-explicit-constructor)
+            : _owner(other._owner), _index(other._index), _ptr(other._ptr), _segmentEnd(other._segmentEnd)
+            {
+            }
+
+            reference operator*() const { return *_ptr; }
+            pointer operator->() const { return _ptr; }
+            reference operator[](difference_type offset) const { return *(*this + offset); }
+
+            // Only the segment boundary takes the slow path.
+            basic_iterator& operator++()
+            {
+                ++_index;
+
+                if(++_ptr == _segmentEnd) { seek(); }
+                return *this;
+            }
+
+            basic_iterator operator++(int) // NOLINT(cert-dcl21-cpp)
+            {
+                auto temp = *this;
+                ++*this;
+                return temp;
+            }
+
+            basic_iterator& operator--()
+            {
+                --_index;
+                seek();
+                return *this;
+            }
+
+            basic_iterator operator--(int) // NOLINT(cert-dcl21-cpp)
+            {
+                auto temp = *this;
+                --*this;
+                return temp;
+            }
+
+            basic_iterator& operator+=(difference_type offset)
+            {
+                _index = static_cast<size_t>(static_cast<difference_type>(_index) + offset);
+                seek();
+                return *this;
+            }
+
+            basic_iterator& operator-=(difference_type offset) { return *this += -offset; }
+
+            friend basic_iterator operator+(basic_iterator it, difference_type offset) { return it += offset; }
+            friend basic_iterator operator+(difference_type offset, basic_iterator it) { return it += offset; }
+            friend basic_iterator operator-(basic_iterator it, difference_type offset) { return it -= offset; }
+
+            friend difference_type operator-(const basic_iterator& lhs, const basic_iterator& rhs)
+            {
+                return static_cast<difference_type>(lhs._index) - static_cast<difference_type>(rhs._index);
+            }
+
+            bool operator==(const basic_iterator& other) const { return _index == other._index; }
+            std::strong_ordering operator<=>(const basic_iterator& other) const { return _index <=> other._index; }
+
+        private:
+            basic_iterator(owner_type* owner, size_t index) : _owner(owner), _index(index) { seek(); }
+
+            void seek()
+            {
+                if(_index >= _owner->_size)
+                {
+                    _ptr = _segmentEnd = nullptr;
+                    return;
+                }
+
+                const auto segment = segment_of(_index);
+                const auto first = segment_start(segment);
+
+                _ptr = _owner->_segments[segment] + (_index - first);
+                _segmentEnd = _owner->_segments[segment] + std::min(segment_size(segment), _owner->_size - first);
+            }
+
+            owner_type* _owner = nullptr;
+            size_t _index = 0uz;
+            pointer _ptr = nullptr;
+            pointer _segmentEnd = nullptr;
+        };
+
+    public:
+        using value_type = T;
+        using size_type = size_t;
+        using reference = T&;
+        using const_reference = const T&;
+        using iterator = basic_iterator<false>;
+        using const_iterator = basic_iterator<true>;
+
+        segmented_array() = default;
+        explicit segmented_array(Policy policy) : _policy(std::move(policy)) {}
+
+        segmented_array(const segmented_array& other) : _policy(other._policy)
+        {
+            reserve(other._size);
+            other.for_each_segment([this](std::span<const T> segment) {
+                for(const auto& item : segment) { emplace_back(item); }
+            });
+        }
+
+        segmented_array(segmented_array&& other) noexcept
+        : _policy(std::move(other._policy)), _segments(std::exchange(other._segments, {})),
+          _size(std::exchange(other._size, 0uz)), _allocated(std::exchange(other._allocated, 0uz))
+        {
+        }
+
+        segmented_array& operator=(const segmented_array& other)
+        {
+            if(this == &other) { return *this; }
+
+            auto temp = segmented_array{other};
+            swap(temp);
+            return *this;
+        }
+
+        segmented_array& operator=(segmented_array&& other) noexcept
+        {
+            if(this == &other) { return *this; }
+
+            release();
+            _policy = std::move(other._policy);
+            _segments = std::exchange(other._segments, {});
+            _size = std::exchange(other._size, 0uz);
+            _allocated = std::exchange(other._allocated, 0uz);
+            return *this;
+        }
+
+        ~segmented_array() { release(); }
+
+        void swap(segmented_array& other) noexcept
+        {
+            std::swap(_policy, other._policy);
+            std::swap(_segments, other._segments);
+            std::swap(_size, other._size);
+            std::swap(_allocated, other._allocated);
+        }
+
+        // Index of the segment holding element 'index'. Segment 0 and 1 both hold B elements, then sizes double.
+        [[nodiscard]] static constexpr size_t segment_of(size_t index)
+        {
+            return static_cast<size_t>(std::bit_width(index >> shift));
+        }
+
+        [[nodiscard]] static constexpr size_t segment_start(size_t segment)
+        {
+            return (segment == 0uz) ? 0uz : (base << (segment - 1uz));
+        }
+
+        [[nodiscard]] static constexpr size_t segment_size(size_t segment)
+        {
+            return (segment == 0uz) ? base : (base << (segment - 1uz));
+        }
+
+        [[nodiscard]] size_t size() const { return _size; }
+        [[nodiscard]] bool empty() const { return _size == 0uz; }
+        [[nodiscard]] size_t capacity() const { return (_allocated == 0uz) ? 0uz : segment_start(_allocated - 1uz) + segment_size(_allocated - 1uz); }
+        [[nodiscard]] const Policy& policy() const { return _policy; }
+
+        [[nodiscard]] T& operator[](size_t index) { return *locate(index); }
+        [[nodiscard]] const T& operator[](size_t index) const { return *locate(index); }
+
+        [[nodiscard]] T& at(size_t index)
+        {
+            if(index >= _size) { throw std::out_of_range("Index out of range."); }
+            return *locate(index);
+        }
+
+        [[nodiscard]] const T& at(size_t index) const
+        {
+            if(index >= _size) { throw std::out_of_range("Index out of range."); }
+            return *locate(index);
+        }
+
+        [[nodiscard]] T& front() { return *_segments[0]; }
+        [[nodiscard]] const T& front() const { return *_segments[0]; }
+        [[nodiscard]] T& back() { return *locate(_size - 1uz); }
+        [[nodiscard]] const T& back() const { return *locate(_size - 1uz); }
+
+        [[nodiscard]] iterator begin() { return iterator{this, 0uz}; }
+        [[nodiscard]] iterator end() { return iterator{this, _size}; }
+        [[nodiscard]] const_iterator begin() const { return const_iterator{this, 0uz}; }
+        [[nodiscard]] const_iterator end() const { return const_iterator{this, _size}; }
+        [[nodiscard]] const_iterator cbegin() const { return begin(); }
+        [[nodiscard]] const_iterator cend() const { return end(); }
+
+        template <typename... Args>
+        T& emplace_back(Args&&... args)
+        {
+            const auto segment = segment_of(_size);
+            if(segment >= _allocated) { allocate_through(segment); }
+
+            auto* slot = _segments[segment] + (_size - segment_start(segment));
+            std::construct_at(slot, std::forward<Args>(args)...);
+            ++_size;
+
+            return *slot;
+        }
+
+        void push_back(const T& value) { emplace_back(value); }
+        void push_back(T&& value) { emplace_back(std::move(value)); }
+
+        void pop_back()
+        {
+            std::destroy_at(locate(--_size));
+        }
+
+        // Allocates segments up front so the next 'count' total elements do not allocate.
+        void reserve(size_t count)
+        {
+            if(count > capacity()) { allocate_through(segment_of(count - 1uz)); }
+        }
+
+        // Destroys every element. The segments are kept for reuse.
+        void clear()
+        {
+            for_each_segment([](std::span<T> segment) { std::destroy(segment.begin(), segment.end()); });
+            _size = 0uz;
+        }
+
+        // Frees the segments past the last one in use.
+        void shrink_to_fit()
+        {
+            const auto used = (_size == 0uz) ? 0uz : segment_of(_size - 1uz) + 1uz;
+
+            while(_allocated > used)
+            {
+                --_allocated;
+                _policy.deallocate_segment(std::exchange(_segments[_allocated], nullptr), segment_size(_allocated));
+            }
+        }
+
+        /**
+         * @brief Calls func(std::span<T>) once per segment in use, in order. The last span only covers the live
+         * elements.
+         */
+        template <typename Func>
+        void for_each_segment(Func&& func)
+        {
+            visit_segments(*this, func);
+        }
+
+        template <typename Func>
+        void for_each_segment(Func&& func) const
+        {
+            visit_segments(*this, func);
+        }
+
+    private:
+        template <typename Self, typename Func>
+        static void visit_segments(Self& self, Func& func)
+        {
+            for(auto segment = 0uz, first = 0uz; first < self._size; first += segment_size(segment), ++segment)
+            {
+                func(std::span{ self._segments[segment], std::min(segment_size(segment), self._size - first) });
+            }
+        }
+
+        [[nodiscard]] T* locate(size_t index) const
+        {
+            const auto segment = segment_of(index);
+            return _segments[segment] + (index - segment_start(segment));
+        }
+
+        void allocate_through(size_t segment)
+        {
+            if(segment >= max_segments) { throw std::length_error("segmented_array is out of segments."); }
+
+            for(; _allocated <= segment; ++_allocated)
+            {
+                _segments[_allocated] = _policy.allocate_segment(segment_size(_allocated));
+            }
+        }
+
+        void release() noexcept
+        {
+            clear();
+            shrink_to_fit();
+        }
+
+        [[no_unique_address]] Policy _policy{};
+        std::array<T*, max_segments> _segments{};
+        size_t _size = 0uz;
+        size_t _allocated = 0uz;
+    };
+    // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+}
+
+#endif
@@ -0,0 +1,189 @@
+#ifndef PROTO_SPARSE_SET_HPP
+#define PROTO_SPARSE_SET_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace proto
+{
+    /*
+        Entity identifiers are 32 bits: the low 20 bits index into the sparse pages and the high 12 bits
+        hold a version that is bumped every time an index is recycled.
+    */
+    using entity_type = uint32_t;
+
+    inline constexpr entity_type entity_index_bits = 20u;
+    inline constexpr entity_type entity_index_mask = (1u << entity_index_bits) - 1u;
+    inline constexpr entity_type entity_version_mask = ~entity_index_mask;
+    inline constexpr entity_type null_entity = ~entity_type{};
+
+    [[nodiscard]] constexpr entity_type entity_index(entity_type e) { return e & entity_index_mask; }
+    [[nodiscard]] constexpr entity_type entity_version(entity_type e) { return e >> entity_index_bits; }
+    [[nodiscard]] constexpr entity_type make_entity(entity_type index, entity_type version)
+    {
+        return (index & entity_index_mask) | (version << entity_index_bits);
+    }
+
+    /**
+     * @brief A paged sparse set of entities. The dense array is packed, so iteration never touches a hole.
+     *
+     * Removal swaps the last element into the freed slot, which keeps the dense array contiguous at the cost of order.
+     */
+    class sparse_set
+    {
+    public:
+        static constexpr size_t page_size = 4096uz;
+
+        sparse_set() = default;
+        sparse_set(const sparse_set&) = delete;
+        sparse_set(sparse_set&&) noexcept = default;
+        sparse_set& operator=(const sparse_set&) = delete;
+        sparse_set& operator=(sparse_set&&) noexcept = default;
+        virtual ~sparse_set() = default;
+
+        [[nodiscard]] bool contains(entity_type e) const
+        {
+            const auto idx = entity_index(e);
+            const auto page = idx / page_size;
+
+            if(page >= _sparse.size() || !_sparse[page]) { return false; }
+
+            const auto pos = (*_sparse[page])[idx % page_size];
+            return pos != null_entity && _dense[pos] == e;
+        }
+
+        // Position of the entity inside the dense array. The entity must be contained in the set.
+        [[nodiscard]] size_t index(entity_type e) const
+        {
+            const auto idx = entity_index(e);
+            return (*_sparse[idx / page_size])[idx % page_size];
+        }
+
+        size_t insert(entity_type e)
+        {
+            if(contains(e)) { throw std::invalid_argument("Entity already exists in sparse_set."); }
+
+            const auto pos = _dense.size();
+            sparse_slot(e) = static_cast<entity_type>(pos);
+            _dense.push_back(e);
+
+            return pos;
+        }
+
+        void erase(entity_type e)
+        {
+            if(!contains(e)) { return; }
+
+            const auto pos = index(e);
+            const auto last = _dense.size() - 1uz;
+
+            swap_and_pop(pos, last);
+
+            const auto moved = _dense[last];
+            _dense[pos] = moved;
+            sparse_slot(moved) = static_cast<entity_type>(pos);
+            sparse_slot(e) = null_entity;
+            _dense.pop_back();
+        }
+
+        virtual void clear()
+        {
+            _dense.clear();
+            _sparse.clear();
+        }
+
+        [[nodiscard]] size_t size() const { return _dense.size(); }
+        [[nodiscard]] bool empty() const { return _dense.empty(); }
+        [[nodiscard]] std::span<const entity_type> entities() const { return _dense; }
+
+        [[nodiscard]] auto begin() const { return _dense.cbegin(); }
+        [[nodiscard]] auto end() const { return _dense.cend(); }
+
+    protected:
+        // Called before the dense slot at 'pos' is overwritten by the one at 'last'. Derived pools mirror the move.
+        virtual void swap_and_pop([[maybe_unused]] size_t pos, [[maybe_unused]] size_t last) {}
+
+    private:
+        using page_type = std::array<entity_type, page_size>;
+
+        entity_type& sparse_slot(entity_type e)
+        {
+            const auto idx = entity_index(e);
+            const auto page = idx / page_size;
+
+            if(page >= _sparse.size()) { _sparse.resize(page + 1uz); }
+
+            if(!_sparse[page])
+            {
+                _sparse[page] = std::make_unique<page_type>();
+                _sparse[page]->fill(null_entity);
+            }
+
+            return (*_sparse[page])[idx % page_size];
+        }
+
+        std::vector<std::unique_ptr<page_type>> _sparse;
+        std::vector<entity_type> _dense;
+    };
+
+    /**
+     * @brief A sparse set that stores one component per entity in a contiguous column, parallel to the dense array.
+     *
+     * @tparam T The component type.
+     */
+    template <typename T>
+    class component_pool : public sparse_set
+    {
+    public:
+        using value_type = T;
+
+        template <typename... Args>
+        T& emplace(entity_type e, Args&&... args)
+        {
+            insert(e);
+
+            if constexpr (std::is_aggregate_v<T>)
+            {
+                return _components.emplace_back(T{std::forward<Args>(args)...});
+            }
+            else
+            {
+                return _components.emplace_back(std::forward<Args>(args)...);
+            }
+        }
+
+        [[nodiscard]] T& get(entity_type e) { return _components[index(e)]; }
+        [[nodiscard]] const T& get(entity_type e) const { return _components[index(e)]; }
+
+        [[nodiscard]] T* try_get(entity_type e) { return contains(e) ? &_components[index(e)] : nullptr; }
+        [[nodiscard]] const T* try_get(entity_type e) const { return contains(e) ? &_components[index(e)] : nullptr; }
+
+        // The component column. Element 'i' belongs to entities()[i].
+        [[nodiscard]] std::span<T> components() { return _components; }
+        [[nodiscard]] std::span<const T> components() const { return _components; }
+
+        void clear() override
+        {
+            sparse_set::clear();
+            _components.clear();
+        }
+
+    protected:
+        void swap_and_pop(size_t pos, size_t last) override
+        {
+            if(pos != last) { _components[pos] = std::move(_components[last]); }
+            _components.pop_back();
+        }
+
+    private:
+        std::vector<T> _components;
+    };
+}
+
+#endif
@@ -0,0 +1,427 @@
+#ifndef PROTO_SPATIAL_GRID_HPP
+#define PROTO_SPATIAL_GRID_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include <flat_hash_map.hpp>
+
+namespace proto
+{
+    struct spatial_box
+    {
+        float min_x = 0.f, min_y = 0.f, max_x = 0.f, max_y = 0.f;
+
+        [[nodiscard]] static constexpr spatial_box around(float x, float y, float half_w = 0.f, float half_h = 0.f)
+        {
+            return { x - half_w, y - half_h, x + half_w, y + half_h };
+        }
+
+        // Touching edges count as overlapping, so a point on the border of a selection is inside it.
+        [[nodiscard]] constexpr bool overlaps(const spatial_box& other) const
+        {
+            return min_x <= other.max_x && other.min_x <= max_x && min_y <= other.max_y && other.min_y <= max_y;
+        }
+
+        bool operator==(const spatial_box&) const = default;
+    };
+
+    struct ray_hit
+    {
+        uint32_t id = 0u;
+        float t = 0.f; // Along the ray direction, 0 if the ray starts inside the box.
+
+        bool operator==(const ray_hit&) const = default;
+    };
+
+    /**
+     * @brief A loose uniform grid over axis aligned boxes. Only occupied cells are stored, in a hash map, so the
+     * grid has no bounds.
+     *
+     * A box is filed under the one cell that holds its center. Insert, remove and move then touch a single cell
+     * however large the box is. Queries make up for it by widening their search by the largest half extent ever
+     * inserted. Pick a cell size near the typical box size. Much smaller cells make that widening cover many
+     * cells. Much larger cells crowd too many boxes into each one.
+     *
+     * Ids index a table of slots, so they should be small and dense, like entity indexes. Each cell is a list
+     * threaded through the slots, so nothing is allocated per cell. Queries write up to out.size() ids into 'out'
+     * and return how many matched in total, so a caller can grow its buffer and ask again. Queries are const and
+     * may run concurrently with each other.
+     */
+    class spatial_grid
+    {
+    public:
+        using id_type = uint32_t;
+
+        explicit spatial_grid(float cell_size) : _cellSize(cell_size), _inverse(1.f / cell_size)
+        {
+            if(!(cell_size > 0.f) || !std::isfinite(cell_size)) { throw std::invalid_argument("Cell size must be positive."); }
+        }
+
+        [[nodiscard]] size_t size() const { return _size; }
+        [[nodiscard]] bool empty() const { return _size == 0uz; }
+        [[nodiscard]] float cell_size() const { return _cellSize; }
+        [[nodiscard]] size_t occupied_cells() const { return _heads.size(); }
+
+        [[nodiscard]] bool contains(id_type id) const { return id < _slots.size() && _slots[id].used; }
+
+        // The box 'id' was filed with, it must be in the grid.
+        [[nodiscard]] const spatial_box& bounds(id_type id) const
+        {
+            if(!contains(id)) { throw std::out_of_range("Id is not in the grid."); }
+            return _slots[id].box;
+        }
+
+        // Makes room for ids below 'count' up front.
+        void reserve(size_t count)
+        {
+            if(count > _slots.size()) { _slots.resize(count); }
+        }
+
+        /**
+         * @throws std::invalid_argument if the id is already in the grid or the box is not finite.
+         */
+        void insert(id_type id, const spatial_box& box)
+        {
+            check(box);
+            if(contains(id)) { throw std::invalid_argument("Id is already in the grid."); }
+
+            reserve(size_t{id} + 1uz);
+
+            link(id, box, key_of(box));
+            ++_size;
+            grow(box);
+        }
+
+        void insert(std::span<const id_type> ids, std::span<const spatial_box> boxes)
+        {
+            if(ids.size() != boxes.size()) { throw std::invalid_argument("Every id needs a box."); }
+            if(ids.empty()) { return; }
+
+            reserve(size_t{std::ranges::max(ids)} + 1uz);
+
+            for(auto i = 0uz; i < ids.size(); ++i) { insert(ids[i], boxes[i]); }
+        }
+
+        /**
+         * @throws std::out_of_range if the id is not in the grid.
+         */
+        void move(id_type id, const spatial_box& box)
+        {
+            check(box);
+            if(!contains(id)) { throw std::out_of_range("Id is not in the grid."); }
+
+            grow(box);
+
+            // Most moves stay inside the cell, which only needs the box replaced.
+            if(const auto key = key_of(box); key != _slots[id].key)
+            {
+                unlink(id);
+                link(id, box, key);
+            }
+            else
+            {
+                _slots[id].box = box;
+            }
+        }
+
+        void move(std::span<const id_type> ids, std::span<const spatial_box> boxes)
+        {
+            if(ids.size() != boxes.size()) { throw std::invalid_argument("Every id needs a box."); }
+
+            for(auto i = 0uz; i < ids.size(); ++i) { move(ids[i], boxes[i]); }
+        }
+
+        // Returns false if the id was not in the grid.
+        bool remove(id_type id)
+        {
+            if(!contains(id)) { return false; }
+
+            unlink(id);
+            --_size;
+
+            return true;
+        }
+
+        // Returns how many of the ids were in the grid.
+        size_t remove(std::span<const id_type> ids)
+        {
+            return static_cast<size_t>(std::ranges::count_if(ids, [this](id_type id) { return remove(id); }));
+        }
+
+        void clear()
+        {
+            _heads.clear();
+            _slots.clear();
+            _size = 0uz;
+            _maxHalf = 0.f;
+        }
+
+        // Every box that overlaps 'area'.
+        [[nodiscard]] size_t query(const spatial_box& area, std::span<id_type> out) const
+        {
+            if(!finite(area)) { return 0uz; }
+
+            return collect(area, out, [&area](const spatial_box& box) { return box.overlaps(area); });
+        }
+
+        // Every box within 'radius' of (x, y).
+        [[nodiscard]] size_t query(float x, float y, float radius, std::span<id_type> out) const
+        {
+            const auto area = spatial_box::around(x, y, radius, radius);
+            if(!finite(area) || radius < 0.f) { return 0uz; }
+
+            return collect(area, out, [x, y, limit = radius * radius](const spatial_box& box) {
+                const auto dx = x - std::clamp(x, box.min_x, box.max_x);
+                const auto dy = y - std::clamp(y, box.min_y, box.max_y);
+                return (dx * dx) + (dy * dy) <= limit;
+            });
+        }
+
+        /**
+         * @brief Every box hit by the ray from (x, y) along (dx, dy), up to 'max_t' times its length. The nearest
+         * out.size() hits are written nearest first, ties in no particular order.
+         */
+        [[nodiscard]] size_t query_ray(float x, float y, float dx, float dy, float max_t, std::span<ray_hit> out) const
+        {
+            if(!std::isfinite(x) || !std::isfinite(y) || !std::isfinite(dx) || !std::isfinite(dy) || !std::isfinite(max_t)) { return 0uz; }
+            if((dx == 0.f && dy == 0.f) || max_t < 0.f || _size == 0uz) { return 0uz; }
+
+            auto found = 0uz, written = 0uz;
+
+            const auto test = [&](id_type id) {
+                const auto t = intersect(_slots[id].box, x, y, dx, dy, max_t);
+                if(t < 0.f) { return; }
+
+                ++found;
+                keep_nearest(out, written, ray_hit{ id, t });
+            };
+
+            // A ray across most of the occupied cells is cheaper as a scan over them.
+            const auto reach = static_cast<int64_t>(std::ceil(_maxHalf * _inverse));
+            const auto start = cell_of(x, y), end = cell_of(x + (dx * max_t), y + (dy * max_t));
+            const auto length = std::abs(int64_t{end.x} - start.x) + std::abs(int64_t{end.y} - start.y) + 1;
+
+            if(static_cast<uint64_t>(length) * static_cast<uint64_t>((2 * reach) + 1) > _heads.size())
+            {
+                for(const auto& [key, head] : _heads) { walk(head, test); }
+                return found;
+            }
+
+            /*
+                Walk the cells along the ray. Boxes are filed by their center, so every step looks 'reach' cells
+                either side. The window only ever slides one cell right or left, up or down, so only the strip
+                it slides onto is new.
+            */
+            const auto step_x = dx > 0.f ? 1 : -1, step_y = dy > 0.f ? 1 : -1;
+            const auto delta_x = dx != 0.f ? std::abs(_cellSize / dx) : std::numeric_limits<float>::infinity();
+            const auto delta_y = dy != 0.f ? std::abs(_cellSize / dy) : std::numeric_limits<float>::infinity();
+
+            const auto boundary = [this](int32_t c, int step) { return static_cast<float>(c + (step > 0 ? 1 : 0)) * _cellSize; };
+            auto next_x = dx != 0.f ? (boundary(start.x, step_x) - x) / dx : std::numeric_limits<float>::infinity();
+            auto next_y = dy != 0.f ? (boundary(start.y, step_y) - y) / dy : std::numeric_limits<float>::infinity();
+
+            auto cx = int64_t{start.x}, cy = int64_t{start.y};
+
+            for(auto wy = cy - reach; wy <= cy + reach; ++wy)
+            {
+                for(auto wx = cx - reach; wx <= cx + reach; ++wx) { visit(wx, wy, test); }
+            }
+
+            for(auto steps = length - 1; steps > 0; --steps)
+            {
+                if(next_x < next_y)
+                {
+                    cx += step_x;
+                    next_x += delta_x;
+                    for(auto wy = cy - reach; wy <= cy + reach; ++wy) { visit(cx + (step_x * reach), wy, test); }
+                }
+                else
+                {
+                    cy += step_y;
+                    next_y += delta_y;
+                    for(auto wx = cx - reach; wx <= cx + reach; ++wx) { visit(wx, cy + (step_y * reach), test); }
+                }
+            }
+
+            return found;
+        }
+
+    private:
+        static constexpr uint32_t npos = ~0u;
+
+        struct cell_key
+        {
+            int32_t x = 0, y = 0;
+        };
+
+        struct slot
+        {
+            spatial_box box;
+            uint64_t key = 0u;
+            uint32_t next = npos, prev = npos;
+            bool used = false;
+        };
+
+        [[nodiscard]] static bool finite(const spatial_box& box)
+        {
+            return std::isfinite(box.min_x) && std::isfinite(box.min_y) && std::isfinite(box.max_x) && std::isfinite(box.max_y);
+        }
+
+        static void check(const spatial_box& box)
+        {
+            if(!finite(box) || box.min_x > box.max_x || box.min_y > box.max_y) { throw std::invalid_argument("Box must be finite and not inverted."); }
+        }
+
+        [[nodiscard]] static uint64_t pack(int64_t x, int64_t y)
+        {
+            return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32u) | static_cast<uint32_t>(y);
+        }
+
+        [[nodiscard]] static cell_key unpack(uint64_t key)
+        {
+            return { static_cast<int32_t>(static_cast<uint32_t>(key >> 32u)), static_cast<int32_t>(static_cast<uint32_t>(key)) };
+        }
+
+        // Far enough out that widening a search by a cell or two never wraps around.
+        [[nodiscard]] int32_t coord(float v) const
+        {
+            static constexpr float limit = 1'000'000'000.f;
+            return static_cast<int32_t>(std::clamp(std::floor(v * _inverse), -limit, limit));
+        }
+
+        [[nodiscard]] cell_key cell_of(float x, float y) const { return { coord(x), coord(y) }; }
+
+        [[nodiscard]] uint64_t key_of(const spatial_box& box) const
+        {
+            const auto c = cell_of((box.min_x * 0.5f) + (box.max_x * 0.5f), (box.min_y * 0.5f) + (box.max_y * 0.5f));
+            return pack(c.x, c.y);
+        }
+
+        void grow(const spatial_box& box)
+        {
+            _maxHalf = std::max({ _maxHalf, (box.max_x - box.min_x) * 0.5f, (box.max_y - box.min_y) * 0.5f });
+        }
+
+        template <typename Func>
+        void walk(uint32_t head, Func& func) const
+        {
+            for(auto id = head; id != npos; id = _slots[id].next) { func(id); }
+        }
+
+        template <typename Func>
+        void visit(int64_t x, int64_t y, Func& func) const
+        {
+            if(const auto it = _heads.find(pack(x, y)); it != _heads.end()) { walk(it->second, func); }
+        }
+
+        template <typename Accept>
+        [[nodiscard]] size_t collect(const spatial_box& area, std::span<id_type> out, Accept accept) const
+        {
+            auto found = 0uz;
+
+            const auto test = [&](id_type id) {
+                if(!accept(_slots[id].box)) { return; }
+
+                if(found < out.size()) { out[found] = id; }
+                ++found;
+            };
+
+            const auto first = cell_of(area.min_x - _maxHalf, area.min_y - _maxHalf);
+            const auto last = cell_of(area.max_x + _maxHalf, area.max_y + _maxHalf);
+            const auto cells = static_cast<uint64_t>(int64_t{last.x} - first.x + 1) * static_cast<uint64_t>(int64_t{last.y} - first.y + 1);
+
+            // An area wider than the occupied cells, like a zoomed out viewport, is cheaper as a scan over them.
+            if(cells > _heads.size())
+            {
+                for(const auto& [key, head] : _heads)
+                {
+                    const auto c = unpack(key);
+                    if(c.x >= first.x && c.x <= last.x && c.y >= first.y && c.y <= last.y) { walk(head, test); }
+                }
+
+                return found;
+            }
+
+            for(auto y = int64_t{first.y}; y <= last.y; ++y)
+            {
+                for(auto x = int64_t{first.x}; x <= last.x; ++x) { visit(x, y, test); }
+            }
+
+            return found;
+        }
+
+        // Slab test, the distance to the box or -1 if the ray misses it within max_t.
+        [[nodiscard]] static float intersect(const spatial_box& box, float x, float y, float dx, float dy, float max_t)
+        {
+            auto near = 0.f, far = max_t;
+
+            const auto slab = [&near, &far](float origin, float dir, float lo, float hi) {
+                if(dir == 0.f) { return origin >= lo && origin <= hi; }
+
+                auto t0 = (lo - origin) / dir, t1 = (hi - origin) / dir;
+                if(t0 > t1) { std::swap(t0, t1); }
+
+                near = std::max(near, t0);
+                far = std::min(far, t1);
+
+                return near <= far;
+            };
+
+            return (slab(x, dx, box.min_x, box.max_x) && slab(y, dy, box.min_y, box.max_y)) ? near : -1.f;
+        }
+
+        // Keeps out[0, written) sorted by distance, dropping the farthest hit once it is full.
+        static void keep_nearest(std::span<ray_hit> out, size_t& written, const ray_hit& hit)
+        {
+            if(out.empty() || (written == out.size() && hit.t >= out[written - 1uz].t)) { return; }
+
+            if(written < out.size()) { ++written; }
+
+            auto i = written - 1uz;
+            for(; i > 0uz && out[i - 1uz].t > hit.t; --i) { out[i] = out[i - 1uz]; }
+
+            out[i] = hit;
+        }
+
+        // Pushes 'id' onto the front of its cell's list.
+        void link(id_type id, const spatial_box& box, uint64_t key)
+        {
+            auto [it, added] = _heads.try_emplace(key, npos);
+
+            auto& entry = _slots[id];
+            entry = slot{ box, key, it->second, npos, true };
+
+            if(!added) { _slots[it->second].prev = id; }
+            it->second = id;
+        }
+
+        void unlink(id_type id)
+        {
+            auto& entry = _slots[id];
+
+            if(entry.next != npos) { _slots[entry.next].prev = entry.prev; }
+
+            if(entry.prev != npos) { _slots[entry.prev].next = entry.next; }
+            else if(entry.next != npos) { _heads.find(entry.key)->second = entry.next; }
+            else { _heads.erase(entry.key); }
+
+            entry = slot{};
+        }
+
+        float _cellSize, _inverse;
+        float _maxHalf = 0.f;
+        size_t _size = 0uz;
+
+        flat_hash_map<uint64_t, uint32_t> _heads;
+        std::vector<slot> _slots;
+    };
+}
+
+#endif
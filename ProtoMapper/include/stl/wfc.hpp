@@ -0,0 +1,762 @@
+#ifndef PROTO_WFC_HPP
+#define PROTO_WFC_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <procgen.hpp>
+
+#if defined(__AVX2__)
+#define PROTO_WFC_AVX2 1
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#define PROTO_WFC_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define PROTO_WFC_NEON 1
+#include <arm_neon.h>
+#endif
+
+/**
+ * @brief Wave Function Collapse over a grid of tiles with adjacency rules: every cell starts out able to hold any
+ * tile, and cells are collapsed to one tile each, lowest entropy first, while the rules remove what their
+ * neighbours can no longer hold.
+ *
+ * Domains are bitsets, one bit per tile, and masks are applied to them a vector at a time. Propagation is AC-4:
+ * every cell keeps, per direction and tile, how many tiles of that neighbour still support it. Removing a tile
+ * decrements the counters it fed, and a tile is removed once one of its counters reaches zero, so nothing is ever
+ * re-checked against a whole neighbouring domain. Every removal goes on a trail, and backtracking pops the trail
+ * back to the last choice, putting back bits and counters exactly, before ruling that choice out.
+ */
+namespace proto
+{
+    enum class wfc_dir : uint8_t
+    {
+        north, // y - 1
+        east,  // x + 1
+        south, // y + 1
+        west   // x - 1
+    };
+
+    [[nodiscard]] constexpr wfc_dir opposite(wfc_dir dir) { return static_cast<wfc_dir>((static_cast<uint32_t>(dir) + 2u) & 3u); }
+
+    // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    namespace detail
+    {
+        // out = a & b, for bitsets of 'words' words. Returns whether any bit is set.
+        inline bool and_words(const uint64_t* a, const uint64_t* b, uint64_t* out, size_t words)
+        {
+            auto i = 0uz;
+            auto any = uint64_t{0u};
+
+#if defined(PROTO_WFC_AVX2)
+            auto acc = _mm256_setzero_si256();
+            for(; i + 4uz <= words; i += 4uz)
+            {
+                const auto both = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i))); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), both); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+                acc = _mm256_or_si256(acc, both);
+            }
+            any = _mm256_testz_si256(acc, acc) == 0 ? 1u : 0u;
+#elif defined(PROTO_WFC_SSE2)
+            auto acc = _mm_setzero_si128();
+            for(; i + 2uz <= words; i += 2uz)
+            {
+                const auto both = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i))); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), both); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+                acc = _mm_or_si128(acc, both);
+            }
+            any = _mm_movemask_epi8(_mm_cmpeq_epi8(acc, _mm_setzero_si128())) != 0xFFFF ? 1u : 0u;
+#elif defined(PROTO_WFC_NEON)
+            auto acc = vdupq_n_u64(0u);
+            for(; i + 2uz <= words; i += 2uz)
+            {
+                const auto both = vandq_u64(vld1q_u64(a + i), vld1q_u64(b + i));
+                vst1q_u64(out + i, both);
+                acc = vorrq_u64(acc, both);
+            }
+            any = vgetq_lane_u64(acc, 0) | vgetq_lane_u64(acc, 1);
+#endif
+
+            for(; i < words; ++i)
+            {
+                out[i] = a[i] & b[i];
+                any |= out[i];
+            }
+
+            return any != 0u;
+        }
+
+        // out = a & ~b, for bitsets of 'words' words. Returns whether any bit is left.
+        inline bool and_not_words(const uint64_t* a, const uint64_t* b, uint64_t* out, size_t words)
+        {
+            auto i = 0uz;
+            auto any = uint64_t{0u};
+
+#if defined(PROTO_WFC_AVX2)
+            auto acc = _mm256_setzero_si256();
+            for(; i + 4uz <= words; i += 4uz)
+            {
+                const auto left = _mm256_andnot_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i))); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), left); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+                acc = _mm256_or_si256(acc, left);
+            }
+            any = _mm256_testz_si256(acc, acc) == 0 ? 1u : 0u;
+#elif defined(PROTO_WFC_SSE2)
+            auto acc = _mm_setzero_si128();
+            for(; i + 2uz <= words; i += 2uz)
+            {
+                const auto left = _mm_andnot_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i))); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), left); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+                acc = _mm_or_si128(acc, left);
+            }
+            any = _mm_movemask_epi8(_mm_cmpeq_epi8(acc, _mm_setzero_si128())) != 0xFFFF ? 1u : 0u;
+#elif defined(PROTO_WFC_NEON)
+            auto acc = vdupq_n_u64(0u);
+            for(; i + 2uz <= words; i += 2uz)
+            {
+                const auto left = vbicq_u64(vld1q_u64(a + i), vld1q_u64(b + i));
+                vst1q_u64(out + i, left);
+                acc = vorrq_u64(acc, left);
+            }
+            any = vgetq_lane_u64(acc, 0) | vgetq_lane_u64(acc, 1);
+#endif
+
+            for(; i < words; ++i)
+            {
+                out[i] = a[i] & ~b[i];
+                any |= out[i];
+            }
+
+            return any != 0u;
+        }
+    }
+    // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+    /**
+     * @brief Which tiles may sit next to which, and how often each should appear. Tiles are numbered from 0, and
+     * each stands for a value of the caller's, such as a tile id.
+     */
+    class wfc_rules
+    {
+    public:
+        wfc_rules() = default;
+
+        explicit wfc_rules(uint32_t tiles)
+        : _tiles(tiles), _words((tiles + 63u) / 64u), _weights(tiles, 1.0), _values(tiles), _bits(size_t{tiles} * 4uz * _words)
+        {
+            if(tiles > std::numeric_limits<uint16_t>::max()) { throw std::invalid_argument("wfc_rules: too many tiles."); }
+            for(auto t = 0u; t < tiles; ++t) { _values[t] = t; }
+        }
+
+        /**
+         * @brief Learns the rules from an example: every pair of neighbours in 'sample' is allowed, and tiles are
+         * weighted by how often they occur. Cells holding 'ignore' are holes in the example.
+         */
+        [[nodiscard]] static wfc_rules learn(std::span<const uint32_t> sample, uint32_t width, uint32_t height, uint32_t ignore)
+        {
+            if(sample.size() < size_t{width} * height) { throw std::invalid_argument("wfc_rules: sample is smaller than its size."); }
+
+            auto values = std::vector<uint32_t>{};
+            for(const auto value : sample.first(size_t{width} * height)) { if(value != ignore) { values.push_back(value); } }
+
+            std::ranges::sort(values);
+            values.erase(std::ranges::unique(values).begin(), values.end());
+
+            auto rules = wfc_rules{ static_cast<uint32_t>(values.size()) };
+            std::ranges::copy(values, rules._values.begin());
+            std::ranges::fill(rules._weights, 0.0);
+
+            const auto index = [&](uint32_t x, uint32_t y) -> std::optional<uint32_t> {
+                const auto value = sample[(size_t{y} * width) + x];
+                if(value == ignore) { return std::nullopt; }
+                return static_cast<uint32_t>(std::ranges::lower_bound(values, value) - values.begin());
+            };
+
+            for(auto y = 0u; y < height; ++y)
+            {
+                for(auto x = 0u; x < width; ++x)
+                {
+                    const auto a = index(x, y);
+                    if(!a) { continue; }
+
+                    rules._weights[*a] += 1.0;
+                    if(const auto b = x + 1u < width ? index(x + 1u, y) : std::nullopt) { rules.allow(*a, wfc_dir::east, *b); }
+                    if(const auto b = y + 1u < height ? index(x, y + 1u) : std::nullopt) { rules.allow(*a, wfc_dir::south, *b); }
+                }
+            }
+
+            return rules;
+        }
+
+        // Lets 'b' sit in direction 'dir' of 'a', and so 'a' in the opposite direction of 'b'.
+        void allow(uint32_t a, wfc_dir dir, uint32_t b)
+        {
+            set_bit(a, dir, b);
+            set_bit(b, opposite(dir), a);
+        }
+
+        void set_weight(uint32_t tile, double weight) { _weights.at(tile) = weight; }
+        void set_value(uint32_t tile, uint32_t value) { _values.at(tile) = value; }
+
+        [[nodiscard]] bool allowed(uint32_t a, wfc_dir dir, uint32_t b) const { return ((compatible(a, dir)[b / 64u] >> (b % 64u)) & 1u) != 0u; }
+
+        // The tiles that may sit in direction 'dir' of 'a', as a bitset.
+        [[nodiscard]] std::span<const uint64_t> compatible(uint32_t a, wfc_dir dir) const
+        {
+            return std::span{ _bits }.subspan(((size_t{a} * 4uz) + static_cast<size_t>(dir)) * _words, _words);
+        }
+
+        [[nodiscard]] uint32_t tiles() const { return _tiles; }
+        [[nodiscard]] uint32_t words() const { return _words; }
+        [[nodiscard]] double weight(uint32_t tile) const { return _weights[tile]; }
+        [[nodiscard]] uint32_t value(uint32_t tile) const { return _values[tile]; }
+
+        // The tile standing for 'value', searched in order.
+        [[nodiscard]] std::optional<uint32_t> index_of(uint32_t value) const
+        {
+            const auto found = std::ranges::find(_values, value);
+            return found != _values.end() ? std::optional{ static_cast<uint32_t>(found - _values.begin()) } : std::nullopt;
+        }
+
+    private:
+        void set_bit(uint32_t a, wfc_dir dir, uint32_t b)
+        {
+            if(a >= _tiles || b >= _tiles) { throw std::out_of_range("wfc_rules: no such tile."); }
+            _bits[(((size_t{a} * 4uz) + static_cast<size_t>(dir)) * _words) + (b / 64u)] |= uint64_t{1u} << (b % 64u);
+        }
+
+        uint32_t _tiles = 0u, _words = 0u;
+        std::vector<double> _weights;
+        std::vector<uint32_t> _values;
+        std::vector<uint64_t> _bits; // Per tile and direction, a bitset of what may sit there.
+    };
+
+    struct wfc_stats
+    {
+        uint64_t observations = 0u, backtracks = 0u, bans = 0u;
+        uint32_t attempts = 0u;
+        std::chrono::nanoseconds propagate{}, observe{};
+    };
+
+    enum class wfc_result : uint8_t
+    {
+        solved,
+        contradiction, // Every attempt ran out of backtracks, or the constraints can't be met at all.
+        stopped
+    };
+
+    /**
+     * @brief Solves one grid. Cells off the grid constrain nothing. The solver may be run again with another
+     * seed, and keeps its constraints between runs.
+     */
+    class wfc_solver
+    {
+    public:
+        static constexpr uint32_t none = ~0u;
+
+        wfc_solver(wfc_rules rules, uint32_t width, uint32_t height)
+        : _rules(std::move(rules)), _width(width), _height(height), _cells(size_t{width} * height), _tiles(_rules.tiles()), _words(_rules.words())
+        {
+            if(_tiles == 0u) { throw std::invalid_argument("wfc_solver: the rules have no tiles."); }
+
+            // A tile's support from a direction starts out as every tile that may sit there.
+            _supporters.resize(size_t{_tiles} * 4uz);
+            for(auto t = 0u; t < _tiles; ++t)
+            {
+                for(auto dir = 0u; dir < 4u; ++dir)
+                {
+                    auto count = 0u;
+                    for(const auto word : _rules.compatible(t, static_cast<wfc_dir>(dir))) { count += static_cast<uint32_t>(std::popcount(word)); }
+                    _supporters[(size_t{dir} * _tiles) + t] = static_cast<uint16_t>(count);
+                }
+            }
+
+            _weights.resize(_tiles);
+            _weightLogs.resize(_tiles);
+            for(auto t = 0u; t < _tiles; ++t)
+            {
+                // Tiles that never occur still get a sliver of weight, so they can be chosen when nothing else fits.
+                _weights[t] = std::max(_rules.weight(t), 1e-6);
+                _weightLogs[t] = _weights[t] * std::log(_weights[t]);
+            }
+
+            _full.assign(_words, ~uint64_t{0u});
+            if(_tiles % 64u != 0u) { _full.back() = (uint64_t{1u} << (_tiles % 64u)) - 1u; }
+
+            _domains.resize(_cells * _words);
+            _sizes.resize(_cells);
+            _sumWeights.resize(_cells);
+            _sumWeightLogs.resize(_cells);
+            _counts.resize(_cells * 4uz * _tiles);
+            _entropies.resize(_cells);
+            _heapSlots.resize(_cells);
+            _dirtyFlags.resize(_cells);
+            _scratch.resize(_words);
+            _removed.resize(_words);
+            _touched.resize(_words);
+        }
+
+        // Cell (x, y) must hold one of the tiles in 'allowed', a bitset of words() words.
+        void restrict(uint32_t x, uint32_t y, std::span<const uint64_t> allowed)
+        {
+            if(x >= _width || y >= _height || allowed.size() < _words) { throw std::out_of_range("wfc_solver: bad constraint."); }
+
+            _constrained.push_back(static_cast<uint32_t>((size_t{y} * _width) + x));
+            _masks.insert(_masks.end(), allowed.begin(), allowed.begin() + _words);
+        }
+
+        void fix(uint32_t x, uint32_t y, uint32_t tile)
+        {
+            auto mask = std::vector<uint64_t>(_words);
+            mask.at(tile / 64u) = uint64_t{1u} << (tile % 64u);
+            restrict(x, y, mask);
+        }
+
+        void clear_constraints()
+        {
+            _constrained.clear();
+            _masks.clear();
+        }
+
+        /**
+         * @brief Collapses every cell. An attempt that needs more than 'max_backtracks' backtracks starts over
+         * with a seed derived from this one, up to 'max_attempts' times. 'stop' is checked between choices.
+         */
+        wfc_result run(uint64_t seed, uint32_t max_backtracks = 1000u, uint32_t max_attempts = 8u, const std::atomic<bool>* stop = nullptr)
+        {
+            _stats = {};
+
+            for(auto attempt = 0u; attempt < std::max(max_attempts, 1u); ++attempt)
+            {
+                ++_stats.attempts;
+                _seed = random_u64(seed, attempt);
+
+                if(!reset()) { return wfc_result::contradiction; }
+
+                auto rng = counter_rng{ _seed };
+                auto backtracks = 0u;
+                auto failed = false;
+
+                while(!failed)
+                {
+                    if(stop != nullptr && stop->load(std::memory_order_relaxed)) { return wfc_result::stopped; }
+
+                    auto started = std::chrono::steady_clock::now();
+
+                    const auto cell = pick();
+                    if(cell == none)
+                    {
+                        _stats.observe += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started);
+                        return wfc_result::solved;
+                    }
+
+                    const auto tile = choose(cell, rng);
+                    _decisions.push_back({ cell, tile, _trail.size() });
+                    collapse(cell, tile);
+                    ++_stats.observations;
+
+                    auto now = std::chrono::steady_clock::now();
+                    _stats.observe += std::chrono::duration_cast<std::chrono::nanoseconds>(now - started);
+                    started = now;
+
+                    // On a contradiction, undo the latest choice and rule it out, and further back if that fails too.
+                    for(auto ok = propagate(); !ok; ok = propagate())
+                    {
+                        if(_decisions.empty() || backtracks == max_backtracks)
+                        {
+                            failed = true;
+                            break;
+                        }
+
+                        const auto decision = _decisions.back();
+                        _decisions.pop_back();
+
+                        undo(decision.mark);
+                        ban(decision.cell, decision.tile);
+
+                        ++backtracks;
+                        ++_stats.backtracks;
+                    }
+
+                    _stats.propagate += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started);
+                    flush();
+                }
+            }
+
+            return wfc_result::contradiction;
+        }
+
+        // The tile at (x, y) once solved, otherwise the lowest one still possible.
+        [[nodiscard]] uint32_t tile_at(uint32_t x, uint32_t y) const
+        {
+            const auto domain = domain_of((size_t{y} * _width) + x);
+
+            for(auto w = 0uz; w < domain.size(); ++w)
+            {
+                if(domain[w] != 0u) { return static_cast<uint32_t>((w * 64uz) + static_cast<size_t>(std::countr_zero(domain[w]))); }
+            }
+
+            return none;
+        }
+
+        [[nodiscard]] uint32_t value_at(uint32_t x, uint32_t y) const
+        {
+            const auto tile = tile_at(x, y);
+            return tile != none ? _rules.value(tile) : none;
+        }
+
+        [[nodiscard]] uint32_t possible(uint32_t x, uint32_t y) const { return _sizes[(size_t{y} * _width) + x]; }
+
+        [[nodiscard]] const wfc_rules& rules() const { return _rules; }
+        [[nodiscard]] const wfc_stats& stats() const { return _stats; }
+        [[nodiscard]] uint32_t width() const { return _width; }
+        [[nodiscard]] uint32_t height() const { return _height; }
+
+    private:
+        struct decision
+        {
+            uint32_t cell, tile;
+            size_t mark; // Trail length before the choice.
+        };
+
+        template <typename Func>
+        static void for_each_bit(std::span<const uint64_t> bits, Func&& func)
+        {
+            for(auto w = 0uz; w < bits.size(); ++w)
+            {
+                for(auto word = bits[w]; word != 0u; word &= word - 1u) { func(static_cast<uint32_t>((w * 64uz) + static_cast<size_t>(std::countr_zero(word)))); }
+            }
+        }
+
+        [[nodiscard]] std::span<uint64_t> domain_of(size_t cell) { return std::span{ _domains }.subspan(cell * _words, _words); }
+        [[nodiscard]] std::span<const uint64_t> domain_of(size_t cell) const { return std::span{ _domains }.subspan(cell * _words, _words); }
+
+        [[nodiscard]] bool has(size_t cell, uint32_t tile) const { return ((_domains[(cell * _words) + (tile / 64u)] >> (tile % 64u)) & 1u) != 0u; }
+
+        [[nodiscard]] uint32_t neighbour(uint32_t cell, uint32_t dir) const
+        {
+            const auto x = cell % _width, y = cell / _width;
+
+            switch(dir)
+            {
+            case 0u: return y > 0u ? cell - _width : none;
+            case 1u: return x + 1u < _width ? cell + 1u : none;
+            case 2u: return y + 1u < _height ? cell + _width : none;
+            default: return x > 0u ? cell - 1u : none;
+            }
+        }
+
+        // Starts an attempt over, with every cell holding every tile its neighbours and the constraints allow.
+        bool reset()
+        {
+            for(auto cell = 0uz; cell < _cells; ++cell) { std::ranges::copy(_full, _domains.begin() + static_cast<std::ptrdiff_t>(cell * _words)); }
+
+            auto sumWeights = 0.0, sumWeightLogs = 0.0;
+            for(auto t = 0u; t < _tiles; ++t)
+            {
+                sumWeights += _weights[t];
+                sumWeightLogs += _weightLogs[t];
+            }
+
+            std::ranges::fill(_sizes, _tiles);
+            std::ranges::fill(_sumWeights, sumWeights);
+            std::ranges::fill(_sumWeightLogs, sumWeightLogs);
+
+            for(auto cell = 0uz; cell < _cells; ++cell) { std::ranges::copy(_supporters, _counts.begin() + static_cast<std::ptrdiff_t>(cell * _supporters.size())); }
+
+            _trail.clear();
+            _queue.clear();
+            _decisions.clear();
+            _heap.clear();
+            _dirty.clear();
+            std::ranges::fill(_dirtyFlags, uint8_t{0u});
+            _contradiction = false;
+
+            // Tiles with no possible neighbour in some direction can only sit on the edge facing it.
+            for(auto dir = 0u; dir < 4u; ++dir)
+            {
+                for(auto t = 0u; t < _tiles; ++t)
+                {
+                    if(_supporters[(size_t{dir} * _tiles) + t] != 0u) { continue; }
+
+                    for(auto cell = 0u; cell < _cells; ++cell)
+                    {
+                        if(neighbour(cell, dir) != none) { ban(cell, t); }
+                    }
+                }
+            }
+
+            for(auto i = 0uz; i < _constrained.size(); ++i)
+            {
+                const auto cell = _constrained[i];
+                detail::and_not_words(domain_of(cell).data(), _masks.data() + (i * _words), _removed.data(), _words); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+                for_each_bit(_removed, [&](uint32_t t) { ban(cell, t); });
+            }
+
+            const auto ok = propagate();
+
+            // Nothing before the first choice is ever undone.
+            _trail.clear();
+            _dirty.clear();
+            std::ranges::fill(_dirtyFlags, uint8_t{0u});
+
+            for(auto cell = 0u; cell < _cells; ++cell)
+            {
+                _heapSlots[cell] = none;
+                if(_sizes[cell] > 1u) { heap_update(cell); }
+            }
+
+            return ok;
+        }
+
+        void ban(uint32_t cell, uint32_t tile)
+        {
+            if(!has(cell, tile)) { return; }
+
+            _domains[(size_t{cell} * _words) + (tile / 64u)] &= ~(uint64_t{1u} << (tile % 64u));
+            _sumWeights[cell] -= _weights[tile];
+            _sumWeightLogs[cell] -= _weightLogs[tile];
+            if(--_sizes[cell] == 0u) { _contradiction = true; }
+
+            _trail.emplace_back(cell, tile);
+            mark_dirty(cell);
+            ++_stats.bans;
+
+            // Every tile this one supported next door loses a supporter, and goes once it has none left.
+            for(auto dir = 0u; dir < 4u; ++dir)
+            {
+                const auto next = neighbour(cell, dir);
+                if(next == none || !supported(tile, dir, next)) { continue; }
+
+                auto* counts = &_counts[((size_t{next} * 4uz) + ((dir + 2u) & 3u)) * _tiles];
+                for_each_bit(_touched, [&](uint32_t b) {
+                    if(--counts[b] == 0u) { _queue.emplace_back(next, b); } // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+                });
+            }
+        }
+
+        /**
+         * @brief Leaves in _touched the tiles next door that 'tile' supports and that are still possible there.
+         * Counters of tiles already gone from a cell are never read again until an undo brings the tile back, and
+         * the undo brings the neighbour back to how it was at the same time, so they are left alone both ways.
+         */
+        bool supported(uint32_t tile, uint32_t dir, uint32_t next)
+        {
+            return detail::and_words(_rules.compatible(tile, static_cast<wfc_dir>(dir)).data(), domain_of(next).data(), _touched.data(), _words);
+        }
+
+        bool propagate()
+        {
+            while(!_contradiction && !_queue.empty())
+            {
+                const auto [cell, tile] = _queue.back();
+                _queue.pop_back();
+                ban(cell, tile);
+            }
+
+            _queue.clear();
+            return !_contradiction;
+        }
+
+        // Pops the trail back to 'mark', restoring bits and counters in the reverse order they were taken.
+        void undo(size_t mark)
+        {
+            while(_trail.size() > mark)
+            {
+                const auto [cell, tile] = _trail.back();
+                _trail.pop_back();
+
+                _domains[(size_t{cell} * _words) + (tile / 64u)] |= uint64_t{1u} << (tile % 64u);
+                _sumWeights[cell] += _weights[tile];
+                _sumWeightLogs[cell] += _weightLogs[tile];
+                ++_sizes[cell];
+                mark_dirty(cell);
+
+                for(auto dir = 0u; dir < 4u; ++dir)
+                {
+                    const auto next = neighbour(cell, dir);
+                    if(next == none || !supported(tile, dir, next)) { continue; }
+
+                    auto* counts = &_counts[((size_t{next} * 4uz) + ((dir + 2u) & 3u)) * _tiles];
+                    for_each_bit(_touched, [&](uint32_t b) { ++counts[b]; }); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+                }
+            }
+
+            _contradiction = false;
+        }
+
+        void collapse(uint32_t cell, uint32_t tile)
+        {
+            auto keep = std::span{ _scratch };
+            std::ranges::fill(keep, uint64_t{0u});
+            keep[tile / 64u] = uint64_t{1u} << (tile % 64u);
+
+            detail::and_not_words(domain_of(cell).data(), keep.data(), _removed.data(), _words);
+            for_each_bit(_removed, [&](uint32_t t) { ban(cell, t); });
+        }
+
+        [[nodiscard]] double entropy(uint32_t cell) const
+        {
+            const auto sum = _sumWeights[cell];
+
+            // A little noise breaks ties between cells the same way every time for a seed.
+            return std::log(sum) - (_sumWeightLogs[cell] / sum) + (1e-6 * random_unit(random_at(_seed, cell, 0u, 1u)));
+        }
+
+        [[nodiscard]] uint32_t pick() const { return _heap.empty() ? none : _heap.front(); }
+
+        /**
+         * @brief The heap holds every undecided cell once, keyed by its entropy, with each cell's slot kept so that
+         * a change moves it up or down in place instead of piling up stale entries.
+         */
+        void heap_update(uint32_t cell)
+        {
+            const auto previous = _entropies[cell];
+            _entropies[cell] = entropy(cell);
+
+            auto slot = _heapSlots[cell];
+            if(slot == none)
+            {
+                slot = static_cast<uint32_t>(_heap.size());
+                _heap.push_back(cell);
+                _heapSlots[cell] = slot;
+                sift_up(slot);
+            }
+            else if(_entropies[cell] < previous) { sift_up(slot); }
+            else { sift_down(slot); }
+        }
+
+        void heap_erase(uint32_t cell)
+        {
+            const auto slot = _heapSlots[cell];
+            if(slot == none) { return; }
+
+            _heapSlots[cell] = none;
+            const auto last = _heap.back();
+            _heap.pop_back();
+            if(last == cell) { return; }
+
+            _heap[slot] = last;
+            _heapSlots[last] = slot;
+            sift_up(slot);
+            sift_down(_heapSlots[last]);
+        }
+
+        void sift_up(uint32_t slot)
+        {
+            const auto cell = _heap[slot];
+
+            while(slot > 0u)
+            {
+                const auto parent = (slot - 1u) / 2u;
+                if(_entropies[_heap[parent]] <= _entropies[cell]) { break; }
+
+                _heap[slot] = _heap[parent];
+                _heapSlots[_heap[slot]] = slot;
+                slot = parent;
+            }
+
+            _heap[slot] = cell;
+            _heapSlots[cell] = slot;
+        }
+
+        void sift_down(uint32_t slot)
+        {
+            const auto cell = _heap[slot];
+            const auto count = static_cast<uint32_t>(_heap.size());
+
+            for(;;)
+            {
+                auto child = (slot * 2u) + 1u;
+                if(child >= count) { break; }
+                if(child + 1u < count && _entropies[_heap[child + 1u]] < _entropies[_heap[child]]) { ++child; }
+                if(_entropies[cell] <= _entropies[_heap[child]]) { break; }
+
+                _heap[slot] = _heap[child];
+                _heapSlots[_heap[slot]] = slot;
+                slot = child;
+            }
+
+            _heap[slot] = cell;
+            _heapSlots[cell] = slot;
+        }
+
+        [[nodiscard]] uint32_t choose(uint32_t cell, counter_rng& rng) const
+        {
+            auto target = static_cast<double>(rng.unit()) * _sumWeights[cell];
+            auto chosen = none;
+
+            for_each_bit(domain_of(cell), [&](uint32_t t) {
+                if(chosen != none && target < 0.0) { return; }
+
+                chosen = t;
+                target -= _weights[t];
+            });
+
+            return chosen;
+        }
+
+        void mark_dirty(uint32_t cell)
+        {
+            if(_dirtyFlags[cell] != 0u) { return; }
+
+            _dirtyFlags[cell] = 1u;
+            _dirty.push_back(cell);
+        }
+
+        // Cells that changed move in the heap, and leave it once decided.
+        void flush()
+        {
+            for(const auto cell : _dirty)
+            {
+                _dirtyFlags[cell] = 0u;
+
+                if(_sizes[cell] < 2u) { heap_erase(cell); }
+                else { heap_update(cell); }
+            }
+
+            _dirty.clear();
+        }
+
+        wfc_rules _rules;
+        uint32_t _width, _height;
+        size_t _cells;
+        uint32_t _tiles, _words;
+        uint64_t _seed = 0u;
+
+        std::vector<uint16_t> _supporters; // Per direction and tile, the counters every cell starts with.
+        std::vector<double> _weights, _weightLogs;
+        std::vector<uint64_t> _full, _scratch, _removed, _touched;
+
+        std::vector<uint64_t> _domains;
+        std::vector<uint32_t> _sizes;
+        std::vector<double> _sumWeights, _sumWeightLogs;
+        std::vector<uint16_t> _counts; // Per cell, direction and tile: supporters left in that neighbour.
+
+        std::vector<std::pair<uint32_t, uint32_t>> _trail, _queue;
+        std::vector<decision> _decisions;
+        std::vector<uint32_t> _heap, _heapSlots, _dirty;
+        std::vector<double> _entropies;
+        std::vector<uint8_t> _dirtyFlags;
+        bool _contradiction = false;
+
+        std::vector<uint32_t> _constrained;
+        std::vector<uint64_t> _masks;
+
+        wfc_stats _stats;
+    };
+}
+
+#endif
@@ -0,0 +1,379 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <AutoTiler.hpp>
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#include <SimpleIni.h>
+#include <sol/sol.hpp>
+
+#include <Scene.hpp>
+
+namespace proto
+{
+	namespace
+	{
+		struct RuleText
+		{
+			std::string pattern;
+			TileId tile = EmptyTile;
+		};
+
+		// What both file formats describe, before it is checked and compiled.
+		struct TerrainText
+		{
+			std::string mode = "blob47";
+			std::optional<TileId> first, fallback;
+			std::vector<RuleText> rules;
+		};
+
+		[[nodiscard]] std::optional<autotile_lut> Compile(std::string_view name, const TerrainText& text)
+		{
+			auto mode = autotile_mode::blob47;
+
+			if(text.mode == "edges4") { mode = autotile_mode::edges4; }
+			else if(text.mode != "blob47")
+			{
+				std::printf("[AutoTiler]: %.*s has an unknown mode '%s'.\n", static_cast<int>(name.size()), name.data(), text.mode.c_str()); // NOLINT(cppcoreguidelines-pro-type-vararg)
+				return std::nullopt;
+			}
+
+			if(text.first) { return autotile_lut::standard(mode, *text.first); }
+
+			if(text.rules.empty())
+			{
+				std::printf("[AutoTiler]: %.*s has neither a first tile nor rules.\n", static_cast<int>(name.size()), name.data()); // NOLINT(cppcoreguidelines-pro-type-vararg)
+				return std::nullopt;
+			}
+
+			auto rules = std::vector<autotile_rule>{};
+			rules.reserve(text.rules.size());
+
+			for(const auto& rule : text.rules)
+			{
+				const auto parsed = parse_autotile_rule(rule.pattern, rule.tile);
+
+				if(!parsed)
+				{
+					std::printf("[AutoTiler]: %.*s has a bad rule '%s'.\n", static_cast<int>(name.size()), name.data(), rule.pattern.c_str()); // NOLINT(cppcoreguidelines-pro-type-vararg)
+					return std::nullopt;
+				}
+
+				rules.push_back(*parsed);
+			}
+
+			return autotile_lut::compile(mode, rules, text.fallback.value_or(rules.back().tile));
+		}
+
+		// SimpleIni keeps everything after the '=', so "value ; comment" loses its comment and padding here.
+		[[nodiscard]] std::string_view StripComment(std::string_view value)
+		{
+			value = value.substr(0uz, value.find(';'));
+			while(!value.empty() && (value.back() == ' ' || value.back() == '\t')) { value.remove_suffix(1uz); }
+			while(!value.empty() && (value.front() == ' ' || value.front() == '\t')) { value.remove_prefix(1uz); }
+
+			return value;
+		}
+
+		[[nodiscard]] std::optional<TileId> ParseTile(std::string_view value)
+		{
+			auto tile = TileId{};
+			const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), tile);
+			if(value.empty() || error != std::errc{} || end != value.data() + value.size()) { return std::nullopt; }
+
+			return tile;
+		}
+
+		// "pattern, tile"
+		[[nodiscard]] std::optional<RuleText> ParseIniRule(std::string_view value)
+		{
+			value = StripComment(value);
+
+			const auto comma = value.rfind(',');
+			if(comma == std::string_view::npos) { return std::nullopt; }
+
+			const auto tile = ParseTile(StripComment(value.substr(comma + 1uz)));
+			if(!tile) { return std::nullopt; }
+
+			return RuleText{ .pattern = std::string{ value.substr(0uz, comma) }, .tile = *tile };
+		}
+	}
+
+	size_t AutoTiler::LoadDirectory(const std::filesystem::path& dir, sol::state_view& lua)
+	{
+		auto error = std::error_code{};
+		if(!std::filesystem::is_directory(dir, error)) { return 0uz; }
+
+		const auto before = _terrains.size();
+
+		// Sorted, so a terrain defined twice always ends up with the same definition.
+		auto files = std::vector<std::filesystem::path>{};
+		for(const auto& entry : std::filesystem::directory_iterator(dir, error)) { files.push_back(entry.path()); }
+		std::ranges::sort(files);
+
+		for(const auto& file : files)
+		{
+			if(file.extension() == ".ini" && !LoadIni(file)) { std::printf("[AutoTiler]: Could not load %s.\n", file.string().c_str()); } // NOLINT(cppcoreguidelines-pro-type-vararg)
+			if(file.extension() == ".lua" && !LoadLua(file, lua)) { std::printf("[AutoTiler]: Could not load %s.\n", file.string().c_str()); } // NOLINT(cppcoreguidelines-pro-type-vararg)
+		}
+
+		return _terrains.size() - before;
+	}
+
+	bool AutoTiler::LoadIni(const std::filesystem::path& file)
+	{
+		// Multiple keys, for the rules.
+		auto ini = CSimpleIniA{ false, true };
+		if(ini.LoadFile(file.string().c_str()) < 0) { return false; }
+
+		auto sections = CSimpleIniA::TNamesDepend{};
+		ini.GetAllSections(sections);
+		sections.sort(CSimpleIniA::Entry::LoadOrder());
+
+		auto loaded = true;
+
+		for(const auto& section : sections)
+		{
+			auto text = TerrainText{};
+			text.mode = StripComment(ini.GetValue(section.pItem, "mode", "blob47"));
+
+			auto numbers = true;
+
+			for(const auto& [key, field] : { std::pair{ "first", &text.first }, std::pair{ "fallback", &text.fallback } })
+			{
+				const auto* value = ini.GetValue(section.pItem, key);
+				if(value == nullptr) { continue; }
+
+				*field = ParseTile(StripComment(value));
+				if(*field) { continue; }
+
+				std::printf("[AutoTiler]: %s has a bad '%s' tile '%s'.\n", section.pItem, key, value); // NOLINT(cppcoreguidelines-pro-type-vararg)
+				numbers = false;
+			}
+
+			if(!numbers) { loaded = false; continue; }
+
+			auto values = CSimpleIniA::TNamesDepend{};
+			ini.GetAllValues(section.pItem, "rule", values);
+			values.sort(CSimpleIniA::Entry::LoadOrder());
+
+			for(const auto& value : values)
+			{
+				if(auto rule = ParseIniRule(value.pItem)) { text.rules.push_back(std::move(*rule)); }
+				else { text.rules.push_back(RuleText{ .pattern = std::string{ StripComment(value.pItem) }, .tile = EmptyTile }); } // Reported by Compile().
+			}
+
+			if(const auto lut = Compile(section.pItem, text)) { AddTerrain(section.pItem, *lut); }
+			else { loaded = false; }
+		}
+
+		return loaded;
+	}
+
+	bool AutoTiler::LoadLua(const std::filesystem::path& file, sol::state_view& lua)
+	{
+		auto result = lua.safe_script_file(file.string(), sol::script_pass_on_error);
+
+		if(!result.valid() || result.get_type() != sol::type::table)
+		{
+			if(!result.valid())
+			{
+				const sol::error error = result;
+				std::printf("[AutoTiler]: %s\n", error.what()); // NOLINT(cppcoreguidelines-pro-type-vararg)
+			}
+
+			return false;
+		}
+
+		const sol::table terrains = result;
+		auto loaded = true;
+
+		for(const auto& [key, value] : terrains)
+		{
+			if(!key.is<std::string>() || !value.is<sol::table>()) { continue; }
+
+			const auto name = key.as<std::string>();
+			const auto terrain = value.as<sol::table>();
+
+			auto text = TerrainText{};
+			text.mode = terrain.get_or<std::string>("mode", "blob47");
+			if(const auto first = terrain.get<sol::optional<TileId>>("first")) { text.first = *first; }
+			if(const auto fallback = terrain.get<sol::optional<TileId>>("fallback")) { text.fallback = *fallback; }
+
+			if(const auto rules = terrain.get<sol::optional<sol::table>>("rules"))
+			{
+				for(auto i = 1uz; i <= rules->size(); ++i)
+				{
+					const sol::table rule = (*rules)[i];
+					text.rules.push_back(RuleText{ .pattern = rule.get_or<std::string>(1, ""), .tile = rule.get_or<TileId>(2, EmptyTile) });
+				}
+			}
+
+			if(const auto lut = Compile(name, text)) { AddTerrain(name, *lut); }
+			else { loaded = false; }
+		}
+
+		return loaded;
+	}
+
+	size_t AutoTiler::AddTerrain(std::string name, const autotile_lut& lut)
+	{
+		auto index = FindTerrain(name).value_or(_terrains.size());
+
+		if(index == _terrains.size()) { _terrains.push_back(Terrain{ .name = std::move(name), .lut = lut }); }
+		else { _terrains[index].lut = lut; }
+
+		// Rebuilt from scratch, a replaced terrain may have given up tiles.
+		_terrainOf.clear();
+
+		for(auto terrain = 0uz; terrain < _terrains.size(); ++terrain)
+		{
+			for(const auto tile : _terrains[terrain].lut.tiles())
+			{
+				// A rule may leave cells empty, which must not make empty cells part of the terrain.
+				if(tile == EmptyTile) { continue; }
+				if(tile >= _terrainOf.size()) { _terrainOf.resize(tile + 1uz, NoTerrain); }
+
+				if(_terrainOf[tile] != NoTerrain && _terrainOf[tile] != terrain)
+				{
+					std::printf("[AutoTiler]: Tile %u is in both %s and %s.\n", tile, _terrains[_terrainOf[tile]].name.c_str(), _terrains[terrain].name.c_str()); // NOLINT(cppcoreguidelines-pro-type-vararg)
+				}
+
+				_terrainOf[tile] = terrain;
+			}
+		}
+
+		return index;
+	}
+
+	std::optional<size_t> AutoTiler::FindTerrain(std::string_view name) const
+	{
+		const auto found = std::ranges::find(_terrains, name, &Terrain::name);
+		return found == _terrains.end() ? std::nullopt : std::optional{ static_cast<size_t>(found - _terrains.begin()) };
+	}
+
+	size_t AutoTiler::Paint(Scene& scene, size_t layer, size_t terrain, std::span<const glm::uvec2> cells)
+	{
+		if(terrain != NoTerrain && terrain >= _terrains.size()) { throw std::out_of_range("Terrain index is out of range."); }
+		if(scene.GetGenerator().Busy()) { return 0uz; }
+
+		auto& journal = scene.GetJournal();
+		const auto& target = scene.GetMap().Layers().at(layer);
+		const auto own = !journal.Recording();
+
+		if(own) { journal.Begin(scene.GetMap(), "Paint"); }
+
+		// Any tile of the terrain will do, re-tiling picks the right one.
+		const auto tile = terrain == NoTerrain ? EmptyTile : _terrains[terrain].lut.interior();
+		_painted.clear();
+
+		for(const auto cell : cells)
+		{
+			if(cell.x >= target.Width() || cell.y >= target.Height() || TerrainOf(target.Get(cell.x, cell.y)) == terrain) { continue; }
+
+			journal.Set(layer, cell.x, cell.y, tile);
+			_painted.push_back((uint64_t{cell.y} << 32u) | cell.x);
+		}
+
+		// A painted cell that re-tiling changes again is still one changed cell.
+		std::ranges::sort(_painted);
+		const auto changed = _painted.size() + RetileCells(scene, layer, cells, _painted);
+
+		if(own) { journal.Commit(); }
+
+		return changed;
+	}
+
+	size_t AutoTiler::Retile(Scene& scene, size_t layer, std::span<const glm::uvec2> dirty)
+	{
+		if(scene.GetGenerator().Busy()) { return 0uz; }
+
+		auto& journal = scene.GetJournal();
+		const auto own = !journal.Recording();
+
+		if(own) { journal.Begin(scene.GetMap(), "Paint"); }
+
+		const auto changed = RetileCells(scene, layer, dirty);
+
+		if(own) { journal.Commit(); }
+
+		return changed;
+	}
+
+	void AutoTiler::Clear()
+	{
+		_terrains.clear();
+		_terrainOf.clear();
+	}
+
+	size_t AutoTiler::RetileCells(Scene& scene, size_t layer, std::span<const glm::uvec2> dirty, std::span<const uint64_t> counted)
+	{
+		auto& journal = scene.GetJournal();
+		const auto& target = scene.GetMap().Layers().at(layer);
+		const auto width = target.Width(), height = target.Height();
+
+		// Every cell next to a dirty one, once each and in row order so writes stay within a chunk for a while.
+		_cells.clear();
+
+		for(const auto cell : dirty)
+		{
+			if(cell.x >= width || cell.y >= height) { continue; }
+
+			for(auto y = cell.y - std::min(cell.y, 1u); y <= std::min(cell.y + 1u, height - 1u); ++y)
+			{
+				for(auto x = cell.x - std::min(cell.x, 1u); x <= std::min(cell.x + 1u, width - 1u); ++x) { _cells.push_back((uint64_t{y} << 32u) | x); }
+			}
+		}
+
+		std::ranges::sort(_cells);
+		const auto [last, end] = std::ranges::unique(_cells);
+		_cells.erase(last, end);
+
+		/*
+			Re-tiling keeps every cell in its terrain, so the masks read below never change under it and the cells
+			can be written as they go.
+		*/
+		auto changed = 0uz;
+
+		for(const auto key : _cells)
+		{
+			const auto x = static_cast<uint32_t>(key), y = static_cast<uint32_t>(key >> 32u);
+			const auto current = target.Get(x, y);
+			const auto terrain = TerrainOf(current);
+
+			if(terrain == NoTerrain) { continue; }
+
+			const auto mask = autotile_mask(x, y, [&](int64_t nx, int64_t ny) {
+				return nx < 0 || ny < 0 || nx >= width || ny >= height || TerrainOf(target.Get(static_cast<uint32_t>(nx), static_cast<uint32_t>(ny))) == terrain;
+			});
+
+			if(const auto tile = _terrains[terrain].lut[mask]; tile != current)
+			{
+				journal.Set(layer, x, y, tile);
+				if(!std::ranges::binary_search(counted, key)) { ++changed; }
+			}
+		}
+
+		return changed;
+	}
+}
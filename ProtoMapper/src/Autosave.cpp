@@ -0,0 +1,136 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <Autosave.hpp>
+
+#include <cstdio>
+#include <system_error>
+#include <utility>
+
+#include <stl/parallel.hpp>
+
+namespace proto
+{
+	namespace
+	{
+		constexpr double MiB = 1024.0 * 1024.0;
+
+		[[maybe_unused]] [[nodiscard]] double Milliseconds(std::chrono::microseconds time) { return static_cast<double>(time.count()) / 1000.0; }
+	}
+
+	Autosave::Autosave(std::filesystem::path file, std::chrono::seconds interval, PmapFile::Compression compression)
+		: _file(std::move(file)), _interval(interval)
+	{
+		_pmap.SetCompression(compression);
+
+		auto error = std::error_code{};
+		std::filesystem::create_directories(_file.parent_path(), error);
+	}
+
+	Autosave::~Autosave()
+	{
+		Finish();
+	}
+
+	bool Autosave::Restore(Scene& scene)
+	{
+		Finish();
+
+		auto error = std::error_code{};
+		if(!std::filesystem::is_regular_file(_file, error)) { return false; }
+		if(!_pmap.Load(_file, scene.GetMap(), scene.GetRegistry())) { return false; }
+
+		scene.MapLoaded();
+
+		// Nothing to save until the restored map is edited.
+		_savedMap = scene.GetMap();
+		_savedObjects = CaptureObjects(scene.GetRegistry());
+		_sinceSave.Reset();
+
+		return true;
+	}
+
+	void Autosave::Update(Scene& scene)
+	{
+		if(_pending.valid())
+		{
+			if(_pending.wait_for(std::chrono::seconds{0}) != std::future_status::ready) { return; }
+			Collect();
+		}
+
+		if(_sinceSave.Elapsed<std::chrono::seconds>() >= _interval) { Save(scene); }
+	}
+
+	bool Autosave::Save(Scene& scene)
+	{
+		if(_pending.valid()) { return false; }
+
+		_sinceSave.Reset();
+
+		const auto timer = Stopwatch{};
+
+		// Comparing chunk pointers is all it takes to see that nothing changed, no tile is read here.
+		auto objects = CaptureObjects(scene.GetRegistry());
+		const auto& map = scene.GetMap();
+
+		if(map == _savedMap && objects == _savedObjects) { return false; }
+
+		_savedMap = map;
+		_savedObjects = std::move(objects);
+
+		_current = Stats{};
+		_current.snapshot = timer.Elapsed();
+
+		_pending = thread_pool::shared().async([this]() {
+			return _pmap.Save(_file, _savedMap, _savedObjects);
+		});
+
+		return true;
+	}
+
+	void Autosave::Finish()
+	{
+		if(_pending.valid())
+		{
+			_pending.wait();
+			Collect();
+		}
+	}
+
+	void Autosave::Collect()
+	{
+		if(!_pending.get())
+		{
+			// Forget the snapshot, so the next save is attempted even if nothing changes in between.
+			_savedMap.Clear();
+			_savedObjects.clear();
+			return;
+		}
+
+		_current.write = _pmap.LastSave();
+
+		const auto seconds = static_cast<double>(_current.write.time.count()) / 1'000'000.0;
+		_current.throughput = seconds > 0.0 ? static_cast<double>(_current.write.bytesWritten) / MiB / seconds : 0.0;
+
+		_lastSave = _current;
+
+#ifdef _DEBUG_
+		std::printf("[Autosave]: snapshot %.3f ms, wrote %.1f MiB in %.2f ms (%.0f MiB/s), %zu chunks changed\n", Milliseconds(_lastSave.snapshot), // NOLINT(cppcoreguidelines-pro-type-vararg)
+			static_cast<double>(_lastSave.write.bytesWritten) / MiB, Milliseconds(_lastSave.write.time), _lastSave.throughput, _lastSave.write.chunksWritten);
+#endif // _DEBUG_
+	}
+}
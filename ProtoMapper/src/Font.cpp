@@ -17,6 +17,26 @@
 */
 #include <Font.hpp>
 
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+#include <gsl/gsl-lite.hpp>
+
+#include <MappedFile.hpp>
+#include <Texture.hpp>
+#include <stl/hash.hpp>
+#include <stl/rect_packer.hpp>
+#include <stl/segmented_array.hpp>
+
 #define NK_INCLUDE_DEFAULT_ALLOCATOR
 #define NK_INCLUDE_STANDARD_IO
 
@@ -29,8 +49,395 @@
 #undef NK_IMPLEMENTATION
 #include <nuklear.h>
 
+// nuklear carries its own static copy for baking, this one is only used for distance fields.
+#define STBTT_STATIC
+#define STB_TRUETYPE_IMPLEMENTATION
+#include <stb_truetype.h>
+
 namespace proto
 {
+    namespace
+    {
+        constexpr uint32_t CacheMagic = 0x43464D50u; // "PMFC"
+        constexpr uint32_t CacheVersion = 2u;
+        constexpr uint32_t BytesPerPixel = 1u;
+        constexpr nk_rune FallbackGlyph = '?';
+
+        // Distance fields are baked at no less than this size, smaller glyphs lose too much of their shape.
+        constexpr float DistanceFieldMinSize = 48.0f;
+        constexpr int DistanceFieldPadding = 4;
+        constexpr uint8_t DistanceFieldEdge = 128u;
+        constexpr uint32_t DistanceFieldPage = 1024u;
+
+        /*
+            Cache file layout: the header, then the zero terminated glyph ranges, the glyph table and the atlas
+            pixels, each at the offset stored in the header. Offsets are aligned so the glyph table can be used
+            in place from the mapping.
+        */
+        struct CacheHeader
+        {
+            uint32_t magic = CacheMagic, version = CacheVersion;
+            uint64_t key = 0u;
+            uint32_t width = 0u, height = 0u, bytesPerPixel = BytesPerPixel, glyphCount = 0u, rangeCount = 0u, fallback = FallbackGlyph;
+            float fontHeight = 0.0f, ascent = 0.0f, descent = 0.0f;
+            uint32_t render = 0u;
+            uint64_t rangeOffset = 0u, glyphOffset = 0u, pixelOffset = 0u;
+        };
+
+        static_assert(std::is_trivially_copyable_v<CacheHeader> && std::is_trivially_copyable_v<struct nk_font_glyph>);
+
+        [[nodiscard]] constexpr size_t AlignUp(size_t value, size_t alignment) { return (value + alignment - 1uz) & ~(alignment - 1uz); }
+
+        // Same as nuklear's internal width callback, which is not exported.
+        float TextWidth(nk_handle handle, float height, const char* text, int len)
+        {
+            auto* font = static_cast<struct nk_font*>(handle.ptr);
+            if(font == nullptr || text == nullptr || len == 0) { return 0.0f; }
+
+            const auto scale = height / font->info.height;
+            auto width = 0.0f;
+            nk_rune unicode = 0u;
+
+            auto glyphLen = nk_utf_decode(text, &unicode, len);
+            auto textLen = glyphLen;
+
+            while(textLen <= len && glyphLen != 0 && unicode != NK_UTF_INVALID)
+            {
+                width += nk_font_find_glyph(font, unicode)->xadvance * scale;
+
+                glyphLen = nk_utf_decode(text + textLen, &unicode, len - textLen); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+                textLen += glyphLen;
+            }
+
+            return width;
+        }
+
+        void QueryGlyph(nk_handle handle, float height, struct nk_user_font_glyph* glyph, nk_rune codepoint, nk_rune /*next*/)
+        {
+            auto* font = static_cast<struct nk_font*>(handle.ptr);
+            const auto scale = height / font->info.height;
+            const auto* g = nk_font_find_glyph(font, codepoint);
+
+            glyph->width = (g->x1 - g->x0) * scale;
+            glyph->height = (g->y1 - g->y0) * scale;
+            glyph->offset = nk_vec2(g->x0 * scale, g->y0 * scale);
+            glyph->xadvance = g->xadvance * scale;
+            glyph->uv[0] = nk_vec2(g->u0, g->v0);
+            glyph->uv[1] = nk_vec2(g->u1, g->v1);
+        }
+
+        [[nodiscard]] std::vector<nk_rune> DefaultRanges()
+        {
+            auto ranges = std::vector<nk_rune>{};
+
+            for(const auto* range = nk_font_default_glyph_ranges(); *range != 0u; ++range) // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            {
+                ranges.push_back(*range);
+            }
+
+            ranges.push_back(0u);
+            return ranges;
+        }
+
+        [[nodiscard]] std::string ReadFile(const std::filesystem::path& filename)
+        {
+            auto in = std::ifstream{filename, std::ios::binary};
+            return std::string{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+        }
+
+        [[nodiscard]] uint64_t CacheKey(const std::filesystem::path& filename, float size, const std::vector<nk_rune>& ranges, FontRender render)
+        {
+            auto key = hash_combine(hash_combine(CacheVersion, BytesPerPixel), hash_string(ReadFile(filename)));
+            key = hash_combine(hash_combine(key, std::bit_cast<uint32_t>(size)), static_cast<uint32_t>(render));
+
+            for(const auto rune : ranges) { key = hash_combine(key, rune); }
+
+            return key;
+        }
+
+        [[nodiscard]] std::filesystem::path CacheFile(const std::filesystem::path& dir, uint64_t key)
+        {
+            auto name = std::array<char, 16uz>{};
+            const auto end = std::to_chars(name.data(), name.data() + name.size(), key, 16).ptr; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+            return dir / ("font_" + std::string{name.data(), end} + ".bin");
+        }
+
+        // Checks that every section of a cache blob is where the header says it is.
+        [[nodiscard]] const CacheHeader* Validate(std::span<const std::byte> blob, uint64_t key, FontRender render)
+        {
+            if(blob.size() < sizeof(CacheHeader)) { return nullptr; }
+
+            const auto* header = reinterpret_cast<const CacheHeader*>(blob.data()); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+
+            if(header->magic != CacheMagic || header->version != CacheVersion || header->key != key || header->bytesPerPixel != BytesPerPixel || header->render != static_cast<uint32_t>(render)) { return nullptr; }
+            if(header->rangeCount == 0u || header->glyphCount == 0u || header->fontHeight <= 0.0f) { return nullptr; }
+
+            const auto pixelBytes = size_t{header->width} * size_t{header->height} * size_t{header->bytesPerPixel};
+
+            const auto fits = [&blob](uint64_t offset, size_t bytes) { return offset <= blob.size() && bytes <= blob.size() - offset; };
+
+            if(!fits(header->rangeOffset, header->rangeCount * sizeof(nk_rune)) || !fits(header->glyphOffset, header->glyphCount * sizeof(struct nk_font_glyph)) || !fits(header->pixelOffset, pixelBytes)) { return nullptr; }
+            if(header->glyphOffset % alignof(struct nk_font_glyph) != 0u) { return nullptr; }
+
+            return header;
+        }
+
+        // What either baker produces: an A8 atlas and one glyph per codepoint in the ranges, in range order.
+        struct BakedFont
+        {
+            uint32_t width = 0u, height = 0u;
+            float fontHeight = 0.0f, ascent = 0.0f, descent = 0.0f;
+            std::span<const struct nk_font_glyph> glyphs;
+            std::span<const uint8_t> pixels;
+        };
+
+        // Lays a baked font out in the cache format.
+        [[nodiscard]] std::vector<std::byte> Serialise(const BakedFont& baked, const std::vector<nk_rune>& ranges, uint64_t key, FontRender render)
+        {
+            auto header = CacheHeader{};
+            header.key = key;
+            header.width = baked.width;
+            header.height = baked.height;
+            header.glyphCount = static_cast<uint32_t>(baked.glyphs.size());
+            header.rangeCount = static_cast<uint32_t>(ranges.size());
+            header.fontHeight = baked.fontHeight;
+            header.ascent = baked.ascent;
+            header.descent = baked.descent;
+            header.render = static_cast<uint32_t>(render);
+            header.rangeOffset = AlignUp(sizeof(CacheHeader), 16uz);
+            header.glyphOffset = AlignUp(header.rangeOffset + (ranges.size() * sizeof(nk_rune)), 16uz);
+            header.pixelOffset = AlignUp(header.glyphOffset + baked.glyphs.size_bytes(), 64uz);
+
+            auto blob = std::vector<std::byte>(header.pixelOffset + baked.pixels.size_bytes());
+
+            std::memcpy(blob.data(), &header, sizeof(header));
+            std::memcpy(blob.data() + header.rangeOffset, ranges.data(), ranges.size() * sizeof(nk_rune)); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            std::memcpy(blob.data() + header.glyphOffset, baked.glyphs.data(), baked.glyphs.size_bytes()); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            std::memcpy(blob.data() + header.pixelOffset, baked.pixels.data(), baked.pixels.size_bytes()); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+            return blob;
+        }
+
+        // Rasterises coverage glyphs with nuklear.
+        [[nodiscard]] std::vector<std::byte> BakeCoverage(const std::filesystem::path& filename, float size, const std::vector<nk_rune>& ranges, uint64_t key)
+        {
+            FontAtlas atlas;
+            nk_font_atlas_begin(atlas.Get());
+
+            auto config = nk_font_config(size);
+            config.range = ranges.data();
+            config.fallback_glyph = FallbackGlyph;
+
+            const auto* font = nk_font_atlas_add_from_file(atlas.Get(), filename.string().c_str(), size, &config);
+            if(font == nullptr) { return {}; }
+
+            int width = 0, height = 0;
+            const auto* pixels = static_cast<const uint8_t*>(nk_font_atlas_bake(atlas.Get(), &width, &height, NK_FONT_ATLAS_ALPHA8));
+            if(pixels == nullptr) { return {}; }
+
+            const auto baked = BakedFont{
+                .width = static_cast<uint32_t>(width),
+                .height = static_cast<uint32_t>(height),
+                .fontHeight = font->info.height,
+                .ascent = font->info.ascent,
+                .descent = font->info.descent,
+                .glyphs = { font->glyphs, static_cast<size_t>(font->info.glyph_count) },
+                .pixels = { pixels, static_cast<size_t>(width) * static_cast<size_t>(height) },
+            };
+
+            return Serialise(baked, ranges, key, FontRender::Coverage);
+        }
+
+        // Generates a signed distance field per glyph with stb_truetype and packs them into a single page.
+        [[nodiscard]] std::vector<std::byte> BakeDistanceField(const std::filesystem::path& filename, float size, const std::vector<nk_rune>& ranges, uint64_t key)
+        {
+            const auto bytes = ReadFile(filename);
+            const auto* data = reinterpret_cast<const unsigned char*>(bytes.data()); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+
+            stbtt_fontinfo info{};
+            if(bytes.empty() || stbtt_InitFont(&info, data, stbtt_GetFontOffsetForIndex(data, 0)) == 0) { return {}; }
+
+            const auto bakeSize = std::max(size, DistanceFieldMinSize);
+            const auto scale = stbtt_ScaleForPixelHeight(&info, bakeSize);
+
+            int ascent = 0, descent = 0, lineGap = 0;
+            stbtt_GetFontVMetrics(&info, &ascent, &descent, &lineGap);
+
+            struct Bitmap
+            {
+                unsigned char* pixels = nullptr;
+                int w = 0, h = 0;
+            };
+
+            auto glyphs = std::vector<struct nk_font_glyph>{};
+            auto bitmaps = std::vector<Bitmap>{};
+            auto sizes = std::vector<packed_rect>{};
+            const auto baseline = std::round(static_cast<float>(ascent) * scale);
+
+            const auto release = gsl::finally([&bitmaps] {
+                for(const auto& bitmap : bitmaps) { stbtt_FreeSDF(bitmap.pixels, nullptr); }
+            });
+
+            for(auto range = 0uz; ranges[range] != 0u; range += 2uz)
+            {
+                for(auto codepoint = ranges[range]; codepoint <= ranges[range + 1uz]; ++codepoint)
+                {
+                    auto& glyph = glyphs.emplace_back();
+                    auto& bitmap = bitmaps.emplace_back();
+                    glyph.codepoint = codepoint;
+
+                    int advance = 0, bearing = 0, xoff = 0, yoff = 0;
+                    stbtt_GetCodepointHMetrics(&info, static_cast<int>(codepoint), &advance, &bearing);
+                    glyph.xadvance = static_cast<float>(advance) * scale;
+
+                    bitmap.pixels = stbtt_GetCodepointSDF(&info, scale, static_cast<int>(codepoint), DistanceFieldPadding, DistanceFieldEdge,
+                        static_cast<float>(DistanceFieldEdge) / static_cast<float>(DistanceFieldPadding), &bitmap.w, &bitmap.h, &xoff, &yoff);
+
+                    glyph.x0 = static_cast<float>(xoff);
+                    glyph.y0 = static_cast<float>(yoff) + baseline;
+                    glyph.x1 = glyph.x0 + static_cast<float>(bitmap.w);
+                    glyph.y1 = glyph.y0 + static_cast<float>(bitmap.h);
+                    glyph.w = static_cast<float>(bitmap.w);
+                    glyph.h = static_cast<float>(bitmap.h);
+
+                    // One texel of space between glyphs keeps bilinear filtering from bleeding across.
+                    sizes.push_back(packed_rect{ .w = static_cast<uint32_t>(bitmap.w) + 1u, .h = static_cast<uint32_t>(bitmap.h) + 1u });
+                }
+            }
+
+            auto placements = std::vector<page_placement>{};
+
+            try
+            {
+                placements = pack_rects(sizes, DistanceFieldPage, DistanceFieldPage);
+            }
+            catch(const std::invalid_argument&)
+            {
+                return {};
+            }
+
+            if(std::ranges::any_of(placements, [](const page_placement& p) { return p.page != 0uz; })) { return {}; }
+
+            // Crop the page to what was used, rounded up so rows stay four byte aligned.
+            auto height = 1u;
+            for(const auto& placement : placements) { height = std::max(height, placement.rect.y + placement.rect.h); }
+            height = static_cast<uint32_t>(AlignUp(height, 4uz));
+
+            const auto width = DistanceFieldPage;
+            auto pixels = std::vector<uint8_t>(size_t{width} * size_t{height}, 0u);
+
+            for(auto i = 0uz; i < glyphs.size(); ++i)
+            {
+                const auto& rect = placements[i].rect;
+                const auto& bitmap = bitmaps[i];
+                auto& glyph = glyphs[i];
+
+                for(auto row = 0; row < bitmap.h; ++row)
+                {
+                    std::memcpy(pixels.data() + ((rect.y + static_cast<size_t>(row)) * width) + rect.x, bitmap.pixels + (static_cast<size_t>(row) * static_cast<size_t>(bitmap.w)), static_cast<size_t>(bitmap.w)); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+                }
+
+                glyph.u0 = static_cast<float>(rect.x) / static_cast<float>(width);
+                glyph.v0 = static_cast<float>(rect.y) / static_cast<float>(height);
+                glyph.u1 = static_cast<float>(rect.x + static_cast<uint32_t>(bitmap.w)) / static_cast<float>(width);
+                glyph.v1 = static_cast<float>(rect.y + static_cast<uint32_t>(bitmap.h)) / static_cast<float>(height);
+            }
+
+            const auto baked = BakedFont{
+                .width = width,
+                .height = height,
+                .fontHeight = bakeSize,
+                .ascent = static_cast<float>(ascent) * scale,
+                .descent = static_cast<float>(descent) * scale,
+                .glyphs = glyphs,
+                .pixels = pixels,
+            };
+
+            return Serialise(baked, ranges, key, FontRender::DistanceField);
+        }
+
+        bool WriteCache(const std::filesystem::path& file, std::span<const std::byte> blob)
+        {
+            auto error = std::error_code{};
+            std::filesystem::create_directories(file.parent_path(), error);
+
+            auto temp = file;
+            temp += ".tmp";
+
+            {
+                auto out = std::ofstream{temp, std::ios::binary | std::ios::trunc};
+                out.write(reinterpret_cast<const char*>(blob.data()), static_cast<std::streamsize>(blob.size())); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+                if(!out) { return false; }
+            }
+
+            std::filesystem::rename(temp, file, error);
+            return !error;
+        }
+    }
+
+    /*
+        A font restored from a cache blob. nuklear only ever reads through nk_font, so the structures below are
+        filled in by hand and the glyph table is used in place, straight from the blob.
+    */
+    struct FontGroup::LoadedFont
+    {
+        struct nk_font font{};
+        struct nk_font_config config{};
+        std::vector<nk_rune> ranges;
+        MappedFile mapping;
+        std::vector<std::byte> baked;
+        Texture2D texture;
+
+        // Copies of the handle at other heights, see FontGroup::GetFontAtHeight.
+        segmented_array<struct nk_user_font> scaled;
+        flat_hash_map<uint32_t, const struct nk_user_font*> byHeight;
+
+        [[nodiscard]] std::span<const std::byte> Blob() const
+        {
+            return mapping.IsOpen() ? mapping.Bytes() : std::span<const std::byte>{baked};
+        }
+
+        // 'size' is the height the font was asked for, distance fields are baked larger than that.
+        void Restore(const CacheHeader& header, float size)
+        {
+            const auto blob = Blob();
+            const auto* runes = reinterpret_cast<const nk_rune*>(blob.data() + header.rangeOffset); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast, cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            ranges.assign(runes, runes + header.rangeCount); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            ranges.back() = 0u;
+
+            config.range = ranges.data();
+            config.size = header.fontHeight;
+            config.fallback_glyph = header.fallback;
+            config.font = &font.info;
+            config.n = config.p = &config;
+
+            font.info.height = header.fontHeight;
+            font.info.ascent = header.ascent;
+            font.info.descent = header.descent;
+            font.info.glyph_offset = 0u;
+            font.info.glyph_count = header.glyphCount;
+            font.info.ranges = ranges.data();
+            font.scale = 1.0f;
+            font.config = &config;
+
+            // nuklear never writes to the glyph table after baking, so it can point into the read-only mapping.
+            font.glyphs = reinterpret_cast<struct nk_font_glyph*>(const_cast<std::byte*>(blob.data() + header.glyphOffset)); // NOLINT
+            font.fallback_codepoint = header.fallback;
+            font.fallback = font.glyphs;
+            font.fallback = nk_font_find_glyph(&font, header.fallback);
+
+            texture.Create().WriteAlpha(blob.data() + header.pixelOffset, static_cast<int>(header.width), static_cast<int>(header.height)); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            font.texture = nk_handle_id(static_cast<int>(texture.GetID()));
+
+            font.handle.userdata = nk_handle_ptr(&font);
+            font.handle.height = size;
+            font.handle.width = TextWidth;
+            font.handle.query = QueryGlyph;
+            font.handle.texture = font.texture;
+        }
+    };
+
     FontAtlas::FontAtlas()
     : _atlas(std::make_shared<struct nk_font_atlas>())
     {
@@ -43,46 +450,125 @@ namespace proto
 	    nk_font_atlas_clear(_atlas.get());
     }
 
-    void FontGroup::Create()
+    FontGroup::FontGroup() = default;
+
+    FontGroup::~FontGroup()
     {
-        nk_font_atlas_begin(_atlas.Get());
+        for(auto& loaded : _loaded) { loaded->texture.Destroy(); }
     }
 
-    void FontGroup::Finalize(unsigned int id)
+    void FontGroup::AddFont(FontStyle styleMask, float size, const std::filesystem::path& filename, FontRender render)
     {
-        nk_font_atlas_end(_atlas.Get(), nk_handle_id((int)id), nullptr);
+        auto& files = (render == FontRender::DistanceField) ? _distanceFieldFiles : _fontFiles;
+        auto& fonts = (render == FontRender::DistanceField) ? _distanceFields : _fonts;
+
+        // A loaded font stays in _loaded, handles given out for it remain valid, the style just loads the new file next time.
+        files.insert_or_assign(styleMask, FontDescriptor{ .filename = filename, .size = size });
+        fonts.erase(styleMask);
     }
-    
-    void FontGroup::AddFont(FontStyle styleMask, float size, const std::filesystem::path& filename)
+
+    std::unique_ptr<FontGroup::LoadedFont> FontGroup::Load(const FontDescriptor& descriptor, FontRender render) const
     {
-        if(!_fonts.contains(styleMask))
+        auto loaded = std::make_unique<LoadedFont>();
+        const auto ranges = DefaultRanges();
+        const auto key = CacheKey(descriptor.filename, descriptor.size, ranges, render);
+        const auto cacheFile = _cacheDir.empty() ? std::filesystem::path{} : CacheFile(_cacheDir, key);
+
+        const CacheHeader* header = nullptr;
+
+        if(!cacheFile.empty() && loaded->mapping.Open(cacheFile))
         {
-            struct nk_font* temp = nk_font_atlas_add_from_file(_atlas.Get(), filename.string().c_str(), size, nullptr);
-            if(temp != nullptr) 
+            header = Validate(loaded->mapping.Bytes(), key, render);
+            if(header == nullptr) { loaded->mapping.Close(); }
+        }
+
+        if(header == nullptr)
+        {
+            loaded->baked = (render == FontRender::DistanceField) ? BakeDistanceField(descriptor.filename, descriptor.size, ranges, key) : BakeCoverage(descriptor.filename, descriptor.size, ranges, key);
+
+            // Prefer the mapped copy once it is on disk, the baked buffer can then be dropped.
+            if(!cacheFile.empty() && WriteCache(cacheFile, loaded->baked) && loaded->mapping.Open(cacheFile))
             {
-                _fonts.insert_or_assign(styleMask, temp);
+                loaded->baked = {};
             }
+
+            header = Validate(loaded->Blob(), key, render);
+            if(header == nullptr) { return nullptr; }
         }
+
+        loaded->Restore(*header, descriptor.size);
+        return loaded;
+    }
+
+    FontGroup::LoadedFont* FontGroup::Find(FontStyle mask, FontRender render)
+    {
+        auto& fonts = (render == FontRender::DistanceField) ? _distanceFields : _fonts;
+        auto& files = (render == FontRender::DistanceField) ? _distanceFieldFiles : _fontFiles;
+
+        if(auto it = fonts.find(mask); it != fonts.end())
+        {
+            return it->second;
+        }
+
+        auto descriptor = files.find(mask);
+        if(descriptor == files.end() || descriptor->second.failed) { return nullptr; }
+
+        auto loaded = Load(descriptor->second, render);
+
+        if(!loaded)
+        {
+            // Only report it once, the UI asks for its fonts every frame.
+            std::printf("[Font]: Could not load font %s.\n", descriptor->second.filename.string().c_str()); // NOLINT(cppcoreguidelines-pro-type-vararg)
+            descriptor->second.failed = true;
+            return nullptr;
+        }
+
+        auto* font = fonts.try_emplace(mask, loaded.get()).first->second;
+        _loaded.push_back(std::move(loaded));
+
+        return font;
     }
 
     nk_font* FontGroup::GetFont(FontStyle mask)
     {
-        if(_fonts.contains(mask))
+        if(auto* loaded = Find(mask, FontRender::Coverage))
         {
-            return _fonts.at(mask);
+            return &loaded->font;
+        }
+
+        if(auto* loaded = Find(mask, FontRender::DistanceField))
+        {
+            return &loaded->font;
         }
 
         return nullptr;
     }
 
-    const nk_font* FontGroup::GetFont(FontStyle mask) const
+    const nk_user_font* FontGroup::GetFontAtHeight(FontStyle mask, float height)
     {
-        if(_fonts.contains(mask))
+        auto* found = Find(mask, FontRender::DistanceField);
+        if(found == nullptr) { found = Find(mask, FontRender::Coverage); }
+        if(found == nullptr) { return nullptr; }
+
+        auto& loaded = *found;
+        const auto key = std::bit_cast<uint32_t>(height);
+
+        if(auto it = loaded.byHeight.find(key); it != loaded.byHeight.end())
         {
-            return _fonts.at(mask);
+            return it->second;
         }
 
-        return nullptr;
+        // The scaled handles never move, nuklear keeps pointers to them on its style stack.
+        auto& handle = loaded.scaled.emplace_back(loaded.font.handle);
+        handle.height = height;
+
+        loaded.byHeight.try_emplace(key, &handle);
+        return &handle;
+    }
+
+    bool FontGroup::IsDistanceField(uint32_t textureId) const
+    {
+        return std::ranges::any_of(_distanceFields, [textureId](const auto& entry) { return entry.second->texture.GetID() == textureId; });
     }
 
 }
@@ -0,0 +1,414 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <Generator.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include <sol/sol.hpp>
+
+#include <Scene.hpp>
+#include <stl/parallel.hpp>
+
+namespace proto
+{
+	namespace
+	{
+		[[nodiscard, maybe_unused]] const char* NameOf(const Generator::Settings& settings)
+		{
+			constexpr auto names = std::array{ "Noise", "Caves", "Dungeon", "WFC" };
+			return names.at(settings.index());
+		}
+
+		[[nodiscard]] std::optional<size_t> LayerIndex(const TileMap& map, std::string_view name)
+		{
+			const auto& layers = map.Layers();
+			const auto found = std::ranges::find_if(layers, [name](const TileLayer& layer) { return layer.Name() == name; });
+
+			return found != layers.end() ? std::optional{ static_cast<size_t>(found - layers.begin()) } : std::nullopt;
+		}
+
+		// Learns the rules from the sample layer and pins down the cells that are kept.
+		[[nodiscard]] std::unique_ptr<wfc_solver> MakeSolver(const TileMap& map, const TileLayer& target, const Generator::WfcSettings& settings)
+		{
+			const auto& sample = map.Layers()[settings.sampleLayer];
+			auto cells = std::vector<TileId>(size_t{sample.Width()} * sample.Height());
+
+			for(auto y = 0u; y < sample.Height(); ++y) { sample.ReadRow(y, std::span{ cells }.subspan(size_t{y} * sample.Width(), sample.Width())); }
+
+			auto rules = wfc_rules::learn(cells, sample.Width(), sample.Height(), EmptyTile);
+			if(rules.tiles() == 0u) { throw std::invalid_argument("The WFC sample layer is empty."); }
+
+			if(size_t{target.Width()} * target.Height() * rules.tiles() * 4uz * sizeof(uint16_t) > Generator::MaxWfcBytes)
+			{
+				throw std::invalid_argument("The layer is too large for WFC with this many tiles.");
+			}
+
+			auto solver = std::make_unique<wfc_solver>(std::move(rules), target.Width(), target.Height());
+
+			if(settings.keepPainted)
+			{
+				auto row = std::vector<TileId>(target.Width());
+
+				for(auto y = 0u; y < target.Height(); ++y)
+				{
+					target.ReadRow(y, row);
+
+					for(auto x = 0u; x < target.Width(); ++x)
+					{
+						if(row[x] == EmptyTile) { continue; }
+						if(const auto tile = solver->rules().index_of(row[x])) { solver->fix(x, y, *tile); }
+					}
+				}
+			}
+
+			return solver;
+		}
+	}
+
+	Generator::~Generator()
+	{
+		Stop();
+	}
+
+	void Generator::Start(Scene& scene, size_t layer, uint64_t seed, Settings settings)
+	{
+		if(_busy) { throw std::logic_error("Generator is already running."); }
+
+		const auto& target = scene.GetMap().Layers().at(layer);
+		auto solver = std::unique_ptr<wfc_solver>{};
+
+		if(auto* noise = std::get_if<NoiseSettings>(&settings))
+		{
+			std::ranges::stable_sort(noise->bands, {}, &NoiseBand::below);
+		}
+		else if(const auto* wfc = std::get_if<WfcSettings>(&settings))
+		{
+			if(wfc->sampleLayer >= scene.GetMap().Layers().size()) { throw std::out_of_range("No such WFC sample layer."); }
+			solver = MakeSolver(scene.GetMap(), target, *wfc);
+		}
+
+		scene.GetJournal().Begin(scene.GetMap(), "Generate", false);
+		_solver = std::move(solver);
+
+#ifdef _DEBUG_
+		std::printf("[Generator]: %s on %s, %ux%u, seed %llu.\n", NameOf(settings), target.Name().c_str(), target.Width(), target.Height(), static_cast<unsigned long long>(seed)); // NOLINT(cppcoreguidelines-pro-type-vararg)
+#endif // _DEBUG_
+
+		_layer = layer;
+		_total = size_t{target.ChunksX()} * target.ChunksY();
+		_adopted = 0uz;
+		_busy = true;
+		_cancel = false;
+		_timer.Reset();
+
+		_work = thread_pool::shared().async([this, seed, settings = std::move(settings), width = target.Width(), height = target.Height()]() {
+			Generate(seed, settings, width, height);
+		});
+	}
+
+	void Generator::Generate(uint64_t seed, const Settings& settings, uint32_t width, uint32_t height)
+	{
+		const auto chunksX = (width + TileLayer::ChunkSize - 1u) / TileLayer::ChunkSize;
+		const auto chunksY = (height + TileLayer::ChunkSize - 1u) / TileLayer::ChunkSize;
+
+		// Caves need their neighbours' previous generation, so they are stepped over the whole layer first. The
+		// others draw each chunk on its own.
+		auto caves = cave_automaton{};
+		auto dungeon = bsp_dungeon{};
+
+		if(const auto* cave = std::get_if<CaveSettings>(&settings))
+		{
+			caves = cave_automaton{ width, height };
+			caves.seed(seed, cave->wallChance);
+
+			for(auto step = 0u; step < cave->steps && !_cancel; ++step) { caves.step(cave->birth, cave->survive); }
+		}
+		else if(const auto* layout = std::get_if<DungeonSettings>(&settings))
+		{
+			dungeon.build(seed, width, height, layout->layout);
+		}
+		else if(const auto* wfc = std::get_if<WfcSettings>(&settings))
+		{
+			const auto result = _solver->run(seed, wfc->backtracks, wfc->attempts, &_cancel);
+
+#ifdef _DEBUG_
+			const auto& stats = _solver->stats();
+
+			std::printf("[Generator]: WFC %s after %llu observations and %llu backtracks in %u attempts, propagate %.1f ms, observe %.1f ms.\n", // NOLINT(cppcoreguidelines-pro-type-vararg)
+				result == wfc_result::solved ? "solved" : result == wfc_result::stopped ? "stopped" : "failed",
+				static_cast<unsigned long long>(stats.observations), static_cast<unsigned long long>(stats.backtracks), stats.attempts,
+				std::chrono::duration<double, std::milli>(stats.propagate).count(), std::chrono::duration<double, std::milli>(stats.observe).count());
+#endif // _DEBUG_
+
+			if(result != wfc_result::solved) { return; }
+		}
+
+		parallel_for(size_t{chunksX} * chunksY, [&](size_t first, size_t last) {
+			auto noise = std::vector<float>(TileLayer::ChunkArea);
+			auto floor = std::vector<uint8_t>(TileLayer::ChunkArea);
+
+			for(auto i = first; i < last && !_cancel.load(std::memory_order_relaxed); ++i)
+			{
+				const auto cx = static_cast<uint32_t>(i % chunksX), cy = static_cast<uint32_t>(i / chunksX);
+				const auto x0 = cx * TileLayer::ChunkSize, y0 = cy * TileLayer::ChunkSize;
+				const auto w = std::min(TileLayer::ChunkSize, width - x0), h = std::min(TileLayer::ChunkSize, height - y0);
+
+				// Cells past the layer's edges stay empty.
+				auto tiles = std::make_shared<TileId[]>(TileLayer::ChunkArea);
+				const auto cells = std::span{ tiles.get(), TileLayer::ChunkArea };
+				const auto put = [&](auto&& tileAt) {
+					for(auto y = 0u; y < h; ++y)
+					{
+						for(auto x = 0u; x < w; ++x) { cells[(size_t{y} * TileLayer::ChunkSize) + x] = tileAt(x, y); }
+					}
+				};
+
+				if(const auto* bands = std::get_if<NoiseSettings>(&settings))
+				{
+					value_noise(seed, bands->noise, x0, y0, w, h, noise);
+
+					put([&](uint32_t x, uint32_t y) {
+						const auto value = noise[(size_t{y} * w) + x];
+						const auto band = std::ranges::find_if(bands->bands, [value](const NoiseBand& b) { return value < b.below; });
+
+						if(band != bands->bands.end()) { return band->tile; }
+						return bands->bands.empty() ? EmptyTile : bands->bands.back().tile;
+					});
+				}
+				else if(const auto* cave = std::get_if<CaveSettings>(&settings))
+				{
+					put([&](uint32_t x, uint32_t y) { return caves.at(x0 + x, y0 + y) != 0u ? cave->wall : cave->floor; });
+				}
+				else if(const auto* layout = std::get_if<DungeonSettings>(&settings))
+				{
+					std::ranges::fill(floor, uint8_t{0u});
+					dungeon.rasterize(x0, y0, w, h, floor);
+
+					put([&](uint32_t x, uint32_t y) { return floor[(size_t{y} * w) + x] != 0u ? layout->floor : layout->wall; });
+				}
+				else
+				{
+					put([&](uint32_t x, uint32_t y) { return _solver->value_at(x0 + x, y0 + y); });
+				}
+
+				// Chunks with nothing in them are freed rather than stored.
+				if(std::ranges::all_of(cells, [](TileId tile) { return tile == EmptyTile; })) { tiles = nullptr; }
+
+				auto lock = std::scoped_lock{ _lock };
+				_ready.push_back({ cx, cy, std::move(tiles) });
+			}
+		}, 4uz);
+	}
+
+	void Generator::Update(Scene& scene)
+	{
+		if(!_busy) { return; }
+
+		_adopting.clear();
+		{
+			auto lock = std::scoped_lock{ _lock };
+			const auto count = std::min(_ready.size(), ChunksPerUpdate);
+
+			// Oldest first, so the layer fills in the order the workers finished.
+			const auto taken = _ready.begin() + static_cast<std::ptrdiff_t>(count);
+			std::move(_ready.begin(), taken, std::back_inserter(_adopting));
+			_ready.erase(_ready.begin(), taken);
+		}
+
+		auto& journal = scene.GetJournal();
+		for(auto& chunk : _adopting) { journal.AdoptChunk(_layer, chunk.cx, chunk.cy, std::move(chunk.tiles)); }
+
+		_adopted += _adopting.size();
+		_adopting.clear();
+
+		if(_adopted == _total) { Finish(scene, "Generated"); }
+		else if(_work.wait_for(std::chrono::seconds{0}) == std::future_status::ready)
+		{
+			// The workers stopped short, which only happens when one of them threw.
+			auto lock = std::scoped_lock{ _lock };
+			if(_ready.empty()) { Finish(scene, "Failed"); }
+		}
+	}
+
+	void Generator::Cancel(Scene& scene)
+	{
+		if(!_busy) { return; }
+
+		_cancel = true;
+		Finish(scene, "Cancelled");
+	}
+
+	void Generator::Stop()
+	{
+		_cancel = true;
+
+		if(_work.valid())
+		{
+			try
+			{
+				_work.get();
+			}
+			catch([[maybe_unused]] const std::exception& e)
+			{
+#ifdef _DEBUG_
+				std::printf("[Generator]: %s\n", e.what()); // NOLINT(cppcoreguidelines-pro-type-vararg)
+#endif // _DEBUG_
+			}
+		}
+
+		_ready.clear();
+		_busy = false;
+
+		if(_solver)
+		{
+			_wfcStats = _solver->stats();
+			_solver.reset();
+		}
+	}
+
+	void Generator::Finish(Scene& scene, [[maybe_unused]] const char* outcome)
+	{
+		Stop();
+		scene.GetJournal().Commit();
+
+#ifdef _DEBUG_
+		std::printf("[Generator]: %s %zu of %zu chunks in %.1f ms.\n", outcome, _adopted, _total, _timer.Milliseconds()); // NOLINT(cppcoreguidelines-pro-type-vararg)
+#endif // _DEBUG_
+	}
+
+	void Generator::BindLua(Scene& scene, sol::state_view& lua)
+	{
+		// Scripts get false and a message instead of an error for anything that keeps a generator from starting.
+		const auto start = [this, &scene](std::string_view layer, uint64_t seed, Settings settings) -> bool {
+			const auto index = LayerIndex(scene.GetMap(), layer);
+
+			if(!index)
+			{
+#ifdef _DEBUG_
+				std::printf("[Generator]: No layer called %.*s.\n", static_cast<int>(layer.size()), layer.data()); // NOLINT(cppcoreguidelines-pro-type-vararg)
+#endif // _DEBUG_
+				return false;
+			}
+
+			try
+			{
+				Start(scene, *index, seed, std::move(settings));
+				return true;
+			}
+			catch([[maybe_unused]] const std::exception& e)
+			{
+#ifdef _DEBUG_
+				std::printf("[Generator]: %s\n", e.what()); // NOLINT(cppcoreguidelines-pro-type-vararg)
+#endif // _DEBUG_
+				return false;
+			}
+		};
+
+		auto generate = lua.create_named_table("Generate");
+
+		generate["Noise"] = [start](const std::string& layer, uint64_t seed, sol::optional<sol::table> options) {
+			auto settings = NoiseSettings{};
+			if(options)
+			{
+				settings.noise.scale = options->get_or<float>("scale", settings.noise.scale);
+				settings.noise.octaves = options->get_or<uint32_t>("octaves", settings.noise.octaves);
+				settings.noise.persistence = options->get_or<float>("persistence", settings.noise.persistence);
+				settings.noise.lacunarity = options->get_or<float>("lacunarity", settings.noise.lacunarity);
+
+				if(const auto bands = options->get<sol::optional<sol::table>>("bands"))
+				{
+					for(auto i = 1uz; i <= bands->size(); ++i)
+					{
+						const sol::table band = (*bands)[i];
+						settings.bands.push_back(NoiseBand{ .below = band.get_or<float>(1, 1.f), .tile = band.get_or<TileId>(2, EmptyTile) });
+					}
+				}
+			}
+
+			return start(layer, seed, std::move(settings));
+		};
+
+		generate["Caves"] = [start](const std::string& layer, uint64_t seed, sol::optional<sol::table> options) {
+			auto settings = CaveSettings{};
+
+			if(options)
+			{
+				settings.wallChance = options->get_or<float>("fill", settings.wallChance);
+				settings.steps = options->get_or<uint32_t>("steps", settings.steps);
+				settings.birth = options->get_or<uint32_t>("birth", settings.birth);
+				settings.survive = options->get_or<uint32_t>("survive", settings.survive);
+				settings.floor = options->get_or<TileId>("floor", settings.floor);
+				settings.wall = options->get_or<TileId>("wall", settings.wall);
+			}
+
+			return start(layer, seed, settings);
+		};
+
+		generate["Dungeon"] = [start](const std::string& layer, uint64_t seed, sol::optional<sol::table> options) {
+			auto settings = DungeonSettings{};
+
+			if(options)
+			{
+				settings.layout.min_leaf = options->get_or<uint32_t>("min_leaf", settings.layout.min_leaf);
+				settings.layout.max_depth = options->get_or<uint32_t>("max_depth", settings.layout.max_depth);
+				settings.layout.min_room = options->get_or<uint32_t>("min_room", settings.layout.min_room);
+				settings.layout.margin = options->get_or<uint32_t>("margin", settings.layout.margin);
+				settings.floor = options->get_or<TileId>("floor", settings.floor);
+				settings.wall = options->get_or<TileId>("wall", settings.wall);
+			}
+
+			return start(layer, seed, settings);
+		};
+
+		generate["Wfc"] = [start, &scene](const std::string& layer, uint64_t seed, sol::table options) {
+			const auto sampleName = options.get_or<std::string>("sample", "");
+			const auto sample = LayerIndex(scene.GetMap(), sampleName);
+
+			if(!sample)
+			{
+#ifdef _DEBUG_
+				std::printf("[Generator]: No WFC sample layer called %s.\n", sampleName.c_str()); // NOLINT(cppcoreguidelines-pro-type-vararg)
+#endif // _DEBUG_
+				return false;
+			}
+
+			auto settings = WfcSettings{ .sampleLayer = *sample };
+			settings.backtracks = options.get_or<uint32_t>("backtracks", settings.backtracks);
+			settings.attempts = options.get_or<uint32_t>("attempts", settings.attempts);
+			settings.keepPainted = options.get_or<bool>("keep", settings.keepPainted);
+
+			return start(layer, seed, settings);
+		};
+
+		generate["Busy"] = [this]() { return Busy(); };
+		generate["Progress"] = [this]() { return Progress(); };
+		generate["Cancel"] = [this, &scene]() { Cancel(scene); };
+	}
+}
@@ -17,35 +17,151 @@
 */
 #include <Image.hpp>
 
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
+#include <stl/pixel_convert.hpp>
+
 namespace proto
 {
+	namespace
+	{
+		struct PamHeader
+		{
+			uint32_t width = 0u, height = 0u, depth = 0u, maxval = 0u;
+			std::string_view tupleType;
+			size_t dataOffset = 0uz;
+		};
+
+		// Parses the text header of a binary PAM file ("P7"). Returns an empty header if ENDHDR is missing or a line is malformed.
+		[[nodiscard]] PamHeader ParsePam(std::string_view text)
+		{
+			auto header = PamHeader{};
+			if(!text.starts_with("P7\n")) { return header; }
+
+			for(auto pos = 3uz; pos < text.size();)
+			{
+				const auto end = text.find('\n', pos);
+				if(end == std::string_view::npos) { break; }
+
+				const auto line = text.substr(pos, end - pos);
+				pos = end + 1uz;
+
+				if(line == "ENDHDR")
+				{
+					header.dataOffset = pos;
+					break;
+				}
+
+				const auto space = line.find(' ');
+				if(line.empty() || line.front() == '#' || space == std::string_view::npos) { continue; }
+
+				// A key with nothing after it, "WIDTH " say, is malformed rather than empty.
+				const auto start = line.find_first_not_of(' ', space);
+				if(start == std::string_view::npos) { return {}; }
+
+				const auto key = line.substr(0uz, space);
+				const auto value = line.substr(start);
+
+				const auto number = [&value](uint32_t& out) { std::from_chars(value.data(), value.data() + value.size(), out); }; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+				if(key == "WIDTH") { number(header.width); }
+				else if(key == "HEIGHT") { number(header.height); }
+				else if(key == "DEPTH") { number(header.depth); }
+				else if(key == "MAXVAL") { number(header.maxval); }
+				else if(key == "TUPLTYPE") { header.tupleType = value; }
+			}
+
+			return header;
+		}
+	}
+
+	ImageView::ImageView(std::shared_ptr<const void> owner, const uint8_t* pixels, uint32_t w, uint32_t h, size_t stride)
+		: _owner(std::move(owner)), _pixels(pixels), _width(w), _height(h), _stride(stride)
+	{
+	}
+
+	std::span<const uint8_t> ImageView::Bytes() const
+	{
+		if(Empty() || _height == 0u) { return {}; }
+		return { _pixels, (_stride * (_height - 1u)) + (size_t{_width} * BytesPerPixel) };
+	}
+
+	std::span<const uint8_t> ImageView::Row(uint32_t y) const
+	{
+		return { _pixels + (_stride * y), size_t{_width} * BytesPerPixel }; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+	}
+
+	ImageView ImageView::Sub(uint32_t x, uint32_t y, uint32_t w, uint32_t h) const
+	{
+		if(x >= _width || y >= _height) { return {}; }
+
+		w = std::min(w, _width - x);
+		h = std::min(h, _height - y);
+
+		return { _owner, _pixels + (_stride * y) + (size_t{x} * BytesPerPixel), w, h, _stride }; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+	}
 	
 	Image::Image(const std::filesystem::path& filename)
 	{
-		Load(filename);
+		static_cast<void>(Load(filename));
 	}
 
 	Image::Image(uint32_t w, uint32_t h, std::span<uint8_t> dataIn)
-		: _width(w), _height(h), _data(dataIn.begin(), dataIn.end())
 	{
+		static_cast<void>(LoadCopy(w, h, dataIn));
 	}
 
 	bool Image::Load(const std::filesystem::path& filename)
 	{
-		// For now, we will require png images.
-		if (std::filesystem::exists(filename) && filename.extension() == ".png")
+		Clear();
+
+		if(!std::filesystem::exists(filename)) { return false; }
+
+		if(filename.extension() == ".pam") { return LoadPam(filename); }
+
+		// Anything else has to go through the decoder, and for now we require png images.
+		if (filename.extension() == ".png")
 		{
 			int w, h, c; // NOLINT(cppcoreguidelines-init-variables) - variables initialized elsewhere
-			uint8_t* ptr = stbi_load(filename.string().c_str(), &w, &h, &c, 0);
+			const auto name = filename.string();
+
+			if(stbi_info(name.c_str(), &w, &h, &c) == 0) { return false; }
+
+			/*
+				Texture2D uploads RGBA. stb expands RGB one pixel at a time, so RGB images are decoded as they are
+				and expanded in place with the SIMD kernel instead, after growing stb's buffer (it allocates with
+				malloc unless STBI_MALLOC is overridden, which we don't).
+			*/
+			const auto rgb = (c == STBI_rgb);
+			uint8_t* ptr = stbi_load(name.c_str(), &w, &h, &c, rgb ? STBI_rgb : STBI_rgb_alpha);
 
 			if(ptr == nullptr) { return false; }
 
-			const auto size = size_t(w) * size_t(h);
-			auto sp = std::span<uint8_t>{ ptr, size };
-			_data.assign(sp.begin(), sp.end());
+			const auto pixels = size_t(w) * size_t(h);
+			const auto size = pixels * ImageView::BytesPerPixel;
+
+			if(rgb)
+			{
+				auto* grown = static_cast<uint8_t*>(std::realloc(ptr, size)); // NOLINT(cppcoreguidelines-no-malloc)
+
+				if(grown == nullptr)
+				{
+					stbi_image_free(ptr);
+					return false;
+				}
+
+				ptr = grown;
+				rgb_to_rgba_in_place(std::span<uint8_t>{ ptr, size }, pixels);
+			}
+
+			Adopt(static_cast<uint32_t>(w), static_cast<uint32_t>(h), std::span<uint8_t>{ ptr, size }, std::shared_ptr<void>{ ptr, stbi_image_free });
 
 			return true;
 		}
@@ -53,15 +169,56 @@ namespace proto
 		return false;
 	}
 
+	bool Image::LoadRaw(const std::filesystem::path& filename, uint32_t w, uint32_t h)
+	{
+		Clear();
+		return AdoptMapping(MappedFile{ filename, MappedFile::Access::CopyOnWrite }, w, h, 0uz);
+	}
+
+	bool Image::LoadPam(const std::filesystem::path& filename)
+	{
+		auto file = MappedFile{ filename, MappedFile::Access::CopyOnWrite };
+		if(!file.IsOpen()) { return false; }
+
+		const auto bytes = file.Bytes();
+		const auto header = ParsePam(std::string_view{ reinterpret_cast<const char*>(bytes.data()), bytes.size() }); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+
+		// Only the layout that matches ours can be used in place.
+		if(header.dataOffset == 0uz || header.depth != ImageView::BytesPerPixel || header.maxval != 255u || header.tupleType != "RGB_ALPHA")
+		{
+			return false;
+		}
+
+		const auto width = header.width, height = header.height;
+		const auto offset = header.dataOffset;
+
+		return AdoptMapping(std::move(file), width, height, offset);
+	}
+
+	bool Image::AdoptMapping(MappedFile&& file, uint32_t w, uint32_t h, size_t offset)
+	{
+		const auto size = size_t{w} * size_t{h} * ImageView::BytesPerPixel;
+		if(!file.IsOpen() || size == 0uz || offset > file.Size() || size > file.Size() - offset) { return false; }
+
+		auto mapping = std::make_shared<MappedFile>(std::move(file));
+		const auto bytes = mapping->WritableBytes().subspan(offset, size);
+		const auto pixels = std::span<uint8_t>{ reinterpret_cast<uint8_t*>(bytes.data()), size }; // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+
+		Adopt(w, h, pixels, std::move(mapping));
+		_mapped = true;
+
+		return true;
+	}
+
 	bool Image::LoadCopy(uint32_t w, uint32_t h, std::span<uint8_t> dataIn)
 	{
 		if (!dataIn.empty())
 		{
-			_width = w; _height = h;
-			_data.clear();
+			auto buffer = std::make_shared_for_overwrite<uint8_t[]>(dataIn.size());
+			const auto pixels = std::span<uint8_t>{ buffer.get(), dataIn.size() };
+			std::ranges::copy(dataIn, pixels.begin());
 
-			_data.reserve(size_t(w) * size_t(h));
-			_data.assign(dataIn.begin(), dataIn.end());
+			Adopt(w, h, pixels, std::move(buffer));
 
 			return true;
 		}
@@ -69,4 +226,39 @@ namespace proto
 		return false;
 	}
 
+	void Image::Adopt(uint32_t w, uint32_t h, std::span<uint8_t> pixels, std::shared_ptr<void> owner)
+	{
+		_width = w;
+		_height = h;
+		_data = pixels;
+		_storage = std::move(owner);
+		_mapped = false;
+	}
+
+	Image Image::Clone() const
+	{
+		auto copy = Image{};
+		static_cast<void>(copy.LoadCopy(_width, _height, _data));
+		return copy;
+	}
+
+	void Image::Clear()
+	{
+		_width = _height = 0u;
+		_data = {};
+		_storage.reset();
+		_mapped = false;
+	}
+
+	void Image::PremultiplyAlpha()
+	{
+		premultiply_alpha(_data);
+	}
+
+	ImageView Image::View() const
+	{
+		if(Empty()) { return {}; }
+		return { _storage, _data.data(), _width, _height, size_t{_width} * ImageView::BytesPerPixel };
+	}
+
 }
@@ -0,0 +1,164 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <ImageLoader.hpp>
+
+#include <cstdio>
+#include <utility>
+
+#include <Stopwatch.hpp>
+
+namespace proto
+{
+	ImageLoader::ImageLoader(thread_pool& pool)
+		: _pool(pool)
+	{
+	}
+
+	ImageLoader::~ImageLoader()
+	{
+		auto lock = std::unique_lock{_lock};
+		_signal.wait(lock, [this]() { return _inFlight == 0uz; });
+	}
+
+	void ImageLoader::Queue(const std::filesystem::path& file)
+	{
+		auto image = std::unique_ptr<Image>{};
+
+		{
+			auto lock = std::scoped_lock{_lock};
+			image = Acquire();
+			++_inFlight;
+		}
+
+		_pool.submit([this, file, image = std::move(image)]() mutable {
+			const Stopwatch timer;
+			const auto loaded = image->Load(file);
+			const auto decode = timer.Elapsed();
+
+			{
+				auto lock = std::scoped_lock{_lock};
+				_done.emplace_back(Decoded{ .file = file, .image = std::move(image), .decode = decode, .loaded = loaded });
+				--_inFlight;
+
+				// Notify under the lock, the destructor may be waiting to tear the loader down.
+				_signal.notify_all();
+			}
+		});
+	}
+
+	size_t ImageLoader::QueueDirectory(const std::filesystem::path& dir, std::string_view extension)
+	{
+		if(!std::filesystem::is_directory(dir)) { return 0uz; }
+
+		auto count = 0uz;
+
+		for(const auto& entry : std::filesystem::directory_iterator(dir))
+		{
+			if(entry.is_regular_file() && entry.path().extension() == extension)
+			{
+				Queue(entry.path());
+				++count;
+			}
+		}
+
+		return count;
+	}
+
+	size_t ImageLoader::Poll(const UploadFunc& upload)
+	{
+		auto lock = std::unique_lock{_lock};
+		return Drain(lock, upload);
+	}
+
+	void ImageLoader::Finish(const UploadFunc& upload)
+	{
+		auto lock = std::unique_lock{_lock};
+
+		while(true)
+		{
+			Drain(lock, upload);
+
+			if(_inFlight == 0uz && _done.empty()) { return; }
+
+			// Help with the decoding rather than sit idle, the pool may be busy with other work.
+			lock.unlock();
+			const auto helped = _pool.try_run_one();
+			lock.lock();
+
+			if(!helped) { _signal.wait(lock, [this]() { return !_done.empty() || _inFlight == 0uz; }); }
+		}
+	}
+
+	size_t ImageLoader::Pending() const
+	{
+		auto lock = std::scoped_lock{_lock};
+		return _inFlight + _done.size();
+	}
+
+	void ImageLoader::Report() const
+	{
+		auto total = std::chrono::microseconds{};
+
+		for(const auto& timing : _timings)
+		{
+			std::printf("[ImageLoader]: %s decoded in %.2f ms%s\n", timing.file.filename().string().c_str(), // NOLINT(cppcoreguidelines-pro-type-vararg)
+				static_cast<double>(timing.decode.count()) / 1000.0, timing.loaded ? "" : " (failed)");
+			total += timing.decode;
+		}
+
+		std::printf("[ImageLoader]: %zu files, %.2f ms of decoding\n", _timings.size(), static_cast<double>(total.count()) / 1000.0); // NOLINT(cppcoreguidelines-pro-type-vararg)
+	}
+
+	std::unique_ptr<Image> ImageLoader::Acquire()
+	{
+		if(_free.empty()) { return std::make_unique<Image>(); }
+
+		auto image = std::move(_free.back());
+		_free.pop_back();
+		return image;
+	}
+
+	/*
+		Uploads run without the lock held so the workers can keep publishing results. The batch is swapped out
+		first, and its Images go back to the pool afterwards.
+	*/
+	size_t ImageLoader::Drain(std::unique_lock<std::mutex>& lock, const UploadFunc& upload)
+	{
+		if(_done.empty()) { return 0uz; }
+
+		auto batch = std::exchange(_done, {});
+		lock.unlock();
+
+		for(auto& decoded : batch)
+		{
+			if(decoded.loaded) { upload(decoded.file, *decoded.image); }
+		}
+
+		lock.lock();
+
+		for(auto& decoded : batch)
+		{
+			_timings.emplace_back(Timing{ .file = std::move(decoded.file), .decode = decoded.decode, .loaded = decoded.loaded });
+
+			decoded.image->Clear();
+			_free.push_back(std::move(decoded.image));
+		}
+
+		return batch.size();
+	}
+}
@@ -0,0 +1,420 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <Journal.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#include <zlib.h>
+
+#include <stl/cell_delta.hpp>
+
+namespace proto
+{
+	namespace
+	{
+		constexpr auto ChunkArea = TileLayer::ChunkArea;
+
+		// Stands in for a chunk that was never allocated.
+		constexpr auto Blank = std::array<TileId, ChunkArea>{};
+
+		[[nodiscard]] uint64_t ChunkKey(size_t layer, uint32_t cx, uint32_t cy) { return (uint64_t{layer} << 32u) | (uint64_t{cy} << 16u) | uint64_t{cx}; }
+	}
+
+	Journal::~Journal()
+	{
+		Clear();
+	}
+
+	void Journal::Configure(size_t budget, std::filesystem::path spillFile)
+	{
+		Clear();
+
+		_budget = budget;
+		_spillFile = std::move(spillFile);
+	}
+
+	void Journal::Begin(TileMap& map, std::string label, bool coalesce)
+	{
+		if(_open) { throw std::logic_error("Journal already has an open edit."); }
+
+		_merging = coalesce && _coalesce && &map == _map && _position == _entries.size() && _entries.back().label == label &&
+			std::chrono::steady_clock::now() - _lastCommit < CoalesceWindow;
+
+		if(!_merging) { StopCoalescing(); }
+
+		_map = &map;
+		_label = std::move(label);
+		_lastKey = ~uint64_t{0u};
+		_open = true;
+	}
+
+	void Journal::Touch(size_t layer, uint32_t cx, uint32_t cy)
+	{
+		if(!_open) { throw std::logic_error("Journal has no open edit."); }
+
+		// Tools write cell after cell into the same chunk, which only needs looking up once.
+		const auto key = ChunkKey(layer, cx, cy);
+		if(key == _lastKey) { return; }
+
+		const auto& target = _map->Layers().at(layer);
+		if(cx >= target.ChunksX() || cy >= target.ChunksY()) { throw std::out_of_range("Chunk is outside the layer."); }
+
+		_before.try_emplace(key, target.SharedChunk(cx, cy));
+		_lastKey = key;
+	}
+
+	void Journal::Set(size_t layer, uint32_t x, uint32_t y, TileId tile)
+	{
+		if(!_open) { throw std::logic_error("Journal has no open edit."); }
+
+		auto& target = _map->Layers().at(layer);
+		if(x >= target.Width() || y >= target.Height()) { return; }
+
+		Touch(layer, x / TileLayer::ChunkSize, y / TileLayer::ChunkSize);
+		target.Set(x, y, tile);
+	}
+
+	std::span<TileId> Journal::WritableChunk(size_t layer, uint32_t cx, uint32_t cy)
+	{
+		Touch(layer, cx, cy);
+		return _map->Layers()[layer].WritableChunk(cx, cy);
+	}
+
+	void Journal::AdoptChunk(size_t layer, uint32_t cx, uint32_t cy, TileLayer::ChunkPtr tiles)
+	{
+		Touch(layer, cx, cy);
+		_map->Layers()[layer].AdoptChunk(cx, cy, std::move(tiles));
+	}
+
+	std::vector<uint8_t> Journal::Encode() const
+	{
+		auto keys = std::vector<uint64_t>{};
+		keys.reserve(_before.size());
+
+		for(const auto& [key, chunk] : _before) { keys.push_back(key); }
+		std::ranges::sort(keys);
+
+		// Per changed chunk: its key, its number of runs, then the runs as put_cell_delta() writes them.
+		auto out = std::vector<uint8_t>{};
+		auto runs = std::vector<uint8_t>{};
+
+		for(const auto key : keys)
+		{
+			const auto& layers = _map->Layers();
+			const auto index = static_cast<size_t>(key >> 32u);
+
+			if(index >= layers.size()) { continue; }
+
+			const auto& before = _before.at(key);
+			const auto& after = layers[index].SharedChunk(static_cast<uint32_t>(key & 0xFFFFu), static_cast<uint32_t>((key >> 16u) & 0xFFFFu));
+
+			// Every write copies a chunk the journal holds, so an untouched chunk is still the same one.
+			if(before == after) { continue; }
+
+			const auto old = before ? std::span<const TileId>{ before.get(), ChunkArea } : std::span<const TileId>{ Blank };
+			const auto now = after ? std::span<const TileId>{ after.get(), ChunkArea } : std::span<const TileId>{ Blank };
+
+			runs.clear();
+
+			const auto count = put_cell_delta(runs, old, now);
+			if(count == 0uz) { continue; }
+
+			put_varint(out, key);
+			put_varint(out, count);
+			out.insert(out.end(), runs.begin(), runs.end());
+		}
+
+		return out;
+	}
+
+	void Journal::Commit()
+	{
+		if(!_open) { return; }
+
+		_open = false;
+
+		auto data = Encode();
+
+		if(_merging)
+		{
+			auto& top = _entries.back();
+			_memoryBytes -= top.data.size();
+
+			// The stroke so far put everything back the way it was.
+			if(data.empty())
+			{
+				_entries.pop_back();
+				--_position;
+				StopCoalescing();
+				return;
+			}
+
+			top.data = std::move(data);
+			_memoryBytes += top.data.size();
+		}
+		else
+		{
+			if(data.empty()) { StopCoalescing(); return; }
+
+			Truncate(_position);
+
+			_memoryBytes += data.size();
+			_entries.push_back(Entry{ .label = _label, .data = std::move(data), .offset = 0u, .stored = 0u, .size = 0u, .spilled = false });
+			++_position;
+		}
+
+		_coalesce = true;
+		_lastCommit = std::chrono::steady_clock::now();
+
+		EnforceBudget();
+	}
+
+	void Journal::Cancel()
+	{
+		if(!_open) { return; }
+
+		_open = false;
+
+		for(auto& [key, chunk] : _before)
+		{
+			auto& layer = _map->Layers()[static_cast<size_t>(key >> 32u)];
+			layer.AdoptChunk(static_cast<uint32_t>(key & 0xFFFFu), static_cast<uint32_t>((key >> 16u) & 0xFFFFu), chunk);
+		}
+
+		// The chunks went back to before the whole stroke, the part that was already committed comes back on top.
+		if(_merging && !Apply(*_map, _entries.back(), true))
+		{
+#ifdef _DEBUG_
+			std::puts("[Journal]: could not restore the stroke before the cancelled edit.");
+#endif // _DEBUG_
+		}
+
+		StopCoalescing();
+	}
+
+	bool Journal::Undo(TileMap& map)
+	{
+		Commit();
+		StopCoalescing();
+
+		if(!CanUndo() || !Apply(map, _entries[_position - 1uz], false)) { return false; }
+
+		--_position;
+		return true;
+	}
+
+	bool Journal::Redo(TileMap& map)
+	{
+		Commit();
+		StopCoalescing();
+
+		if(!CanRedo() || !Apply(map, _entries[_position], true)) { return false; }
+
+		++_position;
+		return true;
+	}
+
+	bool Journal::Apply(TileMap& map, const Entry& entry, bool redo)
+	{
+		auto loaded = std::vector<uint8_t>{};
+
+		if(entry.spilled)
+		{
+			auto stored = std::vector<uint8_t>(entry.stored);
+			loaded.resize(entry.size);
+
+			_spill.seekg(static_cast<std::streamoff>(entry.offset));
+			_spill.read(reinterpret_cast<char*>(stored.data()), static_cast<std::streamsize>(stored.size())); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+
+			auto size = static_cast<uLongf>(loaded.size());
+
+			if(!_spill || uncompress(loaded.data(), &size, stored.data(), static_cast<uLong>(stored.size())) != Z_OK || size != loaded.size())
+			{
+				_spill.clear();
+#ifdef _DEBUG_
+				std::printf("[Journal]: could not read '%s' back from the spill file.\n", entry.label.c_str()); // NOLINT(cppcoreguidelines-pro-type-vararg)
+#endif // _DEBUG_
+				return false;
+			}
+		}
+
+		auto reader = varint_reader{ entry.spilled ? std::span<const uint8_t>{ loaded } : std::span<const uint8_t>{ entry.data } };
+		auto& layers = map.Layers();
+
+		while(!reader.done())
+		{
+			const auto key = reader.next();
+			const auto runs = reader.next();
+
+			const auto index = static_cast<size_t>(key >> 32u);
+			const auto cx = static_cast<uint32_t>(key & 0xFFFFu), cy = static_cast<uint32_t>((key >> 16u) & 0xFFFFu);
+
+			if(index >= layers.size() || cx >= layers[index].ChunksX() || cy >= layers[index].ChunksY()) { return false; }
+
+			if(!apply_cell_delta(reader, runs, layers[index].WritableChunk(cx, cy), redo)) { return false; }
+		}
+
+		return !reader.failed();
+	}
+
+	void Journal::Truncate(size_t count)
+	{
+		for(auto i = count; i < _entries.size(); ++i)
+		{
+			const auto& entry = _entries[i];
+
+			// Spilled entries are appended in order, so the first one dropped is where the file ends now.
+			if(entry.spilled) { _spillEnd = std::min(_spillEnd, entry.offset); }
+			else { _memoryBytes -= entry.data.size(); }
+		}
+
+		_entries.resize(std::min(count, _entries.size()));
+		_position = std::min(_position, _entries.size());
+	}
+
+	void Journal::Spill(Entry& entry)
+	{
+		if(!_spill.is_open())
+		{
+			auto error = std::error_code{};
+			std::filesystem::create_directories(_spillFile.parent_path(), error);
+
+			_spill.open(_spillFile, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+			_spillEnd = 0u;
+
+			if(!_spill.is_open())
+			{
+#ifdef _DEBUG_
+				std::printf("[Journal]: could not open %s, old history is dropped instead.\n", _spillFile.string().c_str()); // NOLINT(cppcoreguidelines-pro-type-vararg)
+#endif // _DEBUG_
+				_spillFile.clear();
+				return;
+			}
+		}
+
+		auto stored = std::vector<uint8_t>(compressBound(static_cast<uLong>(entry.data.size())));
+		auto size = static_cast<uLongf>(stored.size());
+
+		if(compress2(stored.data(), &size, entry.data.data(), static_cast<uLong>(entry.data.size()), Z_BEST_SPEED) != Z_OK) { return; }
+
+		_spill.seekp(static_cast<std::streamoff>(_spillEnd));
+		_spill.write(reinterpret_cast<const char*>(stored.data()), static_cast<std::streamsize>(size)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+
+		if(!_spill.flush())
+		{
+			_spill.clear();
+			return;
+		}
+
+		_memoryBytes -= entry.data.size();
+
+		entry.offset = _spillEnd;
+		entry.stored = static_cast<uint32_t>(size);
+		entry.size = static_cast<uint32_t>(entry.data.size());
+		entry.spilled = true;
+		entry.data = {};
+
+		_spillEnd += size;
+	}
+
+	void Journal::EnforceBudget()
+	{
+		// Spilled entries are always the oldest ones, the rest stay in memory in order.
+		auto resident = static_cast<size_t>(std::ranges::find_if(_entries, [](const Entry& entry) { return !entry.spilled; }) - _entries.begin());
+
+		while(_memoryBytes > _budget && resident < _entries.size())
+		{
+			if(!_spillFile.empty()) { Spill(_entries[resident]); }
+
+			if(!_entries[resident].spilled)
+			{
+				/*
+					No spill file, or it failed. Undo has to step through every entry in order, so the spilled ones
+					older than this one go with it, or undoing past the gap would leave its cells behind.
+				*/
+				const auto dropped = resident + 1uz;
+
+				_memoryBytes -= _entries[resident].data.size();
+				_entries.erase(_entries.begin(), _entries.begin() + static_cast<std::ptrdiff_t>(dropped));
+				_position -= std::min(_position, dropped);
+				resident = 0uz;
+
+				// Nothing left is in the spill file, the next spill starts it over.
+				_spillEnd = 0u;
+			}
+			else
+			{
+				++resident;
+			}
+
+			// The entry a following edit would merge into is gone from memory.
+			if(resident == _entries.size()) { StopCoalescing(); }
+		}
+	}
+
+	void Journal::StopCoalescing()
+	{
+		_before.clear();
+		_coalesce = false;
+		_merging = false;
+	}
+
+	void Journal::Clear()
+	{
+		StopCoalescing();
+
+		_open = false;
+		_map = nullptr;
+		_entries.clear();
+		_position = 0uz;
+		_memoryBytes = 0uz;
+
+		if(_spill.is_open())
+		{
+			_spill.close();
+
+			auto error = std::error_code{};
+			std::filesystem::remove(_spillFile, error);
+		}
+
+		_spillEnd = 0u;
+	}
+
+	Journal::Stats Journal::GetStats() const
+	{
+		auto stats = Stats{};
+		stats.entries = _entries.size();
+		stats.undoable = _position;
+		stats.memoryBytes = _memoryBytes;
+
+		for(const auto& entry : _entries)
+		{
+			if(!entry.spilled) { continue; }
+
+			++stats.spilledEntries;
+			stats.spilledBytes += entry.stored;
+		}
+
+		return stats;
+	}
+}
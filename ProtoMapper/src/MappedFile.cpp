@@ -0,0 +1,142 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <MappedFile.hpp>
+
+#include <utility>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace proto
+{
+	MappedFile::MappedFile(const std::filesystem::path& filename, Access access)
+	{
+		static_cast<void>(Open(filename, access));
+	}
+
+	MappedFile::MappedFile(MappedFile&& other) noexcept
+		: _data(std::exchange(other._data, nullptr)), _size(std::exchange(other._size, 0uz)), _writable(std::exchange(other._writable, false))
+#ifdef _WIN32
+		, _file(std::exchange(other._file, nullptr)), _mapping(std::exchange(other._mapping, nullptr))
+#endif
+	{
+	}
+
+	MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+	{
+		if(this == &other) { return *this; }
+
+		Close();
+		_data = std::exchange(other._data, nullptr);
+		_size = std::exchange(other._size, 0uz);
+		_writable = std::exchange(other._writable, false);
+#ifdef _WIN32
+		_file = std::exchange(other._file, nullptr);
+		_mapping = std::exchange(other._mapping, nullptr);
+#endif
+		return *this;
+	}
+
+	MappedFile::~MappedFile() { Close(); }
+
+#ifdef _WIN32
+	bool MappedFile::Open(const std::filesystem::path& filename, Access access)
+	{
+		Close();
+
+		const auto copyOnWrite = (access == Access::CopyOnWrite);
+
+		// Like a POSIX mapping, this must not stop others from appending to the file or renaming over it.
+		_file = CreateFileW(filename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if(_file == INVALID_HANDLE_VALUE) { _file = nullptr; return false; }
+
+		LARGE_INTEGER size{};
+		if(GetFileSizeEx(_file, &size) == 0 || size.QuadPart == 0) { Close(); return false; }
+
+		_mapping = CreateFileMappingW(_file, nullptr, copyOnWrite ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, nullptr);
+		if(_mapping == nullptr) { Close(); return false; }
+
+		_data = static_cast<std::byte*>(MapViewOfFile(_mapping, copyOnWrite ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0));
+		if(_data == nullptr) { Close(); return false; }
+
+		_size = static_cast<size_t>(size.QuadPart);
+		_writable = copyOnWrite;
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if(_data != nullptr) { UnmapViewOfFile(_data); }
+		if(_mapping != nullptr) { CloseHandle(_mapping); }
+		if(_file != nullptr) { CloseHandle(_file); }
+
+		_data = nullptr;
+		_mapping = _file = nullptr;
+		_size = 0uz;
+		_writable = false;
+	}
+#else
+	bool MappedFile::Open(const std::filesystem::path& filename, Access access)
+	{
+		Close();
+
+		const auto copyOnWrite = (access == Access::CopyOnWrite);
+		const int fd = open(filename.c_str(), O_RDONLY | O_CLOEXEC); // NOLINT(cppcoreguidelines-pro-type-vararg)
+		if(fd < 0) { return false; }
+
+		struct stat info{};
+
+		if(fstat(fd, &info) != 0 || info.st_size <= 0)
+		{
+			close(fd);
+			return false;
+		}
+
+		// MAP_PRIVATE already gives copy-on-write semantics, the write permission is all that changes.
+		void* ptr = mmap(nullptr, static_cast<size_t>(info.st_size), copyOnWrite ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_PRIVATE, fd, 0);
+
+		// The mapping keeps its own reference to the file.
+		close(fd);
+
+		if(ptr == MAP_FAILED) { return false; } // NOLINT(cppcoreguidelines-pro-type-cstyle-cast, performance-no-int-to-ptr)
+
+		_data = static_cast<std::byte*>(ptr);
+		_size = static_cast<size_t>(info.st_size);
+		_writable = copyOnWrite;
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if(_data != nullptr)
+		{
+			munmap(_data, _size);
+		}
+
+		_data = nullptr;
+		_size = 0uz;
+		_writable = false;
+	}
+#endif
+}
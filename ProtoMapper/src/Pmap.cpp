@@ -0,0 +1,583 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <Pmap.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include <zlib.h>
+
+#include <MappedFile.hpp>
+#include <Stopwatch.hpp>
+#include <stl/parallel.hpp>
+
+namespace proto
+{
+	namespace
+	{
+		constexpr uint32_t PmapMagic = 0x50414D50u; // "PMAP"
+		constexpr uint32_t PmapVersion = 1u;
+		constexpr uint64_t PageSize = 4096u;
+		constexpr size_t ChunkBytes = TileLayer::ChunkArea * sizeof(TileId);
+
+		// Chunks are compressed and checksummed on the thread pool this many at a time, which bounds the memory
+		// held for compressed payloads.
+		constexpr size_t SaveBatch = 1024uz;
+
+		// Which components follow an object's Transform.
+		constexpr uint8_t HasMarker = 1u << 0u;
+		constexpr uint8_t HasSpawn = 1u << 1u;
+		constexpr uint8_t HasTrigger = 1u << 2u;
+		constexpr uint8_t HasAgent = 1u << 3u;
+
+		/*
+			File layout: the header, alone in the first page, then the chunk payloads, then the metadata (map size,
+			layers, tilesets and objects), then the directory. Both checksums cover what they name, so a header that
+			points at a torn directory is caught before any chunk is used.
+		*/
+		struct Header
+		{
+			uint32_t magic = PmapMagic, version = PmapVersion;
+			uint64_t metaOffset = 0u, metaSize = 0u;
+			uint64_t directoryOffset = 0u, directoryCount = 0u;
+			uint32_t metaChecksum = 0u, directoryChecksum = 0u;
+		};
+
+		struct DirectoryEntry
+		{
+			uint64_t offset = 0u;
+			uint32_t layer = 0u, chunk = 0u; // The chunk's index in its layer, in row order.
+			uint32_t size = 0u, checksum = 0u;
+			uint32_t compression = 0u, reserved = 0u;
+		};
+
+		[[nodiscard]] constexpr uint64_t AlignUp(uint64_t value, uint64_t alignment) { return (value + alignment - 1u) / alignment * alignment; }
+
+		[[nodiscard]] uint32_t Checksum(std::span<const std::byte> bytes)
+		{
+			return static_cast<uint32_t>(crc32_z(0u, reinterpret_cast<const Bytef*>(bytes.data()), bytes.size())); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+		}
+
+		class Writer
+		{
+		public:
+			template <typename T>
+				requires std::is_trivially_copyable_v<T>
+			void Put(const T& value)
+			{
+				const auto bytes = std::as_bytes(std::span{ &value, 1uz });
+				_bytes.insert(_bytes.end(), bytes.begin(), bytes.end());
+			}
+
+			void PutString(std::string_view text)
+			{
+				Put(static_cast<uint32_t>(text.size()));
+				const auto bytes = std::as_bytes(std::span{ text });
+				_bytes.insert(_bytes.end(), bytes.begin(), bytes.end());
+			}
+
+			[[nodiscard]] std::span<const std::byte> Bytes() const { return _bytes; }
+
+		private:
+			std::vector<std::byte> _bytes;
+		};
+
+		// Reads what Writer wrote. Reading past the end yields zeros and marks the reader failed.
+		class Reader
+		{
+		public:
+			explicit Reader(std::span<const std::byte> bytes)
+			: _bytes(bytes)
+			{
+			}
+
+			template <typename T>
+				requires std::is_trivially_copyable_v<T>
+			[[nodiscard]] T Get()
+			{
+				auto value = T{};
+				if(sizeof(T) > _bytes.size() - _pos) { _ok = false; return value; }
+
+				std::memcpy(&value, _bytes.subspan(_pos).data(), sizeof(T));
+				_pos += sizeof(T);
+				return value;
+			}
+
+			[[nodiscard]] std::string GetString()
+			{
+				const auto size = Get<uint32_t>();
+				if(size > _bytes.size() - _pos) { _ok = false; return {}; }
+
+				auto text = std::string(size, '\0');
+				std::memcpy(text.data(), _bytes.subspan(_pos).data(), size);
+				_pos += size;
+				return text;
+			}
+
+			[[nodiscard]] bool Ok() const { return _ok; }
+
+		private:
+			std::span<const std::byte> _bytes;
+			size_t _pos = 0uz;
+			bool _ok = true;
+		};
+
+		[[nodiscard]] Writer WriteMeta(const TileMap& map, std::span<const MapObject> objects)
+		{
+			auto out = Writer{};
+			out.Put(map.Width());
+			out.Put(map.Height());
+			out.Put(map.TileWidth());
+			out.Put(map.TileHeight());
+
+			out.Put(static_cast<uint32_t>(map.Layers().size()));
+
+			for(const auto& layer : map.Layers())
+			{
+				out.PutString(layer.Name());
+				out.Put(static_cast<uint8_t>(layer.visible));
+				out.Put(layer.opacity);
+			}
+
+			out.Put(static_cast<uint32_t>(map.Tilesets().size()));
+
+			for(const auto& tileset : map.Tilesets())
+			{
+				out.Put(tileset.firstGid);
+				out.PutString(tileset.name);
+				out.PutString(tileset.source.generic_string());
+				out.PutString(tileset.image.generic_string());
+
+				for(const auto value : { tileset.imageWidth, tileset.imageHeight, tileset.tileWidth, tileset.tileHeight, tileset.tileCount, tileset.columns, tileset.spacing, tileset.margin })
+				{
+					out.Put(value);
+				}
+			}
+
+			out.Put(static_cast<uint32_t>(objects.size()));
+
+			for(const auto& object : objects)
+			{
+				const auto flags = (object.marker ? HasMarker : 0u) | (object.spawn ? HasSpawn : 0u) | (object.trigger ? HasTrigger : 0u) | (object.agent ? HasAgent : 0u);
+				out.Put(static_cast<uint8_t>(flags));
+				out.Put(object.transform.pos.x);
+				out.Put(object.transform.pos.y);
+				out.Put(object.transform.rotation);
+
+				if(object.marker) { out.PutString(object.marker->label); }
+
+				if(object.spawn)
+				{
+					out.Put(object.spawn->group);
+					out.Put(object.spawn->capacity);
+				}
+
+				if(object.trigger)
+				{
+					out.Put(object.trigger->halfExtent.x);
+					out.Put(object.trigger->halfExtent.y);
+					out.Put(object.trigger->id);
+				}
+
+				if(object.agent)
+				{
+					for(const auto value : { object.agent->velocity.x, object.agent->velocity.y, object.agent->goal.x, object.agent->goal.y, object.agent->speed }) { out.Put(value); }
+				}
+			}
+
+			return out;
+		}
+
+		[[nodiscard]] bool ReadMeta(std::span<const std::byte> bytes, TileMap& map, std::vector<MapObject>& objects)
+		{
+			auto in = Reader{ bytes };
+
+			const auto width = in.Get<uint32_t>(), height = in.Get<uint32_t>();
+			const auto tileWidth = in.Get<uint32_t>(), tileHeight = in.Get<uint32_t>();
+			if(!in.Ok() || width == 0u || height == 0u || width > TileMap::MaxExtent || height > TileMap::MaxExtent) { return false; }
+
+			map.Reset(width, height, tileWidth, tileHeight);
+
+			for(auto layers = in.Get<uint32_t>(); in.Ok() && layers > 0u; --layers)
+			{
+				auto& layer = map.AddLayer(in.GetString());
+				layer.visible = in.Get<uint8_t>() != 0u;
+				layer.opacity = in.Get<float>();
+			}
+
+			for(auto tilesets = in.Get<uint32_t>(); in.Ok() && tilesets > 0u; --tilesets)
+			{
+				auto& tileset = map.Tilesets().emplace_back();
+				tileset.firstGid = in.Get<TileId>();
+				tileset.name = in.GetString();
+				tileset.source = in.GetString();
+				tileset.image = in.GetString();
+
+				for(auto* value : { &tileset.imageWidth, &tileset.imageHeight, &tileset.tileWidth, &tileset.tileHeight, &tileset.tileCount, &tileset.columns, &tileset.spacing, &tileset.margin })
+				{
+					*value = in.Get<uint32_t>();
+				}
+			}
+
+			for(auto count = in.Get<uint32_t>(); in.Ok() && count > 0u; --count)
+			{
+				auto& object = objects.emplace_back();
+				const auto flags = in.Get<uint8_t>();
+				object.transform.pos = glm::vec2{ in.Get<float>(), in.Get<float>() };
+				object.transform.rotation = in.Get<float>();
+
+				if((flags & HasMarker) != 0u) { object.marker = Marker{ in.GetString() }; }
+				if((flags & HasSpawn) != 0u) { object.spawn = SpawnPoint{ .group = in.Get<uint32_t>(), .capacity = in.Get<uint32_t>() }; }
+				if((flags & HasTrigger) != 0u) { object.trigger = Trigger{ .halfExtent = glm::vec2{ in.Get<float>(), in.Get<float>() }, .id = in.Get<uint32_t>() }; }
+
+				if((flags & HasAgent) != 0u)
+				{
+					auto& agent = object.agent.emplace();
+					for(auto* value : { &agent.velocity.x, &agent.velocity.y, &agent.goal.x, &agent.goal.y, &agent.speed }) { *value = in.Get<float>(); }
+				}
+			}
+
+			return in.Ok();
+		}
+
+		struct Payload
+		{
+			TileLayer::ChunkPtr chunk;
+			uint32_t layer = 0u, index = 0u;
+			std::vector<Bytef> compressed; // Empty when the chunk is stored as is.
+			uint32_t checksum = 0u;
+		};
+
+		void Prepare(Payload& payload, PmapFile::Compression compression)
+		{
+			const auto raw = std::as_bytes(std::span{ payload.chunk.get(), TileLayer::ChunkArea });
+
+			if(compression == PmapFile::Compression::Zlib)
+			{
+				auto size = compressBound(static_cast<uLong>(raw.size()));
+				payload.compressed.resize(size);
+
+				const auto result = compress2(payload.compressed.data(), &size, reinterpret_cast<const Bytef*>(raw.data()), static_cast<uLong>(raw.size()), Z_BEST_SPEED); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+
+				// Only worth giving up the mapping for when it at least halves the chunk.
+				if(result == Z_OK && size <= raw.size() / 2uz) { payload.compressed.resize(size); }
+				else { payload.compressed.clear(); }
+			}
+
+			payload.checksum = payload.compressed.empty() ? Checksum(raw) : Checksum(std::as_bytes(std::span{ payload.compressed }));
+		}
+
+		[[maybe_unused]] [[nodiscard]] double Milliseconds(std::chrono::microseconds time) { return static_cast<double>(time.count()) / 1000.0; }
+	}
+
+	std::vector<MapObject> CaptureObjects(Registry& registry)
+	{
+		auto objects = std::vector<MapObject>{};
+
+		registry.ViewOf<Transform>().Each([&](Entity e, const Transform& transform) {
+			auto& object = objects.emplace_back();
+			object.transform = transform;
+
+			if(const auto* marker = registry.TryGet<Marker>(e)) { object.marker = *marker; }
+			if(const auto* spawn = registry.TryGet<SpawnPoint>(e)) { object.spawn = *spawn; }
+			if(const auto* trigger = registry.TryGet<Trigger>(e)) { object.trigger = *trigger; }
+			if(const auto* agent = registry.TryGet<Agent>(e)) { object.agent = *agent; }
+		});
+
+		return objects;
+	}
+
+	void RestoreObjects(std::span<const MapObject> objects, Registry& registry)
+	{
+		registry.Clear();
+
+		for(const auto& object : objects)
+		{
+			const auto e = registry.Create();
+			registry.Emplace<Transform>(e, object.transform);
+
+			if(object.marker) { registry.Emplace<Marker>(e, *object.marker); }
+			if(object.spawn) { registry.Emplace<SpawnPoint>(e, *object.spawn); }
+			if(object.trigger) { registry.Emplace<Trigger>(e, *object.trigger); }
+			if(object.agent) { registry.Emplace<Agent>(e, *object.agent); }
+		}
+	}
+
+	bool PmapFile::Load(const std::filesystem::path& file, TileMap& map, Registry& registry, bool verify)
+	{
+		[[maybe_unused]] const auto timer = Stopwatch{};
+
+		// Copy-on-write, so the chunks can never write through to the file even when nothing else shares them.
+		auto mapping = std::make_shared<MappedFile>(file, MappedFile::Access::CopyOnWrite);
+		const auto bytes = mapping->WritableBytes();
+		const auto size = uint64_t{bytes.size()};
+
+		const auto fail = [&]([[maybe_unused]] const char* reason) {
+#ifdef _DEBUG_
+			std::printf("[Pmap]: could not load %s, %s.\n", file.string().c_str(), reason); // NOLINT(cppcoreguidelines-pro-type-vararg)
+#endif // _DEBUG_
+			return false;
+		};
+
+		if(bytes.size() < sizeof(Header)) { return fail("the file is missing or too small"); }
+
+		auto header = Header{};
+		std::memcpy(&header, bytes.data(), sizeof(Header));
+
+		if(header.magic != PmapMagic || header.version != PmapVersion) { return fail("it is not a map of this version"); }
+		if(header.metaOffset > size || header.metaSize > size - header.metaOffset) { return fail("the metadata is out of bounds"); }
+		if(header.directoryOffset > size || header.directoryCount > (size - header.directoryOffset) / sizeof(DirectoryEntry)) { return fail("the directory is out of bounds"); }
+
+		const auto meta = bytes.subspan(header.metaOffset, header.metaSize);
+		const auto directoryBytes = bytes.subspan(header.directoryOffset, header.directoryCount * sizeof(DirectoryEntry));
+
+		if(Checksum(meta) != header.metaChecksum || Checksum(directoryBytes) != header.directoryChecksum) { return fail("the metadata or directory is corrupt"); }
+
+		auto loaded = TileMap{};
+		auto objects = std::vector<MapObject>{};
+		if(!ReadMeta(meta, loaded, objects)) { return fail("the metadata is corrupt"); }
+
+		auto directory = std::vector<DirectoryEntry>(header.directoryCount);
+		std::memcpy(directory.data(), directoryBytes.data(), directoryBytes.size());
+
+		auto chunks = std::vector<TileLayer::ChunkPtr>(directory.size());
+		auto valid = std::vector<uint8_t>(directory.size(), 0u);
+
+		parallel_for(directory.size(), [&](size_t first, size_t last) {
+			for(auto i = first; i < last; ++i)
+			{
+				const auto& entry = directory[i];
+				if(entry.layer >= loaded.Layers().size() || entry.offset > size || entry.size > size - entry.offset) { continue; }
+
+				const auto& layer = loaded.Layers()[entry.layer];
+				if(entry.chunk >= layer.ChunksX() * layer.ChunksY()) { continue; }
+
+				const auto payload = bytes.subspan(entry.offset, entry.size);
+
+				if(entry.compression == static_cast<uint32_t>(Compression::None))
+				{
+					if(entry.size != ChunkBytes || entry.offset % PageSize != 0u) { continue; }
+					if(verify && Checksum(payload) != entry.checksum) { continue; }
+
+					chunks[i] = TileLayer::ChunkPtr{ mapping, reinterpret_cast<TileId*>(payload.data()) }; // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+				}
+				else if(entry.compression == static_cast<uint32_t>(Compression::Zlib))
+				{
+					if(Checksum(payload) != entry.checksum) { continue; }
+
+					auto chunk = std::make_shared_for_overwrite<TileId[]>(TileLayer::ChunkArea);
+					auto length = static_cast<uLongf>(ChunkBytes);
+
+					if(uncompress(reinterpret_cast<Bytef*>(chunk.get()), &length, reinterpret_cast<const Bytef*>(payload.data()), entry.size) != Z_OK || length != ChunkBytes) { continue; } // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+
+					chunks[i] = std::move(chunk);
+				}
+
+				valid[i] = 1u;
+			}
+		}, 64uz);
+
+		if(!std::ranges::all_of(valid, [](uint8_t ok) { return ok != 0u; })) { return fail("a chunk is corrupt"); }
+
+		auto stored = flat_hash_map<const TileId*, Stored>{ directory.size() };
+		auto live = uint64_t{0u};
+		[[maybe_unused]] auto mapped = 0uz;
+
+		for(auto i = 0uz; i < directory.size(); ++i)
+		{
+			const auto& entry = directory[i];
+			auto& layer = loaded.Layers()[entry.layer];
+
+			layer.AdoptChunk(entry.chunk % layer.ChunksX(), entry.chunk / layer.ChunksX(), chunks[i]);
+			stored.insert_or_assign(chunks[i].get(), Stored{ .offset = entry.offset, .size = entry.size, .checksum = entry.checksum, .compression = static_cast<Compression>(entry.compression) });
+
+			live += entry.size;
+			mapped += entry.compression == static_cast<uint32_t>(Compression::None) ? 1uz : 0uz;
+		}
+
+		map = std::move(loaded);
+		RestoreObjects(objects, registry);
+
+		_path = file;
+		_stored = std::move(stored);
+		_held = std::move(chunks);
+		_fileSize = size;
+		_liveBytes = live;
+
+#ifdef _DEBUG_
+		std::printf("[Pmap]: loaded %s in %.2f ms, %zu chunks mapped, %zu inflated\n", file.filename().string().c_str(), timer.Milliseconds(), mapped, directory.size() - mapped); // NOLINT(cppcoreguidelines-pro-type-vararg)
+#endif // _DEBUG_
+		return true;
+	}
+
+	bool PmapFile::Save(const std::filesystem::path& file, const TileMap& map, std::span<const MapObject> objects)
+	{
+		auto error = std::error_code{};
+
+		// Appending needs the file this object last loaded or saved, still as it left it.
+		const auto sameFile = !_path.empty() && std::filesystem::equivalent(file, _path, error) && std::filesystem::file_size(file, error) == _fileSize;
+		const auto compact = _fileSize > (2u * _liveBytes) + (16u * PageSize);
+
+		if(sameFile && !compact && Write(file, map, objects, true)) { return true; }
+		if(Write(file, map, objects, false)) { return true; }
+
+		// Windows refuses to replace a file while a view of it is mapped, so compacting the loaded file waits until it is not.
+		return sameFile && compact && Write(file, map, objects, true);
+	}
+
+	bool PmapFile::Write(const std::filesystem::path& file, const TileMap& map, std::span<const MapObject> objects, bool append)
+	{
+		const auto timer = Stopwatch{};
+
+		auto target = file;
+		if(!append) { target += ".tmp"; }
+
+		auto out = std::fstream{ target, append ? (std::ios::in | std::ios::out | std::ios::binary) : (std::ios::out | std::ios::binary | std::ios::trunc) };
+		if(!out) { return false; }
+
+		static constexpr auto Zeros = std::array<char, PageSize>{};
+
+		// The header has the first page to itself, and is written last.
+		auto offset = append ? _fileSize : PageSize;
+		if(append) { out.seekp(static_cast<std::streamoff>(offset)); }
+		else { out.write(Zeros.data(), static_cast<std::streamsize>(PageSize)); }
+
+		auto stats = Stats{};
+		stats.rewritten = !append;
+		auto directory = std::vector<DirectoryEntry>{};
+		auto stored = flat_hash_map<const TileId*, Stored>{};
+		auto held = std::vector<TileLayer::ChunkPtr>{};
+		auto live = uint64_t{0u};
+
+		const auto record = [&](const TileLayer::ChunkPtr& chunk, uint32_t layer, uint32_t index, const Stored& where) {
+			directory.push_back(DirectoryEntry{ .offset = where.offset, .layer = layer, .chunk = index, .size = where.size, .checksum = where.checksum, .compression = static_cast<uint32_t>(where.compression), .reserved = 0u });
+			stored.insert_or_assign(chunk.get(), where);
+			held.push_back(chunk);
+			live += where.size;
+		};
+
+		// Chunks this file already holds keep their payload, the rest are written in batches.
+		auto dirty = std::vector<Payload>{};
+
+		const auto flush = [&]() {
+			parallel_for(dirty.size(), [&](size_t first, size_t last) {
+				for(auto& payload : std::span{ dirty }.subspan(first, last - first)) { Prepare(payload, _compression); }
+			}, 16uz);
+
+			for(const auto& payload : dirty)
+			{
+				const auto raw = payload.compressed.empty();
+				const auto bytes = raw ? std::as_bytes(std::span{ payload.chunk.get(), TileLayer::ChunkArea }) : std::as_bytes(std::span{ payload.compressed });
+
+				// Stored chunks must start on a page so they map as tile arrays.
+				const auto start = raw ? AlignUp(offset, PageSize) : offset;
+				out.write(Zeros.data(), static_cast<std::streamsize>(start - offset));
+				out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size())); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+
+				offset = start + bytes.size();
+				stats.bytesWritten += bytes.size();
+				++stats.chunksWritten;
+
+				record(payload.chunk, payload.layer, payload.index, Stored{ .offset = start, .size = static_cast<uint32_t>(bytes.size()), .checksum = payload.checksum, .compression = raw ? Compression::None : Compression::Zlib });
+			}
+
+			dirty.clear();
+		};
+
+		for(auto li = 0u; li < map.Layers().size(); ++li)
+		{
+			const auto& layer = map.Layers()[li];
+
+			for(auto index = 0u; index < layer.ChunksX() * layer.ChunksY(); ++index)
+			{
+				const auto& chunk = layer.SharedChunk(index % layer.ChunksX(), index / layer.ChunksX());
+				if(!chunk) { continue; }
+
+				if(const auto existing = _stored.find(chunk.get()); append && existing != _stored.end())
+				{
+					record(chunk, li, index, existing->second);
+					++stats.chunksReused;
+					continue;
+				}
+
+				dirty.push_back(Payload{ .chunk = chunk, .layer = li, .index = index, .compressed = {}, .checksum = 0u });
+				if(dirty.size() == SaveBatch) { flush(); }
+			}
+		}
+
+		flush();
+
+		const auto meta = WriteMeta(map, objects);
+		const auto directoryBytes = std::as_bytes(std::span{ directory });
+
+		auto header = Header{};
+		header.metaOffset = offset;
+		header.metaSize = meta.Bytes().size();
+		header.metaChecksum = Checksum(meta.Bytes());
+		header.directoryOffset = AlignUp(offset + header.metaSize, alignof(DirectoryEntry));
+		header.directoryCount = directory.size();
+		header.directoryChecksum = Checksum(directoryBytes);
+
+		out.write(reinterpret_cast<const char*>(meta.Bytes().data()), static_cast<std::streamsize>(meta.Bytes().size())); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+		out.write(Zeros.data(), static_cast<std::streamsize>(header.directoryOffset - (offset + header.metaSize)));
+		out.write(reinterpret_cast<const char*>(directoryBytes.data()), static_cast<std::streamsize>(directoryBytes.size())); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+
+		const auto end = header.directoryOffset + directoryBytes.size();
+
+		// Everything the header points at has to be in the file before the header is.
+		out.flush();
+		out.seekp(0);
+		out.write(reinterpret_cast<const char*>(&header), sizeof(Header)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+		out.close();
+
+		auto error = std::error_code{};
+
+		if(!append && !out.fail()) { std::filesystem::rename(target, file, error); }
+
+		if(out.fail() || error)
+		{
+			if(!append) { std::filesystem::remove(target, error); }
+#ifdef _DEBUG_
+			std::printf("[Pmap]: could not save %s.\n", file.string().c_str()); // NOLINT(cppcoreguidelines-pro-type-vararg)
+#endif // _DEBUG_
+			return false;
+		}
+
+		_path = file;
+		_stored = std::move(stored);
+		_held = std::move(held);
+		_fileSize = end;
+		_liveBytes = live;
+
+		stats.time = timer.Elapsed();
+		_lastSave = stats;
+
+#ifdef _DEBUG_
+		std::printf("[Pmap]: saved %s in %.2f ms, %zu chunks written (%.1f MiB), %zu reused%s\n", file.filename().string().c_str(), Milliseconds(stats.time), // NOLINT(cppcoreguidelines-pro-type-vararg)
+			stats.chunksWritten, static_cast<double>(stats.bytesWritten) / (1024.0 * 1024.0), stats.chunksReused, stats.rewritten ? ", rewritten" : "");
+#endif // _DEBUG_
+
+		return true;
+	}
+}
@@ -18,7 +18,10 @@
 #include <ProtoMapper.hpp>
 #include <Config.hpp>
 #include <GLFW/glfw3.h>
+#include <algorithm>
+#include <cstdio>
 #include <cstdlib>
+#include <stdexcept>
 #include <sol/stack_core.hpp>
 
 namespace proto 
@@ -34,6 +37,18 @@ namespace proto
 		{
 			nk_input_key(self->UI()->Context(), (nk_keys)key, nk_bool(action == GLFW_PRESS || action == GLFW_REPEAT));
 		}
+
+		/*
+			Ctrl+Z undoes the last map edit, Ctrl+Y or Ctrl+Shift+Z redoes it. Held keys repeat. A widget that is
+			being used, such as a text field, keeps the keys to itself.
+		*/
+		const auto ctrl = (mods & GLFW_MOD_CONTROL) == GLFW_MOD_CONTROL, shift = (mods & GLFW_MOD_SHIFT) == GLFW_MOD_SHIFT;
+
+		if (self->_scene && ctrl && action != GLFW_RELEASE && nk_item_is_any_active(self->UI()->Context()) == nk_false)
+		{
+			if (keyn == GLFW_KEY_Z && !shift) { static_cast<void>(self->_scene->Undo()); }
+			else if (keyn == GLFW_KEY_Y || (keyn == GLFW_KEY_Z && shift)) { static_cast<void>(self->_scene->Redo()); }
+		}
 	}
 
 	void Mapper::TextEventCallback([[maybe_unused]] GLFWwindow* window, [[maybe_unused]] unsigned int codepoint)
@@ -74,6 +89,14 @@ namespace proto
 	Mapper::~Mapper()
 	{
 		_configData.Reset();
+
+		// Everything holding GL objects has to go while the context still exists.
+		_autosave.reset();
+		_background.reset();
+		_scene.reset();
+		_ui.reset();
+		_renderer.reset();
+
 		glfwTerminate();
 	}
 
@@ -211,7 +234,16 @@ namespace proto
 		_renderer->SetViewport(0, 0, _window.GetWidth(), _window.GetHeight());
 		_renderer->Init(Renderer::mode::Two);
 
-		_ui = std::make_shared<UIContainer>(_fonts, _lua, _renderer.get());
+		try
+		{
+			_ui = std::make_shared<UIContainer>(_fonts, _lua, _renderer.get());
+		}
+		catch(const std::runtime_error& e)
+		{
+			std::printf("[UI]: %s\n", e.what()); // NOLINT(cppcoreguidelines-pro-type-vararg)
+			return EXIT_FAILURE;
+		}
+
 		_ui->InitLua();
 
 		if(!_ui->SetDefinitions(GetUIDir(), _lua))
@@ -227,6 +259,60 @@ namespace proto
 
 		_scene = std::make_unique<Scene>(_ui);
 
+		/*
+			Undo history past the memory budget is compressed into the cache directory, unless spilling is off.
+		*/
+
+		const auto journalBudget = std::max(_configData.GetLongValue("journal", "memory_mb", static_cast<long>(Journal::DefaultBudget >> 20uz)), 1L);
+		auto spillFile = _configData.GetBoolValue("journal", "spill", true) ? std::filesystem::path{ GetCacheDir() } / "journal.bin" : std::filesystem::path{};
+
+		_scene->GetJournal().Configure(static_cast<size_t>(journalBudget) << 20uz, std::move(spillFile));
+
+		/*
+			Terrains for auto-tiling, from every .ini and .lua file in the autotile directory.
+		*/
+
+		[[maybe_unused]] const auto terrains = _scene->GetAutoTiler().LoadDirectory(GetAutotileDir(), _lua);
+
+#ifdef _DEBUG_
+		std::printf("[AutoTiler]: Loaded %zu terrains.\n", terrains); // NOLINT(cppcoreguidelines-pro-type-vararg)
+#endif // _DEBUG_
+
+		/*
+			Scripts reach the map through the Map table, with files relative to the profile directory, and start
+			procedural layers through the Generate table.
+		*/
+
+		_scene->BindLua(_lua, GetProfileDir());
+
+		/*
+			Save the map in the background every so often, the file is relative to the profile directory.
+		*/
+
+		if (_configData.GetBoolValue("autosave", "enabled", true))
+		{
+			const auto interval = std::max(_configData.GetLongValue("autosave", "interval", static_cast<long>(Autosave::DefaultInterval.count())), 1L);
+			const auto compression = _configData.GetBoolValue("autosave", "compress", true) ? PmapFile::Compression::Zlib : PmapFile::Compression::None;
+			const auto file = std::filesystem::path{ GetProfileDir() } / _configData.GetValue("autosave", "file", "autosave.pmap");
+
+			_autosave = std::make_unique<Autosave>(file, std::chrono::seconds{ interval }, compression);
+
+			// Picks up where the last session left off.
+			if (_configData.GetBoolValue("autosave", "restore", true)) { _autosave->Restore(*_scene); }
+		}
+
+		/*
+			An optional tracing image drawn behind everything, relative to the profile directory. It is streamed in
+			tiles, so it may be far larger than one texture. There is no camera yet, so it is drawn 1:1 from its top
+			left corner.
+		*/
+
+		if (const std::string background = _configData.GetValue("background", "image", ""); !background.empty())
+		{
+			_background = std::make_unique<VirtualTexture>(_renderer->GetUploader());
+			_background->Begin(std::filesystem::path{ GetProfileDir() } / background, std::filesystem::path{ GetCacheDir() } / "background");
+		}
+
 		/*
 			Show main window and start main loop.
 
@@ -267,8 +353,21 @@ namespace proto
 
 			_scene->Update(seconds.count());
 
+			if (_autosave) { _autosave->Update(*_scene); }
+
+			if (_background)
+			{
+				const auto visible = glm::vec4{ 0.f, 0.f, static_cast<float>(_renderer->GetRenderWidth()), static_cast<float>(_renderer->GetRenderHeight()) };
+				_background->Update(visible, 1.f);
+			}
+
 			_renderer->Begin();
 
+			if (_background)
+			{
+				if (auto call = _background->Compile()) { _renderer->PushDrawCall(*call); }
+			}
+
 			_renderer->End(_scene->GetUIDrawCalls());
 
 			glfwSwapBuffers(_window.GetPtr());
@@ -281,6 +380,14 @@ namespace proto
 			nk_input_end(_ui->Context());
 		}
 
+		// One last save, so nothing edited since the previous one is lost.
+		if (_autosave)
+		{
+			_autosave->Finish();
+			_autosave->Save(*_scene);
+			_autosave->Finish();
+		}
+
 		if (_configUpdate)
 		{
 			_configData.SaveFile(_configFile.c_str());
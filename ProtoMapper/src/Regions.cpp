@@ -0,0 +1,101 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <Regions.hpp>
+
+#include <algorithm>
+
+namespace proto
+{
+	namespace
+	{
+		// Hands the layer's chunks to the stl algorithms, an unallocated chunk reads as empty.
+		[[nodiscard]] auto ChunksOf(const TileLayer& layer)
+		{
+			return [&layer](uint32_t cx, uint32_t cy) { return layer.Chunk(cx, cy); };
+		}
+	}
+
+	std::vector<TileRun> FillArea(const TileLayer& layer, uint32_t x, uint32_t y)
+	{
+		auto runs = std::vector<TileRun>{};
+
+		scanline_fill(layer.Width(), layer.Height(), TileLayer::ChunkSize, ChunksOf(layer), x, y, [&runs](uint32_t rx, uint32_t ry, uint32_t length) {
+			runs.push_back(TileRun{ rx, ry, length });
+		}, EmptyTile);
+
+		return runs;
+	}
+
+	region_labels LabelRegions(const TileLayer& layer)
+	{
+		auto labels = region_labels{};
+		labels.build(layer.Width(), layer.Height(), TileLayer::ChunkSize, ChunksOf(layer), EmptyTile);
+
+		return labels;
+	}
+
+	size_t FloodFill(Scene& scene, size_t layer, uint32_t x, uint32_t y, TileId tile)
+	{
+		const auto& target = scene.GetMap().Layers().at(layer);
+		if(x >= target.Width() || y >= target.Height() || target.Get(x, y) == tile) { return 0uz; }
+
+		return FillRuns(scene, layer, FillArea(target, x, y), tile);
+	}
+
+	size_t FillRuns(Scene& scene, size_t layer, std::span<const TileRun> runs, TileId tile)
+	{
+		// A running generator holds the journal's edit open, anything written now would undo along with it.
+		if(runs.empty() || scene.GetGenerator().Busy()) { return 0uz; }
+
+		auto& journal = scene.GetJournal();
+		const auto own = !journal.Recording();
+
+		if(own) { journal.Begin(scene.GetMap(), "Fill", false); }
+
+		auto filled = 0uz;
+
+		// Runs are split at chunk edges and written a chunk row at a time, the journal only sees whole chunks.
+		for(const auto& run : runs)
+		{
+			for(auto x = run.x, end = run.x + run.length; x < end;)
+			{
+				const auto cx = x / TileLayer::ChunkSize;
+				const auto stop = std::min(end, (cx + 1u) * TileLayer::ChunkSize);
+				const auto row = journal.WritableChunk(layer, cx, run.y / TileLayer::ChunkSize).subspan(size_t{run.y % TileLayer::ChunkSize} * TileLayer::ChunkSize);
+
+				std::fill(row.begin() + (x % TileLayer::ChunkSize), row.begin() + (x % TileLayer::ChunkSize) + (stop - x), tile);
+				filled += stop - x;
+				x = stop;
+			}
+		}
+
+		if(own) { journal.Commit(); }
+
+		return filled;
+	}
+
+	size_t FillRegion(Scene& scene, size_t layer, const region_labels& labels, region_labels::label_type label, TileId tile)
+	{
+		if(labels.get(label).value == tile) { return 0uz; }
+
+		auto runs = std::vector<TileRun>{};
+		labels.for_each_run(label, [&runs](uint32_t x, uint32_t y, uint32_t length) { runs.push_back(TileRun{ x, y, length }); });
+
+		return FillRuns(scene, layer, runs, tile);
+	}
+}
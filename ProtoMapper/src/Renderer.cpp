@@ -33,9 +33,14 @@ namespace proto
 	{
 		_defaultTexture.Create().GenerateBlank(1, 1);
 
-		const std::filesystem::path vs = dir / "assets/shaders/DefaultVS.glsl",
-			fs = dir / "assets/shaders/DefaultFS.glsl";
+		const auto shaderDir = dir / "assets/shaders";
 
+		LoadProgram(_defaultShader, shaderDir / "DefaultVS.glsl", shaderDir / "DefaultFS.glsl");
+		LoadProgram(_distanceFieldShader, shaderDir / "DefaultVS.glsl", shaderDir / "DistanceFieldFS.glsl");
+	}
+
+	bool Renderer::LoadProgram(Shader& shader, const std::filesystem::path& vs, const std::filesystem::path& fs)
+	{
 		auto streamVS = std::fstream{ vs.string().c_str(), std::ios_base::in };
 		auto streamFS = std::fstream{ fs.string().c_str(), std::ios_base::in };
 
@@ -56,10 +61,13 @@ namespace proto
 				fsSrc += line;
 			}
 
-			auto objs = _defaultShader.CreateBasic(vsSrc.c_str(), fsSrc.c_str());
-			_defaultShader.Link(objs);
+			auto objs = shader.CreateBasic(vsSrc.c_str(), fsSrc.c_str());
+			shader.Link(objs);
 
+			return true;
 		}
+
+		return false;
 	}
 
 	bool Renderer::Init(mode newMode)
@@ -67,7 +75,8 @@ namespace proto
 		SetRenderMode(newMode);
 
 		glEnable(GL_BLEND);
-		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		// Textures hold premultiplied alpha, so filtering and mip levels never bleed the colour of transparent texels.
+		glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
 		glBlendEquation(GL_FUNC_ADD);
 
 		return true;
@@ -75,6 +84,8 @@ namespace proto
 
 	void Renderer::Begin()
 	{	
+		_uploads.Process();
+
 		switch (_currentMode)
 		{
 		case Renderer::mode::Two:
@@ -98,6 +109,7 @@ namespace proto
 			auto& call = _drawQueue.front();
 
 			UseTexture(call.texture);
+			UseShader(call.shader);
 
 			Draw<uint32_t>(call.buffer, call.elemCount, call.offset, call.drawMode);
 
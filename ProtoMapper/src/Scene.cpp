@@ -17,19 +17,74 @@
 */
 #include <Scene.hpp>
 
+#include <Components.hpp>
 #include <UIContainer.hpp>
+#include <Systems.hpp>
+#include <Tmx.hpp>
+#include <algorithm>
 #include <memory>
+#include <string>
+
+#include <sol/sol.hpp>
 
 namespace proto
 {
+	namespace
+	{
+		// Triggers cover their extent, everything else is a point.
+		[[nodiscard]] spatial_box BoundsOf(Registry& registry, Entity e, const Transform& transform)
+		{
+			const auto* trigger = registry.TryGet<Trigger>(e);
+			const auto half = trigger != nullptr ? glm::abs(trigger->halfExtent) : glm::vec2{};
+
+			return spatial_box::around(transform.pos.x, transform.pos.y, half.x, half.y);
+		}
+
+		// Query results come back as entity indexes, these turn them into entities in place.
+		template <typename Result, typename Convert>
+		size_t ToEntities(size_t found, std::span<Result> out, Convert convert)
+		{
+			for(auto& result : out.first(std::min(found, out.size()))) { convert(result); }
+			return found;
+		}
+	}
+
 	Scene::Scene(std::shared_ptr<UIContainer> ui)
 	: _uiSystem(ui)
 	{
-		
+		AddSystem<AgentSystem>();
 	}
 
 	void Scene::Update(float dt)
 	{
+		for(auto& system : _systems)
+		{
+			system->Update(_registry, dt);
+		}
+
+		// Agents are the only objects that move on their own.
+		_indexIds.clear();
+		_indexBoxes.clear();
+
+		_registry.ViewOf<Agent, Transform>().Each([this](Entity e, Agent&, Transform& transform) {
+			const auto id = entity_index(e);
+			const auto box = BoundsOf(_registry, e, transform);
+
+			if(_objectIndex.contains(id))
+			{
+				_indexIds.push_back(id);
+				_indexBoxes.push_back(box);
+			}
+			else
+			{
+				_objectIndex.insert(id, box);
+			}
+		});
+
+		_objectIndex.move(_indexIds, _indexBoxes);
+
+		_generator.Update(*this);
+
 		if(auto ui = _uiSystem.lock())
 		{
 			ui->Update();
@@ -40,6 +95,88 @@ namespace proto
 
 	void Scene::Cleanup()
 	{
-		
+		_generator.Stop();
+		_systems.clear();
+		_registry.Clear();
+		_journal.Clear();
+		_map.Clear();
+		_objectIndex.clear();
+	}
+
+	void Scene::MapLoaded()
+	{
+		_generator.Stop();
+		_journal.Clear();
+		RebuildObjectIndex();
+	}
+
+	void Scene::BindLua(sol::state_view& lua, const std::filesystem::path& dir)
+	{
+		auto map = lua.create_named_table("Map");
+
+		map["ExportTmx"] = [this, dir](const std::string& file) {
+			return ExportTmx(_map, _registry, dir / file);
+		};
+
+		map["ImportTmx"] = [this, dir](const std::string& file) {
+			if(!ImportTmx(dir / file, _map, _registry)) { return false; }
+
+			MapLoaded();
+			return true;
+		};
+
+		_generator.BindLua(*this, lua);
+	}
+
+	bool Scene::Undo()
+	{
+		return !_generator.Busy() && _journal.Undo(_map);
+	}
+
+	bool Scene::Redo()
+	{
+		return !_generator.Busy() && _journal.Redo(_map);
+	}
+
+	void Scene::RefreshObjects(std::span<const Entity> entities)
+	{
+		for(const auto e : entities)
+		{
+			const auto id = entity_index(e);
+			auto* transform = _registry.Valid(e) ? _registry.TryGet<Transform>(e) : nullptr;
+
+			if(transform == nullptr) { _objectIndex.remove(id); }
+			else if(_objectIndex.contains(id)) { _objectIndex.move(id, BoundsOf(_registry, e, *transform)); }
+			else { _objectIndex.insert(id, BoundsOf(_registry, e, *transform)); }
+		}
+	}
+
+	void Scene::RebuildObjectIndex()
+	{
+		_objectIndex.clear();
+		_indexIds.clear();
+		_indexBoxes.clear();
+
+		_registry.ViewOf<Transform>().Each([this](Entity e, Transform& transform) {
+			_indexIds.push_back(entity_index(e));
+			_indexBoxes.push_back(BoundsOf(_registry, e, transform));
+		});
+
+		_objectIndex.insert(_indexIds, _indexBoxes);
+	}
+
+	size_t Scene::ObjectsIn(const spatial_box& area, std::span<Entity> out) const
+	{
+		return ToEntities(_objectIndex.query(area, out), out, [this](Entity& id) { id = _registry.EntityAt(id); });
+	}
+
+	size_t Scene::ObjectsNear(glm::vec2 point, float radius, std::span<Entity> out) const
+	{
+		return ToEntities(_objectIndex.query(point.x, point.y, radius, out), out, [this](Entity& id) { id = _registry.EntityAt(id); });
+	}
+
+	size_t Scene::ObjectsAlong(glm::vec2 origin, glm::vec2 direction, float maxT, std::span<ray_hit> out) const
+	{
+		return ToEntities(_objectIndex.query_ray(origin.x, origin.y, direction.x, direction.y, maxT, out), out, [this](ray_hit& hit) { hit.id = _registry.EntityAt(hit.id); });
 	}
 }
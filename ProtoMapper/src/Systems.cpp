@@ -0,0 +1,43 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <Systems.hpp>
+
+#include <Components.hpp>
+
+namespace proto
+{
+	void AgentSystem::Update(Registry& registry, float dt)
+	{
+		static constexpr float arrivalDistance = 0.01f;
+
+		registry.ViewOf<Agent, Transform>().ParallelEach([dt](Entity, Agent& agent, Transform& transform) {
+			const auto delta = agent.goal - transform.pos;
+			const auto distance = glm::length(delta);
+
+			if(distance <= arrivalDistance)
+			{
+				agent.velocity = glm::vec2{};
+				return;
+			}
+
+			const auto step = agent.speed * dt;
+			agent.velocity = (delta / distance) * agent.speed;
+			transform.pos = (step >= distance) ? agent.goal : transform.pos + (agent.velocity * dt);
+		});
+	}
+}
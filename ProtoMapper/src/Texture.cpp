@@ -17,8 +17,35 @@
 */
 #include <Texture.hpp>
 
+#include <algorithm>
+#include <array>
+#include <string_view>
+#include <utility>
+#include <vector>
+
 namespace proto
 {
+	namespace
+	{
+		// Core since 4.6 and the same values as EXT/ARB_texture_filter_anisotropic, which every 4.5 driver we target has.
+		constexpr GLenum TextureMaxAnisotropy = 0x84FE;
+		constexpr GLenum MaxTextureMaxAnisotropy = 0x84FF;
+		constexpr float AnisotropyLimit = 16.0f;
+
+		[[nodiscard]] bool HasExtension(std::string_view name)
+		{
+			auto count = GLint{0};
+			glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+
+			for(auto i = 0u; i < static_cast<GLuint>(count); ++i)
+			{
+				if(const auto* ext = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i)); ext != nullptr && name == ext) { return true; } // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+			}
+
+			return false;
+		}
+	}
+
 	Texture2D::Texture2D(IDType id)
 		:ID(id)
 	{
@@ -51,6 +78,16 @@ namespace proto
 		return *this;
 	}
 
+	Texture2D& Texture2D::WriteImage(const ImageView& view)
+	{
+		Bind();
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<int>(view.Stride() / ImageView::BytesPerPixel));
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, static_cast<int>(view.Width()), static_cast<int>(view.Height()), 0, GL_RGBA, GL_UNSIGNED_BYTE, view.Bytes().data());
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+		Unbind();
+		return *this;
+	}
+
 	Texture2D& Texture2D::WriteData(const void* data, int width, int height)
 	{
 		Bind();
@@ -59,6 +96,19 @@ namespace proto
 		return *this;
 	}
 
+	Texture2D& Texture2D::WriteAlpha(const void* data, int width, int height)
+	{
+		static constexpr std::array<GLint, 4uz> swizzle = { GL_RED, GL_RED, GL_RED, GL_RED };
+
+		Bind();
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, width, height, 0, GL_RED, GL_UNSIGNED_BYTE, data);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle.data());
+		Unbind();
+		return *this;
+	}
+
 	Texture2D& Texture2D::GenerateBlank(int w, int h, uint32_t colorValue)
 	{
 		Bind();
@@ -66,4 +116,89 @@ namespace proto
 		Unbind();
 		return *this;
 	}
+
+	Texture2D& Texture2D::Allocate(int width, int height, int levels, GLenum format)
+	{
+		Bind();
+		glTexStorage2D(GL_TEXTURE_2D, levels, format, width, height);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+		Unbind();
+		return *this;
+	}
+
+	Texture2D& Texture2D::WriteMipmapped(const ImageView& view, mip_filter filter)
+	{
+		if(view.Empty()) { return *this; }
+
+		// The filters want tightly packed rows, a sub-rectangle is copied out once.
+		auto packed = std::vector<uint8_t>{};
+		auto pixels = view.Bytes();
+
+		if(!view.Contiguous())
+		{
+			packed.reserve(size_t{view.Width()} * view.Height() * ImageView::BytesPerPixel);
+			for(auto y = 0u; y < view.Height(); ++y) { packed.insert(packed.end(), view.Row(y).begin(), view.Row(y).end()); }
+			pixels = packed;
+		}
+
+		const auto levels = build_mip_chain(pixels, view.Width(), view.Height(), filter);
+
+		Allocate(static_cast<int>(view.Width()), static_cast<int>(view.Height()), static_cast<int>(levels.size() + 1uz));
+
+		Bind();
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<int>(view.Stride() / ImageView::BytesPerPixel));
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, static_cast<int>(view.Width()), static_cast<int>(view.Height()), GL_RGBA, GL_UNSIGNED_BYTE, view.Bytes().data());
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+		for(auto level = 0uz; level < levels.size(); ++level)
+		{
+			const auto& mip = levels[level];
+			glTexSubImage2D(GL_TEXTURE_2D, static_cast<int>(level + 1uz), 0, 0, static_cast<int>(mip.width), static_cast<int>(mip.height), GL_RGBA, GL_UNSIGNED_BYTE, mip.pixels.data());
+		}
+
+		Unbind();
+		return *this;
+	}
+
+	Texture2D& Texture2D::SetSampling(Sampling preset)
+	{
+		const auto [minFilter, magFilter] = [preset]() -> std::pair<GLint, GLint> {
+			switch(preset)
+			{
+			case Sampling::Nearest: return { GL_NEAREST, GL_NEAREST };
+			case Sampling::Bilinear: return { GL_LINEAR, GL_LINEAR };
+			case Sampling::Trilinear:
+			case Sampling::Anisotropic: return { GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR };
+			}
+
+			return { GL_LINEAR, GL_LINEAR };
+		}();
+
+		Bind();
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, magFilter);
+
+		if(const auto limit = MaxAnisotropy(); limit > 1.0f)
+		{
+			glTexParameterf(GL_TEXTURE_2D, TextureMaxAnisotropy, preset == Sampling::Anisotropic ? limit : 1.0f);
+		}
+
+		Unbind();
+		return *this;
+	}
+
+	float Texture2D::MaxAnisotropy()
+	{
+		static const auto limit = []() {
+			if(!HasExtension("GL_EXT_texture_filter_anisotropic") && !HasExtension("GL_ARB_texture_filter_anisotropic")) { return 1.0f; }
+
+			auto max = 1.0f;
+			glGetFloatv(MaxTextureMaxAnisotropy, &max);
+
+			// Past 16 samples the difference is hard to see and the cost is not.
+			return std::clamp(max, 1.0f, AnisotropyLimit);
+		}();
+
+		return limit;
+	}
 }
@@ -0,0 +1,298 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <TextureAtlas.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <utility>
+
+#include <ImageLoader.hpp>
+#include <stl/hash.hpp>
+#include <stl/parallel.hpp>
+
+namespace proto
+{
+	namespace
+	{
+		constexpr uint32_t CacheMagic = 0x41544D50u; // "PMTA"
+		constexpr uint32_t CacheVersion = 2u; // 2: premultiplied alpha.
+
+		template <typename T>
+		void WritePod(std::ofstream& out, const T& value)
+		{
+			out.write(reinterpret_cast<const char*>(&value), sizeof(T)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+		}
+
+		template <typename T>
+		[[nodiscard]] bool ReadPod(std::ifstream& in, T& value)
+		{
+			return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T))); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+		}
+
+		// GL 4.3 takes any texture size, so pages are only rounded up to keep rows 16-byte aligned.
+		[[nodiscard]] uint32_t PageExtent(uint32_t used) { return std::max((used + 3u) & ~3u, 4u); }
+	}
+
+	TextureAtlas::~TextureAtlas()
+	{
+		if(_pending.valid()) { _pending.wait(); }
+
+		for(auto& texture : _textures) { texture.Destroy(); }
+	}
+
+	void TextureAtlas::Begin(std::vector<std::filesystem::path> files, std::filesystem::path cacheFile)
+	{
+		_pending = thread_pool::shared().async([this, files = std::move(files), cacheFile = std::move(cacheFile)]() {
+			Build(files, cacheFile);
+		});
+	}
+
+	bool TextureAtlas::Finish()
+	{
+		if(!_pending.valid()) { return !_textures.empty(); }
+
+		_pending.get();
+
+		for(auto& page : _pages)
+		{
+			auto& texture = _textures.emplace_back();
+
+			// Icons are drawn at their own size almost always, the mip chain keeps them clean when a skin shrinks them.
+			const auto view = ImageView{ nullptr, page.pixels.data(), page.width, page.height, size_t{page.width} * ImageView::BytesPerPixel };
+			texture.Create().WriteMipmapped(view).SetSampling(Sampling::Trilinear);
+
+			// The pixels live on in the texture and the cache file.
+			page.pixels = {};
+		}
+
+		return !_textures.empty();
+	}
+
+	const AtlasRegion* TextureAtlas::Find(const hashed_string& name) const
+	{
+		if(auto it = _regions.find(name); it != _regions.end())
+		{
+			return &it->second;
+		}
+
+		return nullptr;
+	}
+
+	void TextureAtlas::Build(const std::vector<std::filesystem::path>& files, const std::filesystem::path& cacheFile)
+	{
+		const auto key = ContentKey(files);
+
+		_fromCache = LoadCache(cacheFile, key);
+		if(_fromCache) { return; }
+
+		Pack(files);
+		SaveCache(cacheFile, key);
+	}
+
+	void TextureAtlas::Pack(const std::vector<std::filesystem::path>& files)
+	{
+		auto images = std::vector<Image>(files.size());
+		auto index = flat_hash_map<std::string, size_t>{};
+
+		ImageLoader loader;
+
+		for(auto i = 0uz; i < files.size(); ++i)
+		{
+			index.insert_or_assign(files[i].string(), i);
+			loader.Queue(files[i]);
+		}
+
+		// This already runs on a worker, so it is safe to take the images straight out of the loader.
+		loader.Finish([&](const std::filesystem::path& file, Image& img) {
+			img.PremultiplyAlpha();
+			images[index.at(file.string())] = std::move(img);
+		});
+
+		auto names = std::vector<std::string>{};
+		auto sizes = std::vector<packed_rect>{};
+		auto sources = std::vector<size_t>{};
+
+		for(auto i = 0uz; i < images.size(); ++i)
+		{
+			if(images[i].Empty()) { continue; }
+
+			const auto w = images[i].Width() + (2u * Padding), h = images[i].Height() + (2u * Padding);
+			if(w > MaxPageSize || h > MaxPageSize) { continue; }
+
+			names.push_back(files[i].stem().string());
+			sizes.push_back(packed_rect{ .x = 0u, .y = 0u, .w = w, .h = h });
+			sources.push_back(i);
+		}
+
+		const auto placements = pack_rects(sizes, MaxPageSize, MaxPageSize);
+
+		// Shrink each page to what was placed on it.
+		for(const auto& placement : placements)
+		{
+			if(placement.page >= _pages.size()) { _pages.resize(placement.page + 1uz); }
+
+			auto& page = _pages[placement.page];
+			page.width = std::max(page.width, PageExtent(placement.rect.x + placement.rect.w));
+			page.height = std::max(page.height, PageExtent(placement.rect.y + placement.rect.h));
+		}
+
+		for(auto& page : _pages) { page.pixels.assign(size_t{page.width} * size_t{page.height} * 4uz, 0u); }
+
+		for(auto i = 0uz; i < placements.size(); ++i)
+		{
+			const auto& [pageIndex, rect] = placements[i];
+			auto& page = _pages[pageIndex];
+			auto& img = images[sources[i]];
+
+			const auto inner = packed_rect{ .x = rect.x + Padding, .y = rect.y + Padding, .w = img.Width(), .h = img.Height() };
+			const auto rowBytes = size_t{inner.w} * 4uz;
+			const auto pixels = img.Data();
+
+			for(auto row = 0uz; row < inner.h; ++row)
+			{
+				const auto dst = ((size_t{inner.y} + row) * size_t{page.width} + size_t{inner.x}) * 4uz;
+				std::memcpy(page.pixels.data() + dst, pixels.data() + (row * rowBytes), rowBytes); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+			}
+
+			_regions.insert_or_assign(names[i], AtlasRegion{ .page = static_cast<uint32_t>(pageIndex), .rect = inner });
+		}
+	}
+
+	/*
+		Cache layout, all little-endian:
+			magic, version, key, page count, region count
+			per page:   width, height
+			per region: name length, name bytes, page, x, y, w, h
+			per page:   width * height RGBA pixels
+	*/
+	bool TextureAtlas::LoadCache(const std::filesystem::path& cacheFile, uint64_t key)
+	{
+		auto in = std::ifstream{cacheFile, std::ios::binary};
+		if(!in) { return false; }
+
+		uint32_t magic = 0u, version = 0u, pageCount = 0u, regionCount = 0u;
+		uint64_t storedKey = 0u;
+
+		if(!ReadPod(in, magic) || !ReadPod(in, version) || !ReadPod(in, storedKey) || !ReadPod(in, pageCount) || !ReadPod(in, regionCount)) { return false; }
+		if(magic != CacheMagic || version != CacheVersion || storedKey != key) { return false; }
+
+		auto pages = std::vector<Page>(pageCount);
+		auto regions = flat_hash_map<std::string, AtlasRegion>{};
+
+		for(auto& page : pages)
+		{
+			if(!ReadPod(in, page.width) || !ReadPod(in, page.height)) { return false; }
+			if(page.width > MaxPageSize || page.height > MaxPageSize) { return false; }
+		}
+
+		for(auto i = 0u; i < regionCount; ++i)
+		{
+			uint32_t length = 0u;
+			auto region = AtlasRegion{};
+
+			if(!ReadPod(in, length) || length > 4096u) { return false; }
+
+			auto name = std::string(length, '\0');
+
+			if(!in.read(name.data(), static_cast<std::streamsize>(length))) { return false; }
+			if(!ReadPod(in, region.page) || !ReadPod(in, region.rect.x) || !ReadPod(in, region.rect.y) || !ReadPod(in, region.rect.w) || !ReadPod(in, region.rect.h)) { return false; }
+			if(region.page >= pageCount) { return false; }
+
+			regions.insert_or_assign(std::move(name), region);
+		}
+
+		for(auto& page : pages)
+		{
+			page.pixels.resize(size_t{page.width} * size_t{page.height} * 4uz);
+			if(!in.read(reinterpret_cast<char*>(page.pixels.data()), static_cast<std::streamsize>(page.pixels.size()))) { return false; } // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+		}
+
+		_pages = std::move(pages);
+		_regions = std::move(regions);
+		return true;
+	}
+
+	void TextureAtlas::SaveCache(const std::filesystem::path& cacheFile, uint64_t key) const
+	{
+		auto error = std::error_code{};
+		std::filesystem::create_directories(cacheFile.parent_path(), error);
+
+		// Write to a temporary first so a crash never leaves a half written cache behind.
+		auto temp = cacheFile;
+		temp += ".tmp";
+
+		{
+			auto out = std::ofstream{temp, std::ios::binary | std::ios::trunc};
+			if(!out) { return; }
+
+			WritePod(out, CacheMagic);
+			WritePod(out, CacheVersion);
+			WritePod(out, key);
+			WritePod(out, static_cast<uint32_t>(_pages.size()));
+			WritePod(out, static_cast<uint32_t>(_regions.size()));
+
+			for(const auto& page : _pages)
+			{
+				WritePod(out, page.width);
+				WritePod(out, page.height);
+			}
+
+			for(const auto& [name, region] : _regions)
+			{
+				WritePod(out, static_cast<uint32_t>(name.size()));
+				out.write(name.data(), static_cast<std::streamsize>(name.size()));
+				WritePod(out, region.page);
+				WritePod(out, region.rect.x);
+				WritePod(out, region.rect.y);
+				WritePod(out, region.rect.w);
+				WritePod(out, region.rect.h);
+			}
+
+			for(const auto& page : _pages)
+			{
+				out.write(reinterpret_cast<const char*>(page.pixels.data()), static_cast<std::streamsize>(page.pixels.size())); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+			}
+
+			if(!out) { return; }
+		}
+
+		std::filesystem::rename(temp, cacheFile, error);
+	}
+
+	// Hashes every file's name and bytes, plus the packing settings, so any change forces a repack.
+	uint64_t TextureAtlas::ContentKey(const std::vector<std::filesystem::path>& files)
+	{
+		auto sorted = files;
+		std::ranges::sort(sorted);
+
+		auto key = hash_combine(hash_combine(CacheVersion, MaxPageSize), Padding);
+
+		for(const auto& file : sorted)
+		{
+			auto in = std::ifstream{file, std::ios::binary};
+			const auto bytes = std::string{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+
+			key = hash_combine(key, hash_string(file.stem().string()));
+			key = hash_combine(key, hash_string(bytes));
+		}
+
+		return key;
+	}
+}
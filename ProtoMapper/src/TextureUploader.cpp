@@ -0,0 +1,266 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <TextureUploader.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace proto
+{
+	namespace
+	{
+		constexpr GLbitfield RingFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		constexpr GLuint64 NoWait = 0u;
+		constexpr GLuint64 WaitForever = ~GLuint64{0};
+
+		// Rows are RGBA8, so every staged band starts 4-byte aligned without padding.
+		[[nodiscard]] size_t RowBytes(const ImageView& view) { return size_t{view.Width()} * ImageView::BytesPerPixel; }
+	}
+
+	TextureUploader::TextureUploader(size_t ringSize)
+		: _ringSize(ringSize)
+	{
+		glGenBuffers(1, &_buffer);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _buffer);
+		glBufferStorage(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(_ringSize), nullptr, RingFlags);
+		_ring = static_cast<std::byte*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(_ringSize), RingFlags));
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+		if(_ring == nullptr)
+		{
+#ifdef _DEBUG_
+			std::puts("Could not map the texture upload ring, textures will upload synchronously.");
+#endif // _DEBUG_
+			glDeleteBuffers(1, &_buffer);
+			_buffer = 0u;
+		}
+	}
+
+	TextureUploader::~TextureUploader()
+	{
+		Retire(true);
+
+		if(Valid())
+		{
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _buffer);
+			glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			glDeleteBuffers(1, &_buffer);
+		}
+	}
+
+	std::future<Texture2D> TextureUploader::Upload(ImageView view, Callback onDone)
+	{
+		auto request = Request{ .view = std::move(view), .target = {}, .createTarget = true, .done = {}, .onDone = std::move(onDone) };
+		auto future = request.done.get_future();
+
+		const auto lock = std::scoped_lock{ _lock };
+		_queued.push_back(std::move(request));
+
+		return future;
+	}
+
+	std::future<Texture2D> TextureUploader::Upload(ImageView view, Texture2D target, int x, int y, Callback onDone)
+	{
+		auto request = Request{ .view = std::move(view), .target = target, .x = x, .y = y, .done = {}, .onDone = std::move(onDone) };
+		auto future = request.done.get_future();
+
+		const auto lock = std::scoped_lock{ _lock };
+		_queued.push_back(std::move(request));
+
+		return future;
+	}
+
+	void TextureUploader::Process()
+	{
+		Retire(false);
+
+		{
+			const auto lock = std::scoped_lock{ _lock };
+			std::ranges::move(_queued, std::back_inserter(_active));
+			_queued.clear();
+		}
+
+		auto budget = _frameBudget;
+
+		while(!_active.empty())
+		{
+			auto& request = _active.front();
+
+			if(request.view.Empty())
+			{
+				request.done.set_value(request.target);
+				_active.pop_front();
+				continue;
+			}
+
+			if(request.createTarget)
+			{
+				request.target.Create().Allocate(static_cast<int>(request.view.Width()), static_cast<int>(request.view.Height()));
+				request.createTarget = false;
+			}
+
+			if(!Valid() || RowBytes(request.view) > _ringSize) { Direct(request); }
+			else if(!Stage(request, budget)) { break; }
+
+			// GL runs commands in order, so the texture can be drawn as soon as its last band is issued.
+			request.done.set_value(request.target);
+			if(request.onDone) { request.onDone(request.target); }
+
+			_active.pop_front();
+		}
+
+		if(_frameBytes > 0uz)
+		{
+			_inFlight.push_back(InFlight{ .fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0u), .end = _head, .bytes = _frameBytes });
+			_frameBytes = 0uz;
+		}
+	}
+
+	void TextureUploader::Finish()
+	{
+		for(Process(); Pending() > 0uz; Process())
+		{
+			// Out of ring, wait for the GPU to hand some back.
+			Retire(true);
+		}
+	}
+
+	size_t TextureUploader::Pending() const
+	{
+		const auto lock = std::scoped_lock{ _lock };
+		return _active.size() + _queued.size();
+	}
+
+	std::optional<size_t> TextureUploader::Reserve(size_t bytes)
+	{
+		if(_used == 0uz) { _head = _tail = 0uz; }
+
+		auto offset = std::optional<size_t>{};
+
+		if(_head >= _tail && _used < _ringSize)
+		{
+			// Free space is the end of the ring, then the start up to the oldest in-flight band.
+			if(bytes <= _ringSize - _head) { offset = _head; }
+			else if(bytes <= _tail)
+			{
+				// The unused end is skipped over, and counted until the band before it retires.
+				const auto skipped = _ringSize - _head;
+				_used += skipped;
+				_frameBytes += skipped;
+				offset = 0uz;
+			}
+		}
+		else if(_head < _tail && bytes <= _tail - _head) { offset = _head; }
+
+		if(offset)
+		{
+			_head = *offset + bytes;
+			_used += bytes;
+			_frameBytes += bytes;
+		}
+
+		return offset;
+	}
+
+	void TextureUploader::Retire(bool wait)
+	{
+		while(!_inFlight.empty())
+		{
+			auto& flight = _inFlight.front();
+
+			const auto status = glClientWaitSync(flight.fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0u, wait ? WaitForever : NoWait);
+			if(status == GL_TIMEOUT_EXPIRED) { break; }
+
+			glDeleteSync(flight.fence);
+			_tail = flight.end;
+			_used -= flight.bytes;
+
+			_inFlight.pop_front();
+		}
+	}
+
+	bool TextureUploader::Stage(Request& request, size_t& budget)
+	{
+		const auto& view = request.view;
+		const auto rowBytes = RowBytes(view);
+
+		auto issued = false;
+
+		while(request.nextRow < view.Height())
+		{
+			// At least one row per frame, so a budget smaller than a row cannot stall an upload for good.
+			const auto affordable = std::max(budget / rowBytes, budget == _frameBudget ? 1uz : 0uz);
+			const auto rows = std::min({ size_t{view.Height() - request.nextRow}, affordable, _ringSize / rowBytes });
+			if(rows == 0uz) { break; }
+
+			const auto offset = Reserve(rows * rowBytes);
+			if(!offset) { break; }
+
+			auto* band = _ring + *offset; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+			if(view.Contiguous())
+			{
+				std::memcpy(band, view.Row(request.nextRow).data(), rows * rowBytes);
+			}
+			else
+			{
+				for(auto row = 0uz; row < rows; ++row)
+				{
+					std::memcpy(band + (row * rowBytes), view.Row(request.nextRow + static_cast<uint32_t>(row)).data(), rowBytes); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+				}
+			}
+
+			if(!issued)
+			{
+				glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _buffer);
+				request.target.Bind();
+				issued = true;
+			}
+
+			// With a buffer bound to GL_PIXEL_UNPACK_BUFFER the pointer argument is an offset into it.
+			glTexSubImage2D(GL_TEXTURE_2D, 0, request.x, request.y + static_cast<int>(request.nextRow), static_cast<int>(view.Width()), static_cast<int>(rows),
+				GL_RGBA, GL_UNSIGNED_BYTE, reinterpret_cast<const void*>(*offset)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast, performance-no-int-to-ptr)
+
+			request.nextRow += static_cast<uint32_t>(rows);
+			budget -= std::min(budget, rows * rowBytes);
+		}
+
+		if(issued)
+		{
+			Texture2D::Unbind();
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		}
+
+		return request.nextRow == view.Height();
+	}
+
+	void TextureUploader::Direct(Request& request) const
+	{
+		const auto& view = request.view;
+
+		request.target.Bind();
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<int>(view.Stride() / ImageView::BytesPerPixel));
+		glTexSubImage2D(GL_TEXTURE_2D, 0, request.x, request.y, static_cast<int>(view.Width()), static_cast<int>(view.Height()), GL_RGBA, GL_UNSIGNED_BYTE, view.Bytes().data());
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+		Texture2D::Unbind();
+
+		request.nextRow = view.Height();
+	}
+}
@@ -0,0 +1,148 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <TileMap.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+
+namespace proto
+{
+	namespace
+	{
+		[[nodiscard]] constexpr uint32_t ChunkCount(uint32_t extent) { return (extent + TileLayer::ChunkSize - 1u) / TileLayer::ChunkSize; }
+	}
+
+	TileLayer::TileLayer(std::string name, uint32_t width, uint32_t height)
+	: _name(std::move(name)), _width(width), _height(height), _chunksX(ChunkCount(width)), _chunksY(ChunkCount(height)),
+	  _chunks(size_t{_chunksX} * size_t{_chunksY})
+	{
+	}
+
+	TileId TileLayer::Get(uint32_t x, uint32_t y) const
+	{
+		if(x >= _width || y >= _height) { return EmptyTile; }
+
+		const auto chunk = Chunk(x / ChunkSize, y / ChunkSize);
+		return chunk.empty() ? EmptyTile : chunk[(size_t{y % ChunkSize} * ChunkSize) + (x % ChunkSize)];
+	}
+
+	void TileLayer::Set(uint32_t x, uint32_t y, TileId tile)
+	{
+		if(x >= _width || y >= _height) { return; }
+
+		// Clearing a cell never needs to allocate.
+		if(tile == EmptyTile && !SharedChunk(x / ChunkSize, y / ChunkSize)) { return; }
+
+		WritableChunk(x / ChunkSize, y / ChunkSize)[(size_t{y % ChunkSize} * ChunkSize) + (x % ChunkSize)] = tile;
+	}
+
+	std::span<const TileId> TileLayer::Chunk(uint32_t cx, uint32_t cy) const
+	{
+		const auto& chunk = SharedChunk(cx, cy);
+		return chunk ? std::span<const TileId>{ chunk.get(), ChunkArea } : std::span<const TileId>{};
+	}
+
+	std::span<TileId> TileLayer::WritableChunk(uint32_t cx, uint32_t cy)
+	{
+		auto& chunk = _chunks[(size_t{cy} * _chunksX) + cx];
+
+		if(!chunk)
+		{
+			chunk = std::make_shared<TileId[]>(ChunkArea);
+		}
+		else if(chunk.use_count() > 1)
+		{
+			auto copy = std::make_shared_for_overwrite<TileId[]>(ChunkArea);
+			std::copy_n(chunk.get(), ChunkArea, copy.get());
+			chunk = std::move(copy);
+		}
+		else
+		{
+			/*
+				The last other share may have just been dropped by a save on another thread. use_count() is only a
+				relaxed load, the fence pairs it with that thread's release of its share, so every read it made of
+				the chunk happens before the writes below.
+			*/
+			std::atomic_thread_fence(std::memory_order_acquire);
+		}
+
+		return { chunk.get(), ChunkArea };
+	}
+
+	void TileLayer::AdoptChunk(uint32_t cx, uint32_t cy, ChunkPtr tiles)
+	{
+		if(cx >= _chunksX || cy >= _chunksY) { throw std::out_of_range("Chunk is outside the layer."); }
+
+		_chunks[(size_t{cy} * _chunksX) + cx] = std::move(tiles);
+	}
+
+	void TileLayer::ReadRow(uint32_t y, std::span<TileId> out) const
+	{
+		if(out.size() < _width) { throw std::invalid_argument("Row buffer is smaller than the layer."); }
+
+		const auto cy = y / ChunkSize;
+		const auto offset = size_t{y % ChunkSize} * ChunkSize;
+
+		for(auto cx = 0u; cx < _chunksX; ++cx)
+		{
+			const auto x = cx * ChunkSize;
+			const auto count = std::min(ChunkSize, _width - x);
+			const auto dst = out.subspan(x, count);
+
+			if(const auto& chunk = SharedChunk(cx, cy)) { std::copy_n(chunk.get() + offset, count, dst.begin()); } // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+			else { std::ranges::fill(dst, EmptyTile); }
+		}
+	}
+
+	void TileLayer::Clear()
+	{
+		std::ranges::fill(_chunks, nullptr);
+	}
+
+	size_t TileLayer::AllocatedChunks() const
+	{
+		return static_cast<size_t>(std::ranges::count_if(_chunks, [](const auto& chunk) { return chunk != nullptr; }));
+	}
+
+	TileMap::TileMap(uint32_t width, uint32_t height, uint32_t tileWidth, uint32_t tileHeight)
+	{
+		Reset(width, height, tileWidth, tileHeight);
+	}
+
+	void TileMap::Reset(uint32_t width, uint32_t height, uint32_t tileWidth, uint32_t tileHeight)
+	{
+		_width = width;
+		_height = height;
+		_tileWidth = tileWidth;
+		_tileHeight = tileHeight;
+		_layers.clear();
+		_tilesets.clear();
+	}
+
+	TileLayer& TileMap::AddLayer(std::string name)
+	{
+		return _layers.emplace_back(std::move(name), _width, _height);
+	}
+
+	TileLayer* TileMap::FindLayer(std::string_view name)
+	{
+		const auto layer = std::ranges::find(_layers, name, &TileLayer::Name);
+		return layer == _layers.end() ? nullptr : &*layer;
+	}
+}
@@ -0,0 +1,403 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <Tmx.hpp>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <climits>
+#include <cstdio>
+#include <numbers>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <tinyxml2.h>
+#include <zlib.h>
+
+#include <Components.hpp>
+#include <Stopwatch.hpp>
+#include <stl/base64.hpp>
+#include <stl/parallel.hpp>
+
+namespace proto
+{
+	namespace
+	{
+		constexpr size_t WriteBuffer = 1uz << 20uz;
+
+		/*
+			Layers are compressed a band of chunk rows at a time, every band on its own thread, the way pigz does
+			it. Each band is an independent raw deflate stream that ends on a byte boundary, so they concatenate
+			into one stream, and their checksums combine into the one zlib wants at the end.
+		*/
+		constexpr uint32_t BandRows = TileLayer::ChunkSize;
+		constexpr std::array<uint8_t, 2uz> ZlibHeader = { 0x78u, 0x01u }; // 32K window, fastest compression.
+
+		struct Band
+		{
+			std::vector<TileId> tiles;
+			std::vector<uint8_t> deflated;
+			uLong adler = 1u;
+			size_t bytes = 0uz;
+			bool ok = false, blank = false;
+		};
+
+		[[nodiscard]] bool IsBlank(const TileLayer& layer, uint32_t band)
+		{
+			for(auto cx = 0u; cx < layer.ChunksX(); ++cx)
+			{
+				if(layer.SharedChunk(cx, band)) { return false; }
+			}
+
+			return true;
+		}
+
+		[[nodiscard]] bool Deflate(std::span<const uint8_t> raw, bool last, std::vector<uint8_t>& out)
+		{
+			if(raw.size() > UINT_MAX) { return false; }
+
+			auto stream = z_stream{};
+			if(deflateInit2(&stream, Z_BEST_SPEED, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) { return false; }
+
+			// A sync flush adds an empty stored block on top of the bound.
+			out.resize(deflateBound(&stream, static_cast<uLong>(raw.size())) + 16uz);
+
+			stream.next_in = const_cast<Bytef*>(raw.data()); // NOLINT(cppcoreguidelines-pro-type-const-cast)
+			stream.avail_in = static_cast<uInt>(raw.size());
+			stream.next_out = out.data();
+			stream.avail_out = static_cast<uInt>(out.size());
+
+			const auto result = deflate(&stream, last ? Z_FINISH : Z_SYNC_FLUSH);
+			const auto ok = (last ? result == Z_STREAM_END : result == Z_OK) && stream.avail_in == 0u;
+
+			out.resize(out.size() - stream.avail_out);
+			deflateEnd(&stream);
+
+			return ok;
+		}
+
+		void CompressBand(const TileLayer& layer, uint32_t first, bool last, Band& band)
+		{
+			const auto rows = std::min(BandRows, layer.Height() - first);
+			const auto width = size_t{layer.Width()};
+
+			band.tiles.resize(width * rows);
+
+			for(auto row = 0u; row < rows; ++row) { layer.ReadRow(first + row, std::span{ band.tiles }.subspan(row * width, width)); }
+
+			// TMX stores tile ids little endian.
+			if constexpr(std::endian::native == std::endian::big)
+			{
+				for(auto& tile : band.tiles) { tile = std::byteswap(tile); }
+			}
+
+			const auto raw = std::as_bytes(std::span{ band.tiles });
+			const auto* bytes = reinterpret_cast<const uint8_t*>(raw.data()); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+
+			band.bytes = raw.size();
+			band.adler = adler32_z(1u, bytes, raw.size());
+			band.ok = Deflate({ bytes, raw.size() }, last, band.deflated);
+		}
+
+		/*
+			Base64 encodes a byte stream into the current element's text. Bytes that do not make up a whole
+			3 byte group wait for the next write, so no padding appears before the end.
+		*/
+		class TextStream
+		{
+		public:
+			explicit TextStream(tinyxml2::XMLPrinter& printer)
+			: _printer(printer)
+			{
+			}
+
+			void Write(std::span<const uint8_t> bytes) { _pending.insert(_pending.end(), bytes.begin(), bytes.end()); }
+
+			// Encodes everything but the trailing partial group on the thread pool.
+			void Flush(bool last = false)
+			{
+				const auto groups = _pending.size() / 3uz;
+				const auto whole = last ? _pending.size() : groups * 3uz;
+
+				_text.resize(base64_encoded_size(whole) + 1uz);
+
+				parallel_for(groups, [this](size_t first, size_t end) {
+					base64_encode(std::span{ _pending }.subspan(first * 3uz, (end - first) * 3uz), std::span{ _text }.subspan(first * 4uz));
+				}, 1uz << 16uz);
+
+				if(whole > groups * 3uz) { base64_encode(std::span{ _pending }.subspan(groups * 3uz), std::span{ _text }.subspan(groups * 4uz)); }
+
+				_text.back() = '\0';
+				if(whole > 0uz) { _printer.PushText(_text.data()); }
+
+				_pending.erase(_pending.begin(), _pending.begin() + static_cast<ptrdiff_t>(whole));
+			}
+
+		private:
+			tinyxml2::XMLPrinter& _printer;
+			std::vector<uint8_t> _pending;
+			std::vector<char> _text;
+		};
+
+		[[nodiscard]] bool WriteLayerData(tinyxml2::XMLPrinter& printer, const TileLayer& layer)
+		{
+			printer.OpenElement("data");
+			printer.PushAttribute("encoding", "base64");
+			printer.PushAttribute("compression", "zlib");
+
+			auto text = TextStream{ printer };
+			text.Write(ZlibHeader);
+
+			// Bands are compressed in batches, which bounds the memory held at once for very large layers.
+			const auto bandCount = std::max((layer.Height() + BandRows - 1u) / BandRows, 1u);
+			const auto batch = std::max(thread_pool::shared().size(), 1uz) * 2uz;
+
+			auto bands = std::vector<Band>(std::min(size_t{bandCount}, batch));
+			auto adler = adler32(0u, nullptr, 0u);
+
+			// Bands without a single allocated chunk all compress to the same bytes, so that happens once per layer.
+			auto blank = Band{};
+
+			for(auto first = 0u; first < bandCount; first += static_cast<uint32_t>(bands.size()))
+			{
+				const auto count = std::min(size_t{bandCount - first}, bands.size());
+
+				parallel_for(count, [&](size_t begin, size_t end) {
+					for(auto i = begin; i < end; ++i)
+					{
+						const auto band = first + static_cast<uint32_t>(i);
+						const auto last = band + 1u == bandCount;
+
+						bands[i].blank = !last && IsBlank(layer, band);
+						if(!bands[i].blank) { CompressBand(layer, band * BandRows, last, bands[i]); }
+					}
+				}, 1uz);
+
+				for(auto i = 0uz; i < count; ++i)
+				{
+					if(bands[i].blank && !blank.ok) { CompressBand(layer, (first + static_cast<uint32_t>(i)) * BandRows, false, blank); }
+
+					const auto& band = bands[i].blank ? blank : bands[i];
+					if(!band.ok) { return false; }
+
+					text.Write(band.deflated);
+					adler = adler32_combine(adler, band.adler, static_cast<z_off_t>(band.bytes));
+				}
+
+				text.Flush();
+			}
+
+			const auto trailer = std::array{ static_cast<uint8_t>(adler >> 24u), static_cast<uint8_t>(adler >> 16u), static_cast<uint8_t>(adler >> 8u), static_cast<uint8_t>(adler) };
+			text.Write(trailer);
+			text.Flush(true);
+
+			printer.CloseElement();
+			return true;
+		}
+
+		// Paths in a TMX file are relative to the file itself.
+		[[nodiscard]] std::string RelativePath(const std::filesystem::path& path, const std::filesystem::path& dir)
+		{
+			return (path.is_absolute() ? path.lexically_relative(dir) : path).generic_string();
+		}
+
+		void WriteTileset(tinyxml2::XMLPrinter& printer, const Tileset& tileset, const std::filesystem::path& dir)
+		{
+			printer.OpenElement("tileset");
+			printer.PushAttribute("firstgid", tileset.firstGid);
+
+			if(!tileset.source.empty())
+			{
+				printer.PushAttribute("source", RelativePath(tileset.source, dir).c_str());
+				printer.CloseElement();
+				return;
+			}
+
+			printer.PushAttribute("name", tileset.name.c_str());
+			printer.PushAttribute("tilewidth", tileset.tileWidth);
+			printer.PushAttribute("tileheight", tileset.tileHeight);
+			if(tileset.spacing != 0u) { printer.PushAttribute("spacing", tileset.spacing); }
+			if(tileset.margin != 0u) { printer.PushAttribute("margin", tileset.margin); }
+			printer.PushAttribute("tilecount", tileset.tileCount);
+			printer.PushAttribute("columns", tileset.columns);
+
+			if(!tileset.image.empty())
+			{
+				printer.OpenElement("image");
+				printer.PushAttribute("source", RelativePath(tileset.image, dir).c_str());
+				printer.PushAttribute("width", tileset.imageWidth);
+				printer.PushAttribute("height", tileset.imageHeight);
+				printer.CloseElement();
+			}
+
+			printer.CloseElement();
+		}
+
+		template <typename T>
+		void WriteProperty(tinyxml2::XMLPrinter& printer, const char* name, const char* type, T value)
+		{
+			printer.OpenElement("property");
+			printer.PushAttribute("name", name);
+			printer.PushAttribute("type", type);
+			printer.PushAttribute("value", value);
+			printer.CloseElement();
+		}
+
+		void WriteObjects(tinyxml2::XMLPrinter& printer, Registry& registry, uint32_t layerId)
+		{
+			printer.OpenElement("objectgroup");
+			printer.PushAttribute("id", layerId);
+			printer.PushAttribute("name", "Objects");
+
+			// Object ids are entity indices plus one, Tiled reserves 0.
+			registry.ViewOf<Transform>().Each([&](Entity e, const Transform& transform) {
+				const auto* trigger = registry.TryGet<Trigger>(e);
+				const auto* spawn = registry.TryGet<SpawnPoint>(e);
+				const auto* agent = registry.TryGet<Agent>(e);
+				const auto* marker = registry.TryGet<Marker>(e);
+
+				printer.OpenElement("object");
+				printer.PushAttribute("id", entity_index(e) + 1u);
+				if(marker != nullptr) { printer.PushAttribute("name", marker->label.c_str()); }
+				printer.PushAttribute("type", trigger != nullptr ? "trigger" : spawn != nullptr ? "spawn" : agent != nullptr ? "agent" : "marker");
+
+				// Triggers are centered on their Transform, Tiled rectangles hang from their top left corner.
+				const auto pos = trigger != nullptr ? transform.pos - trigger->halfExtent : transform.pos;
+				printer.PushAttribute("x", static_cast<double>(pos.x));
+				printer.PushAttribute("y", static_cast<double>(pos.y));
+
+				if(trigger != nullptr)
+				{
+					printer.PushAttribute("width", static_cast<double>(trigger->halfExtent.x) * 2.0);
+					printer.PushAttribute("height", static_cast<double>(trigger->halfExtent.y) * 2.0);
+				}
+
+				if(transform.rotation != 0.f) { printer.PushAttribute("rotation", static_cast<double>(transform.rotation) * 180.0 / std::numbers::pi); }
+
+				if(trigger != nullptr || spawn != nullptr || agent != nullptr)
+				{
+					printer.OpenElement("properties");
+
+					if(trigger != nullptr) { WriteProperty(printer, "id", "int", trigger->id); }
+
+					if(spawn != nullptr)
+					{
+						WriteProperty(printer, "group", "int", spawn->group);
+						WriteProperty(printer, "capacity", "int", spawn->capacity);
+					}
+
+					if(agent != nullptr)
+					{
+						WriteProperty(printer, "speed", "float", static_cast<double>(agent->speed));
+						WriteProperty(printer, "goalX", "float", static_cast<double>(agent->goal.x));
+						WriteProperty(printer, "goalY", "float", static_cast<double>(agent->goal.y));
+					}
+
+					printer.CloseElement();
+				}
+
+				printer.CloseElement();
+			});
+
+			printer.CloseElement();
+		}
+	}
+
+	bool ExportTmx(const TileMap& map, Registry& registry, const std::filesystem::path& file)
+	{
+		[[maybe_unused]] const auto timer = Stopwatch{};
+		const auto dir = std::filesystem::absolute(file).parent_path();
+
+		auto temp = file;
+		temp += ".tmp";
+
+		auto* out = std::fopen(temp.string().c_str(), "wb");
+		if(out == nullptr)
+		{
+#ifdef _DEBUG_
+			std::printf("[Tmx]: could not open %s for writing.\n", temp.string().c_str()); // NOLINT(cppcoreguidelines-pro-type-vararg)
+#endif // _DEBUG_
+			return false;
+		}
+
+		std::setvbuf(out, nullptr, _IOFBF, WriteBuffer);
+
+		auto nextObject = 1u;
+		registry.ViewOf<Transform>().Each([&nextObject](Entity e, const Transform&) { nextObject = std::max(nextObject, entity_index(e) + 2u); });
+
+		const auto layerCount = static_cast<uint32_t>(map.Layers().size());
+		auto ok = true;
+
+		{
+			auto printer = tinyxml2::XMLPrinter{ out };
+			printer.PushHeader(false, true);
+
+			printer.OpenElement("map");
+			printer.PushAttribute("version", "1.10");
+			printer.PushAttribute("orientation", "orthogonal");
+			printer.PushAttribute("renderorder", "right-down");
+			printer.PushAttribute("width", map.Width());
+			printer.PushAttribute("height", map.Height());
+			printer.PushAttribute("tilewidth", map.TileWidth());
+			printer.PushAttribute("tileheight", map.TileHeight());
+			printer.PushAttribute("infinite", 0);
+			printer.PushAttribute("nextlayerid", layerCount + 2u);
+			printer.PushAttribute("nextobjectid", nextObject);
+
+			for(const auto& tileset : map.Tilesets()) { WriteTileset(printer, tileset, dir); }
+
+			for(auto id = 1u; const auto& layer : map.Layers())
+			{
+				printer.OpenElement("layer");
+				printer.PushAttribute("id", id++);
+				printer.PushAttribute("name", layer.Name().c_str());
+				printer.PushAttribute("width", layer.Width());
+				printer.PushAttribute("height", layer.Height());
+				if(!layer.visible) { printer.PushAttribute("visible", 0); }
+				if(layer.opacity != 1.f) { printer.PushAttribute("opacity", static_cast<double>(layer.opacity)); }
+
+				ok = ok && WriteLayerData(printer, layer);
+				printer.CloseElement();
+			}
+
+			WriteObjects(printer, registry, layerCount + 1u);
+			printer.CloseElement();
+		}
+
+		ok = std::ferror(out) == 0 && ok;
+		ok = std::fclose(out) == 0 && ok;
+
+		auto error = std::error_code{};
+		if(ok) { std::filesystem::rename(temp, file, error); }
+
+		if(!ok || error)
+		{
+			std::filesystem::remove(temp, error);
+#ifdef _DEBUG_
+			std::printf("[Tmx]: could not export %s.\n", file.string().c_str()); // NOLINT(cppcoreguidelines-pro-type-vararg)
+#endif // _DEBUG_
+			return false;
+		}
+
+#ifdef _DEBUG_
+		std::printf("[Tmx]: exported %s in %.2f ms\n", file.filename().string().c_str(), timer.Milliseconds()); // NOLINT(cppcoreguidelines-pro-type-vararg)
+#endif // _DEBUG_
+		return true;
+	}
+}
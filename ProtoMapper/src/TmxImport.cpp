@@ -0,0 +1,441 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <Tmx.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <numbers>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include <tinyxml2.h>
+#include <zlib.h>
+
+#include <Components.hpp>
+#include <MappedFile.hpp>
+#include <Stopwatch.hpp>
+#include <stl/base64.hpp>
+#include <stl/parallel.hpp>
+
+namespace proto
+{
+	namespace
+	{
+		enum class Encoding : uint8_t
+		{
+			Base64,
+			Compressed, // zlib or gzip, inflate tells them apart by their headers.
+			Csv,
+		};
+
+		struct PendingLayer
+		{
+			size_t layer = 0uz;
+			Encoding encoding = Encoding::Base64;
+			std::string_view text;
+			std::vector<uint8_t> bytes; // The base64 decoded text.
+			bool ok = false;
+		};
+
+		[[nodiscard]] std::optional<TmxTimings> Fail([[maybe_unused]] const std::filesystem::path& file, [[maybe_unused]] const char* reason)
+		{
+#ifdef _DEBUG_
+			std::printf("[Tmx]: could not import %s, %s.\n", file.string().c_str(), reason); // NOLINT(cppcoreguidelines-pro-type-vararg)
+#endif // _DEBUG_
+			return std::nullopt;
+		}
+
+		[[nodiscard]] std::string_view Attribute(const tinyxml2::XMLElement& element, const char* name)
+		{
+			const auto* value = element.Attribute(name);
+			return value == nullptr ? std::string_view{} : std::string_view{ value };
+		}
+
+		/*
+			Calls func(tiles) for every run of a layer's tiles in file order, where each run is one row of one chunk,
+			so decoders write into chunk storage directly.
+		*/
+		template <typename Func>
+		[[nodiscard]] bool ForEachRun(TileLayer& layer, Func&& func)
+		{
+			for(auto y = 0u; y < layer.Height(); ++y)
+			{
+				const auto cy = y / TileLayer::ChunkSize;
+				const auto offset = size_t{y % TileLayer::ChunkSize} * TileLayer::ChunkSize;
+
+				for(auto cx = 0u; cx < layer.ChunksX(); ++cx)
+				{
+					const auto count = std::min(TileLayer::ChunkSize, layer.Width() - (cx * TileLayer::ChunkSize));
+					if(!func(layer.WritableChunk(cx, cy).subspan(offset, count))) { return false; }
+				}
+			}
+
+			return true;
+		}
+
+		/*
+			Inflates a row of the map at a time and hands it out to the chunks. zlib only takes its fast path with
+			at least 258 bytes of output room, which a run of one chunk does not have, and a row stays in cache.
+		*/
+		[[nodiscard]] bool Inflate(std::span<const uint8_t> src, TileLayer& layer)
+		{
+			if(src.size() > UINT_MAX) { return false; }
+
+			auto stream = z_stream{};
+			if(inflateInit2(&stream, MAX_WBITS + 32) != Z_OK) { return false; }
+
+			stream.next_in = const_cast<Bytef*>(src.data()); // NOLINT(cppcoreguidelines-pro-type-const-cast)
+			stream.avail_in = static_cast<uInt>(src.size());
+
+			auto row = std::vector<TileId>(layer.Width());
+			auto result = Z_OK;
+			auto read = row.size();
+
+			auto ok = ForEachRun(layer, [&](std::span<TileId> tiles) {
+				if(read == row.size())
+				{
+					stream.next_out = reinterpret_cast<Bytef*>(row.data()); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+					stream.avail_out = static_cast<uInt>(std::span{ row }.size_bytes());
+
+					while(stream.avail_out > 0u && result == Z_OK) { result = inflate(&stream, Z_NO_FLUSH); }
+					if(stream.avail_out > 0u) { return false; }
+
+					read = 0uz;
+				}
+
+				std::ranges::copy(std::span{ row }.subspan(read, tiles.size()), tiles.begin());
+				read += tiles.size();
+				return true;
+			});
+
+			// Every tile is in, but the checksum after them has not been read yet. It must be the end of the stream.
+			auto spare = Bytef{};
+			stream.next_out = &spare;
+			stream.avail_out = 1u;
+
+			while(ok && result == Z_OK) { result = inflate(&stream, Z_NO_FLUSH); }
+			ok = ok && result == Z_STREAM_END && stream.avail_out == 1u;
+
+			inflateEnd(&stream);
+			return ok;
+		}
+
+		[[nodiscard]] bool Copy(std::span<const uint8_t> src, TileLayer& layer)
+		{
+			if(src.size() != size_t{layer.Width()} * layer.Height() * sizeof(TileId)) { return false; }
+
+			auto read = 0uz;
+			return ForEachRun(layer, [&](std::span<TileId> tiles) {
+				std::memcpy(tiles.data(), src.subspan(read).data(), tiles.size_bytes());
+				read += tiles.size_bytes();
+				return true;
+			});
+		}
+
+		[[nodiscard]] bool ParseCsv(std::string_view text, TileLayer& layer)
+		{
+			auto pos = 0uz;
+
+			return ForEachRun(layer, [&](std::span<TileId> tiles) {
+				for(auto& tile : tiles)
+				{
+					pos = text.find_first_not_of(", \t\r\n", pos);
+					if(pos == std::string_view::npos) { return false; }
+
+					const auto [next, error] = std::from_chars(text.substr(pos).data(), text.data() + text.size(), tile); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+					if(error != std::errc{}) { return false; }
+
+					pos = static_cast<size_t>(next - text.data());
+				}
+
+				return true;
+			});
+		}
+
+		// Decoding allocates every chunk, the ones that turned out empty are freed again.
+		void DropBlankChunks(TileLayer& layer)
+		{
+			for(auto cy = 0u; cy < layer.ChunksY(); ++cy)
+			{
+				for(auto cx = 0u; cx < layer.ChunksX(); ++cx)
+				{
+					const auto chunk = layer.Chunk(cx, cy);
+					if(std::ranges::all_of(chunk, [](TileId tile) { return tile == EmptyTile; })) { layer.AdoptChunk(cx, cy, nullptr); }
+				}
+			}
+		}
+
+		void Fill(PendingLayer& pending, TileLayer& layer)
+		{
+			switch(pending.encoding)
+			{
+			case Encoding::Base64: pending.ok = Copy(pending.bytes, layer); break;
+			case Encoding::Compressed: pending.ok = Inflate(pending.bytes, layer); break;
+			case Encoding::Csv: pending.ok = ParseCsv(pending.text, layer); break;
+			}
+
+			// TMX stores binary tile ids little endian.
+			if constexpr(std::endian::native == std::endian::big)
+			{
+				if(pending.encoding != Encoding::Csv)
+				{
+					static_cast<void>(ForEachRun(layer, [](std::span<TileId> tiles) {
+						for(auto& tile : tiles) { tile = std::byteswap(tile); }
+						return true;
+					}));
+				}
+			}
+
+			DropBlankChunks(layer);
+			pending.bytes = {};
+		}
+
+		[[nodiscard]] Tileset ReadTileset(const tinyxml2::XMLElement& element, const std::filesystem::path& dir)
+		{
+			auto tileset = Tileset{};
+			tileset.firstGid = element.UnsignedAttribute("firstgid", 1u);
+
+			// An external tileset only leaves its first id in the map, the rest is in its .tsx file.
+			auto external = tinyxml2::XMLDocument{};
+			const auto* data = &element;
+
+			if(const auto source = Attribute(element, "source"); !source.empty())
+			{
+				tileset.source = dir / source;
+
+				if(external.LoadFile(tileset.source.string().c_str()) != tinyxml2::XML_SUCCESS || external.RootElement() == nullptr)
+				{
+#ifdef _DEBUG_
+					std::printf("[Tmx]: could not read tileset %s.\n", tileset.source.string().c_str()); // NOLINT(cppcoreguidelines-pro-type-vararg)
+#endif // _DEBUG_
+					return tileset;
+				}
+
+				data = external.RootElement();
+			}
+
+			tileset.name = Attribute(*data, "name");
+			tileset.tileWidth = data->UnsignedAttribute("tilewidth");
+			tileset.tileHeight = data->UnsignedAttribute("tileheight");
+			tileset.tileCount = data->UnsignedAttribute("tilecount");
+			tileset.columns = data->UnsignedAttribute("columns");
+			tileset.spacing = data->UnsignedAttribute("spacing");
+			tileset.margin = data->UnsignedAttribute("margin");
+
+			if(const auto* image = data->FirstChildElement("image"))
+			{
+				// Relative to the file the tileset was defined in.
+				tileset.image = (tileset.source.empty() ? dir : tileset.source.parent_path()) / Attribute(*image, "source");
+				tileset.imageWidth = image->UnsignedAttribute("width");
+				tileset.imageHeight = image->UnsignedAttribute("height");
+			}
+
+			return tileset;
+		}
+
+		[[nodiscard]] const char* ReadLayers(const tinyxml2::XMLElement& parent, TileMap& map, std::vector<PendingLayer>& pending,
+			std::vector<const tinyxml2::XMLElement*>& objectGroups, bool visible, float opacity)
+		{
+			for(const auto* element = parent.FirstChildElement(); element != nullptr; element = element->NextSiblingElement())
+			{
+				const auto name = std::string_view{ element->Name() };
+				const auto layerVisible = visible && element->BoolAttribute("visible", true);
+				const auto layerOpacity = opacity * element->FloatAttribute("opacity", 1.f);
+
+				if(name == "objectgroup") { objectGroups.push_back(element); }
+
+				// Group layers are flattened, their children take on the group's visibility and opacity.
+				if(name == "group")
+				{
+					if(const auto* error = ReadLayers(*element, map, pending, objectGroups, layerVisible, layerOpacity)) { return error; }
+				}
+
+				if(name != "layer") { continue; }
+
+				if(element->UnsignedAttribute("width") != map.Width() || element->UnsignedAttribute("height") != map.Height()) { return "a layer is not the size of the map"; }
+
+				const auto* data = element->FirstChildElement("data");
+				if(data == nullptr) { return "a layer has no data"; }
+
+				const auto encoding = Attribute(*data, "encoding"), compression = Attribute(*data, "compression");
+				auto layer = PendingLayer{};
+				layer.layer = map.Layers().size();
+				layer.text = data->GetText() == nullptr ? std::string_view{} : data->GetText();
+
+				if(encoding == "csv") { layer.encoding = Encoding::Csv; }
+				else if(encoding != "base64") { return "only base64 and CSV layer data is supported"; }
+				else if(compression == "zlib" || compression == "gzip") { layer.encoding = Encoding::Compressed; }
+				else if(!compression.empty()) { return "only zlib and gzip compression are supported"; }
+
+				auto& added = map.AddLayer(std::string{ Attribute(*element, "name") });
+				added.visible = layerVisible;
+				added.opacity = layerOpacity;
+
+				pending.push_back(std::move(layer));
+			}
+
+			return nullptr;
+		}
+
+		[[nodiscard]] const tinyxml2::XMLElement* FindProperty(const tinyxml2::XMLElement& object, std::string_view name)
+		{
+			const auto* properties = object.FirstChildElement("properties");
+
+			for(const auto* property = properties != nullptr ? properties->FirstChildElement("property") : nullptr; property != nullptr; property = property->NextSiblingElement("property"))
+			{
+				if(Attribute(*property, "name") == name) { return property; }
+			}
+
+			return nullptr;
+		}
+
+		[[nodiscard]] uint32_t UnsignedProperty(const tinyxml2::XMLElement& object, std::string_view name, uint32_t fallback)
+		{
+			const auto* property = FindProperty(object, name);
+			return property != nullptr ? property->UnsignedAttribute("value", fallback) : fallback;
+		}
+
+		[[nodiscard]] float FloatProperty(const tinyxml2::XMLElement& object, std::string_view name, float fallback)
+		{
+			const auto* property = FindProperty(object, name);
+			return property != nullptr ? property->FloatAttribute("value", fallback) : fallback;
+		}
+
+		// The reverse of the exporter: rectangles become triggers, and points markers unless their type says otherwise.
+		void ReadObjects(const tinyxml2::XMLElement& group, Registry& registry)
+		{
+			for(const auto* object = group.FirstChildElement("object"); object != nullptr; object = object->NextSiblingElement("object"))
+			{
+				// Tiled 1.9 briefly called the type 'class'.
+				const auto type = object->Attribute("type") != nullptr ? Attribute(*object, "type") : Attribute(*object, "class");
+				const auto name = Attribute(*object, "name");
+				const auto pos = glm::vec2{ object->FloatAttribute("x"), object->FloatAttribute("y") };
+				const auto size = glm::vec2{ object->FloatAttribute("width"), object->FloatAttribute("height") };
+
+				const auto e = registry.Create();
+				auto kept = false;
+				auto& transform = registry.Emplace<Transform>(e, Transform{ .pos = pos, .rotation = object->FloatAttribute("rotation") * std::numbers::pi_v<float> / 180.f });
+
+				if(type == "trigger" || (type != "spawn" && type != "agent" && size.x > 0.f && size.y > 0.f))
+				{
+					const auto half = glm::vec2{ size.x * 0.5f, size.y * 0.5f };
+					transform.pos = glm::vec2{ pos.x + half.x, pos.y + half.y };
+					registry.Emplace<Trigger>(e, Trigger{ .halfExtent = half, .id = UnsignedProperty(*object, "id", 0u) });
+					kept = true;
+				}
+				else if(type == "spawn")
+				{
+					registry.Emplace<SpawnPoint>(e, SpawnPoint{ .group = UnsignedProperty(*object, "group", 0u), .capacity = UnsignedProperty(*object, "capacity", 1u) });
+					kept = true;
+				}
+
+				if(type == "agent" || FindProperty(*object, "speed") != nullptr)
+				{
+					const auto goal = glm::vec2{ FloatProperty(*object, "goalX", 0.f), FloatProperty(*object, "goalY", 0.f) };
+					registry.Emplace<Agent>(e, Agent{ .velocity = {}, .goal = goal, .speed = FloatProperty(*object, "speed", 1.f) });
+					kept = true;
+				}
+
+				// Anything else would be a bare Transform, so it is kept as a marker.
+				if(!name.empty() || !kept) { registry.Emplace<Marker>(e, Marker{ std::string{ name } }); }
+			}
+		}
+
+		[[maybe_unused]] [[nodiscard]] double Milliseconds(std::chrono::microseconds time) { return static_cast<double>(time.count()) / 1000.0; }
+	}
+
+	std::optional<TmxTimings> ImportTmx(const std::filesystem::path& file, TileMap& map, Registry& registry)
+	{
+		auto timings = TmxTimings{};
+		auto timer = Stopwatch{};
+
+		const auto source = MappedFile{ file };
+		if(!source.IsOpen()) { return Fail(file, "the file could not be opened"); }
+
+		auto doc = tinyxml2::XMLDocument{};
+		if(doc.Parse(reinterpret_cast<const char*>(source.Bytes().data()), source.Size()) != tinyxml2::XML_SUCCESS) { return Fail(file, doc.ErrorStr()); } // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+
+		timings.parse = timer.Elapsed();
+		timer.Reset();
+
+		const auto* root = doc.RootElement();
+		if(root == nullptr || std::string_view{ root->Name() } != "map") { return Fail(file, "it is not a map"); }
+		if(Attribute(*root, "orientation") != "orthogonal") { return Fail(file, "only orthogonal maps are supported"); }
+		if(root->BoolAttribute("infinite")) { return Fail(file, "infinite maps are not supported"); }
+
+		const auto width = root->UnsignedAttribute("width"), height = root->UnsignedAttribute("height");
+		if(width == 0u || height == 0u || width > TileMap::MaxExtent || height > TileMap::MaxExtent) { return Fail(file, "the map size is out of range"); }
+
+		auto loaded = TileMap{ width, height, root->UnsignedAttribute("tilewidth"), root->UnsignedAttribute("tileheight") };
+		const auto dir = std::filesystem::absolute(file).parent_path();
+
+		for(const auto* tileset = root->FirstChildElement("tileset"); tileset != nullptr; tileset = tileset->NextSiblingElement("tileset"))
+		{
+			loaded.Tilesets().push_back(ReadTileset(*tileset, dir));
+		}
+
+		auto pending = std::vector<PendingLayer>{};
+		auto objectGroups = std::vector<const tinyxml2::XMLElement*>{};
+
+		if(const auto* error = ReadLayers(*root, loaded, pending, objectGroups, true, 1.f)) { return Fail(file, error); }
+
+		// Each layer is one stream, so the parallelism is across layers.
+		parallel_for(pending.size(), [&pending](size_t first, size_t last) {
+			for(auto& layer : std::span{ pending }.subspan(first, last - first))
+			{
+				if(layer.encoding == Encoding::Csv) { layer.ok = true; continue; }
+
+				layer.bytes.resize(base64_decoded_size(layer.text.size()));
+				const auto size = base64_decode(layer.text, layer.bytes);
+
+				layer.ok = size.has_value();
+				layer.bytes.resize(size.value_or(0uz));
+			}
+		}, 1uz);
+
+		if(!std::ranges::all_of(pending, &PendingLayer::ok)) { return Fail(file, "a layer's base64 data is corrupt"); }
+
+		timings.decode = timer.Elapsed();
+		timer.Reset();
+
+		parallel_for(pending.size(), [&pending, &loaded](size_t first, size_t last) {
+			for(auto& layer : std::span{ pending }.subspan(first, last - first)) { Fill(layer, loaded.Layers()[layer.layer]); }
+		}, 1uz);
+
+		if(!std::ranges::all_of(pending, &PendingLayer::ok)) { return Fail(file, "a layer's data is corrupt or the wrong size"); }
+
+		map = std::move(loaded);
+		registry.Clear();
+
+		for(const auto* group : objectGroups) { ReadObjects(*group, registry); }
+
+		timings.fill = timer.Elapsed();
+
+#ifdef _DEBUG_
+		std::printf("[Tmx]: imported %s, parse %.2f ms, decode %.2f ms, fill %.2f ms\n", file.filename().string().c_str(), // NOLINT(cppcoreguidelines-pro-type-vararg)
+			Milliseconds(timings.parse), Milliseconds(timings.decode), Milliseconds(timings.fill));
+#endif // _DEBUG_
+
+		return timings;
+	}
+}
@@ -24,6 +24,7 @@
 #include <sol/sol.hpp>
 #include <stdexcept>
 #include <utility>
+#include <vector>
 
 #include <ProtoMapper.hpp>
 #include <Config.hpp>
@@ -45,23 +46,24 @@ namespace proto
 	};
 
 	UIContainer::UIContainer(FontGroup& fonts, const sol::state_view& state, Renderer* ren)
-		: _env(state, sol::create, state.globals()), _ctx(new nk_context, CtxDeleter{}), _configurator(), _cmds(), _verts(), _inds(), _nullTexture()
+		: _env(state, sol::create, state.globals()), _fonts(&fonts), _distanceFieldShader(ren->GetDistanceFieldShader()), _ctx(new nk_context{}, CtxDeleter{}), _configurator(), _cmds(), _verts(), _inds(), _nullTexture()
 	{
 		const std::filesystem::path fontDir = GetAssetDir() + "/fonts/roboto";
 		const std::filesystem::path imgDir = GetAssetDir() + "/icons";
 
-		if(std::filesystem::exists(imgDir) && std::filesystem::is_directory(imgDir))
+		// Icons and the skin are packed into one atlas on the worker threads while the buffers and fonts are set up below.
+		auto atlasFiles = std::vector<std::filesystem::path>{ GetAssetDir() + "/UIskins/DefaultSkin.png" };
+
+		if(std::filesystem::is_directory(imgDir))
 		{
 			for(const auto& icon : std::filesystem::directory_iterator(imgDir))
 			{
-				const auto& file = icon.path();
-
-				Image img{file};
-				auto iconImg = _icons.insert_or_assign(file.stem().string(), std::shared_ptr<Texture2D>{new Texture2D{}, [](Texture2D* tex){ tex->Destroy(); }});
-				iconImg.first->second->Create().WriteImage(img);
+				if(icon.path().extension() == ".png") { atlasFiles.push_back(icon.path()); }
 			}
 		}
 
+		_atlas.Begin(std::move(atlasFiles), std::filesystem::path{GetCacheDir()} / "ui_atlas.bin");
+
 		_nkBuffer.Generate(MaxVertexBuffer, MaxVertexBuffer);
 
 		constexpr int segmentsPerCurve = 22;
@@ -84,9 +86,10 @@ namespace proto
 		_nullTexture.texture = nk_handle_id(static_cast<int>(nTexture.ID));
 		_nullTexture.uv = nk_vec2(0.0f, 0.0f);
 
-		// Add Fonts to the FontGroup.
+		// Register the fonts with the FontGroup. Each style is loaded the first time a script pushes it, and baked
+		// atlases are cached, so only the first run rasterises them.
 
-		fonts.Create();
+		fonts.SetCacheDir(std::filesystem::path{GetCacheDir()} / "fonts");
 
 		// We leave these magic numbers in, for now. They will be replaced with a more intelligent solution later.
 
@@ -95,25 +98,17 @@ namespace proto
 		fonts.AddFont(FontStyle::BoldItalic, 20.0f, fontDir / "Roboto-BoldItalic.ttf");
 		fonts.AddFont(FontStyle::Italic, 20.0f, fontDir / "Roboto-Italic.ttf");
 
-		/*
-            Because the pointer returned by nk_font_atlas_bake() is a 'reference' pointer, not an owning pointer, we can't
-			include a Bake function in the FontGroup class that returns an Image.
-
-			As a result, it's just easier to handle baking this way.
-        */
-
-		int imgWidth, imgHeight; // NOLINT(cppcoreguidelines-init-variables) - variables initialized later
-	    const void* img = nk_font_atlas_bake(fonts.GetAtlas(), &imgWidth, &imgHeight, NK_FONT_ATLAS_RGBA32);
+		// Distance field variants for text drawn at other heights through StylePushFont.
+		fonts.AddFont(FontStyle::Normal, 20.0f, fontDir / "Roboto-Medium.ttf", FontRender::DistanceField);
+		fonts.AddFont(FontStyle::Bold, 20.0f, fontDir / "Roboto-Bold.ttf", FontRender::DistanceField);
 
-		if(img != nullptr) 
-		{ 
-			// Create Texture object.
-			_fontTexture.Create().WriteData(img, imgWidth, imgHeight);
+		if(!_atlas.Finish()) { std::puts("Could not build the UI texture atlas."); }
 
-			fonts.Finalize(_fontTexture.GetID());
-		}
+		// The default font is the only one loaded up front, nuklear can not run without it.
+		auto* normal = fonts.GetFont(FontStyle::Normal);
+		if(normal == nullptr) { throw std::runtime_error("Could not load the default UI font."); }
 
-		nk_init_default(_ctx.get(), &fonts.GetFont(FontStyle::Normal)->handle);
+		nk_init_default(_ctx.get(), &normal->handle);
 	}
 
 	bool UIContainer::SetDefinitions(const std::filesystem::path& filepath, sol::state_view& state)
@@ -194,6 +189,11 @@ namespace proto
 			if (cmd->texture.id != 0 && glIsTexture((unsigned int)cmd->texture.id) == GL_TRUE)
 			{
 				draw.texture = Texture2D{ static_cast<Texture2D::IDType>(cmd->texture.id) };
+
+				if(_distanceFieldShader.Valid() && _fonts->IsDistanceField(static_cast<uint32_t>(cmd->texture.id)))
+				{
+					draw.shader = _distanceFieldShader;
+				}
 			}
 
 			_drawCalls.emplace_back(draw);
@@ -206,6 +206,18 @@ namespace proto
 		return std::span<DrawCall> { _drawCalls.begin(), _drawCalls.size() };
 	}
 
+	std::optional<struct nk_image> UIContainer::GetIcon(const hashed_string& name) const
+	{
+		const auto* region = _atlas.Find(name);
+		if(region == nullptr) { return std::nullopt; }
+
+		const auto texture = _atlas.PageTexture(region->page);
+		const auto& rect = region->rect;
+
+		return nk_subimage_id(static_cast<int>(texture.GetID()), static_cast<nk_ushort>(_atlas.PageWidth(region->page)), static_cast<nk_ushort>(_atlas.PageHeight(region->page)),
+			nk_rect(static_cast<float>(rect.x), static_cast<float>(rect.y), static_cast<float>(rect.w), static_cast<float>(rect.h)));
+	}
+
 	void UIContainer::Update()
 	{		
 		for (auto& [name, errorMsg] : _luaFunctions)
@@ -223,6 +235,12 @@ namespace proto
 
 	void UIContainer::InitLua()
 	{		
+		// Icons are atlas sub-images, pass the result straight to the image functions. Returns nil for unknown names.
+		_env["Icon"] = [this](std::string_view name) -> sol::optional<struct nk_image> {
+			if(auto icon = GetIcon(name)) { return *icon; }
+			return sol::nullopt;
+		};
+
 		// Useful types
 
 		auto vec2 = _env.new_usertype<struct nk_vec2>("vec2", sol::no_constructor);
@@ -513,24 +531,24 @@ namespace proto
 			};
 
 		context["MenuBeginImg"] = 
-			[](sol::optional<nk_context*> ctx, sol::optional<std::string_view> id, sol::optional<int> img, sol::optional<struct nk_vec2> size) -> bool
+			[](sol::optional<nk_context*> ctx, sol::optional<std::string_view> id, sol::optional<struct nk_image> img, sol::optional<struct nk_vec2> size) -> bool
 			{
 				if(!ctx) { throw std::runtime_error{"No UI context provided. Please call function with a ':' or pass Ctx as 1st arg."}; }
 				if(!id) { throw std::runtime_error{"No identifying string provided."}; }
-				if(!img) { throw std::runtime_error{"No image id provided."}; }
+				if(!img) { throw std::runtime_error{"No image provided."}; }
 				
-				return static_cast<bool>(nk_menu_begin_image(*ctx, id.value().data(), nk_image_id(*img), size.value_or(nk_vec2(0.0f, 0.0f)))); // NOLINT
+				return static_cast<bool>(nk_menu_begin_image(*ctx, id.value().data(), *img, size.value_or(nk_vec2(0.0f, 0.0f)))); // NOLINT
 			};
 
 		context["MenuBeginImgLbl"] = 
-			[](sol::optional<nk_context*> ctx, sol::optional<std::string_view> text, sol::optional<nk_flags> flags, sol::optional<int> img, sol::optional<struct nk_vec2> size) -> bool
+			[](sol::optional<nk_context*> ctx, sol::optional<std::string_view> text, sol::optional<nk_flags> flags, sol::optional<struct nk_image> img, sol::optional<struct nk_vec2> size) -> bool
 			{
 				if(!ctx) { throw std::runtime_error{"No UI context provided. Please call function with a ':' or pass Ctx as 1st arg."}; }
 				if(!text) { throw std::runtime_error{"No text string provided."}; }
-				if(!img) { throw std::runtime_error{"No image id provided."}; }
+				if(!img) { throw std::runtime_error{"No image provided."}; }
 				
 				const auto& str = text.value();				
-				return static_cast<bool>(nk_menu_begin_image_text(*ctx, str.data(), static_cast<int>(str.size()), flags.value_or(NK_TEXT_CENTERED), nk_image_id(*img), size.value_or(nk_vec2(0.0f, 0.0f))));
+				return static_cast<bool>(nk_menu_begin_image_text(*ctx, str.data(), static_cast<int>(str.size()), flags.value_or(NK_TEXT_CENTERED), *img, size.value_or(nk_vec2(0.0f, 0.0f))));
 
 			};
 
@@ -566,14 +584,14 @@ namespace proto
 			};
 
 		context["MenuItemImgLbl"] = 
-			[](sol::optional<nk_context*> ctx, sol::optional<int> img, sol::optional<std::string_view> text, sol::optional<nk_flags> flags) -> bool
+			[](sol::optional<nk_context*> ctx, sol::optional<struct nk_image> img, sol::optional<std::string_view> text, sol::optional<nk_flags> flags) -> bool
 			{
 				if(!ctx) { throw std::runtime_error{"No UI context provided. Please call function with a ':' or pass Ctx as 1st arg."}; }
 				if(!text) { throw std::runtime_error{"No text string provided."}; }
-				if(!img) { throw std::runtime_error{"No image id provided."}; }
+				if(!img) { throw std::runtime_error{"No image provided."}; }
 
 				const auto& str = text.value();
-				return static_cast<bool>(nk_menu_item_image_text(*ctx, nk_image_id(*img), str.data(), static_cast<int>(str.size()), flags.value_or(NK_TEXT_CENTERED)));
+				return static_cast<bool>(nk_menu_item_image_text(*ctx, *img, str.data(), static_cast<int>(str.size()), flags.value_or(NK_TEXT_CENTERED)));
 
 			};
 
@@ -640,12 +658,12 @@ namespace proto
 			};
 
 		context["ButtonImg"] = 
-			[](sol::optional<nk_context*> ctx, sol::optional<int> img) -> bool
+			[](sol::optional<nk_context*> ctx, sol::optional<struct nk_image> img) -> bool
 			{
 				if(!ctx) { throw std::runtime_error{"No UI context provided. Please call function with a ':' or pass Ctx as 1st arg."}; }
-				if(!img) { throw std::runtime_error{"No image id provided."}; }
+				if(!img) { throw std::runtime_error{"No image provided."}; }
 				
-				return static_cast<bool>(nk_button_image(*ctx, nk_image_id(*img)));
+				return static_cast<bool>(nk_button_image(*ctx, *img));
 			};
 
 		context["ButtonSymLbl"] = 
@@ -660,14 +678,14 @@ namespace proto
 			};
 
 		context["ButtonImgLbl"] = 
-			[](sol::optional<nk_context*> ctx, sol::optional<int> img, sol::optional<std::string_view> text, sol::optional<nk_flags> flags) -> bool
+			[](sol::optional<nk_context*> ctx, sol::optional<struct nk_image> img, sol::optional<std::string_view> text, sol::optional<nk_flags> flags) -> bool
 			{
 				if(!ctx) { throw std::runtime_error{"No UI context provided. Please call function with a ':' or pass Ctx as 1st arg."}; }
 				if(!text) { throw std::runtime_error{"No text string provided."}; }
-				if(!img) { throw std::runtime_error{"No image id provided."}; }
+				if(!img) { throw std::runtime_error{"No image provided."}; }
 				
 				const auto& str = text.value();
-				return static_cast<bool>(nk_button_image_text(*ctx, nk_image_id(*img), str.data(), static_cast<int>(str.size()), flags.value_or(NK_TEXT_CENTERED)));
+				return static_cast<bool>(nk_button_image_text(*ctx, *img, str.data(), static_cast<int>(str.size()), flags.value_or(NK_TEXT_CENTERED)));
 			};
 
 		//context["ButtonLblSty"] = nk_button_label_styled;
@@ -751,15 +769,15 @@ namespace proto
 			};
 
 		context["SelectableImgLbl"] = 
-			[](sol::optional<nk_context*> ctx, sol::optional<int> img, sol::optional<std::string_view> text, sol::optional<nk_flags> flags, sol::optional<int*> value) -> bool
+			[](sol::optional<nk_context*> ctx, sol::optional<struct nk_image> img, sol::optional<std::string_view> text, sol::optional<nk_flags> flags, sol::optional<int*> value) -> bool
 			{
 				if(!ctx) { throw std::runtime_error{"No UI context provided. Please call function with a ':' or pass Ctx as 1st arg."}; }
 				if(!text) { throw std::runtime_error{"No text string provided."}; }
-				if(!img) { throw std::runtime_error{"No image id provided."}; }
+				if(!img) { throw std::runtime_error{"No image provided."}; }
 				if(!value) { throw std::runtime_error{"Not value pointer provided."}; }
 				
 				const auto& str = text.value();
-				return static_cast<bool>(nk_selectable_image_text(*ctx, nk_image_id(*img), str.data(), static_cast<int>(str.size()), flags.value_or(NK_TEXT_CENTERED), *value));
+				return static_cast<bool>(nk_selectable_image_text(*ctx, *img, str.data(), static_cast<int>(str.size()), flags.value_or(NK_TEXT_CENTERED), *value));
 			};
 
 		context["SelectableSymLbl"] = 
@@ -789,7 +807,7 @@ namespace proto
 			{
 				if(!ctx) { throw std::runtime_error{"No UI context provided. Please call function with a ':' or pass Ctx as 1st arg."}; }
 				if(!text) { throw std::runtime_error{"No text string provided."}; }
-				if(!img) { throw std::runtime_error{"No image id provided."}; }
+				if(!img) { throw std::runtime_error{"No image provided."}; }
 				
 				const auto& str = text.value();
 				return static_cast<bool>(nk_select_image_text(*ctx, *img, str.data(), static_cast<int>(str.size()), flags.value_or(NK_TEXT_CENTERED), nk_bool{value.value_or(0)}));
@@ -956,14 +974,14 @@ namespace proto
 			};
 
 		context["ContextItemImgLbl"] = 
-			[](sol::optional<nk_context*> ctx, sol::optional<int> img, sol::optional<std::string_view> text, sol::optional<nk_flags> flags) -> bool
+			[](sol::optional<nk_context*> ctx, sol::optional<struct nk_image> img, sol::optional<std::string_view> text, sol::optional<nk_flags> flags) -> bool
 			{
 				if(!ctx) { throw std::runtime_error{"No UI context provided. Please call function with a ':' or pass Ctx as 1st arg."}; }
 				if(!text) { throw std::runtime_error{"No text string provided."}; }
-				if(!img) { throw std::runtime_error{"No image id provided."}; }
+				if(!img) { throw std::runtime_error{"No image provided."}; }
 				
 				const auto& str = text.value();
-				return static_cast<bool>(nk_contextual_item_image_text(*ctx, nk_image_id(*img), str.data(), static_cast<int>(str.size()), flags.value_or(NK_TEXT_CENTERED)));
+				return static_cast<bool>(nk_contextual_item_image_text(*ctx, *img, str.data(), static_cast<int>(str.size()), flags.value_or(NK_TEXT_CENTERED)));
 			};
 
 		context["ContextItemSymLbl"] = 
@@ -1014,12 +1032,24 @@ namespace proto
 
 		// Styles
 
-		context["StylePushFont"] = [](sol::optional<nk_context*> ctx, sol::optional<FontStyle> style) -> bool {
+		// An optional height draws the style at that size, using its distance field font when there is one.
+		context["StylePushFont"] = [](sol::optional<nk_context*> ctx, sol::optional<FontStyle> style, sol::optional<float> height) -> bool {
 				if(!ctx) { throw std::runtime_error{"No UI context provided. Please call function with a ':' or pass Ctx as 1st arg."}; }
 				if (style)
 				{
-					const auto* host = Mapper::GetInstance();
-					return static_cast<bool>(nk_style_push_font(*ctx, &host->GetFont(*style)->handle));
+					auto* host = Mapper::GetInstance();
+					const nk_user_font* font = nullptr;
+
+					if(height)
+					{
+						font = host->GetFontAtHeight(*style, *height);
+					}
+					else if(const auto* baked = host->GetFont(*style))
+					{
+						font = &baked->handle;
+					}
+
+					return font != nullptr && static_cast<bool>(nk_style_push_font(*ctx, font));
 				}
 
 				return false;
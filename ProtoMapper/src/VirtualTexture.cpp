@@ -0,0 +1,452 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <VirtualTexture.hpp>
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <span>
+
+#include <Image.hpp>
+#include <stl/hash.hpp>
+#include <stl/mipmap.hpp>
+#include <stl/parallel.hpp>
+#include <stl/pixel_convert.hpp>
+
+namespace proto
+{
+	namespace
+	{
+		constexpr uint32_t CacheMagic = 0x54564D50u; // "PMVT"
+		constexpr uint32_t CacheVersion = 2u; // 2: premultiplied alpha.
+		constexpr size_t BytesPerPixel = 4uz;
+		constexpr size_t TileBytes = size_t{VirtualTexture::SlotSize} * size_t{VirtualTexture::SlotSize} * BytesPerPixel;
+
+		/*
+			Cache layout: the header, then every tile of every level from the finest level to the coarsest, each
+			level in row order. A tile is SlotSize x SlotSize RGBA pixels, border included, so it uploads in one go.
+		*/
+		struct CacheHeader
+		{
+			uint32_t magic = CacheMagic, version = CacheVersion;
+			uint64_t key = 0u;
+			uint32_t width = 0u, height = 0u, tileSize = VirtualTexture::TileSize, border = VirtualTexture::TileBorder, levels = 0u, tileCount = 0u;
+			uint64_t dataOffset = 0u;
+		};
+
+		// Halves the image until it fits in a single tile.
+		[[nodiscard]] std::vector<VirtualTexture::Level> BuildLevels(uint32_t width, uint32_t height)
+		{
+			auto levels = std::vector<VirtualTexture::Level>{};
+			auto first = 0u;
+
+			for(auto level = 0u;; ++level)
+			{
+				const auto w = std::max(width >> level, 1u), h = std::max(height >> level, 1u);
+				const auto tilesX = (w + VirtualTexture::TileSize - 1u) / VirtualTexture::TileSize;
+				const auto tilesY = (h + VirtualTexture::TileSize - 1u) / VirtualTexture::TileSize;
+
+				levels.push_back(VirtualTexture::Level{ .width = w, .height = h, .tilesX = tilesX, .tilesY = tilesY, .first = first });
+				first += tilesX * tilesY;
+
+				if(tilesX == 1u && tilesY == 1u) { break; }
+			}
+
+			return levels;
+		}
+
+		[[nodiscard]] uint64_t SourceKey(const std::filesystem::path& source)
+		{
+			auto error = std::error_code{};
+			const auto size = std::filesystem::file_size(source, error);
+			const auto modified = std::filesystem::last_write_time(source, error).time_since_epoch().count();
+
+			auto key = hash_combine(hash_combine(CacheVersion, VirtualTexture::TileSize), VirtualTexture::TileBorder);
+			key = hash_combine(key, hash_string(source.string()));
+			return hash_combine(hash_combine(key, size), static_cast<uint64_t>(modified));
+		}
+
+		[[nodiscard]] std::filesystem::path CacheFile(const std::filesystem::path& dir, uint64_t key)
+		{
+			auto name = std::array<char, 16uz>{};
+			const auto end = std::to_chars(name.data(), name.data() + name.size(), key, 16).ptr; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+			return dir / ("vt_" + std::string{name.data(), end} + ".bin");
+		}
+
+		[[nodiscard]] const CacheHeader* Validate(std::span<const std::byte> blob, uint64_t key)
+		{
+			if(blob.size() < sizeof(CacheHeader)) { return nullptr; }
+
+			const auto* header = reinterpret_cast<const CacheHeader*>(blob.data()); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+
+			if(header->magic != CacheMagic || header->version != CacheVersion || header->key != key) { return nullptr; }
+			if(header->tileSize != VirtualTexture::TileSize || header->border != VirtualTexture::TileBorder || header->width == 0u || header->height == 0u) { return nullptr; }
+
+			const auto levels = BuildLevels(header->width, header->height);
+			const auto tiles = levels.back().first + 1u;
+
+			if(header->levels != levels.size() || header->tileCount != tiles) { return nullptr; }
+			if(header->dataOffset > blob.size() || size_t{tiles} * TileBytes > blob.size() - header->dataOffset) { return nullptr; }
+
+			return header;
+		}
+
+		// Copies one tile and its border out of a level, clamping at the edges of the image.
+		void CopyTile(std::span<const uint8_t> src, const VirtualTexture::Level& level, uint32_t tx, uint32_t ty, std::span<uint8_t> dst)
+		{
+			const auto left = static_cast<int64_t>(tx * VirtualTexture::TileSize) - VirtualTexture::TileBorder;
+			const auto top = static_cast<int64_t>(ty * VirtualTexture::TileSize) - VirtualTexture::TileBorder;
+			const auto width = static_cast<int64_t>(level.width), height = static_cast<int64_t>(level.height);
+			const auto slot = static_cast<int64_t>(VirtualTexture::SlotSize);
+
+			// The columns that exist in the image are copied as one run, the rest repeat the edge pixel.
+			const auto runStart = std::clamp(left, int64_t{0}, width - 1), runEnd = std::clamp(left + slot, int64_t{1}, width);
+
+			for(auto row = int64_t{0}; row < slot; ++row)
+			{
+				const auto sy = std::clamp(top + row, int64_t{0}, height - 1);
+				const auto* line = src.data() + (static_cast<size_t>(sy * width) * BytesPerPixel); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+				auto* out = dst.data() + (static_cast<size_t>(row * slot) * BytesPerPixel); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+				for(auto col = int64_t{0}; col < slot; ++col)
+				{
+					const auto sx = left + col;
+
+					if(sx >= runStart && sx < runEnd)
+					{
+						std::memcpy(out + (col * 4), line + (sx * 4), static_cast<size_t>(runEnd - sx) * BytesPerPixel); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+						col += runEnd - sx - 1;
+						continue;
+					}
+
+					std::memcpy(out + (col * 4), line + (std::clamp(sx, int64_t{0}, width - 1) * 4), BytesPerPixel); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+				}
+			}
+		}
+
+		// Runs on a worker thread. Returns the cache file, or an empty path if the source could not be read.
+		[[nodiscard]] std::filesystem::path BuildCache(const std::filesystem::path& source, const std::filesystem::path& cacheDir)
+		{
+			const auto key = SourceKey(source);
+			const auto cacheFile = CacheFile(cacheDir, key);
+
+			if(const auto existing = MappedFile{cacheFile}; existing.IsOpen() && Validate(existing.Bytes(), key) != nullptr)
+			{
+				return cacheFile;
+			}
+
+			auto image = Image{};
+			if(!image.Load(source)) { return {}; }
+
+			const auto levels = BuildLevels(image.Width(), image.Height());
+
+			auto header = CacheHeader{};
+			header.key = key;
+			header.width = image.Width();
+			header.height = image.Height();
+			header.levels = static_cast<uint32_t>(levels.size());
+			header.tileCount = levels.back().first + 1u;
+			header.dataOffset = (sizeof(CacheHeader) + 63uz) & ~63uz;
+
+			auto error = std::error_code{};
+			std::filesystem::create_directories(cacheDir, error);
+
+			// Write to a temporary first so a crash never leaves a half written cache behind.
+			auto temp = cacheFile;
+			temp += ".tmp";
+
+			{
+				auto out = std::ofstream{temp, std::ios::binary | std::ios::trunc};
+				if(!out) { return {}; }
+
+				out.write(reinterpret_cast<const char*>(&header), sizeof(header)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+				out.seekp(static_cast<std::streamoff>(header.dataOffset));
+
+				// Only the current level and the next one are held in memory, the source itself may be mapped.
+				auto pixels = std::span<const uint8_t>{image.Data()};
+				auto owned = std::vector<uint8_t>{};
+				auto row = std::vector<uint8_t>{};
+
+				for(auto l = 0uz; l < levels.size(); ++l)
+				{
+					const auto& level = levels[l];
+					row.resize(size_t{level.tilesX} * TileBytes);
+
+					for(auto ty = 0u; ty < level.tilesY; ++ty)
+					{
+						parallel_for(level.tilesX, [&](size_t first, size_t last) {
+							for(auto tx = first; tx < last; ++tx)
+							{
+								const auto tile = std::span{row}.subspan(tx * TileBytes, TileBytes);
+
+								// Premultiplied here rather than up front, so a mapped source is never copied whole.
+								CopyTile(pixels, level, static_cast<uint32_t>(tx), ty, tile);
+								premultiply_alpha(tile);
+							}
+						}, 1uz);
+
+						out.write(reinterpret_cast<const char*>(row.data()), static_cast<std::streamsize>(row.size())); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+					}
+
+					if(l + 1uz < levels.size())
+					{
+						const auto& next = levels[l + 1uz];
+						auto reduced = std::vector<uint8_t>(size_t{next.width} * size_t{next.height} * BytesPerPixel);
+
+						downsample_box(pixels, level.width, level.height, reduced);
+						owned = std::move(reduced);
+						pixels = owned;
+
+						// The full resolution source is no longer needed once the first level is written.
+						image.Clear();
+					}
+				}
+
+				if(!out) { return {}; }
+			}
+
+			std::filesystem::rename(temp, cacheFile, error);
+			return error ? std::filesystem::path{} : cacheFile;
+		}
+	}
+
+	VirtualTexture::VirtualTexture(TextureUploader& uploads)
+		: _uploads(&uploads)
+	{
+	}
+
+	VirtualTexture::~VirtualTexture()
+	{
+		if(_pending.valid()) { _pending.wait(); }
+
+		// Queued tiles read from the mapping and call back into this object.
+		_uploads->Finish();
+
+		if(_page.Valid()) { _page.Destroy(); }
+	}
+
+	void VirtualTexture::Begin(std::filesystem::path source, std::filesystem::path cacheDir)
+	{
+		_pending = thread_pool::shared().async([source = std::move(source), cacheDir = std::move(cacheDir)]() {
+			return BuildCache(source, cacheDir);
+		});
+	}
+
+	bool VirtualTexture::Open(const std::filesystem::path& cacheFile)
+	{
+		if(cacheFile.empty() || !_cache.Open(cacheFile)) { return false; }
+
+		// The key was checked when the cache was built, here only the layout matters.
+		const auto* header = reinterpret_cast<const CacheHeader*>(_cache.Bytes().data()); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+		if(_cache.Size() < sizeof(CacheHeader) || Validate(_cache.Bytes(), header->key) == nullptr) { _cache.Close(); return false; }
+
+		_width = header->width;
+		_height = header->height;
+		_dataOffset = header->dataOffset;
+		_levels = BuildLevels(_width, _height);
+		_slots.assign(size_t{PageSlots} * size_t{PageSlots}, Slot{});
+		_resident.clear();
+
+		// The page holds tiles of every level side by side, so its levels come from the cache rather than a mip chain.
+		_page.Create().Allocate(static_cast<int>(PageExtent), static_cast<int>(PageExtent)).SetSampling(Sampling::Bilinear);
+
+		_quads.Generate(0uz, 0uz);
+
+		// The coarsest level is a single tile, keeping it resident means there is always something to draw.
+		Upload(_levels.back().first, 0u, true);
+
+		return true;
+	}
+
+	void VirtualTexture::Update(const glm::vec4& visible, float texelsPerPixel)
+	{
+		if(!_page.Valid())
+		{
+			if(!_pending.valid() || _pending.wait_for(std::chrono::seconds{0}) != std::future_status::ready) { return; }
+
+			if(const auto cacheFile = _pending.get(); !Open(cacheFile))
+			{
+#ifdef _DEBUG_
+				std::puts("Could not open the virtual texture cache.");
+#endif // _DEBUG_
+				return;
+			}
+		}
+
+		++_frame;
+		_visible.clear();
+		_requests.clear();
+
+		const auto maxLevel = static_cast<uint32_t>(_levels.size() - 1uz);
+		const auto level = (texelsPerPixel <= 1.0f) ? 0u : std::min(static_cast<uint32_t>(std::log2(texelsPerPixel)), maxLevel);
+
+		const auto& info = _levels[level];
+		const auto tileExtent = static_cast<float>(TileSize << level);
+
+		if(visible.x >= static_cast<float>(_width) || visible.y >= static_cast<float>(_height) || visible.x + visible.z <= 0.0f || visible.y + visible.w <= 0.0f) { return; }
+
+		const auto first = [tileExtent](float pos, uint32_t tiles) { return std::min(static_cast<uint32_t>(std::max(pos, 0.0f) / tileExtent), tiles - 1u); };
+
+		const auto x0 = first(visible.x, info.tilesX), x1 = first(visible.x + visible.z, info.tilesX);
+		const auto y0 = first(visible.y, info.tilesY), y1 = first(visible.y + visible.w, info.tilesY);
+
+		for(auto y = y0; y <= y1; ++y)
+		{
+			for(auto x = x0; x <= x1; ++x)
+			{
+				const auto ref = TileRef{ .level = level, .x = x, .y = y };
+				_visible.push_back(ref);
+
+				if(!_resident.contains(TileIndex(ref))) { _requests.push_back(ref); }
+
+				// Keep whatever this tile is drawn from resident, it may be an ancestor.
+				if(const auto drawn = ResidentAncestor(ref))
+				{
+					_slots[_resident.find(TileIndex(*drawn))->second].lastUsed = _frame;
+				}
+			}
+		}
+
+		// Fill in from the middle of the view outwards.
+		const auto cx = static_cast<int64_t>(x0 + x1), cy = static_cast<int64_t>(y0 + y1);
+
+		std::ranges::sort(_requests, {}, [cx, cy](const TileRef& ref) {
+			const auto dx = (static_cast<int64_t>(ref.x) * 2) - cx, dy = (static_cast<int64_t>(ref.y) * 2) - cy;
+			return (dx * dx) + (dy * dy);
+		});
+
+		auto uploaded = 0uz;
+
+		for(; uploaded < std::min<size_t>(_uploadBudget, _requests.size()); ++uploaded)
+		{
+			const auto slot = FindSlot();
+			if(!slot) { break; }
+
+			Upload(TileIndex(_requests[uploaded]), *slot);
+		}
+
+		_requests.erase(_requests.begin(), _requests.begin() + static_cast<ptrdiff_t>(uploaded));
+	}
+
+	std::optional<uint32_t> VirtualTexture::FindSlot() const
+	{
+		auto best = std::optional<uint32_t>{};
+
+		for(auto i = 0u; i < _slots.size(); ++i)
+		{
+			const auto& slot = _slots[i];
+			if(slot.tile == NoTile) { return i; }
+
+			// Never evict a tile drawn this frame, or one whose upload is still queued.
+			if(slot.pinned || slot.loading || slot.lastUsed == _frame) { continue; }
+
+			if(!best || slot.lastUsed < _slots[*best].lastUsed) { best = i; }
+		}
+
+		return best;
+	}
+
+	void VirtualTexture::Upload(uint32_t tile, uint32_t slot, bool pinned)
+	{
+		auto& target = _slots[slot];
+
+		if(target.tile != NoTile) { _resident.erase(target.tile); }
+
+		target = Slot{ .tile = tile, .lastUsed = _frame, .pinned = pinned, .loading = true };
+		_resident.insert_or_assign(tile, slot);
+
+		// The mapping stays open as long as this object, which finishes every queued upload before it goes.
+		const auto* pixels = reinterpret_cast<const uint8_t*>(_cache.Bytes().data() + _dataOffset + (size_t{tile} * TileBytes)); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic, cppcoreguidelines-pro-type-reinterpret-cast)
+		const auto x = static_cast<int>((slot % PageSlots) * SlotSize), y = static_cast<int>((slot / PageSlots) * SlotSize);
+
+		_uploads->Upload(ImageView{ nullptr, pixels, SlotSize, SlotSize, size_t{SlotSize} * BytesPerPixel }, _page, x, y, [this, slot](Texture2D) {
+			_slots[slot].loading = false;
+		});
+	}
+
+	std::optional<VirtualTexture::TileRef> VirtualTexture::ResidentAncestor(TileRef ref) const
+	{
+		for(; ref.level < _levels.size(); ++ref.level, ref.x >>= 1u, ref.y >>= 1u)
+		{
+			if(const auto found = _resident.find(TileIndex(ref)); found != _resident.end() && !_slots[found->second].loading) { return ref; }
+		}
+
+		return std::nullopt;
+	}
+
+	std::optional<DrawCall> VirtualTexture::Compile()
+	{
+		if(!_page.Valid() || _visible.empty()) { return std::nullopt; }
+
+		_vertices.clear();
+		_indices.clear();
+
+		const auto white = glm::vec4{ 1.0f };
+		const auto extent = static_cast<float>(PageExtent);
+
+		for(const auto& ref : _visible)
+		{
+			const auto drawn = ResidentAncestor(ref);
+			if(!drawn) { continue; }
+
+			const auto& level = _levels[ref.level];
+			const auto scale = static_cast<float>(1u << ref.level);
+
+			// The part of this tile that is inside the image, in texels of its own level.
+			const auto left = ref.x * TileSize, top = ref.y * TileSize;
+			const auto w = std::min(TileSize, level.width - left), h = std::min(TileSize, level.height - top);
+
+			/*
+				Coarse levels round their size down, so an odd sized image has pixels past the last texel of the level.
+				Tiles on the level's right and bottom edges stretch to the image's own edges to cover them.
+			*/
+			const auto x0 = static_cast<float>(left) * scale, y0 = static_cast<float>(top) * scale;
+			const auto x1 = left + w == level.width ? static_cast<float>(_width) : std::min(static_cast<float>(left + w) * scale, static_cast<float>(_width));
+			const auto y1 = top + h == level.height ? static_cast<float>(_height) : std::min(static_cast<float>(top + h) * scale, static_cast<float>(_height));
+
+			// The same area in texels of the tile it is drawn from.
+			const auto shrink = static_cast<float>(1u << (drawn->level - ref.level));
+			const auto slot = _resident.find(TileIndex(*drawn))->second;
+
+			const auto originX = static_cast<float>(((slot % PageSlots) * SlotSize) + TileBorder) - static_cast<float>(drawn->x * TileSize);
+			const auto originY = static_cast<float>(((slot / PageSlots) * SlotSize) + TileBorder) - static_cast<float>(drawn->y * TileSize);
+
+			const auto u0 = (originX + (static_cast<float>(left) / shrink)) / extent, u1 = (originX + (static_cast<float>(left + w) / shrink)) / extent;
+			const auto v0 = (originY + (static_cast<float>(top) / shrink)) / extent, v1 = (originY + (static_cast<float>(top + h) / shrink)) / extent;
+
+			const auto base = static_cast<uint32_t>(_vertices.size());
+
+			_vertices.push_back(Vertex2D{ .pos = { x0, y0 }, .texCoords = { u0, v0 }, .color = white });
+			_vertices.push_back(Vertex2D{ .pos = { x1, y0 }, .texCoords = { u1, v0 }, .color = white });
+			_vertices.push_back(Vertex2D{ .pos = { x1, y1 }, .texCoords = { u1, v1 }, .color = white });
+			_vertices.push_back(Vertex2D{ .pos = { x0, y1 }, .texCoords = { u0, v1 }, .color = white });
+
+			for(const auto index : { 0u, 1u, 2u, 2u, 3u, 0u }) { _indices.push_back(base + index); }
+		}
+
+		_quads.Clear();
+		_quads.AddValues(_vertices, _indices).WriteData();
+
+		return DrawCall{ .buffer = _quads.VAO(), .drawMode = GL_TRIANGLES, .elemCount = static_cast<int32_t>(_indices.size()), .offset = 0u, .texture = _page };
+	}
+}
@@ -0,0 +1,176 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <autotile.hpp>
+#include <algorithm>
+#include <array>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+
+namespace
+{
+    // Spells a canonical mask out as a pattern, '0' where a neighbour must differ.
+    std::string pattern_of(uint8_t mask)
+    {
+        const auto bit = [mask](uint8_t b) { return (mask & b) != 0u ? '1' : '0'; };
+
+        return { bit(proto::autotile_nw), bit(proto::autotile_n), bit(proto::autotile_ne), '/',
+                 bit(proto::autotile_w), '.', bit(proto::autotile_e), '/',
+                 bit(proto::autotile_sw), bit(proto::autotile_s), bit(proto::autotile_se) };
+    }
+}
+
+TEST_CASE("Canonical masks", "[autotile]")
+{
+    static_assert(proto::autotile_blob_masks.front() == 0u);
+    static_assert(proto::autotile_blob_masks.back() == 255u);
+
+    auto blob = std::set<uint8_t>{}, edges = std::set<uint8_t>{};
+
+    for(auto mask = 0u; mask < 256u; ++mask)
+    {
+        blob.insert(proto::autotile_canonical(proto::autotile_mode::blob47, static_cast<uint8_t>(mask)));
+        edges.insert(proto::autotile_canonical(proto::autotile_mode::edges4, static_cast<uint8_t>(mask)));
+    }
+
+    REQUIRE(blob.size() == 47uz);
+    REQUIRE(edges.size() == 16uz);
+    REQUIRE(std::ranges::equal(blob, proto::autotile_blob_masks));
+
+    // A corner without both of its edges is dropped.
+    REQUIRE(proto::autotile_canonical(proto::autotile_mode::blob47, proto::autotile_ne | proto::autotile_n) == proto::autotile_n);
+    REQUIRE(proto::autotile_canonical(proto::autotile_mode::blob47, proto::autotile_ne | proto::autotile_n | proto::autotile_e) ==
+            (proto::autotile_ne | proto::autotile_n | proto::autotile_e));
+}
+
+TEST_CASE("Rule patterns", "[autotile]")
+{
+    const auto rule = proto::parse_autotile_rule("*1* / 1.1 / *0*", 7u);
+
+    REQUIRE(rule.has_value());
+    REQUIRE(rule->same == (proto::autotile_n | proto::autotile_w | proto::autotile_e));
+    REQUIRE(rule->other == proto::autotile_s);
+    REQUIRE(rule->tile == 7u);
+
+    REQUIRE(proto::parse_autotile_rule("*********", 1u).has_value());
+    REQUIRE_FALSE(proto::parse_autotile_rule("*1*/1.1", 1u).has_value());
+    REQUIRE_FALSE(proto::parse_autotile_rule("*1*/1.1/*0**", 1u).has_value());
+    REQUIRE_FALSE(proto::parse_autotile_rule("*1*/101/*0*", 1u).has_value());
+    REQUIRE_FALSE(proto::parse_autotile_rule("*1*/1.x/*0*", 1u).has_value());
+}
+
+TEST_CASE("Standard layouts and compiled rules agree", "[autotile]")
+{
+    for(const auto mode : { proto::autotile_mode::edges4, proto::autotile_mode::blob47 })
+    {
+        const auto standard = proto::autotile_lut::standard(mode, 100u);
+
+        auto used = std::set<uint32_t>(standard.tiles().begin(), standard.tiles().end());
+        REQUIRE(used.size() == (mode == proto::autotile_mode::edges4 ? 16uz : 47uz));
+        REQUIRE(*used.begin() == 100u);
+        REQUIRE(standard.interior() == *used.rbegin());
+
+        // One exact rule per canonical mask, spelled out as text, gives the same table.
+        auto rules = std::vector<proto::autotile_rule>{};
+        for(auto mask = 0u; mask < 256u; ++mask)
+        {
+            const auto canonical = proto::autotile_canonical(mode, static_cast<uint8_t>(mask));
+            if(canonical != mask) { continue; }
+
+            auto text = pattern_of(canonical);
+
+            // Corners edges4 ignores may be anything.
+            if(mode == proto::autotile_mode::edges4) { for(const auto i : { 0uz, 2uz, 8uz, 10uz }) { text[i] = '*'; } }
+
+            rules.push_back(*proto::parse_autotile_rule(text, standard[canonical]));
+        }
+
+        const auto compiled = proto::autotile_lut::compile(mode, rules, 0u);
+        REQUIRE(std::ranges::equal(compiled.tiles(), standard.tiles()));
+    }
+
+    // First match wins, the rest falls back.
+    const auto rules = std::array{ *proto::parse_autotile_rule("*1*/*.*/***", 1u), *proto::parse_autotile_rule("***/*.*/*1*", 2u) };
+    const auto lut = proto::autotile_lut::compile(proto::autotile_mode::edges4, rules, 9u);
+
+    REQUIRE(lut[proto::autotile_n | proto::autotile_s] == 1u);
+    REQUIRE(lut[proto::autotile_s] == 2u);
+    REQUIRE(lut[proto::autotile_e | proto::autotile_ne] == 9u);
+}
+
+TEST_CASE("Neighbour masks", "[autotile]")
+{
+    // A plus shape: the centre sees its four edges, the top arm only its south.
+    const auto filled = [](int64_t x, int64_t y) { return (x == 1 && y >= 0 && y <= 2) || (y == 1 && x >= 0 && x <= 2); };
+
+    REQUIRE(proto::autotile_mask(1, 1, filled) == proto::autotile_edges);
+    REQUIRE(proto::autotile_mask(1, 0, filled) == (proto::autotile_s | proto::autotile_se | proto::autotile_sw));
+    REQUIRE(proto::autotile_canonical(proto::autotile_mode::blob47, proto::autotile_mask(1, 0, filled)) == proto::autotile_s);
+}
+
+TEST_CASE("Autotile benchmark", "[autotile], [!benchmark]")
+{
+    constexpr auto side = 1024;
+
+    auto engine = std::mt19937{ 1u };
+    auto terrain = std::vector<uint8_t>(static_cast<size_t>(side) * side);
+    for(auto& cell : terrain) { cell = engine() % 4u != 0u ? 1u : 0u; }
+
+    const auto same = [&](int64_t x, int64_t y) {
+        return x < 0 || y < 0 || x >= side || y >= side || terrain[static_cast<size_t>((y * side) + x)] != 0u;
+    };
+
+    const auto lut = proto::autotile_lut::standard(proto::autotile_mode::blob47, 1u);
+
+    auto rules = std::vector<proto::autotile_rule>{};
+    for(const auto mask : proto::autotile_blob_masks) { rules.push_back(*proto::parse_autotile_rule(pattern_of(mask), lut[mask])); }
+
+    BENCHMARK("tile 1024^2: rules per cell")
+    {
+        auto sum = uint64_t{0u};
+        for(auto y = 0; y < side; ++y)
+        {
+            for(auto x = 0; x < side; ++x)
+            {
+                const auto canonical = proto::autotile_canonical(proto::autotile_mode::blob47, proto::autotile_mask(x, y, same));
+                for(const auto& rule : rules)
+                {
+                    if(rule.matches(canonical)) { sum += rule.tile; break; }
+                }
+            }
+        }
+        return sum;
+    };
+
+    BENCHMARK("tile 1024^2: lut")
+    {
+        auto sum = uint64_t{0u};
+        for(auto y = 0; y < side; ++y)
+        {
+            for(auto x = 0; x < side; ++x) { sum += lut[proto::autotile_mask(x, y, same)]; }
+        }
+        return sum;
+    };
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
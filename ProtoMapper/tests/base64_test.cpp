@@ -0,0 +1,111 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <base64.hpp>
+#include <random>
+#include <vector>
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+
+namespace
+{
+    std::vector<uint8_t> bytes_of(std::string_view text) { return { text.begin(), text.end() }; }
+
+    std::string decode_text(std::string_view encoded)
+    {
+        auto out = std::vector<uint8_t>(proto::base64_decoded_size(encoded.size()));
+        const auto size = proto::base64_decode(encoded, out);
+
+        REQUIRE(size.has_value());
+        return { out.begin(), out.begin() + static_cast<std::ptrdiff_t>(*size) };
+    }
+}
+
+TEST_CASE("base64 matches the RFC 4648 test vectors", "[base64]")
+{
+    const auto vectors = std::vector<std::pair<std::string_view, std::string_view>>{
+        { "", "" }, { "f", "Zg==" }, { "fo", "Zm8=" }, { "foo", "Zm9v" },
+        { "foob", "Zm9vYg==" }, { "fooba", "Zm9vYmE=" }, { "foobar", "Zm9vYmFy" },
+    };
+
+    for(const auto& [plain, encoded] : vectors)
+    {
+        REQUIRE(proto::base64_encode(bytes_of(plain)) == encoded);
+        REQUIRE(decode_text(encoded) == plain);
+    }
+}
+
+TEST_CASE("base64 decode skips whitespace and rejects bad input", "[base64]")
+{
+    REQUIRE(decode_text("\n   Zm9v\n   YmFy\n  ") == "foobar");
+    REQUIRE(decode_text("Zm8=\n") == "fo");
+
+    auto out = std::vector<uint8_t>(16uz);
+    REQUIRE_FALSE(proto::base64_decode("Zm9v!", out).has_value());
+    REQUIRE_FALSE(proto::base64_decode("Zm9", out).has_value());
+    REQUIRE_FALSE(proto::base64_decode("Zg==Zm9v", out).has_value());
+    REQUIRE_FALSE(proto::base64_decode("Z===", out).has_value());
+
+    auto small = std::vector<uint8_t>(2uz);
+    REQUIRE_FALSE(proto::base64_decode("Zm9v", small).has_value());
+
+    auto tiny = std::vector<char>(3uz);
+    REQUIRE_THROWS_AS(proto::base64_encode(bytes_of("f"), tiny), std::invalid_argument);
+}
+
+TEST_CASE("base64 round trips random data", "[base64]")
+{
+    auto engine = std::mt19937{ 3u };
+
+    for(const auto size : { 1uz, 2uz, 3uz, 100uz, 4097uz })
+    {
+        auto data = std::vector<uint8_t>(size);
+        for(auto& byte : data) { byte = static_cast<uint8_t>(engine()); }
+
+        const auto encoded = proto::base64_encode(data);
+        auto decoded = std::vector<uint8_t>(proto::base64_decoded_size(encoded.size()));
+        const auto written = proto::base64_decode(encoded, decoded);
+
+        REQUIRE(written == size);
+        decoded.resize(size);
+        REQUIRE(decoded == data);
+    }
+}
+
+TEST_CASE("base64 throughput", "[base64], [!benchmark]")
+{
+    auto data = std::vector<uint8_t>(16uz << 20uz);
+    auto engine = std::mt19937{ 5u };
+    for(auto& byte : data) { byte = static_cast<uint8_t>(engine()); }
+
+    const auto encoded = proto::base64_encode(data);
+    auto decoded = std::vector<uint8_t>(data.size());
+
+    BENCHMARK("encode 16 MiB")
+    {
+        return proto::base64_encode(data).size();
+    };
+
+    BENCHMARK("decode 16 MiB")
+    {
+        return proto::base64_decode(encoded, decoded);
+    };
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
@@ -0,0 +1,186 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <bit_grid.hpp>
+#include <random>
+#include <vector>
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+
+namespace
+{
+    proto::bit_grid random_grid(size_t width, size_t height, uint32_t seed, uint32_t percent)
+    {
+        auto engine = std::mt19937{ seed };
+        auto grid = proto::bit_grid{ width, height };
+
+        for(auto y = 0uz; y < height; ++y)
+        {
+            for(auto x = 0uz; x < width; ++x)
+            {
+                grid.set(x, y, engine() % 100u < percent);
+            }
+        }
+
+        return grid;
+    }
+
+    // Cell by cell reference for the square structuring element.
+    proto::bit_grid naive_morph(const proto::bit_grid& grid, size_t radius, bool shrink)
+    {
+        auto out = proto::bit_grid{ grid.width(), grid.height() };
+        const auto r = static_cast<long>(radius);
+
+        for(auto y = 0l; y < static_cast<long>(grid.height()); ++y)
+        {
+            for(auto x = 0l; x < static_cast<long>(grid.width()); ++x)
+            {
+                auto any = false, all = true;
+
+                for(auto dy = -r; dy <= r; ++dy)
+                {
+                    for(auto dx = -r; dx <= r; ++dx)
+                    {
+                        const auto nx = x + dx, ny = y + dy;
+                        const auto inside = nx >= 0 && ny >= 0 && nx < static_cast<long>(grid.width()) && ny < static_cast<long>(grid.height());
+                        const auto value = inside ? grid.test(static_cast<size_t>(nx), static_cast<size_t>(ny)) : shrink;
+
+                        any = any || value;
+                        all = all && value;
+                    }
+                }
+
+                out.set(static_cast<size_t>(x), static_cast<size_t>(y), shrink ? all : any);
+            }
+        }
+
+        return out;
+    }
+}
+
+TEST_CASE("bit_grid set, count and padding", "[bit_grid]")
+{
+    auto grid = proto::bit_grid{ 130uz, 7uz };
+
+    REQUIRE(grid.words_per_row() == 4uz);
+    REQUIRE(grid.count() == 0uz);
+
+    grid.fill(true);
+    REQUIRE(grid.count() == 130uz * 7uz);
+    REQUIRE(grid.count_row(3uz) == 130uz);
+
+    grid.reset(129uz, 6uz);
+    grid.flip(0uz, 0uz);
+    REQUIRE_FALSE(grid.test(129uz, 6uz));
+    REQUIRE_FALSE(grid.at(0uz, 0uz));
+    REQUIRE_THROWS(grid.at(130uz, 0uz));
+
+    grid.invert();
+    REQUIRE(grid.count() == 2uz);
+
+    grid.fill_rect(60uz, 2uz, 10uz, 3uz, true);
+    REQUIRE(grid.count_rect(0uz, 0uz, 200uz, 200uz) == grid.count());
+    REQUIRE(grid.count_rect(60uz, 2uz, 10uz, 3uz) == 30uz);
+    REQUIRE(grid.count_rect(64uz, 3uz, 2uz, 1uz) == 2uz);
+}
+
+TEST_CASE("bit_grid row and column scans", "[bit_grid]")
+{
+    auto grid = proto::bit_grid{ 300uz, 50uz };
+    grid.set(5uz, 10uz);
+    grid.set(257uz, 10uz);
+    grid.set(257uz, 40uz);
+
+    REQUIRE(grid.next_set(0uz, 10uz) == 5uz);
+    REQUIRE(grid.next_set(6uz, 10uz) == 257uz);
+    REQUIRE(grid.next_set(258uz, 10uz) == proto::bit_grid::npos);
+    REQUIRE(grid.next_clear(5uz, 10uz) == 6uz);
+    REQUIRE(grid.next_set_in_column(257uz, 11uz) == 40uz);
+    REQUIRE(grid.next_clear_in_column(5uz, 10uz) == 11uz);
+
+    grid.fill(true);
+    REQUIRE(grid.next_clear(0uz, 0uz) == proto::bit_grid::npos);
+}
+
+TEST_CASE("bit_grid dilation and erosion match a cell by cell reference", "[bit_grid]")
+{
+    for(const auto width : { 37uz, 64uz, 200uz })
+    {
+        const auto source = random_grid(width, 41uz, static_cast<uint32_t>(width), 15u);
+
+        for(const auto radius : { 1uz, 2uz, 5uz, 70uz })
+        {
+            auto dilated = source;
+            dilated.dilate(radius);
+            REQUIRE(dilated == naive_morph(source, radius, false));
+
+            auto eroded = random_grid(width, 41uz, static_cast<uint32_t>(width), 85u);
+            const auto expected = naive_morph(eroded, radius, true);
+            eroded.erode(radius);
+            REQUIRE(eroded == expected);
+        }
+    }
+}
+
+TEST_CASE("bit_grid combines grids of the same size", "[bit_grid]")
+{
+    const auto a = random_grid(100uz, 20uz, 1u, 50u);
+    const auto b = random_grid(100uz, 20uz, 2u, 50u);
+
+    auto both = a;
+    both &= b;
+    auto either = a;
+    either |= b;
+    auto onlyA = a;
+    onlyA.and_not(b);
+
+    REQUIRE(either.count() == a.count() + b.count() - both.count());
+    REQUIRE(onlyA.count() == a.count() - both.count());
+    REQUIRE_THROWS_AS(either |= proto::bit_grid(10uz, 10uz), std::invalid_argument);
+}
+
+TEST_CASE("bit_grid against std::vector<bool>", "[bit_grid], [!benchmark]")
+{
+    constexpr auto side = 1024uz;
+    const auto grid = random_grid(side, side, 7u, 30u);
+
+    auto bools = std::vector<bool>(side * side);
+    for(auto i = 0uz; i < bools.size(); ++i) { bools[i] = grid.test(i % side, i / side); }
+
+    BENCHMARK("count: std::vector<bool>")
+    {
+        auto total = 0uz;
+        for(const bool cell : bools) { total += cell ? 1uz : 0uz; }
+        return total;
+    };
+
+    BENCHMARK("count: bit_grid")
+    {
+        return grid.count();
+    };
+
+    BENCHMARK("dilate radius 2: bit_grid")
+    {
+        auto copy = grid;
+        copy.dilate(2uz);
+        return copy.count();
+    };
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
@@ -0,0 +1,290 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <cell_delta.hpp>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <span>
+#include <vector>
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+
+namespace
+{
+    constexpr auto chunk_side = 64uz;
+    constexpr auto chunk_area = chunk_side * chunk_side;
+
+    // A square grid stored as chunks in row order, the way TileLayer keeps its cells.
+    struct grid
+    {
+        size_t chunks = 0uz;
+        std::vector<uint32_t> cells;
+
+        explicit grid(size_t side) : chunks(side / chunk_side), cells(side * side) {}
+
+        [[nodiscard]] std::span<uint32_t> chunk(size_t index) { return std::span{ cells }.subspan(index * chunk_area, chunk_area); }
+        [[nodiscard]] std::span<const uint32_t> chunk(size_t index) const { return std::span{ cells }.subspan(index * chunk_area, chunk_area); }
+    };
+
+    // Per changed chunk: its index, its number of runs, then the runs. The journal's layout, keyed by chunk index.
+    std::vector<uint8_t> encode(const grid& before, const grid& after)
+    {
+        auto out = std::vector<uint8_t>{}, runs = std::vector<uint8_t>{};
+
+        for(auto c = 0uz; c < before.chunks * before.chunks; ++c)
+        {
+            runs.clear();
+
+            const auto count = proto::put_cell_delta(runs, before.chunk(c), after.chunk(c));
+            if(count == 0uz) { continue; }
+
+            proto::put_varint(out, c);
+            proto::put_varint(out, count);
+            out.insert(out.end(), runs.begin(), runs.end());
+        }
+
+        return out;
+    }
+
+    bool apply(grid& target, std::span<const uint8_t> data, bool redo)
+    {
+        auto reader = proto::varint_reader{ data };
+
+        while(!reader.done())
+        {
+            const auto index = reader.next();
+            const auto runs = reader.next();
+
+            if(index >= target.chunks * target.chunks) { return false; }
+            if(!proto::apply_cell_delta(reader, runs, target.chunk(index), redo)) { return false; }
+        }
+
+        return !reader.failed();
+    }
+
+    // Sets a square of cells, a brush dab.
+    void dab(grid& target, size_t side, size_t x0, size_t y0, size_t size, uint32_t value)
+    {
+        for(auto y = y0; y < std::min(y0 + size, side); ++y)
+        {
+            for(auto x = x0; x < std::min(x0 + size, side); ++x)
+            {
+                const auto chunk = ((y / chunk_side) * (side / chunk_side)) + (x / chunk_side);
+                target.chunk(chunk)[((y % chunk_side) * chunk_side) + (x % chunk_side)] = value;
+            }
+        }
+    }
+}
+
+TEST_CASE("Varints round trip and fail on truncated data", "[cell_delta]")
+{
+    const auto values = std::vector<uint64_t>{ 0u, 1u, 127u, 128u, 300u, 16'383u, 16'384u, 0xFFFF'FFFFu, ~uint64_t{0u} };
+
+    auto out = std::vector<uint8_t>{};
+    for(const auto value : values) { proto::put_varint(out, value); }
+
+    REQUIRE(out.size() == 1uz + 1uz + 1uz + 2uz + 2uz + 2uz + 3uz + 5uz + 10uz);
+
+    auto reader = proto::varint_reader{ out };
+    for(const auto value : values) { REQUIRE(reader.next() == value); }
+    REQUIRE(reader.done());
+    REQUIRE_FALSE(reader.failed());
+
+    // The last value loses its final byte.
+    auto cut = proto::varint_reader{ std::span{ out }.first(out.size() - 1uz) };
+    for(auto i = 0uz; i + 1uz < values.size(); ++i) { static_cast<void>(cut.next()); }
+
+    REQUIRE(cut.next() == 0u);
+    REQUIRE(cut.failed());
+    REQUIRE(cut.next() == 0u);
+
+    // Eleven continuation bytes are more than 64 bits.
+    const auto overlong = std::vector<uint8_t>(11uz, 0x80u);
+    auto wide = proto::varint_reader{ overlong };
+    static_cast<void>(wide.next());
+    REQUIRE(wide.failed());
+}
+
+TEST_CASE("Random edits undo and redo exactly", "[cell_delta]")
+{
+    auto engine = std::mt19937{ 5u };
+
+    for(auto trial = 0; trial < 50; ++trial)
+    {
+        auto before = std::vector<uint32_t>(chunk_area);
+        for(auto& cell : before) { cell = static_cast<uint32_t>(engine() % 4u); }
+
+        auto after = before;
+        for(auto edits = engine() % 200u; edits > 0u; --edits) { after[engine() % chunk_area] = static_cast<uint32_t>(engine() % 1'000'000u); }
+
+        auto data = std::vector<uint8_t>{};
+        const auto runs = proto::put_cell_delta(data, std::span<const uint32_t>{ before }, std::span<const uint32_t>{ after });
+
+        REQUIRE((runs == 0uz) == (before == after));
+        REQUIRE((runs == 0uz) == data.empty());
+
+        auto cells = after;
+        auto undo = proto::varint_reader{ data };
+        REQUIRE(proto::apply_cell_delta(undo, runs, std::span{ cells }, false));
+        REQUIRE(undo.done());
+        REQUIRE(cells == before);
+
+        auto redo = proto::varint_reader{ data };
+        REQUIRE(proto::apply_cell_delta(redo, runs, std::span{ cells }, true));
+        REQUIRE(cells == after);
+    }
+}
+
+TEST_CASE("A 1M cell fill is a few bytes per chunk", "[cell_delta]")
+{
+    constexpr auto side = 1024uz;
+
+    // Terrain bands, so the old side is not one value per chunk either.
+    auto before = grid{ side };
+    for(auto y = 0uz; y < side; ++y) { dab(before, side, 0uz, y, side, static_cast<uint32_t>(y / 100uz)); }
+
+    auto after = grid{ side };
+    std::ranges::fill(after.cells, 7u);
+
+    const auto data = encode(before, after);
+
+    // Every chunk changes, and its runs cover at most two bands.
+    REQUIRE(data.size() < 256uz * 32uz);
+
+    auto cells = after;
+    REQUIRE(apply(cells, data, false));
+    REQUIRE(cells.cells == before.cells);
+    REQUIRE(apply(cells, data, true));
+    REQUIRE(cells.cells == after.cells);
+
+    // Unchanged chunks cost nothing.
+    REQUIRE(encode(after, after).empty());
+}
+
+TEST_CASE("A coalesced stroke undoes as one and vanishes when it ends where it began", "[cell_delta]")
+{
+    constexpr auto side = 256uz;
+
+    auto original = grid{ side };
+    for(auto i = 0uz; i < original.cells.size(); ++i) { original.cells[i] = static_cast<uint32_t>((i / 97uz) % 3uz); }
+
+    // The journal keeps the chunks from before the first dab and re-encodes the whole stroke after each one.
+    auto current = original;
+    auto entry = std::vector<uint8_t>{};
+
+    for(auto step = 0uz; step < 40uz; ++step)
+    {
+        dab(current, side, step * 5uz, 40uz + (step % 7uz), 9uz, 9u);
+        entry = encode(original, current);
+    }
+
+    auto undone = current;
+    REQUIRE(apply(undone, entry, false));
+    REQUIRE(undone.cells == original.cells);
+
+    auto redone = original;
+    REQUIRE(apply(redone, entry, true));
+    REQUIRE(redone.cells == current.cells);
+
+    // Painting back over the stroke leaves nothing to record.
+    for(auto step = 0uz; step < 40uz; ++step)
+    {
+        for(auto y = 40uz + (step % 7uz); y < 49uz + (step % 7uz); ++y)
+        {
+            for(auto x = step * 5uz; x < std::min(step * 5uz + 9uz, side); ++x)
+            {
+                const auto chunk = ((y / chunk_side) * (side / chunk_side)) + (x / chunk_side);
+                const auto cell = ((y % chunk_side) * chunk_side) + (x % chunk_side);
+                current.chunk(chunk)[cell] = original.chunk(chunk)[cell];
+            }
+        }
+    }
+
+    REQUIRE(encode(original, current).empty());
+}
+
+TEST_CASE("Spilled entries read back from their offset", "[cell_delta]")
+{
+    constexpr auto side = 256uz;
+    const auto path = std::filesystem::temp_directory_path() / "proto_cell_delta_spill.bin";
+
+    auto states = std::vector<grid>(3uz, grid{ side });
+    dab(states[1], side, 10uz, 10uz, 100uz, 4u);
+    states[2] = states[1];
+    dab(states[2], side, 60uz, 0uz, 30uz, 5u);
+
+    const auto first = encode(states[0], states[1]), second = encode(states[1], states[2]);
+
+    // Appended one after the other, as the journal spills its oldest entries.
+    {
+        auto spill = std::ofstream{ path, std::ios::binary | std::ios::trunc };
+        spill.write(reinterpret_cast<const char*>(first.data()), static_cast<std::streamsize>(first.size())); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+        spill.write(reinterpret_cast<const char*>(second.data()), static_cast<std::streamsize>(second.size())); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+    }
+
+    const auto read_back = [&path](size_t offset, size_t size) {
+        auto data = std::vector<uint8_t>(size);
+        auto spill = std::ifstream{ path, std::ios::binary };
+        spill.seekg(static_cast<std::streamoff>(offset));
+        spill.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(size)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+        return data;
+    };
+
+    auto cells = states[2];
+    REQUIRE(apply(cells, read_back(first.size(), second.size()), false));
+    REQUIRE(cells.cells == states[1].cells);
+    REQUIRE(apply(cells, read_back(0uz, first.size()), false));
+    REQUIRE(cells.cells == states[0].cells);
+
+    // A short read is refused instead of half applied past the end.
+    auto damaged = states[2];
+    REQUIRE_FALSE(apply(damaged, read_back(first.size(), second.size() - 1uz), false));
+
+    auto error = std::error_code{};
+    std::filesystem::remove(path, error);
+}
+
+TEST_CASE("Cell delta benchmark", "[cell_delta], [!benchmark]")
+{
+    constexpr auto side = 1024uz;
+
+    auto before = grid{ side };
+    auto engine = std::mt19937{ 3u };
+    for(auto& cell : before.cells) { cell = static_cast<uint32_t>(engine() % 3u); }
+
+    auto after = grid{ side };
+    std::ranges::fill(after.cells, 7u);
+
+    const auto data = encode(before, after);
+    auto cells = after;
+
+    BENCHMARK("encode 1M cell fill over noise")
+    {
+        return encode(before, after).size();
+    };
+
+    BENCHMARK("undo 1M cell fill over noise")
+    {
+        return apply(cells, data, false);
+    };
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
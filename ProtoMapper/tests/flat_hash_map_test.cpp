@@ -0,0 +1,170 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <flat_hash_map.hpp>
+#include <array>
+#include <string>
+#include <unordered_map>
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+
+using namespace proto::literals;
+
+namespace
+{
+    enum class Style : uint8_t { Normal = 1u, Bold = 2u, Italic = 4u, BoldItalic = 6u };
+
+    constexpr auto icon_names = std::array<std::string_view, 5uz>{ "iconClose", "iconNew", "iconWindowMaximize", "iconWindowMinimize", "iconWindowRestore" };
+}
+
+TEST_CASE("flat_hash_map insert, find and erase", "[flat_hash_map]")
+{
+    auto map = proto::flat_hash_map<std::string, int>{};
+
+    for(auto i = 0; i < 1000; ++i)
+    {
+        map.try_emplace(std::to_string(i), i);
+    }
+
+    REQUIRE(map.size() == 1000uz);
+    REQUIRE(map.at("512") == 512);
+    REQUIRE_THROWS(map.at("1000"));
+    REQUIRE_FALSE(map.try_emplace(std::string{"3"}, 9).second);
+
+    for(auto i = 0; i < 1000; i += 2)
+    {
+        REQUIRE(map.erase(std::to_string(i)) == 1uz);
+    }
+
+    REQUIRE(map.size() == 500uz);
+    REQUIRE_FALSE(map.contains("10"));
+    REQUIRE(map.find("11")->second == 11);
+
+    auto count = 0uz;
+    for(const auto& [key, value] : map)
+    {
+        REQUIRE(std::stoi(key) == value);
+        ++count;
+    }
+
+    REQUIRE(count == 500uz);
+}
+
+TEST_CASE("flat_hash_map heterogeneous and compile-time hashed lookups", "[flat_hash_map], [hash]")
+{
+    static_assert("iconClose"_hs.hash() == proto::hash_string("iconClose"));
+
+    auto map = proto::flat_hash_map<std::string, int>{};
+    map.insert_or_assign("iconClose", 1);
+    map["iconNew"] = 2;
+
+    constexpr auto key = proto::hashed_string{"iconNew"};
+
+    REQUIRE(map.contains("iconClose"_hs));
+    REQUIRE(map.at(key) == 2);
+    REQUIRE(map.contains(std::string_view{"iconClose"}));
+    REQUIRE_FALSE(map.contains("iconOpen"_hs));
+}
+
+TEST_CASE("flat_hash_map with enum keys survives copies and moves", "[flat_hash_map]")
+{
+    auto map = proto::flat_hash_map<Style, int>{ { Style::Normal, 1 }, { Style::Bold, 2 } };
+    auto copy = map;
+    auto moved = std::move(map);
+
+    copy.erase(Style::Bold);
+
+    REQUIRE(moved.size() == 2uz);
+    REQUIRE(copy.size() == 1uz);
+    REQUIRE(map.empty()); // NOLINT(bugprone-use-after-move)
+    REQUIRE(moved.at(Style::Bold) == 2);
+}
+
+TEST_CASE("flat_hash_map against std::unordered_map", "[flat_hash_map], [!benchmark]")
+{
+    auto flatFonts = proto::flat_hash_map<Style, int>{ { Style::Normal, 1 }, { Style::Bold, 2 }, { Style::Italic, 3 }, { Style::BoldItalic, 4 } };
+    auto stdFonts = std::unordered_map<Style, int>{ { Style::Normal, 1 }, { Style::Bold, 2 }, { Style::Italic, 3 }, { Style::BoldItalic, 4 } };
+
+    auto flatIcons = proto::flat_hash_map<std::string, int>{};
+    auto stdIcons = std::unordered_map<std::string, int>{};
+
+    for(auto i = 0; const auto name : icon_names)
+    {
+        flatIcons.try_emplace(std::string{name}, i);
+        stdIcons.try_emplace(std::string{name}, i);
+        ++i;
+    }
+
+    static constexpr auto styles = std::array{ Style::Normal, Style::Bold, Style::Italic, Style::BoldItalic };
+
+    BENCHMARK("font lookup: std::unordered_map contains + at")
+    {
+        auto sum = 0;
+        for(auto i = 0uz; i < 4096uz; ++i)
+        {
+            const auto style = styles[i % styles.size()];
+            if(stdFonts.contains(style)) { sum += stdFonts.at(style); }
+        }
+        return sum;
+    };
+
+    BENCHMARK("font lookup: flat_hash_map find")
+    {
+        auto sum = 0;
+        for(auto i = 0uz; i < 4096uz; ++i)
+        {
+            if(auto it = flatFonts.find(styles[i % styles.size()]); it != flatFonts.end()) { sum += it->second; }
+        }
+        return sum;
+    };
+
+    BENCHMARK("icon lookup: std::unordered_map<std::string>")
+    {
+        auto sum = 0;
+        for(auto i = 0uz; i < 4096uz; ++i)
+        {
+            if(auto it = stdIcons.find(std::string{icon_names[i % icon_names.size()]}); it != stdIcons.end()) { sum += it->second; }
+        }
+        return sum;
+    };
+
+    BENCHMARK("icon lookup: flat_hash_map string_view")
+    {
+        auto sum = 0;
+        for(auto i = 0uz; i < 4096uz; ++i)
+        {
+            if(auto it = flatIcons.find(icon_names[i % icon_names.size()]); it != flatIcons.end()) { sum += it->second; }
+        }
+        return sum;
+    };
+
+    static constexpr auto hashed = std::array{ "iconClose"_hs, "iconNew"_hs, "iconWindowMaximize"_hs, "iconWindowMinimize"_hs, "iconWindowRestore"_hs };
+
+    BENCHMARK("icon lookup: flat_hash_map hashed_string")
+    {
+        auto sum = 0;
+        for(auto i = 0uz; i < 4096uz; ++i)
+        {
+            if(auto it = flatIcons.find(hashed[i % hashed.size()]); it != flatIcons.end()) { sum += it->second; }
+        }
+        return sum;
+    };
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
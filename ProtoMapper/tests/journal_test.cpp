@@ -0,0 +1,244 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <Journal.hpp>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <csignal>
+#include <sys/resource.h>
+#endif
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+
+namespace
+{
+    using proto::Journal;
+    using proto::TileId;
+    using proto::TileLayer;
+    using proto::TileMap;
+
+    constexpr uint32_t Cells = 64u;
+
+    std::filesystem::path temp_file(std::string_view name)
+    {
+        return std::filesystem::temp_directory_path() / name;
+    }
+
+    TileMap test_map()
+    {
+        auto map = TileMap{ 4u * TileLayer::ChunkSize, 4u * TileLayer::ChunkSize, 16u, 16u };
+        map.AddLayer("ground");
+        return map;
+    }
+
+    // Edit 'step' writes one row of cells, all of them new, so every edit is the same size and none overlap.
+    void edit(Journal& journal, TileMap& map, uint32_t step)
+    {
+        journal.Begin(map, "paint", false);
+        for(auto x = 0u; x < Cells; ++x) { journal.Set(0uz, x + (step % 2u) * Cells, step, 1000u + (step * Cells) + x); }
+        journal.Commit();
+    }
+
+    // How much memory one edit takes, measured on a journal that never spills.
+    size_t edit_size()
+    {
+        auto map = test_map();
+        auto journal = Journal{};
+        journal.Configure(Journal::DefaultBudget, {});
+
+        edit(journal, map, 0u);
+        return journal.GetStats().memoryBytes;
+    }
+
+    bool same_tiles(const TileMap& lhs, const TileMap& rhs)
+    {
+        auto lhsRow = std::vector<TileId>(lhs.Width()), rhsRow = std::vector<TileId>(rhs.Width());
+
+        for(auto i = 0uz; i < lhs.Layers().size(); ++i)
+        {
+            for(auto y = 0u; y < lhs.Height(); ++y)
+            {
+                lhs.Layers()[i].ReadRow(y, lhsRow);
+                rhs.Layers()[i].ReadRow(y, rhsRow);
+                if(lhsRow != rhsRow) { return false; }
+            }
+        }
+
+        return true;
+    }
+
+    /*
+        Undoes everything the journal still has, checking each step against the map as it was, then redoes it all.
+        'states' holds the map after every edit, states.front() before the first. Copies share their chunks, and
+        the journal never writes in place, so they keep their tiles.
+    */
+    void require_history(Journal& journal, TileMap& map, const std::vector<TileMap>& states)
+    {
+        const auto undoable = journal.GetStats().undoable;
+        REQUIRE(undoable < states.size());
+
+        auto at = states.size() - 1uz;
+        REQUIRE(same_tiles(map, states[at]));
+
+        while(journal.CanUndo())
+        {
+            REQUIRE(journal.Undo(map));
+            REQUIRE(same_tiles(map, states[--at]));
+        }
+
+        REQUIRE(at == states.size() - 1uz - undoable);
+
+        while(journal.CanRedo())
+        {
+            REQUIRE(journal.Redo(map));
+            REQUIRE(same_tiles(map, states[++at]));
+        }
+
+        REQUIRE(at == states.size() - 1uz);
+    }
+}
+
+TEST_CASE("journal undoes and redoes spilled edits", "[journal]")
+{
+    const auto spill = temp_file("proto_journal_test_spill.bin");
+    auto map = test_map();
+    auto states = std::vector<TileMap>{ map };
+
+    auto journal = Journal{};
+    journal.Configure(edit_size() * 3uz / 2uz, spill);
+
+    for(auto step = 0u; step < 6u; ++step)
+    {
+        edit(journal, map, step);
+        states.push_back(map);
+    }
+
+    REQUIRE(journal.GetStats().spilledEntries == 5uz);
+    REQUIRE(journal.GetStats().undoable == 6uz);
+
+    require_history(journal, map, states);
+    journal.Clear();
+}
+
+TEST_CASE("journal forgets old edits when the spill file cannot be opened", "[journal]")
+{
+    // A regular file where the spill file's directory should be.
+    const auto blocker = temp_file("proto_journal_test_blocker");
+    std::ofstream{ blocker } << "not a directory";
+
+    auto map = test_map();
+    auto states = std::vector<TileMap>{ map };
+
+    auto journal = Journal{};
+    journal.Configure(edit_size() * 3uz / 2uz, blocker / "journal.bin");
+
+    for(auto step = 0u; step < 4u; ++step)
+    {
+        edit(journal, map, step);
+        states.push_back(map);
+    }
+
+    REQUIRE(journal.GetStats().spilledEntries == 0uz);
+    REQUIRE(journal.GetStats().undoable == 1uz);
+
+    require_history(journal, map, states);
+    journal.Clear();
+    std::filesystem::remove(blocker);
+}
+
+#ifndef _WIN32
+TEST_CASE("journal drops every older edit when a spill fails after earlier ones succeeded", "[journal]")
+{
+    const auto spill = temp_file("proto_journal_test_full.bin");
+    auto map = test_map();
+    auto states = std::vector<TileMap>{ map };
+
+    auto journal = Journal{};
+    journal.Configure(edit_size() * 3uz / 2uz, spill);
+
+    for(auto step = 0u; step < 4u; ++step)
+    {
+        edit(journal, map, step);
+        states.push_back(map);
+    }
+
+    REQUIRE(journal.GetStats().spilledEntries == 3uz);
+
+    // From here on the spill file cannot grow, so the next spill fails with older entries already in the file.
+    auto limit = rlimit{};
+    REQUIRE(getrlimit(RLIMIT_FSIZE, &limit) == 0);
+    const auto previous = limit;
+    const auto handler = std::signal(SIGXFSZ, SIG_IGN);
+
+    limit.rlim_cur = static_cast<rlim_t>(std::filesystem::file_size(spill));
+    REQUIRE(setrlimit(RLIMIT_FSIZE, &limit) == 0);
+
+    edit(journal, map, 4u);
+    states.push_back(map);
+
+    setrlimit(RLIMIT_FSIZE, &previous);
+    std::signal(SIGXFSZ, handler);
+
+    // Only the newest edit is left, nothing older than the one that failed to spill.
+    REQUIRE(journal.GetStats().spilledEntries == 0uz);
+    REQUIRE(journal.GetStats().undoable == 1uz);
+    require_history(journal, map, states);
+
+    // Spilling works again once there is room, starting the file over.
+    edit(journal, map, 5u);
+    states.push_back(map);
+    edit(journal, map, 6u);
+    states.push_back(map);
+
+    REQUIRE(journal.GetStats().spilledEntries == 2uz);
+    REQUIRE(journal.GetStats().undoable == 3uz);
+    require_history(journal, map, states);
+
+    journal.Clear();
+}
+#endif
+
+TEST_CASE("journal throughput", "[journal], [!benchmark]")
+{
+    auto map = test_map();
+    auto journal = Journal{};
+    journal.Configure(Journal::DefaultBudget, {});
+
+    auto step = 0u;
+
+    BENCHMARK("commit a whole chunk")
+    {
+        journal.Begin(map, "fill", false);
+        auto chunk = journal.WritableChunk(0uz, step % 4u, (step / 4u) % 4u);
+        for(auto& tile : chunk) { tile = step; }
+        journal.Commit();
+        return ++step;
+    };
+
+    BENCHMARK("undo and redo a whole chunk")
+    {
+        return journal.Undo(map) && journal.Redo(map);
+    };
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
@@ -0,0 +1,204 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <mipmap.hpp>
+#include <random>
+#include <vector>
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+
+namespace
+{
+    std::vector<uint8_t> random_image(uint32_t width, uint32_t height, uint32_t seed)
+    {
+        auto engine = std::mt19937{ seed };
+        auto pixels = std::vector<uint8_t>(size_t{width} * size_t{height} * 4uz);
+
+        for(auto& byte : pixels) { byte = static_cast<uint8_t>(engine()); }
+
+        return pixels;
+    }
+
+    // Texel by texel 2x2 average with clamped edges.
+    std::vector<uint8_t> naive_box(const std::vector<uint8_t>& src, uint32_t width, uint32_t height)
+    {
+        const auto outWidth = proto::mip_extent(width), outHeight = proto::mip_extent(height);
+        auto out = std::vector<uint8_t>(size_t{outWidth} * size_t{outHeight} * 4uz);
+
+        for(auto y = 0uz; y < outHeight; ++y)
+        {
+            for(auto x = 0uz; x < outWidth; ++x)
+            {
+                const auto x0 = std::min(x * 2uz, width - 1uz), x1 = std::min((x * 2uz) + 1uz, width - 1uz);
+                const auto y0 = std::min(y * 2uz, height - 1uz), y1 = std::min((y * 2uz) + 1uz, height - 1uz);
+                const auto at = [&](size_t px, size_t py, size_t c) { return uint32_t{src[(((py * width) + px) * 4uz) + c]}; };
+
+                for(auto c = 0uz; c < 4uz; ++c)
+                {
+                    const auto sum = at(x0, y0, c) + at(x1, y0, c) + at(x0, y1, c) + at(x1, y1, c);
+                    out[(((y * outWidth) + x) * 4uz) + c] = static_cast<uint8_t>((sum + 2u) >> 2u);
+                }
+            }
+        }
+
+        return out;
+    }
+
+    // The same fixed point pipeline as downsample_kaiser, one texel and one tap at a time.
+    std::vector<uint8_t> naive_kaiser(const std::vector<uint8_t>& src, uint32_t width, uint32_t height)
+    {
+        const auto weights = proto::detail::kaiser_weights();
+        const auto outWidth = proto::mip_extent(width), outHeight = proto::mip_extent(height);
+        const auto clamp = [](long at, uint32_t extent) { return static_cast<size_t>(std::clamp(at, 0l, static_cast<long>(extent) - 1l)); };
+
+        auto columns = std::vector<int32_t>(size_t{outWidth} * height * 4uz);
+
+        for(auto y = 0uz; y < height; ++y)
+        {
+            for(auto x = 0uz; x < outWidth; ++x)
+            {
+                for(auto c = 0uz; c < 4uz; ++c)
+                {
+                    auto sum = 1 << 7;
+                    for(auto k = 0uz; k < 8uz; ++k) { sum += weights[k] * src[(((y * width) + clamp(static_cast<long>((x * 2uz) + k) - 3l, width)) * 4uz) + c]; }
+                    columns[(((y * outWidth) + x) * 4uz) + c] = sum >> 8;
+                }
+            }
+        }
+
+        auto out = std::vector<uint8_t>(size_t{outWidth} * outHeight * 4uz);
+
+        for(auto y = 0uz; y < outHeight; ++y)
+        {
+            for(auto i = 0uz; i < size_t{outWidth} * 4uz; ++i)
+            {
+                auto sum = 1 << 19;
+                for(auto k = 0uz; k < 8uz; ++k) { sum += weights[k] * columns[(clamp(static_cast<long>((y * 2uz) + k) - 3l, height) * outWidth * 4uz) + i]; }
+                out[(y * outWidth * 4uz) + i] = static_cast<uint8_t>(std::clamp(sum >> 20, 0, 255));
+            }
+        }
+
+        return out;
+    }
+}
+
+TEST_CASE("mipmap box filter matches a texel by texel reference", "[mipmap]")
+{
+    for(const auto& [width, height] : { std::pair{ 1u, 1u }, { 1u, 7u }, { 9u, 1u }, { 2u, 2u }, { 17u, 5u }, { 64u, 33u }, { 250u, 131u } })
+    {
+        const auto src = random_image(width, height, width * height);
+        auto out = std::vector<uint8_t>(size_t{proto::mip_extent(width)} * size_t{proto::mip_extent(height)} * 4uz);
+
+        proto::downsample_box(src, width, height, out);
+        REQUIRE(out == naive_box(src, width, height));
+    }
+
+    auto small = std::vector<uint8_t>(4uz), wide = std::vector<uint8_t>(8uz);
+    REQUIRE_THROWS_AS(proto::downsample_box(std::vector<uint8_t>(16uz), 2u, 2u, wide), std::invalid_argument);
+    REQUIRE_THROWS_AS(proto::downsample_box(std::vector<uint8_t>(4uz), 0u, 1u, small), std::invalid_argument);
+    REQUIRE_THROWS_AS(proto::downsample_kaiser(std::vector<uint8_t>(12uz), 2u, 2u, small), std::invalid_argument);
+}
+
+TEST_CASE("mipmap kaiser filter matches the fixed point reference and keeps flat colour", "[mipmap]")
+{
+    for(const auto& [width, height] : { std::pair{ 1u, 1u }, { 3u, 8u }, { 12u, 1u }, { 41u, 19u }, { 128u, 64u } })
+    {
+        const auto src = random_image(width, height, width + height);
+        auto out = std::vector<uint8_t>(size_t{proto::mip_extent(width)} * size_t{proto::mip_extent(height)} * 4uz);
+
+        proto::downsample_kaiser(src, width, height, out);
+        REQUIRE(out == naive_kaiser(src, width, height));
+    }
+
+    constexpr auto width = 37u, height = 22u;
+
+    auto flat = std::vector<uint8_t>(size_t{width} * size_t{height} * 4uz);
+    for(auto i = 0uz; i < flat.size(); ++i) { flat[i] = static_cast<uint8_t>(10uz + ((i % 4uz) * 80uz)); }
+
+    auto out = std::vector<uint8_t>(size_t{proto::mip_extent(width)} * size_t{proto::mip_extent(height)} * 4uz);
+    proto::downsample_kaiser(flat, width, height, out);
+
+    for(auto i = 0uz; i < out.size(); ++i) { REQUIRE(out[i] == flat[i % 4uz]); }
+
+    // A hard black and white edge rings, the overshoot has to be clamped rather than wrap.
+    auto edge = std::vector<uint8_t>(size_t{width} * size_t{height} * 4uz);
+    for(auto i = 0uz; i < edge.size(); ++i) { edge[i] = ((i / 4uz) % width) < width / 2u ? 0u : 255u; }
+
+    proto::downsample_kaiser(edge, width, height, out);
+    const auto outWidth = proto::mip_extent(width);
+
+    REQUIRE(out[0] == 0u);
+    REQUIRE(out[(outWidth - 1u) * 4u] == 255u);
+
+    for(auto x = 1uz; x < outWidth; ++x) { REQUIRE(out[x * 4uz] >= out[(x - 1uz) * 4uz] - 40); }
+}
+
+TEST_CASE("mipmap chain follows the GL level sizes", "[mipmap]")
+{
+    REQUIRE(proto::mip_level_count(1u, 1u) == 1u);
+    REQUIRE(proto::mip_level_count(256u, 256u) == 9u);
+    REQUIRE(proto::mip_level_count(300u, 5u) == 9u);
+
+    const auto src = random_image(300u, 5u, 1u);
+    const auto chain = proto::build_mip_chain(src, 300u, 5u, proto::mip_filter::kaiser);
+
+    REQUIRE(chain.size() == 8uz);
+    REQUIRE(chain.front().width == 150u);
+    REQUIRE(chain.front().height == 2u);
+    REQUIRE(chain[1].height == 1u);
+    REQUIRE(chain.back().width == 1u);
+    REQUIRE(chain.back().height == 1u);
+
+    for(const auto& level : chain) { REQUIRE(level.pixels.size() == size_t{level.width} * level.height * 4uz); }
+
+    REQUIRE(proto::build_mip_chain(src, 300u, 5u, proto::mip_filter::box, 3u).size() == 2uz);
+    REQUIRE(proto::build_mip_chain(src, 300u, 5u, proto::mip_filter::box, 0u).empty());
+    REQUIRE_THROWS_AS(proto::build_mip_chain(src, 300u, 6u), std::invalid_argument);
+}
+
+TEST_CASE("mipmap filters against the texel by texel reference", "[mipmap], [!benchmark]")
+{
+    constexpr auto side = 2048u;
+    const auto src = random_image(side, side, 9u);
+    auto out = std::vector<uint8_t>(size_t{side / 2u} * size_t{side / 2u} * 4uz);
+
+    BENCHMARK("box: reference")
+    {
+        return naive_box(src, side, side).back();
+    };
+
+    BENCHMARK("box")
+    {
+        proto::downsample_box(src, side, side, out);
+        return out.back();
+    };
+
+    BENCHMARK("kaiser")
+    {
+        proto::downsample_kaiser(src, side, side, out);
+        return out.back();
+    };
+
+    BENCHMARK("full chain: box")
+    {
+        return proto::build_mip_chain(src, side, side).size();
+    };
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
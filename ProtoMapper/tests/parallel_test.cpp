@@ -0,0 +1,139 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <parallel.hpp>
+#include <dyn_array.hpp>
+#include <algorithm>
+#include <array>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+
+TEST_CASE("parallel_for visits every element of a dyn_array once", "[parallel]")
+{
+    auto cells = proto::dyn_array<int>{100'000uz, 0};
+
+    proto::parallel_for(cells, [](int& cell) { ++cell; });
+
+    REQUIRE(std::ranges::all_of(cells, [](int cell) { return cell == 1; }));
+}
+
+TEST_CASE("parallel_for over an index range covers it without overlap", "[parallel]")
+{
+    auto hits = std::vector<std::atomic<int>>(50'000uz);
+
+    proto::parallel_for(hits.size(), [&hits](size_t first, size_t last) {
+        for(auto i = first; i < last; ++i) { hits[i].fetch_add(1); }
+    }, 256uz);
+
+    REQUIRE(std::ranges::all_of(hits, [](const std::atomic<int>& hit) { return hit.load() == 1; }));
+}
+
+TEST_CASE("nested parallel_for does not deadlock", "[parallel]")
+{
+    auto rows = std::vector<std::vector<int>>(64uz, std::vector<int>(4096uz, 1));
+    auto totals = std::vector<long>(rows.size());
+
+    proto::parallel_for(rows.size(), [&](size_t first, size_t last) {
+        for(auto r = first; r < last; ++r)
+        {
+            totals[r] = proto::parallel_reduce(rows[r], 0l, std::plus<>{});
+        }
+    }, 1uz);
+
+    REQUIRE(std::ranges::all_of(totals, [](long total) { return total == 4096l; }));
+}
+
+TEST_CASE("many tiny parallel_for calls finish cleanly", "[parallel]")
+{
+    // Each call returns as soon as its chunks are done, racing the workers that are still signalling completion.
+    auto total = 0uz;
+
+    for(auto call = 0uz; call < 20'000uz; ++call)
+    {
+        auto hits = std::array<std::atomic<uint8_t>, 16uz>{};
+
+        proto::parallel_for(hits.size(), [&hits](size_t first, size_t last) {
+            for(auto i = first; i < last; ++i) { hits[i].fetch_add(1u, std::memory_order_relaxed); }
+        }, 1uz);
+
+        total += static_cast<size_t>(std::ranges::count_if(hits, [](const std::atomic<uint8_t>& hit) { return hit.load() == 1u; }));
+    }
+
+    REQUIRE(total == 20'000uz * 16uz);
+}
+
+TEST_CASE("parallel_reduce and parallel_sort match the serial algorithms", "[parallel]")
+{
+    auto engine = std::mt19937{ 42u };
+    auto values = std::vector<uint32_t>(200'000uz);
+    std::ranges::generate(values, [&engine]() { return engine() % 1'000'000u; });
+
+    const auto expected = std::accumulate(values.begin(), values.end(), uint64_t{});
+    const auto sum = proto::parallel_reduce(std::span{values}, uint64_t{}, std::plus<>{}, [](uint32_t v) { return uint64_t{v}; });
+
+    REQUIRE(sum == expected);
+
+    auto sorted = values;
+    std::ranges::sort(sorted);
+
+    proto::parallel_sort(values);
+
+    REQUIRE(values == sorted);
+}
+
+TEST_CASE("exceptions thrown in a chunk reach the caller", "[parallel]")
+{
+    auto values = std::vector<int>(10'000uz, 0);
+    values[7'777uz] = 1;
+
+    REQUIRE_THROWS_AS(proto::parallel_for(values, [](int v) { if(v == 1) { throw std::runtime_error{"bad cell"}; } }), std::runtime_error);
+}
+
+TEST_CASE("parallel helpers against serial loops", "[parallel], [!benchmark]")
+{
+    auto values = std::vector<float>(4'000'000uz, 1.5f);
+
+    BENCHMARK("serial transform")
+    {
+        for(auto& v : values) { v = (v * 0.5f) + 1.f; }
+        return values.front();
+    };
+
+    BENCHMARK("parallel_for transform")
+    {
+        proto::parallel_for(values, [](float& v) { v = (v * 0.5f) + 1.f; });
+        return values.front();
+    };
+
+    BENCHMARK("serial sum")
+    {
+        return std::accumulate(values.begin(), values.end(), 0.0);
+    };
+
+    BENCHMARK("parallel_reduce sum")
+    {
+        return proto::parallel_reduce(values, 0.0, std::plus<>{}, [](float v) { return static_cast<double>(v); });
+    };
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
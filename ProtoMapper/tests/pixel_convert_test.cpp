@@ -0,0 +1,173 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <pixel_convert.hpp>
+#include <random>
+#include <vector>
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+
+namespace
+{
+    std::vector<uint8_t> random_bytes(size_t count, uint32_t seed)
+    {
+        auto engine = std::mt19937{ seed };
+        auto bytes = std::vector<uint8_t>(count);
+
+        for(auto& byte : bytes) { byte = static_cast<uint8_t>(engine()); }
+
+        return bytes;
+    }
+}
+
+TEST_CASE("pixel_convert rgb_to_rgba matches the reference", "[pixel_convert]")
+{
+    // Odd pixel counts exercise the scalar tail after the 16 pixel blocks.
+    for(const auto pixels : { 0uz, 1uz, 15uz, 16uz, 17uz, 63uz, 1000uz })
+    {
+        const auto rgb = random_bytes(pixels * 3uz, static_cast<uint32_t>(pixels));
+        auto expected = std::vector<uint8_t>(pixels * 4uz), actual = std::vector<uint8_t>(pixels * 4uz);
+
+        proto::reference::rgb_to_rgba(rgb, expected, 200u);
+        proto::rgb_to_rgba(rgb, actual, 200u);
+        REQUIRE(actual == expected);
+
+        auto buffer = std::vector<uint8_t>(pixels * 4uz);
+        std::ranges::copy(rgb, buffer.begin());
+        proto::rgb_to_rgba_in_place(buffer, pixels, 200u);
+        REQUIRE(buffer == expected);
+    }
+
+    auto small = std::vector<uint8_t>(7uz);
+    REQUIRE_THROWS_AS(proto::rgb_to_rgba(std::vector<uint8_t>(6uz), small), std::invalid_argument);
+    REQUIRE_THROWS_AS(proto::rgb_to_rgba_in_place(small, 2uz), std::invalid_argument);
+}
+
+TEST_CASE("pixel_convert premultiply_alpha is exact for every colour and alpha", "[pixel_convert]")
+{
+    // One pixel per (colour, alpha) pair, so every SIMD lane sees every product.
+    auto straight = std::vector<uint8_t>(256uz * 256uz * 4uz);
+
+    for(auto a = 0uz; a < 256uz; ++a)
+    {
+        for(auto c = 0uz; c < 256uz; ++c)
+        {
+            const auto i = ((a * 256uz) + c) * 4uz;
+            straight[i] = static_cast<uint8_t>(c);
+            straight[i + 1uz] = static_cast<uint8_t>(255uz - c);
+            straight[i + 2uz] = static_cast<uint8_t>(c ^ a);
+            straight[i + 3uz] = static_cast<uint8_t>(a);
+        }
+    }
+
+    auto premultiplied = std::vector<uint8_t>(straight.size());
+    proto::premultiply_alpha(straight, premultiplied);
+
+    for(auto i = 0uz; i < straight.size(); i += 4uz)
+    {
+        const auto a = static_cast<double>(straight[i + 3uz]);
+
+        for(auto c = 0uz; c < 3uz; ++c)
+        {
+            const auto rounded = std::lround(static_cast<double>(straight[i + c]) * a / 255.0);
+            REQUIRE(premultiplied[i + c] == rounded);
+        }
+
+        REQUIRE(premultiplied[i + 3uz] == straight[i + 3uz]);
+    }
+
+    auto tail = random_bytes(37uz * 4uz, 3u), expected = tail;
+    proto::reference::premultiply_alpha(tail, expected);
+    proto::premultiply_alpha(tail);
+    REQUIRE(tail == expected);
+}
+
+TEST_CASE("pixel_convert swizzle and sRGB decode", "[pixel_convert]")
+{
+    const auto rgba = random_bytes(45uz * 4uz, 11u);
+
+    auto bgra = rgba;
+    proto::swizzle_rgba(bgra, { 2u, 1u, 0u, 3u });
+
+    for(auto i = 0uz; i < rgba.size(); i += 4uz)
+    {
+        REQUIRE(bgra[i] == rgba[i + 2uz]);
+        REQUIRE(bgra[i + 1uz] == rgba[i + 1uz]);
+        REQUIRE(bgra[i + 2uz] == rgba[i]);
+        REQUIRE(bgra[i + 3uz] == rgba[i + 3uz]);
+    }
+
+    auto expected = std::vector<uint8_t>(rgba.size());
+    proto::reference::swizzle_rgba(rgba, expected, { 3u, 3u, 0u, 1u });
+    auto actual = std::vector<uint8_t>(rgba.size());
+    proto::swizzle_rgba(rgba, actual, { 3u, 3u, 0u, 1u });
+    REQUIRE(actual == expected);
+
+    REQUIRE_THROWS_AS(proto::swizzle_rgba(actual, { 0u, 1u, 2u, 4u }), std::invalid_argument);
+
+    auto linear = std::vector<uint8_t>{ 0u, 128u, 255u, 77u };
+    proto::srgb_to_linear(linear);
+    REQUIRE(linear == std::vector<uint8_t>{ 0u, 55u, 255u, 77u });
+}
+
+TEST_CASE("pixel_convert against the scalar reference", "[pixel_convert], [!benchmark]")
+{
+    constexpr auto pixels = 1024uz * 1024uz;
+    const auto rgb = random_bytes(pixels * 3uz, 5u);
+    const auto rgba = random_bytes(pixels * 4uz, 6u);
+    auto out = std::vector<uint8_t>(pixels * 4uz);
+
+    BENCHMARK("rgb_to_rgba: reference")
+    {
+        proto::reference::rgb_to_rgba(rgb, out);
+        return out.back();
+    };
+
+    BENCHMARK("rgb_to_rgba")
+    {
+        proto::rgb_to_rgba(rgb, out);
+        return out.back();
+    };
+
+    BENCHMARK("premultiply_alpha: reference")
+    {
+        proto::reference::premultiply_alpha(rgba, out);
+        return out.back();
+    };
+
+    BENCHMARK("premultiply_alpha")
+    {
+        proto::premultiply_alpha(rgba, out);
+        return out.back();
+    };
+
+    BENCHMARK("swizzle_rgba: reference")
+    {
+        proto::reference::swizzle_rgba(rgba, out, { 2u, 1u, 0u, 3u });
+        return out.back();
+    };
+
+    BENCHMARK("swizzle_rgba")
+    {
+        proto::swizzle_rgba(rgba, out, { 2u, 1u, 0u, 3u });
+        return out.back();
+    };
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
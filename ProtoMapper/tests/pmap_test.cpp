@@ -0,0 +1,360 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <Pmap.hpp>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <vector>
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+
+namespace
+{
+    using proto::PmapFile;
+    using proto::TileId;
+    using proto::TileLayer;
+    using proto::TileMap;
+
+    constexpr size_t HeaderPage = 4096uz;
+
+    std::filesystem::path temp_file(std::string_view name)
+    {
+        return std::filesystem::temp_directory_path() / name;
+    }
+
+    std::vector<char> read_file(const std::filesystem::path& file)
+    {
+        auto in = std::ifstream{ file, std::ios::binary };
+        return { std::istreambuf_iterator<char>{ in }, std::istreambuf_iterator<char>{} };
+    }
+
+    void write_file(const std::filesystem::path& file, const std::vector<char>& bytes)
+    {
+        auto out = std::ofstream{ file, std::ios::binary | std::ios::trunc };
+        out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    }
+
+    // Two layers of 4 x 3 chunks, the second one sparse, with a tileset.
+    TileMap test_map(uint32_t seed)
+    {
+        auto map = TileMap{ 4u * TileLayer::ChunkSize, 3u * TileLayer::ChunkSize - 5u, 16u, 16u };
+
+        auto& tileset = map.Tilesets().emplace_back();
+        tileset.firstGid = 1u;
+        tileset.name = "terrain";
+        tileset.image = "terrain.png";
+        tileset.imageWidth = tileset.imageHeight = 256u;
+        tileset.tileWidth = tileset.tileHeight = 16u;
+        tileset.tileCount = 256u;
+        tileset.columns = 16u;
+
+        auto engine = std::mt19937{ seed };
+        auto next = [&engine](uint32_t bound) { return static_cast<uint32_t>(engine() % bound); };
+
+        auto& ground = map.AddLayer("ground");
+        for(auto y = 0u; y < ground.Height(); ++y)
+        {
+            for(auto x = 0u; x < ground.Width(); ++x) { ground.Set(x, y, 1u + ((x / 7u + y / 5u) % 4u)); }
+        }
+
+        auto& props = map.AddLayer("props");
+        props.visible = false;
+        props.opacity = 0.25f;
+        for(auto i = 0u; i < 50u; ++i) { props.Set(next(TileLayer::ChunkSize * 2u), next(TileLayer::ChunkSize), 1u + next(255u)); }
+
+        return map;
+    }
+
+    std::vector<proto::MapObject> test_objects()
+    {
+        auto objects = std::vector<proto::MapObject>(3uz);
+        objects[0].transform = proto::Transform{ { 10.f, 20.f }, 0.5f };
+        objects[0].marker = proto::Marker{ "gate" };
+        objects[1].transform = proto::Transform{ { 48.f, 64.f } };
+        objects[1].trigger = proto::Trigger{ { 8.f, 4.f }, 7u };
+        objects[2].transform = proto::Transform{ { 1.f, 2.f } };
+        objects[2].spawn = proto::SpawnPoint{ 3u, 9u };
+        objects[2].agent = proto::Agent{ {}, { 5.f, 6.f }, 2.f };
+        return objects;
+    }
+
+    void require_same_tiles(const TileMap& lhs, const TileMap& rhs)
+    {
+        REQUIRE(lhs.Width() == rhs.Width());
+        REQUIRE(lhs.Height() == rhs.Height());
+        REQUIRE(lhs.TileWidth() == rhs.TileWidth());
+        REQUIRE(lhs.TileHeight() == rhs.TileHeight());
+        REQUIRE(lhs.Tilesets() == rhs.Tilesets());
+        REQUIRE(lhs.Layers().size() == rhs.Layers().size());
+
+        auto lhsRow = std::vector<TileId>(lhs.Width()), rhsRow = std::vector<TileId>(rhs.Width());
+
+        for(auto i = 0uz; i < lhs.Layers().size(); ++i)
+        {
+            const auto& a = lhs.Layers()[i];
+            const auto& b = rhs.Layers()[i];
+
+            REQUIRE(a.Name() == b.Name());
+            REQUIRE(a.visible == b.visible);
+            REQUIRE(a.opacity == b.opacity);
+            REQUIRE(a.AllocatedChunks() == b.AllocatedChunks());
+
+            for(auto y = 0u; y < a.Height(); ++y)
+            {
+                a.ReadRow(y, lhsRow);
+                b.ReadRow(y, rhsRow);
+                REQUIRE(lhsRow == rhsRow);
+            }
+        }
+    }
+
+    // Loads 'file' into a fresh map and checks it against 'map' and 'objects'.
+    void require_loads(const std::filesystem::path& file, const TileMap& map, const std::vector<proto::MapObject>& objects, bool verify = true)
+    {
+        auto loaded = TileMap{};
+        auto registry = proto::Registry{};
+
+        REQUIRE(PmapFile{}.Load(file, loaded, registry, verify));
+        require_same_tiles(map, loaded);
+        REQUIRE(proto::CaptureObjects(registry) == objects);
+    }
+
+    // A load of 'file' must fail and leave what was loaded before alone.
+    void require_rejected(const std::filesystem::path& file, bool verify = false)
+    {
+        auto map = test_map(1u);
+        auto registry = proto::Registry{};
+        proto::RestoreObjects(test_objects(), registry);
+
+        REQUIRE_FALSE(PmapFile{}.Load(file, map, registry, verify));
+        require_same_tiles(map, test_map(1u));
+        REQUIRE(proto::CaptureObjects(registry) == test_objects());
+    }
+}
+
+TEST_CASE("pmap saves and loads a map with its objects", "[pmap]")
+{
+    const auto file = temp_file("proto_pmap_test_round_trip.pmap");
+    const auto map = test_map(1u);
+    const auto objects = test_objects();
+
+    for(const auto compression : { PmapFile::Compression::None, PmapFile::Compression::Zlib })
+    {
+        auto pmap = PmapFile{};
+        pmap.SetCompression(compression);
+
+        REQUIRE(pmap.Save(file, map, objects));
+        REQUIRE(pmap.LastSave().rewritten);
+        REQUIRE(pmap.LastSave().chunksWritten == map.Layers()[0].AllocatedChunks() + map.Layers()[1].AllocatedChunks());
+        REQUIRE_FALSE(std::filesystem::exists(std::filesystem::path{ file } += ".tmp"));
+
+        require_loads(file, map, objects);
+    }
+
+    std::filesystem::remove(file);
+}
+
+TEST_CASE("pmap appends only the chunks that changed", "[pmap]")
+{
+    const auto file = temp_file("proto_pmap_test_append.pmap");
+    auto map = test_map(2u);
+    const auto objects = test_objects();
+    const auto chunks = map.Layers()[0].AllocatedChunks() + map.Layers()[1].AllocatedChunks();
+
+    auto pmap = PmapFile{};
+    REQUIRE(pmap.Save(file, map, objects));
+    const auto first = std::filesystem::file_size(file);
+
+    // One edit copies one chunk, every other chunk is still the one the file holds.
+    map.Layers()[0].Set(TileLayer::ChunkSize + 3u, 2u, 99u);
+
+    REQUIRE(pmap.Save(file, map, objects));
+    REQUIRE_FALSE(pmap.LastSave().rewritten);
+    REQUIRE(pmap.LastSave().chunksWritten == 1uz);
+    REQUIRE(pmap.LastSave().chunksReused == chunks - 1uz);
+    REQUIRE(std::filesystem::file_size(file) > first);
+
+    require_loads(file, map, objects);
+
+    // A loaded file is appended to the same way.
+    auto loaded = TileMap{};
+    auto registry = proto::Registry{};
+    auto reopened = PmapFile{};
+    REQUIRE(reopened.Load(file, loaded, registry));
+
+    loaded.Layers()[1].Set(0u, 0u, 7u);
+    REQUIRE(reopened.Save(file, loaded, proto::CaptureObjects(registry)));
+    REQUIRE_FALSE(reopened.LastSave().rewritten);
+    REQUIRE(reopened.LastSave().chunksWritten == 1uz);
+
+    map.Layers()[1].Set(0u, 0u, 7u);
+    require_loads(file, map, objects);
+
+    std::filesystem::remove(file);
+}
+
+TEST_CASE("pmap rewrites the file once most of it is dead", "[pmap]")
+{
+    const auto file = temp_file("proto_pmap_test_compact.pmap");
+    auto map = test_map(3u);
+    const auto objects = test_objects();
+
+    auto pmap = PmapFile{};
+    REQUIRE(pmap.Save(file, map, objects));
+    const auto fresh = std::filesystem::file_size(file);
+
+    // Every save replaces every chunk of the ground layer, so the file grows by that much each time.
+    auto rewritten = false;
+    auto largest = fresh;
+
+    for(auto round = 1u; round <= 8u && !rewritten; ++round)
+    {
+        auto& ground = map.Layers()[0];
+        for(auto cy = 0u; cy < ground.ChunksY(); ++cy)
+        {
+            for(auto cx = 0u; cx < ground.ChunksX(); ++cx) { ground.Set(cx * TileLayer::ChunkSize, cy * TileLayer::ChunkSize, round); }
+        }
+
+        REQUIRE(pmap.Save(file, map, objects));
+        rewritten = pmap.LastSave().rewritten;
+
+        if(!rewritten) { largest = std::max(largest, std::filesystem::file_size(file)); }
+    }
+
+    REQUIRE(rewritten);
+    REQUIRE(std::filesystem::file_size(file) < largest);
+    REQUIRE(std::filesystem::file_size(file) <= fresh + HeaderPage);
+
+    require_loads(file, map, objects);
+
+    std::filesystem::remove(file);
+}
+
+TEST_CASE("pmap rejects a chunk whose checksum does not match", "[pmap]")
+{
+    const auto file = temp_file("proto_pmap_test_crc.pmap");
+    const auto map = test_map(4u);
+    const auto objects = test_objects();
+
+    for(const auto compression : { PmapFile::Compression::None, PmapFile::Compression::Zlib })
+    {
+        auto pmap = PmapFile{};
+        pmap.SetCompression(compression);
+        REQUIRE(pmap.Save(file, map, objects));
+
+        // The first payload follows the header page. Flipping a bit keeps a zlib stream well formed often enough
+        // that only the checksum can catch it.
+        auto bytes = read_file(file);
+        bytes[HeaderPage + 100uz] ^= 0x10;
+        write_file(file, bytes);
+
+        // Mapped chunks are only checked when asked to, compressed ones always.
+        require_rejected(file, true);
+        if(compression == PmapFile::Compression::Zlib) { require_rejected(file); }
+    }
+
+    std::filesystem::remove(file);
+}
+
+TEST_CASE("pmap rejects a truncated or torn directory", "[pmap]")
+{
+    const auto file = temp_file("proto_pmap_test_torn.pmap");
+    auto map = test_map(5u);
+    const auto objects = test_objects();
+
+    auto pmap = PmapFile{};
+    REQUIRE(pmap.Save(file, map, objects));
+    const auto saved = read_file(file);
+
+    SECTION("a file cut short inside the directory")
+    {
+        auto bytes = saved;
+        bytes.resize(bytes.size() - 8uz);
+        write_file(file, bytes);
+
+        require_rejected(file);
+    }
+
+    SECTION("a directory overwritten after the header was written")
+    {
+        auto bytes = saved;
+        bytes[bytes.size() - 12uz] ^= 0x01;
+        write_file(file, bytes);
+
+        require_rejected(file);
+    }
+
+    SECTION("an append cut short before its header leaves the last save readable")
+    {
+        const auto before = map;
+        map.Layers()[0].Set(5u, 5u, 42u);
+        REQUIRE(pmap.Save(file, map, objects));
+        REQUIRE_FALSE(pmap.LastSave().rewritten);
+
+        // Put back the old header, as if the new one never made it to disk.
+        auto bytes = read_file(file);
+        std::memcpy(bytes.data(), saved.data(), HeaderPage);
+        write_file(file, bytes);
+
+        require_loads(file, before, objects);
+    }
+
+    std::filesystem::remove(file);
+}
+
+TEST_CASE("pmap throughput", "[pmap], [!benchmark]")
+{
+    const auto file = temp_file("proto_pmap_test_bench.pmap");
+    auto map = TileMap{ 1024u, 1024u, 16u, 16u };
+    auto& ground = map.AddLayer("ground");
+    for(auto y = 0u; y < ground.Height(); ++y)
+    {
+        for(auto x = 0u; x < ground.Width(); ++x) { ground.Set(x, y, 1u + ((x / 7u + y / 5u) % 4u)); }
+    }
+
+    BENCHMARK("save 1024 x 1024, zlib")
+    {
+        auto pmap = PmapFile{};
+        pmap.SetCompression(PmapFile::Compression::Zlib);
+        return pmap.Save(file, map, {});
+    };
+
+    auto pmap = PmapFile{};
+    REQUIRE(pmap.Save(file, map, {}));
+
+    BENCHMARK("append one changed chunk")
+    {
+        ground.Set(0u, 0u, ground.Get(0u, 0u) + 1u);
+        return pmap.Save(file, map, {});
+    };
+
+    BENCHMARK("load 1024 x 1024, mapped")
+    {
+        auto loaded = TileMap{};
+        auto registry = proto::Registry{};
+        return PmapFile{}.Load(file, loaded, registry);
+    };
+
+    std::filesystem::remove(file);
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
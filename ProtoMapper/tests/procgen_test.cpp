@@ -0,0 +1,302 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <procgen.hpp>
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <set>
+#include <vector>
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+
+namespace
+{
+    // One cell at a time, straight from the definition.
+    float naive_noise(uint64_t seed, const proto::noise_settings& settings, uint32_t x, uint32_t y)
+    {
+        const auto lattice = [seed](int64_t lx, int64_t ly, uint32_t octave) {
+            return proto::random_unit(proto::random_at(seed, static_cast<uint32_t>(lx), static_cast<uint32_t>(ly), octave));
+        };
+
+        auto frequency = 1.f / settings.scale, amplitude = 1.f, total = 0.f, sum = 0.f;
+
+        for(auto octave = 0u; octave < settings.octaves; ++octave)
+        {
+            const auto u = static_cast<float>(x) * frequency, v = static_cast<float>(y) * frequency;
+            const auto lx = static_cast<int64_t>(std::floor(u)), ly = static_cast<int64_t>(std::floor(v));
+            const auto tx = proto::detail::smooth(u - std::floor(u)), ty = proto::detail::smooth(v - std::floor(v));
+
+            const auto left = lattice(lx, ly, octave) + ((lattice(lx, ly + 1, octave) - lattice(lx, ly, octave)) * ty);
+            const auto right = lattice(lx + 1, ly, octave) + ((lattice(lx + 1, ly + 1, octave) - lattice(lx + 1, ly, octave)) * ty);
+
+            sum += amplitude * (left + ((right - left) * tx));
+            total += amplitude;
+            amplitude *= settings.persistence;
+            frequency *= settings.lacunarity;
+        }
+
+        return sum / total;
+    }
+
+    // Counts all eight neighbours of every cell one by one.
+    std::vector<uint8_t> naive_cave_step(const std::vector<uint8_t>& cells, uint32_t width, uint32_t height)
+    {
+        auto next = std::vector<uint8_t>(cells.size());
+
+        for(auto y = 0; y < static_cast<int>(height); ++y)
+        {
+            for(auto x = 0; x < static_cast<int>(width); ++x)
+            {
+                auto walls = 0u;
+                for(auto dy = -1; dy <= 1; ++dy)
+                {
+                    for(auto dx = -1; dx <= 1; ++dx)
+                    {
+                        if(dx == 0 && dy == 0) { continue; }
+
+                        const auto nx = x + dx, ny = y + dy;
+                        const auto outside = nx < 0 || ny < 0 || nx >= static_cast<int>(width) || ny >= static_cast<int>(height);
+                        walls += outside || cells[(static_cast<size_t>(ny) * width) + static_cast<size_t>(nx)] != 0u ? 1u : 0u;
+                    }
+                }
+
+                const auto index = (static_cast<size_t>(y) * width) + static_cast<size_t>(x);
+                next[index] = walls >= (cells[index] != 0u ? 4u : 5u) ? 1u : 0u;
+            }
+        }
+
+        return next;
+    }
+}
+
+TEST_CASE("Counter-based numbers", "[procgen]")
+{
+    static_assert(proto::random_at(1u, 2u, 3u) == proto::random_at(1u, 2u, 3u));
+
+    REQUIRE(proto::random_at(1u, 2u, 3u) != proto::random_at(1u, 3u, 2u));
+    REQUIRE(proto::random_at(1u, 2u, 3u) != proto::random_at(1u, 2u, 3u, 1u));
+    REQUIRE(proto::random_at(1u, 2u, 3u) != proto::random_at(2u, 2u, 3u));
+
+    // Skipping ahead gives the same numbers as drawing up to them.
+    auto a = proto::counter_rng{ 42u }, b = proto::counter_rng{ 42u, 10u };
+    for(auto i = 0; i < 10; ++i) { (void)a.next(); }
+    REQUIRE(a.next() == b.next());
+
+    auto rng = proto::counter_rng{ 7u };
+    auto seen = std::set<uint32_t>{};
+    for(auto i = 0; i < 1000; ++i)
+    {
+        const auto value = rng.between(3u, 9u);
+        REQUIRE(value >= 3u);
+        REQUIRE(value <= 9u);
+        seen.insert(value);
+
+        const auto unit = rng.unit();
+        REQUIRE(unit >= 0.f);
+        REQUIRE(unit < 1.f);
+    }
+    REQUIRE(seen.size() == 7uz);
+}
+
+TEST_CASE("Noise does not depend on how the area is split", "[procgen]")
+{
+    const auto settings = proto::noise_settings{ .scale = 23.f, .octaves = 5u, .persistence = 0.6f, .lacunarity = 2.1f };
+    constexpr auto x0 = 10u, y0 = 20u, width = 200u, height = 150u;
+
+    auto whole = std::vector<float>(size_t{width} * height);
+    proto::value_noise(99u, settings, x0, y0, width, height, whole);
+
+    for(auto y = 0u; y < height; ++y)
+    {
+        for(auto x = 0u; x < width; ++x)
+        {
+            const auto value = whole[(size_t{y} * width) + x];
+            REQUIRE(value >= 0.f);
+            REQUIRE(value < 1.f);
+            REQUIRE(std::abs(value - naive_noise(99u, settings, x0 + x, y0 + y)) < 1e-5f);
+        }
+    }
+
+    // Odd tile sizes put every cell at a different offset in its spans and vectors.
+    for(const auto tile : { 1u, 7u, 37u, 64u })
+    {
+        auto part = std::vector<float>(size_t{tile} * tile);
+
+        for(auto ty = 0u; ty < height; ty += tile)
+        {
+            for(auto tx = 0u; tx < width; tx += tile)
+            {
+                const auto w = std::min(tile, width - tx), h = std::min(tile, height - ty);
+                proto::value_noise(99u, settings, x0 + tx, y0 + ty, w, h, part);
+
+                for(auto y = 0u; y < h; ++y)
+                {
+                    for(auto x = 0u; x < w; ++x) { REQUIRE(part[(size_t{y} * w) + x] == whole[(size_t{ty + y} * width) + tx + x]); }
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("Cave steps match a cell by cell count", "[procgen]")
+{
+    constexpr auto width = 301u, height = 211u;
+
+    auto caves = proto::cave_automaton{ width, height };
+    caves.seed(5u, 0.45f);
+
+    auto expected = std::vector<uint8_t>(caves.cells().begin(), caves.cells().end());
+    const auto walls = std::ranges::count(expected, uint8_t{1u});
+    REQUIRE(walls > static_cast<std::ptrdiff_t>(expected.size() * 2uz / 5uz));
+    REQUIRE(walls < static_cast<std::ptrdiff_t>(expected.size() / 2uz));
+
+    auto again = proto::cave_automaton{ width, height };
+    again.seed(5u, 0.45f);
+    REQUIRE(std::ranges::equal(again.cells(), expected));
+
+    for(auto step = 0; step < 5; ++step)
+    {
+        caves.step();
+        expected = naive_cave_step(expected, width, height);
+        REQUIRE(std::ranges::equal(caves.cells(), expected));
+    }
+}
+
+TEST_CASE("Dungeons are connected and drawn the same in pieces", "[procgen]")
+{
+    constexpr auto width = 300u, height = 200u;
+
+    auto dungeon = proto::bsp_dungeon{};
+    dungeon.build(17u, width, height, { .min_leaf = 12u, .max_depth = 10u, .min_room = 4u, .margin = 1u });
+
+    REQUIRE(dungeon.rooms().size() > 20uz);
+
+    const auto rooms = dungeon.rooms();
+    for(auto i = 0uz; i < rooms.size(); ++i)
+    {
+        REQUIRE(rooms[i].w >= 4u);
+        REQUIRE(rooms[i].h >= 4u);
+        REQUIRE(rooms[i].x + rooms[i].w <= width);
+        REQUIRE(rooms[i].y + rooms[i].h <= height);
+
+        for(auto j = i + 1uz; j < rooms.size(); ++j) { REQUIRE_FALSE(rooms[i].overlaps(rooms[j].x, rooms[j].y, rooms[j].w, rooms[j].h)); }
+    }
+
+    auto whole = std::vector<uint8_t>(size_t{width} * height);
+    dungeon.rasterize(0u, 0u, width, height, whole);
+
+    // Every floor cell reaches every other.
+    const auto start = static_cast<size_t>(std::ranges::find(whole, uint8_t{1u}) - whole.begin());
+    auto seen = std::vector<uint8_t>(whole.size());
+    auto open = std::deque<size_t>{ start };
+    seen[start] = 1u;
+
+    while(!open.empty())
+    {
+        const auto cell = open.front();
+        open.pop_front();
+
+        const auto x = cell % width, y = cell / width;
+        for(const auto next : { x > 0uz ? cell - 1uz : cell, x + 1uz < width ? cell + 1uz : cell, y > 0uz ? cell - width : cell, y + 1uz < height ? cell + width : cell })
+        {
+            if(whole[next] != 0u && seen[next] == 0u)
+            {
+                seen[next] = 1u;
+                open.push_back(next);
+            }
+        }
+    }
+
+    REQUIRE(std::ranges::equal(seen, whole));
+
+    auto part = std::vector<uint8_t>(64uz * 64uz);
+    for(auto cy = 0u; cy < height; cy += 64u)
+    {
+        for(auto cx = 0u; cx < width; cx += 64u)
+        {
+            std::ranges::fill(part, uint8_t{0u});
+            dungeon.rasterize(cx, cy, 64u, 64u, part);
+
+            for(auto y = 0u; y < 64u; ++y)
+            {
+                for(auto x = 0u; x < 64u; ++x)
+                {
+                    const auto inside = cx + x < width && cy + y < height;
+                    REQUIRE(part[(y * 64uz) + x] == (inside ? whole[(size_t{cy + y} * width) + cx + x] : 0u));
+                }
+            }
+        }
+    }
+
+    auto same = proto::bsp_dungeon{};
+    same.build(17u, width, height, { .min_leaf = 12u, .max_depth = 10u, .min_room = 4u, .margin = 1u });
+    REQUIRE(same.rooms().size() == rooms.size());
+    for(auto i = 0uz; i < rooms.size(); ++i) { REQUIRE(same.rooms()[i].x == rooms[i].x); }
+
+    auto tiny = proto::bsp_dungeon{};
+    tiny.build(1u, 3u, 3u);
+    REQUIRE(tiny.rooms().empty());
+}
+
+TEST_CASE("Procgen benchmark", "[procgen], [!benchmark]")
+{
+    constexpr auto side = 1024u;
+    const auto settings = proto::noise_settings{};
+    auto noise = std::vector<float>(size_t{side} * side);
+
+    BENCHMARK("noise 1024^2: per cell")
+    {
+        auto sum = 0.f;
+        for(auto y = 0u; y < side; ++y)
+        {
+            for(auto x = 0u; x < side; ++x) { sum += naive_noise(1u, settings, x, y); }
+        }
+        return sum;
+    };
+
+    BENCHMARK("noise 1024^2: spans")
+    {
+        proto::value_noise(1u, settings, 0u, 0u, side, side, noise);
+        return noise.back();
+    };
+
+    BENCHMARK("caves 1024^2: 5 steps")
+    {
+        auto caves = proto::cave_automaton{ side, side };
+        caves.seed(1u, 0.45f);
+        for(auto step = 0; step < 5; ++step) { caves.step(); }
+        return caves.at(side / 2u, side / 2u);
+    };
+
+    BENCHMARK("dungeon 4096^2: build and draw in chunks")
+    {
+        auto dungeon = proto::bsp_dungeon{};
+        dungeon.build(1u, 4096u, 4096u);
+
+        auto part = std::vector<uint8_t>(64uz * 64uz);
+        for(auto cy = 0u; cy < 4096u; cy += 64u)
+        {
+            for(auto cx = 0u; cx < 4096u; cx += 64u) { dungeon.rasterize(cx, cy, 64u, 64u, part); }
+        }
+        return part.front();
+    };
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
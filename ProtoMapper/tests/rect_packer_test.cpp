@@ -0,0 +1,81 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <catch2/catch_test_macros.hpp>
+#include <rect_packer.hpp>
+#include <random>
+#include <vector>
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+
+namespace
+{
+    bool overlaps(const proto::packed_rect& a, const proto::packed_rect& b)
+    {
+        return a.x < b.x + b.w && b.x < a.x + a.w && a.y < b.y + b.h && b.y < a.y + a.h;
+    }
+}
+
+TEST_CASE("skyline_packer fills a page exactly with equal squares", "[rect_packer]")
+{
+    auto packer = proto::skyline_packer{ 64u, 64u };
+
+    for(auto i = 0; i < 16; ++i)
+    {
+        REQUIRE(packer.insert(16u, 16u).has_value());
+    }
+
+    REQUIRE(packer.occupancy() == 1.0);
+    REQUIRE_FALSE(packer.insert(1u, 1u).has_value());
+
+    packer.reset();
+    REQUIRE(packer.insert(64u, 64u) == proto::packed_rect{ 0u, 0u, 64u, 64u });
+}
+
+TEST_CASE("pack_rects places random sizes without overlap", "[rect_packer]")
+{
+    auto engine = std::mt19937{ 3u };
+    auto sizes = std::vector<proto::packed_rect>{};
+
+    for(auto i = 0; i < 300; ++i)
+    {
+        sizes.push_back({ 0u, 0u, 4u + static_cast<uint32_t>(engine() % 60u), 4u + static_cast<uint32_t>(engine() % 60u) });
+    }
+
+    const auto placements = proto::pack_rects(sizes, 256u, 256u);
+
+    REQUIRE(placements.size() == sizes.size());
+
+    for(auto i = 0uz; i < placements.size(); ++i)
+    {
+        const auto& rect = placements[i].rect;
+
+        REQUIRE(rect.w == sizes[i].w);
+        REQUIRE(rect.h == sizes[i].h);
+        REQUIRE(rect.x + rect.w <= 256u);
+        REQUIRE(rect.y + rect.h <= 256u);
+
+        for(auto j = i + 1uz; j < placements.size(); ++j)
+        {
+            if(placements[i].page == placements[j].page) { REQUIRE_FALSE(overlaps(rect, placements[j].rect)); }
+        }
+    }
+
+    REQUIRE_THROWS_AS(proto::pack_rects(std::vector<proto::packed_rect>{ { 0u, 0u, 300u, 10u } }, 256u, 256u), std::invalid_argument);
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
@@ -0,0 +1,276 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <region_labels.hpp>
+#include <algorithm>
+#include <deque>
+#include <random>
+#include <span>
+#include <tuple>
+#include <vector>
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+
+namespace
+{
+    // A dense grid stored in chunks like a TileLayer, where chunks that only hold zeroes are left out.
+    struct chunked_grid
+    {
+        uint32_t width, height, chunk_size, chunks_x, chunks_y;
+        std::vector<std::vector<uint32_t>> chunks;
+
+        chunked_grid(uint32_t w, uint32_t h, uint32_t size)
+        : width(w), height(h), chunk_size(size), chunks_x((w + size - 1u) / size), chunks_y((h + size - 1u) / size),
+          chunks(size_t{chunks_x} * chunks_y)
+        {
+        }
+
+        [[nodiscard]] uint32_t get(uint32_t x, uint32_t y) const
+        {
+            const auto& chunk = chunks[((y / chunk_size) * chunks_x) + (x / chunk_size)];
+            return chunk.empty() ? 0u : chunk[((y % chunk_size) * chunk_size) + (x % chunk_size)];
+        }
+
+        void set(uint32_t x, uint32_t y, uint32_t value)
+        {
+            auto& chunk = chunks[((y / chunk_size) * chunks_x) + (x / chunk_size)];
+            if(chunk.empty()) { chunk.assign(size_t{chunk_size} * chunk_size, 0u); }
+
+            // Padding past the edges gets junk, which nothing may read.
+            chunk[((y % chunk_size) * chunk_size) + (x % chunk_size)] = value;
+        }
+
+        [[nodiscard]] std::span<const uint32_t> operator()(uint32_t cx, uint32_t cy) const { return chunks[(cy * chunks_x) + cx]; }
+    };
+
+    chunked_grid random_grid(uint32_t width, uint32_t height, uint32_t chunk_size, uint32_t values, uint32_t seed)
+    {
+        auto engine = std::mt19937{ seed };
+        auto grid = chunked_grid{ width, height, chunk_size };
+
+        for(auto& chunk : grid.chunks)
+        {
+            // Some chunks stay unallocated and some are solid, like a real map.
+            if(engine() % 4u == 0u) { continue; }
+            chunk.assign(size_t{chunk_size} * chunk_size, engine() % 3u == 0u ? 7u : 0xDEADu);
+        }
+
+        for(auto y = 0u; y < height; ++y)
+        {
+            for(auto x = 0u; x < width; ++x)
+            {
+                auto& chunk = grid.chunks[((y / chunk_size) * grid.chunks_x) + (x / chunk_size)];
+                if(!chunk.empty() && chunk[0] != 7u) { grid.set(x, y, static_cast<uint32_t>(engine() % values)); }
+            }
+        }
+
+        return grid;
+    }
+
+    // Breadth-first component ids, the reference for everything below.
+    std::vector<uint32_t> naive_components(const chunked_grid& grid)
+    {
+        auto ids = std::vector<uint32_t>(size_t{grid.width} * grid.height, ~0u);
+        auto next = 0u;
+
+        for(auto start = 0uz; start < ids.size(); ++start)
+        {
+            if(ids[start] != ~0u) { continue; }
+
+            const auto value = grid.get(static_cast<uint32_t>(start % grid.width), static_cast<uint32_t>(start / grid.width));
+            auto open = std::deque<size_t>{ start };
+            ids[start] = next;
+
+            while(!open.empty())
+            {
+                const auto cell = open.front();
+                open.pop_front();
+
+                const auto x = static_cast<uint32_t>(cell % grid.width), y = static_cast<uint32_t>(cell / grid.width);
+
+                auto visit = [&](uint32_t nx, uint32_t ny) {
+                    const auto index = (size_t{ny} * grid.width) + nx;
+                    if(ids[index] == ~0u && grid.get(nx, ny) == value)
+                    {
+                        ids[index] = next;
+                        open.push_back(index);
+                    }
+                };
+
+                if(x > 0u) { visit(x - 1u, y); }
+                if(x + 1u < grid.width) { visit(x + 1u, y); }
+                if(y > 0u) { visit(x, y - 1u); }
+                if(y + 1u < grid.height) { visit(x, y + 1u); }
+            }
+
+            ++next;
+        }
+
+        return ids;
+    }
+}
+
+TEST_CASE("Run searches match a scalar scan", "[region_labels]")
+{
+    auto engine = std::mt19937{ 3u };
+    auto cells = std::vector<uint32_t>(100uz);
+
+    for(auto round = 0; round < 200; ++round)
+    {
+        for(auto& cell : cells) { cell = engine() % 8u == 0u ? 2u : 1u; }
+
+        const auto first = engine() % 50u, last = 50u + (engine() % 51u);
+
+        auto end = first;
+        while(end < last && cells[end] == 1u) { ++end; }
+        REQUIRE(proto::detail::run_end(cells.data(), first, last, 1u) == end);
+
+        auto found = first;
+        while(found < last && cells[found] != 2u) { ++found; }
+        REQUIRE(proto::detail::find_value(cells.data(), first, last, 2u) == found);
+
+        auto begin = last;
+        while(begin > first && cells[begin - 1u] == 1u) { --begin; }
+        REQUIRE(proto::detail::run_begin(cells.data(), first, last, 1u) == begin);
+    }
+}
+
+TEST_CASE("Labels match a breadth-first search", "[region_labels]")
+{
+    for(const auto& [width, height, chunk, values] : { std::tuple{ 100u, 77u, 16u, 3u }, std::tuple{ 64u, 64u, 64u, 2u }, std::tuple{ 130u, 45u, 8u, 5u } })
+    {
+        const auto grid = random_grid(width, height, chunk, values, width * height);
+        const auto expected = naive_components(grid);
+
+        auto labels = proto::region_labels{};
+        labels.build(width, height, chunk, grid);
+
+        auto toLabel = std::vector<uint32_t>(expected.size(), ~0u);
+
+        for(auto y = 0u; y < height; ++y)
+        {
+            for(auto x = 0u; x < width; ++x)
+            {
+                const auto id = expected[(size_t{y} * width) + x];
+                const auto label = labels.at(x, y);
+
+                // Labels are numbered chunk by chunk, so only the partition has to match.
+                REQUIRE(label < labels.size());
+                if(toLabel[id] == ~0u) { toLabel[id] = label; }
+                REQUIRE(toLabel[id] == label);
+
+                const auto& region = labels.get(label);
+                REQUIRE(region.value == grid.get(x, y));
+                REQUIRE(x >= region.min_x);
+                REQUIRE(x <= region.max_x);
+                REQUIRE(y >= region.min_y);
+                REQUIRE(y <= region.max_y);
+            }
+        }
+
+        auto areas = std::vector<size_t>(labels.size());
+        for(const auto id : expected) { ++areas[toLabel[id]]; }
+
+        for(auto label = 0u; label < labels.size(); ++label)
+        {
+            REQUIRE(labels.get(label).area == areas[label]);
+
+            auto covered = 0uz;
+            labels.for_each_run(label, [&](uint32_t x, uint32_t y, uint32_t length) {
+                for(auto i = 0u; i < length; ++i) { REQUIRE(labels.at(x + i, y) == label); }
+                REQUIRE((x == 0u || labels.at(x - 1u, y) != label));
+                REQUIRE((x + length == width || labels.at(x + length, y) != label));
+                covered += length;
+            });
+
+            REQUIRE(covered == areas[label]);
+        }
+
+        REQUIRE(*std::ranges::max_element(expected) + 1u == labels.size());
+        REQUIRE(labels.at(width, 0u) == proto::region_labels::no_label);
+    }
+}
+
+TEST_CASE("Scanline fill covers the connected area", "[region_labels]")
+{
+    const auto grid = random_grid(150u, 90u, 16u, 2u, 9u);
+    const auto expected = naive_components(grid);
+
+    auto engine = std::mt19937{ 11u };
+
+    for(auto round = 0; round < 50; ++round)
+    {
+        const auto x = static_cast<uint32_t>(engine() % 150u), y = static_cast<uint32_t>(engine() % 90u);
+        const auto id = expected[(size_t{y} * 150u) + x];
+
+        auto seen = std::vector<uint8_t>(expected.size());
+        const auto filled = proto::scanline_fill(150u, 90u, 16u, grid, x, y, [&](uint32_t rx, uint32_t ry, uint32_t length) {
+            for(auto i = 0u; i < length; ++i)
+            {
+                auto& cell = seen[(size_t{ry} * 150u) + rx + i];
+                REQUIRE(cell == 0u);
+                cell = 1u;
+            }
+        });
+
+        auto area = 0uz;
+        for(auto i = 0uz; i < expected.size(); ++i)
+        {
+            REQUIRE((seen[i] != 0u) == (expected[i] == id));
+            area += expected[i] == id ? 1uz : 0uz;
+        }
+
+        REQUIRE(filled == area);
+    }
+
+    REQUIRE(proto::scanline_fill(150u, 90u, 16u, grid, 150u, 0u, [](uint32_t, uint32_t, uint32_t) {}) == 0uz);
+}
+
+TEST_CASE("Region labels benchmark", "[region_labels], [!benchmark]")
+{
+    // A 4096 x 4096 map in 64 x 64 chunks: a quarter noise, the rest empty or solid.
+    constexpr auto side = 4096u;
+    const auto grid = random_grid(side, side, 64u, 2u, 5u);
+
+    auto empty = chunked_grid{ side, side, 64u };
+
+    BENCHMARK("label 4096^2: breadth-first")
+    {
+        return naive_components(grid).size();
+    };
+
+    BENCHMARK("label 4096^2: region_labels")
+    {
+        auto labels = proto::region_labels{};
+        labels.build(side, side, 64u, grid);
+        return labels.size();
+    };
+
+    BENCHMARK("fill 4096^2 empty map: scanline")
+    {
+        return proto::scanline_fill(side, side, 64u, empty, 0u, 0u, [](uint32_t, uint32_t, uint32_t) {});
+    };
+
+    BENCHMARK("fill noisy area: scanline")
+    {
+        return proto::scanline_fill(side, side, 64u, grid, side / 2u, side / 2u, [](uint32_t, uint32_t, uint32_t) {});
+    };
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
@@ -0,0 +1,190 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <Registry.hpp>
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+
+namespace
+{
+    struct Position { float x = 0.f, y = 0.f; };
+    struct Walker { float goalX = 0.f, goalY = 0.f, speed = 1.f; };
+    struct Tag { int id = 0; };
+
+    // The same step as AgentSystem, without glm.
+    void step(Position& pos, const Walker& walker, float dt)
+    {
+        const auto dx = walker.goalX - pos.x, dy = walker.goalY - pos.y;
+        const auto distance = std::sqrt((dx * dx) + (dy * dy));
+        const auto move = walker.speed * dt;
+
+        if(distance <= move) { pos = { walker.goalX, walker.goalY }; return; }
+
+        pos.x += dx / distance * move;
+        pos.y += dy / distance * move;
+    }
+}
+
+TEST_CASE("Registry recycles indices with a new version", "[registry]")
+{
+    auto registry = proto::Registry{};
+
+    const auto a = registry.Create(), b = registry.Create(), c = registry.Create();
+    registry.Emplace<Tag>(b, 7);
+
+    registry.Destroy(b);
+    registry.Destroy(a);
+
+    REQUIRE_FALSE(registry.Valid(a));
+    REQUIRE_FALSE(registry.Valid(b));
+    REQUIRE(registry.Valid(c));
+    REQUIRE(registry.EntityAt(proto::entity_index(b)) == proto::NullEntity);
+    REQUIRE_FALSE(registry.Pool<Tag>().contains(b));
+
+    // Last freed, first reused.
+    const auto a2 = registry.Create(), b2 = registry.Create();
+
+    REQUIRE(proto::entity_index(a2) == proto::entity_index(a));
+    REQUIRE(proto::entity_index(b2) == proto::entity_index(b));
+    REQUIRE(proto::entity_version(a2) == proto::entity_version(a) + 1u);
+    REQUIRE(registry.EntityAt(proto::entity_index(b2)) == b2);
+    REQUIRE(proto::entity_index(registry.Create()) == 3u);
+}
+
+TEST_CASE("Registry refuses to overflow the index bits", "[registry]")
+{
+    auto registry = proto::Registry{};
+
+    auto last = proto::NullEntity;
+    for(auto i = 0uz; i < proto::Registry::MaxEntities; ++i) { last = registry.Create(); }
+
+    REQUIRE(proto::entity_index(last) == proto::entity_index_mask - 1u);
+    REQUIRE_THROWS_AS(registry.Create(), std::length_error);
+
+    // Freeing the highest index keeps the rest of the free list intact.
+    registry.Destroy(proto::make_entity(5u, 0u));
+    registry.Destroy(last);
+    registry.Destroy(proto::make_entity(9u, 0u));
+
+    auto reused = std::set<proto::entity_type>{};
+    for(auto i = 0; i < 3; ++i) { reused.insert(proto::entity_index(registry.Create())); }
+
+    REQUIRE(reused == std::set<proto::entity_type>{ 5u, 9u, proto::entity_index_mask - 1u });
+    REQUIRE_THROWS_AS(registry.Create(), std::length_error);
+}
+
+TEST_CASE("Views visit entities that own every component", "[registry]")
+{
+    auto registry = proto::Registry{};
+
+    for(auto i = 0; i < 10'000; ++i)
+    {
+        const auto e = registry.Create();
+        registry.Emplace<Position>(e, static_cast<float>(i), 0.f);
+
+        if(i % 3 == 0) { registry.Emplace<Walker>(e, 0.f, 0.f, 1.f); }
+        if(i % 5 == 0) { registry.Emplace<Tag>(e, i); }
+    }
+
+    auto view = registry.ViewOf<Position, Walker, Tag>();
+    REQUIRE(view.SizeHint() == registry.Pool<Tag>().size());
+
+    auto seen = std::vector<int>{};
+    view.Each([&](proto::Entity e, Position& pos, Walker&, Tag& tag) {
+        REQUIRE(registry.Has<Walker>(e));
+        REQUIRE(pos.x == static_cast<float>(tag.id));
+        seen.push_back(tag.id);
+    });
+
+    REQUIRE(seen.size() == 667uz);
+    REQUIRE(std::ranges::all_of(seen, [](int id) { return id % 15 == 0; }));
+
+    // Single component views walk the column directly.
+    auto count = 0uz;
+    registry.ViewOf<Position>().Each([&count](proto::Entity, Position&) { ++count; });
+    REQUIRE(count == 10'000uz);
+}
+
+TEST_CASE("ParallelEach matches Each", "[registry]")
+{
+    auto serial = proto::Registry{}, parallel = proto::Registry{};
+
+    for(auto* registry : { &serial, &parallel })
+    {
+        for(auto i = 0; i < 50'000; ++i)
+        {
+            const auto e = registry->Create();
+            registry->Emplace<Position>(e, static_cast<float>(i % 97), static_cast<float>(i % 89));
+            if(i % 4 != 0) { registry->Emplace<Walker>(e, 10.f, 20.f, 1.5f); }
+        }
+    }
+
+    for(auto tick = 0; tick < 5; ++tick)
+    {
+        serial.ViewOf<Walker, Position>().Each([](proto::Entity, Walker& walker, Position& pos) { step(pos, walker, 0.25f); });
+        parallel.ViewOf<Walker, Position>().ParallelEach([](proto::Entity, Walker& walker, Position& pos) { step(pos, walker, 0.25f); }, 512uz);
+    }
+
+    const auto lhs = serial.Pool<Position>().components(), rhs = parallel.Pool<Position>().components();
+    REQUIRE(std::ranges::equal(lhs, rhs, [](const Position& a, const Position& b) { return a.x == b.x && a.y == b.y; }));
+}
+
+TEST_CASE("Registry with 100k agents", "[registry], [!benchmark]")
+{
+    static constexpr auto count = 100'000;
+
+    auto registry = proto::Registry{};
+
+    for(auto i = 0; i < count; ++i)
+    {
+        const auto e = registry.Create();
+        registry.Emplace<Position>(e, static_cast<float>(i % 1000), static_cast<float>(i / 1000));
+        registry.Emplace<Walker>(e, 500.f, 50.f, 2.f);
+    }
+
+    BENCHMARK("create and destroy 100k")
+    {
+        auto scratch = proto::Registry{};
+        auto entities = std::vector<proto::Entity>(count);
+
+        for(auto& e : entities) { e = scratch.Create(); scratch.Emplace<Position>(e); }
+        for(const auto e : entities) { scratch.Destroy(e); }
+
+        return scratch.Create();
+    };
+
+    BENCHMARK("step 100k agents: Each")
+    {
+        registry.ViewOf<Walker, Position>().Each([](proto::Entity, Walker& walker, Position& pos) { step(pos, walker, 0.016f); });
+        return registry.Pool<Position>().components().front().x;
+    };
+
+    BENCHMARK("step 100k agents: ParallelEach")
+    {
+        registry.ViewOf<Walker, Position>().ParallelEach([](proto::Entity, Walker& walker, Position& pos) { step(pos, walker, 0.016f); });
+        return registry.Pool<Position>().components().front().x;
+    };
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
@@ -0,0 +1,174 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <segmented_array.hpp>
+#include <dyn_array.hpp>
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <ranges>
+#include <string>
+#include <vector>
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+
+namespace
+{
+    // Small segments so the tests cross many boundaries, and a counter to check the policy is used.
+    struct counting_policy
+    {
+        static constexpr size_t first_segment_shift = 2uz;
+
+        std::shared_ptr<size_t> live = std::make_shared<size_t>(0uz);
+
+        [[nodiscard]] int* allocate_segment(size_t count)
+        {
+            ++*live;
+            return std::allocator<int>{}.allocate(count);
+        }
+
+        void deallocate_segment(int* ptr, size_t count) noexcept
+        {
+            --*live;
+            std::allocator<int>{}.deallocate(ptr, count);
+        }
+    };
+}
+
+static_assert(std::random_access_iterator<proto::segmented_array<int>::iterator>);
+static_assert(std::random_access_iterator<proto::segmented_array<int>::const_iterator>);
+
+TEST_CASE("segmented_array segment math", "[segmented_array]")
+{
+    using array = proto::segmented_array<int, counting_policy>;
+
+    REQUIRE(array::segment_of(0uz) == 0uz);
+    REQUIRE(array::segment_of(3uz) == 0uz);
+    REQUIRE(array::segment_of(4uz) == 1uz);
+    REQUIRE(array::segment_of(7uz) == 1uz);
+    REQUIRE(array::segment_of(8uz) == 2uz);
+    REQUIRE(array::segment_of(16uz) == 3uz);
+    REQUIRE(array::segment_start(3uz) == 16uz);
+    REQUIRE(array::segment_size(3uz) == 16uz);
+}
+
+TEST_CASE("segmented_array keeps element addresses stable while growing", "[segmented_array]")
+{
+    auto values = proto::segmented_array<std::string>{};
+    auto addresses = std::vector<const std::string*>{};
+
+    for(auto i = 0; i < 10'000; ++i)
+    {
+        addresses.push_back(&values.emplace_back(std::to_string(i)));
+    }
+
+    REQUIRE(values.size() == 10'000uz);
+
+    for(auto i = 0uz; i < values.size(); ++i)
+    {
+        REQUIRE(&values[i] == addresses[i]);
+        REQUIRE(values[i] == std::to_string(i));
+    }
+
+    REQUIRE(values.back() == "9999");
+    REQUIRE_THROWS_AS(values.at(10'000uz), std::out_of_range);
+
+    values.pop_back();
+    REQUIRE(values.size() == 9'999uz);
+    REQUIRE(values.back() == "9998");
+}
+
+TEST_CASE("segmented_array iterators, copies and the segment policy", "[segmented_array]")
+{
+    auto policy = counting_policy{};
+    auto live = policy.live;
+
+    {
+        auto values = proto::segmented_array<int, counting_policy>{ policy };
+
+        for(auto i = 0; i < 100; ++i) { values.push_back(i); }
+
+        REQUIRE(*live == 6uz); // 4 + 4 + 8 + 16 + 32 + 64 covers 100
+        REQUIRE(std::ranges::equal(values, std::views::iota(0, 100)));
+        REQUIRE(std::accumulate(values.begin(), values.end(), 0) == 4950);
+        REQUIRE(*(values.begin() + 50) == 50);
+        REQUIRE(values.end() - values.begin() == 100);
+        REQUIRE(*std::ranges::lower_bound(values, 77) == 77);
+
+        auto segments = 0uz, seen = 0uz;
+        values.for_each_segment([&](std::span<int> segment) { ++segments; seen += segment.size(); });
+        REQUIRE(segments == 6uz);
+        REQUIRE(seen == 100uz);
+
+        auto copy = values;
+        REQUIRE(std::ranges::equal(copy, values));
+        REQUIRE(*live == 12uz);
+
+        copy.clear();
+        copy.shrink_to_fit();
+        REQUIRE(*live == 6uz);
+
+        auto moved = std::move(values);
+        REQUIRE(moved.size() == 100uz);
+        REQUIRE(*live == 6uz);
+    }
+
+    REQUIRE(*live == 0uz);
+}
+
+TEST_CASE("segmented_array iteration against dyn_array", "[segmented_array], [!benchmark]")
+{
+    constexpr auto count = 1'000'000uz;
+
+    auto flat = proto::dyn_array<int>{ count, 1 };
+    auto segmented = proto::segmented_array<int>{};
+    for(auto i = 0uz; i < count; ++i) { segmented.push_back(1); }
+
+    BENCHMARK("dyn_array range for")
+    {
+        auto sum = 0l;
+        for(const auto v : flat) { sum += v; }
+        return sum;
+    };
+
+    BENCHMARK("segmented_array range for")
+    {
+        auto sum = 0l;
+        for(const auto v : segmented) { sum += v; }
+        return sum;
+    };
+
+    BENCHMARK("segmented_array for_each_segment")
+    {
+        auto sum = 0l;
+        segmented.for_each_segment([&sum](std::span<const int> segment) {
+            for(const auto v : segment) { sum += v; }
+        });
+        return sum;
+    };
+
+    BENCHMARK("segmented_array push_back")
+    {
+        auto values = proto::segmented_array<int>{};
+        for(auto i = 0; i < 100'000; ++i) { values.push_back(i); }
+        return values.size();
+    };
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
@@ -0,0 +1,109 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <sparse_set.hpp>
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+
+TEST_CASE("sparse_set insert, contains and erase", "[sparse_set]")
+{
+    auto set = proto::sparse_set{};
+
+    set.insert(proto::make_entity(3u, 0u));
+    set.insert(proto::make_entity(9000u, 0u));
+    set.insert(proto::make_entity(5u, 2u));
+
+    REQUIRE(set.size() == 3uz);
+    REQUIRE(set.contains(proto::make_entity(9000u, 0u)));
+    REQUIRE_FALSE(set.contains(proto::make_entity(5u, 1u)));
+    REQUIRE_FALSE(set.contains(proto::make_entity(4u, 0u)));
+    REQUIRE_THROWS(set.insert(proto::make_entity(3u, 0u)));
+
+    set.erase(proto::make_entity(3u, 0u));
+
+    REQUIRE(set.size() == 2uz);
+    REQUIRE_FALSE(set.contains(proto::make_entity(3u, 0u)));
+    REQUIRE(set.index(proto::make_entity(5u, 2u)) == 0uz);
+}
+
+TEST_CASE("component_pool keeps the column in step with the dense array", "[sparse_set], [component_pool]")
+{
+    struct Position { float x, y; };
+
+    auto pool = proto::component_pool<Position>{};
+
+    for(auto i = 0u; i < 10u; ++i)
+    {
+        pool.emplace(proto::make_entity(i, 0u), static_cast<float>(i), 0.f);
+    }
+
+    pool.erase(proto::make_entity(2u, 0u));
+    pool.erase(proto::make_entity(7u, 0u));
+
+    REQUIRE(pool.size() == 8uz);
+    REQUIRE(pool.components().size() == 8uz);
+    REQUIRE(pool.try_get(proto::make_entity(2u, 0u)) == nullptr);
+
+    const auto entities = pool.entities();
+    const auto column = pool.components();
+
+    for(auto i = 0uz; i < entities.size(); ++i)
+    {
+        REQUIRE(column[i].x == static_cast<float>(proto::entity_index(entities[i])));
+    }
+}
+
+TEST_CASE("component_pool iteration over 100k entities", "[sparse_set], [!benchmark]")
+{
+    struct Velocity { float x, y; };
+
+    static constexpr auto count = 100'000u;
+    auto pool = proto::component_pool<Velocity>{};
+
+    for(auto i = 0u; i < count; ++i)
+    {
+        pool.emplace(proto::make_entity(i, 0u), 1.f, 2.f);
+    }
+
+    BENCHMARK("walk column")
+    {
+        auto sum = 0.f;
+
+        for(const auto& v : pool.components())
+        {
+            sum += v.x + v.y;
+        }
+
+        return sum;
+    };
+
+    BENCHMARK("lookup by entity")
+    {
+        auto sum = 0.f;
+
+        for(const auto e : pool.entities())
+        {
+            sum += pool.get(e).x;
+        }
+
+        return sum;
+    };
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
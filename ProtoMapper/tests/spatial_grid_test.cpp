@@ -0,0 +1,274 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <spatial_grid.hpp>
+#include <algorithm>
+#include <array>
+#include <random>
+#include <vector>
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+
+namespace
+{
+    using proto::spatial_box;
+
+    std::vector<spatial_box> random_boxes(size_t count, float extent, float max_half, uint32_t seed)
+    {
+        auto engine = std::mt19937{ seed };
+        auto pos = std::uniform_real_distribution<float>{ -extent, extent };
+        auto half = std::uniform_real_distribution<float>{ 0.f, max_half };
+
+        auto boxes = std::vector<spatial_box>(count);
+        for(auto& box : boxes) { box = spatial_box::around(pos(engine), pos(engine), half(engine), half(engine)); }
+
+        return boxes;
+    }
+
+    std::vector<uint32_t> sorted(std::span<const uint32_t> ids)
+    {
+        auto out = std::vector<uint32_t>{ ids.begin(), ids.end() };
+        std::ranges::sort(out);
+        return out;
+    }
+
+    template <typename Pred>
+    std::vector<uint32_t> brute_force(std::span<const spatial_box> boxes, const std::vector<bool>& live, Pred pred)
+    {
+        auto out = std::vector<uint32_t>{};
+        for(auto i = 0uz; i < boxes.size(); ++i)
+        {
+            if(live[i] && pred(boxes[i])) { out.push_back(static_cast<uint32_t>(i)); }
+        }
+        return out;
+    }
+
+    std::vector<uint32_t> query(const proto::spatial_grid& grid, const spatial_box& area)
+    {
+        auto out = std::vector<uint32_t>(grid.size());
+        out.resize(grid.query(area, out));
+        return sorted(out);
+    }
+}
+
+TEST_CASE("spatial_grid insert, move and remove keep the cells consistent", "[spatial_grid]")
+{
+    auto grid = proto::spatial_grid{ 10.f };
+
+    grid.insert(3u, spatial_box::around(5.f, 5.f, 1.f, 1.f));
+    grid.insert(7u, spatial_box::around(-25.f, 5.f));
+
+    REQUIRE(grid.size() == 2uz);
+    REQUIRE(grid.contains(3u));
+    REQUIRE_FALSE(grid.contains(4u));
+    REQUIRE_THROWS_AS(grid.insert(3u, spatial_box{}), std::invalid_argument);
+    REQUIRE_THROWS_AS(grid.move(4u, spatial_box{}), std::out_of_range);
+    REQUIRE_THROWS_AS(grid.insert(9u, spatial_box{ 1.f, 0.f, 0.f, 0.f }), std::invalid_argument);
+
+    grid.move(3u, spatial_box::around(6.f, 5.f, 1.f, 1.f));
+    REQUIRE(grid.occupied_cells() == 2uz);
+    REQUIRE(grid.bounds(3u) == spatial_box::around(6.f, 5.f, 1.f, 1.f));
+
+    grid.move(3u, spatial_box::around(-24.f, 4.f));
+    REQUIRE(grid.occupied_cells() == 1uz);
+    REQUIRE(query(grid, spatial_box{ -30.f, 0.f, -20.f, 10.f }) == std::vector<uint32_t>{ 3u, 7u });
+
+    REQUIRE(grid.remove(7u));
+    REQUIRE_FALSE(grid.remove(7u));
+    REQUIRE(grid.size() == 1uz);
+    REQUIRE(query(grid, spatial_box{ -30.f, 0.f, -20.f, 10.f }) == std::vector<uint32_t>{ 3u });
+
+    // A full buffer still reports every match.
+    auto none = std::vector<uint32_t>{};
+    REQUIRE(grid.query(spatial_box{ -30.f, 0.f, -20.f, 10.f }, none) == 1uz);
+}
+
+TEST_CASE("spatial_grid queries match a brute force scan", "[spatial_grid]")
+{
+    const auto extent = 500.f;
+    auto boxes = random_boxes(5'000uz, extent, 20.f, 11u);
+    auto live = std::vector<bool>(boxes.size(), true);
+
+    auto grid = proto::spatial_grid{ 16.f };
+    auto ids = std::vector<uint32_t>(boxes.size());
+    for(auto i = 0uz; i < ids.size(); ++i) { ids[i] = static_cast<uint32_t>(i); }
+    grid.insert(ids, boxes);
+
+    // Move a third, remove a tenth.
+    auto engine = std::mt19937{ 12u };
+    auto moved = random_boxes(boxes.size() / 3uz, extent, 20.f, 13u);
+    auto movedIds = std::vector<uint32_t>{};
+    for(auto i = 0uz; i < moved.size(); ++i)
+    {
+        movedIds.push_back(static_cast<uint32_t>(i * 3uz));
+        boxes[i * 3uz] = moved[i];
+    }
+    grid.move(movedIds, moved);
+
+    auto removed = std::vector<uint32_t>{};
+    for(auto i = 1uz; i < boxes.size(); i += 10uz)
+    {
+        removed.push_back(static_cast<uint32_t>(i));
+        live[i] = false;
+    }
+    REQUIRE(grid.remove(removed) == removed.size());
+    REQUIRE(grid.size() == boxes.size() - removed.size());
+
+    auto pos = std::uniform_real_distribution<float>{ -extent * 1.2f, extent * 1.2f };
+    auto out = std::vector<uint32_t>(boxes.size());
+
+    for(auto q = 0; q < 200; ++q)
+    {
+        const auto x = pos(engine), y = pos(engine);
+        const auto size = q < 190 ? 30.f : 2'000.f; // The last few cover everything, and take the scan path.
+        const auto area = spatial_box{ x, y, x + size, y + (size * 0.5f) };
+
+        REQUIRE(query(grid, area) == brute_force(boxes, live, [&](const spatial_box& box) { return box.overlaps(area); }));
+
+        const auto radius = size * 0.5f;
+        out.resize(grid.query(x, y, radius, std::span<uint32_t>{ out.data(), boxes.size() }));
+        REQUIRE(sorted(out) == brute_force(boxes, live, [&](const spatial_box& box) {
+            const auto dx = x - std::clamp(x, box.min_x, box.max_x), dy = y - std::clamp(y, box.min_y, box.max_y);
+            return (dx * dx) + (dy * dy) <= radius * radius;
+        }));
+        out.resize(boxes.size());
+    }
+}
+
+TEST_CASE("spatial_grid rays return the nearest hits first", "[spatial_grid]")
+{
+    const auto extent = 400.f;
+    auto boxes = random_boxes(3'000uz, extent, 6.f, 21u);
+    auto live = std::vector<bool>(boxes.size(), true);
+
+    auto grid = proto::spatial_grid{ 8.f };
+    for(auto i = 0uz; i < boxes.size(); ++i) { grid.insert(static_cast<uint32_t>(i), boxes[i]); }
+
+    auto engine = std::mt19937{ 22u };
+    auto pos = std::uniform_real_distribution<float>{ -extent, extent };
+    auto angle = std::uniform_real_distribution<float>{ 0.f, 6.2831853f };
+
+    auto hits = std::vector<proto::ray_hit>(boxes.size());
+
+    for(auto q = 0; q < 300; ++q)
+    {
+        const auto x = pos(engine), y = pos(engine), a = angle(engine);
+        const auto dx = q % 50 == 0 ? 0.f : std::cos(a), dy = std::sin(a); // Some rays run straight along an axis.
+        const auto length = q < 280 ? 150.f : 5'000.f;
+
+        const auto found = grid.query_ray(x, y, dx, dy, length, hits);
+        REQUIRE(found <= hits.size());
+
+        auto ids = std::vector<uint32_t>{};
+        for(auto i = 0uz; i < found; ++i)
+        {
+            ids.push_back(hits[i].id);
+            if(i > 0uz) { REQUIRE(hits[i - 1uz].t <= hits[i].t); }
+        }
+
+        // Every box the ray reaches, from a slab test over all of them.
+        const auto expected = brute_force(boxes, live, [&](const spatial_box& box) {
+            auto near = 0.f, far = length;
+            for(const auto [origin, dir, lo, hi] : { std::array{ x, dx, box.min_x, box.max_x }, std::array{ y, dy, box.min_y, box.max_y } })
+            {
+                if(dir == 0.f)
+                {
+                    if(origin < lo || origin > hi) { return false; }
+                    continue;
+                }
+
+                const auto t0 = (lo - origin) / dir, t1 = (hi - origin) / dir;
+                near = std::max(near, std::min(t0, t1));
+                far = std::min(far, std::max(t0, t1));
+            }
+            return near <= far;
+        });
+
+        REQUIRE(sorted(ids) == expected);
+
+        // A short buffer keeps the nearest ones.
+        auto nearest = std::vector<proto::ray_hit>(3uz);
+        REQUIRE(grid.query_ray(x, y, dx, dy, length, nearest) == found);
+        for(auto i = 0uz; i < std::min(found, nearest.size()); ++i) { REQUIRE(nearest[i].t == hits[i].t); }
+    }
+}
+
+TEST_CASE("spatial_grid against a linear scan with 1M objects", "[spatial_grid], [!benchmark]")
+{
+    const auto extent = 50'000.f;
+    const auto boxes = random_boxes(1'000'000uz, extent, 24.f, 31u);
+
+    auto ids = std::vector<uint32_t>(boxes.size());
+    for(auto i = 0uz; i < ids.size(); ++i) { ids[i] = static_cast<uint32_t>(i); }
+
+    auto grid = proto::spatial_grid{ 64.f };
+    grid.insert(ids, boxes);
+
+    auto moved = boxes;
+    for(auto& box : moved)
+    {
+        box.min_x += 3.f;
+        box.max_x += 3.f;
+    }
+
+    const auto viewport = spatial_box{ -960.f, -540.f, 960.f, 540.f };
+    auto out = std::vector<uint32_t>(boxes.size());
+    auto hits = std::vector<proto::ray_hit>(16uz);
+
+    BENCHMARK("insert 1M")
+    {
+        auto fresh = proto::spatial_grid{ 64.f };
+        fresh.insert(ids, boxes);
+        return fresh.size();
+    };
+
+    BENCHMARK("move 1M")
+    {
+        grid.move(ids, moved);
+        grid.move(ids, boxes);
+        return grid.size();
+    };
+
+    BENCHMARK("viewport: linear scan")
+    {
+        auto found = 0uz;
+        for(auto i = 0uz; i < boxes.size(); ++i)
+        {
+            if(boxes[i].overlaps(viewport)) { out[found++] = ids[i]; }
+        }
+        return found;
+    };
+
+    BENCHMARK("viewport: grid")
+    {
+        return grid.query(viewport, out);
+    };
+
+    BENCHMARK("pick radius 8: grid")
+    {
+        return grid.query(1'000.f, 2'000.f, 8.f, out);
+    };
+
+    BENCHMARK("ray 4000: grid")
+    {
+        return grid.query_ray(0.f, 0.f, 0.6f, 0.8f, 4'000.f, hits);
+    };
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
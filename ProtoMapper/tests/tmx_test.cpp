@@ -0,0 +1,397 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <Components.hpp>
+#include <Tmx.hpp>
+#include <base64.hpp>
+#include <zlib.h>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+
+namespace
+{
+    using proto::TileId;
+    using proto::TileLayer;
+    using proto::TileMap;
+
+    std::filesystem::path temp_file(std::string_view name)
+    {
+        return std::filesystem::temp_directory_path() / name;
+    }
+
+    std::string read_file(const std::filesystem::path& file)
+    {
+        auto in = std::ifstream{ file, std::ios::binary };
+        auto text = std::stringstream{};
+        text << in.rdbuf();
+        return text.str();
+    }
+
+    void write_file(const std::filesystem::path& file, std::string_view text)
+    {
+        auto out = std::ofstream{ file, std::ios::binary };
+        out.write(text.data(), static_cast<std::streamsize>(text.size()));
+    }
+
+    // Where the text of the first <data> element starts and ends.
+    std::pair<size_t, size_t> first_data(const std::string& document)
+    {
+        const auto start = document.find('>', document.find("<data")) + 1uz;
+        return { start, document.find("</data>", start) };
+    }
+
+    // The base64 decoded contents of every <data> element, in layer order.
+    std::vector<std::vector<uint8_t>> layer_data(const std::string& document)
+    {
+        auto layers = std::vector<std::vector<uint8_t>>{};
+
+        for(auto pos = document.find("<data"); pos != std::string::npos; pos = document.find("<data", pos))
+        {
+            const auto start = document.find('>', pos) + 1uz;
+            const auto end = document.find("</data>", start);
+            const auto text = std::string_view{ document }.substr(start, end - start);
+
+            auto bytes = std::vector<uint8_t>(proto::base64_decoded_size(text.size()));
+            const auto size = proto::base64_decode(text, bytes);
+
+            REQUIRE(size.has_value());
+            bytes.resize(*size);
+            layers.push_back(std::move(bytes));
+            pos = end;
+        }
+
+        return layers;
+    }
+
+    // Tiles as they are stored in the file, little endian GIDs in row order.
+    std::vector<uint8_t> raw_tiles(const TileLayer& layer)
+    {
+        auto row = std::vector<TileId>(layer.Width());
+        auto raw = std::vector<uint8_t>{};
+        raw.reserve(size_t{layer.Width()} * layer.Height() * sizeof(TileId));
+
+        for(auto y = 0u; y < layer.Height(); ++y)
+        {
+            layer.ReadRow(y, row);
+            for(const auto tile : row)
+            {
+                for(auto shift = 0u; shift < 32u; shift += 8u) { raw.push_back(static_cast<uint8_t>(tile >> shift)); }
+            }
+        }
+
+        return raw;
+    }
+
+    // Inflates a whole zlib stream, Z_STREAM_END is only returned once the adler32 trailer matched.
+    int inflate_all(std::vector<uint8_t>& compressed, std::vector<uint8_t>& out)
+    {
+        auto stream = z_stream{};
+        REQUIRE(inflateInit(&stream) == Z_OK);
+
+        stream.next_in = compressed.data();
+        stream.avail_in = static_cast<uInt>(compressed.size());
+        stream.next_out = out.data();
+        stream.avail_out = static_cast<uInt>(out.size());
+
+        const auto result = inflate(&stream, Z_FINISH);
+        out.resize(stream.total_out);
+        inflateEnd(&stream);
+
+        return result;
+    }
+
+    // Several bands of chunk rows, with a band that has no chunks at all between filled ones.
+    TileMap banded_map(uint32_t width, uint32_t height)
+    {
+        auto map = TileMap{ width, height, 16u, 16u };
+        auto& tileset = map.Tilesets().emplace_back();
+        tileset.firstGid = 1u;
+        tileset.source = "terrain.tsx";
+
+        auto engine = std::mt19937{ 11u };
+        auto next = [&engine](uint32_t bound) { return static_cast<uint32_t>(engine() % bound); };
+
+        auto& ground = map.AddLayer("ground");
+        for(auto y = 0u; y < height; ++y)
+        {
+            if(y / TileLayer::ChunkSize == 1u) { continue; }
+            for(auto x = 0u; x < width; ++x) { ground.Set(x, y, 1u + next(40u)); }
+        }
+
+        auto& props = map.AddLayer("props");
+        for(auto i = 0u; i < 200u; ++i) { props.Set(next(width), next(height), 0x80000000u | (1u + next(8u))); }
+
+        map.AddLayer("empty");
+        return map;
+    }
+
+    void require_same_tiles(const TileMap& lhs, const TileMap& rhs)
+    {
+        REQUIRE(lhs.Width() == rhs.Width());
+        REQUIRE(lhs.Height() == rhs.Height());
+        REQUIRE(lhs.TileWidth() == rhs.TileWidth());
+        REQUIRE(lhs.TileHeight() == rhs.TileHeight());
+        REQUIRE(lhs.Layers().size() == rhs.Layers().size());
+
+        auto lhsRow = std::vector<TileId>(lhs.Width()), rhsRow = std::vector<TileId>(rhs.Width());
+
+        for(auto i = 0uz; i < lhs.Layers().size(); ++i)
+        {
+            const auto& a = lhs.Layers()[i];
+            const auto& b = rhs.Layers()[i];
+
+            REQUIRE(a.Name() == b.Name());
+            REQUIRE(a.visible == b.visible);
+            REQUIRE(a.opacity == b.opacity);
+            REQUIRE(a.AllocatedChunks() == b.AllocatedChunks());
+
+            for(auto y = 0u; y < a.Height(); ++y)
+            {
+                a.ReadRow(y, lhsRow);
+                b.ReadRow(y, rhsRow);
+                REQUIRE(lhsRow == rhsRow);
+            }
+        }
+    }
+
+    // Imports a broken copy of a good export and checks it is refused without touching what was loaded before.
+    void require_rejected(const std::string& document, std::string_view name)
+    {
+        const auto file = temp_file(name);
+        write_file(file, document);
+
+        auto map = banded_map(40u, 40u);
+        auto registry = proto::Registry{};
+        const auto marker = registry.Create();
+        registry.Emplace<proto::Marker>(marker, proto::Marker{ "kept" });
+
+        REQUIRE_FALSE(proto::ImportTmx(file, map, registry).has_value());
+        require_same_tiles(map, banded_map(40u, 40u));
+        REQUIRE(registry.Valid(marker));
+        REQUIRE(registry.Get<proto::Marker>(marker).label == "kept");
+
+        std::filesystem::remove(file);
+    }
+
+    std::string exported_document(std::string_view name)
+    {
+        const auto map = banded_map(100u, 3u * TileLayer::ChunkSize);
+        const auto file = temp_file(name);
+        auto registry = proto::Registry{};
+
+        REQUIRE(proto::ExportTmx(map, registry, file));
+        auto document = read_file(file);
+        std::filesystem::remove(file);
+
+        return document;
+    }
+}
+
+TEST_CASE("tmx export writes every band into one zlib stream per layer", "[tmx]")
+{
+    const auto map = banded_map(150u, 5u * TileLayer::ChunkSize - 17u);
+    const auto file = temp_file("proto_tmx_test_bands.tmx");
+    auto registry = proto::Registry{};
+
+    REQUIRE(proto::ExportTmx(map, registry, file));
+    REQUIRE_FALSE(std::filesystem::exists(std::filesystem::path{ file } += ".tmp"));
+
+    auto layers = layer_data(read_file(file));
+    REQUIRE(layers.size() == map.Layers().size());
+
+    for(auto i = 0uz; i < layers.size(); ++i)
+    {
+        auto& compressed = layers[i];
+        const auto expected = raw_tiles(map.Layers()[i]);
+
+        REQUIRE(compressed.size() > 6uz);
+        REQUIRE(compressed[0] == 0x78u);
+        REQUIRE((compressed[0] * 256u + compressed[1]) % 31u == 0u);
+
+        // The trailer is the adler32 of all the tiles, put together from each band's with adler32_combine.
+        const auto adler = adler32(adler32(0u, nullptr, 0u), expected.data(), static_cast<uInt>(expected.size()));
+        const auto* trailer = compressed.data() + compressed.size() - 4uz;
+        REQUIRE(((uLong{trailer[0]} << 24u) | (uLong{trailer[1]} << 16u) | (uLong{trailer[2]} << 8u) | uLong{trailer[3]}) == adler);
+
+        auto tiles = std::vector<uint8_t>(expected.size() + 1uz);
+        REQUIRE(inflate_all(compressed, tiles) == Z_STREAM_END);
+        REQUIRE(tiles == expected);
+    }
+
+    std::filesystem::remove(file);
+}
+
+TEST_CASE("tmx export trailer is checked when the stream is inflated", "[tmx]")
+{
+    const auto map = banded_map(70u, 3u * TileLayer::ChunkSize);
+    const auto file = temp_file("proto_tmx_test_trailer.tmx");
+    auto registry = proto::Registry{};
+
+    REQUIRE(proto::ExportTmx(map, registry, file));
+
+    auto layers = layer_data(read_file(file));
+    REQUIRE_FALSE(layers.empty());
+
+    auto& compressed = layers.front();
+    compressed.back() ^= 0x01u;
+
+    auto tiles = std::vector<uint8_t>(size_t{map.Width()} * map.Height() * sizeof(TileId) + 1uz);
+    REQUIRE(inflate_all(compressed, tiles) == Z_DATA_ERROR);
+
+    std::filesystem::remove(file);
+}
+
+TEST_CASE("tmx export fails cleanly when the file cannot be written", "[tmx]")
+{
+    const auto map = banded_map(16u, 16u);
+    auto registry = proto::Registry{};
+
+    REQUIRE_FALSE(proto::ExportTmx(map, registry, temp_file("proto_tmx_test_missing") / "map.tmx"));
+}
+
+TEST_CASE("tmx import reads back what was exported", "[tmx]")
+{
+    auto map = banded_map(150u, 5u * TileLayer::ChunkSize - 17u);
+    map.Layers()[1].visible = false;
+    map.Layers()[1].opacity = 0.5f;
+
+    auto registry = proto::Registry{};
+    const auto marker = registry.Create();
+    registry.Emplace<proto::Transform>(marker, proto::Transform{ { 10.f, 20.f } });
+    registry.Emplace<proto::Marker>(marker, proto::Marker{ "well & <gate>" });
+    const auto trigger = registry.Create();
+    registry.Emplace<proto::Transform>(trigger, proto::Transform{ { 48.f, 64.f } });
+    registry.Emplace<proto::Trigger>(trigger, proto::Trigger{ { 8.f, 4.f }, 7u });
+    const auto spawn = registry.Create();
+    registry.Emplace<proto::Transform>(spawn, proto::Transform{ { 1.f, 2.f } });
+    registry.Emplace<proto::SpawnPoint>(spawn, proto::SpawnPoint{ 3u, 9u });
+
+    const auto file = temp_file("proto_tmx_test_round_trip.tmx");
+    REQUIRE(proto::ExportTmx(map, registry, file));
+
+    auto loaded = TileMap{};
+    auto objects = proto::Registry{};
+    REQUIRE(proto::ImportTmx(file, loaded, objects).has_value());
+
+    require_same_tiles(map, loaded);
+    REQUIRE(loaded.Tilesets().size() == 1uz);
+    REQUIRE(loaded.Tilesets().front().firstGid == 1u);
+    REQUIRE(loaded.Tilesets().front().source.filename() == "terrain.tsx");
+
+    auto markers = 0uz, triggers = 0uz, spawns = 0uz;
+    objects.ViewOf<proto::Marker, proto::Transform>().Each([&markers](proto::Entity, const proto::Marker& m, const proto::Transform& t) {
+        REQUIRE(m.label == "well & <gate>");
+        REQUIRE(t.pos == glm::vec2{ 10.f, 20.f });
+        ++markers;
+    });
+    objects.ViewOf<proto::Trigger, proto::Transform>().Each([&triggers](proto::Entity, const proto::Trigger& tr, const proto::Transform& t) {
+        REQUIRE(tr.halfExtent == glm::vec2{ 8.f, 4.f });
+        REQUIRE(tr.id == 7u);
+        REQUIRE(t.pos == glm::vec2{ 48.f, 64.f });
+        ++triggers;
+    });
+    objects.ViewOf<proto::SpawnPoint>().Each([&spawns](proto::Entity, const proto::SpawnPoint& sp) {
+        REQUIRE(sp == proto::SpawnPoint{ 3u, 9u });
+        ++spawns;
+    });
+
+    REQUIRE(markers == 1uz);
+    REQUIRE(triggers == 1uz);
+    REQUIRE(spawns == 1uz);
+
+    // Exporting the import again gives the same file.
+    const auto again = temp_file("proto_tmx_test_round_trip_again.tmx");
+    REQUIRE(proto::ExportTmx(loaded, objects, again));
+    REQUIRE(layer_data(read_file(again)) == layer_data(read_file(file)));
+
+    std::filesystem::remove(file);
+    std::filesystem::remove(again);
+}
+
+TEST_CASE("tmx import rejects layer data of the wrong base64 length", "[tmx]")
+{
+    auto document = exported_document("proto_tmx_test_length.tmx");
+    const auto [start, end] = first_data(document);
+
+    // One character short of a whole base64 quantum.
+    document.erase(document.find_last_not_of(" \t\r\n", end - 1uz), 1uz);
+    require_rejected(document, "proto_tmx_test_length_bad.tmx");
+}
+
+TEST_CASE("tmx import rejects a zlib stream with a bad adler32 trailer", "[tmx]")
+{
+    auto document = exported_document("proto_tmx_test_adler.tmx");
+    const auto [start, end] = first_data(document);
+
+    auto layers = layer_data(document);
+    layers.front().back() ^= 0x01u;
+
+    document.replace(start, end - start, proto::base64_encode(layers.front()));
+    require_rejected(document, "proto_tmx_test_adler_bad.tmx");
+}
+
+TEST_CASE("tmx import rejects sizes past MaxExtent", "[tmx]")
+{
+    const auto document = exported_document("proto_tmx_test_extent.tmx");
+    const auto huge = std::to_string(TileMap::MaxExtent + 1u);
+
+    // The map and every layer claim the same too large width.
+    auto wide = document;
+    for(auto pos = wide.find(" width=\"100\""); pos != std::string::npos; pos = wide.find(" width=\"100\"", pos))
+    {
+        wide.replace(pos, 12uz, " width=\"" + huge + "\"");
+    }
+
+    require_rejected(wide, "proto_tmx_test_extent_bad.tmx");
+
+    // A layer larger than its map.
+    auto layer = document;
+    const auto pos = layer.find(" width=\"100\"", layer.find("<layer"));
+    layer.replace(pos, 12uz, " width=\"" + huge + "\"");
+
+    require_rejected(layer, "proto_tmx_test_layer_bad.tmx");
+}
+
+TEST_CASE("tmx throughput", "[tmx], [!benchmark]")
+{
+    const auto map = banded_map(1024u, 1024u);
+    const auto file = temp_file("proto_tmx_test_bench.tmx");
+    auto registry = proto::Registry{};
+
+    BENCHMARK("export 1024 x 1024, 3 layers")
+    {
+        return proto::ExportTmx(map, registry, file);
+    };
+
+    auto loaded = TileMap{};
+    BENCHMARK("import 1024 x 1024, 3 layers")
+    {
+        return proto::ImportTmx(file, loaded, registry).has_value();
+    };
+
+    std::filesystem::remove(file);
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
@@ -0,0 +1,218 @@
+/*
+	ProtoMapper - Map creation and pathfinding software for game development.
+	Copyright (C) 2023  Samuel Bridgham - moosethree473@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <wfc.hpp>
+#include <random>
+#include <vector>
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+
+namespace
+{
+    // Every pair of neighbours in the solution is allowed by the rules.
+    bool follows_rules(const proto::wfc_solver& solver)
+    {
+        const auto& rules = solver.rules();
+
+        for(auto y = 0u; y < solver.height(); ++y)
+        {
+            for(auto x = 0u; x < solver.width(); ++x)
+            {
+                if(solver.possible(x, y) != 1u) { return false; }
+
+                const auto a = solver.tile_at(x, y);
+                if(x + 1u < solver.width() && !rules.allowed(a, proto::wfc_dir::east, solver.tile_at(x + 1u, y))) { return false; }
+                if(y + 1u < solver.height() && !rules.allowed(a, proto::wfc_dir::south, solver.tile_at(x, y + 1u))) { return false; }
+            }
+        }
+
+        return true;
+    }
+
+    // Height bands 0 to 'levels' - 1, where neighbours differ by at most one level.
+    std::vector<uint32_t> terraced_sample(uint32_t side, uint32_t levels)
+    {
+        auto sample = std::vector<uint32_t>(size_t{side} * side);
+
+        for(auto y = 0u; y < side; ++y)
+        {
+            for(auto x = 0u; x < side; ++x)
+            {
+                const auto distance = std::max(x > side / 2u ? x - (side / 2u) : (side / 2u) - x, y > side / 2u ? y - (side / 2u) : (side / 2u) - y);
+                sample[(size_t{y} * side) + x] = 10u + std::min(distance, levels - 1u);
+            }
+        }
+
+        return sample;
+    }
+}
+
+TEST_CASE("Masked words match a scalar and-not", "[wfc]")
+{
+    auto engine = std::mt19937_64{ 1u };
+
+    for(const auto words : { 1uz, 2uz, 3uz, 4uz, 5uz, 9uz })
+    {
+        auto a = std::vector<uint64_t>(words), b = std::vector<uint64_t>(words), out = std::vector<uint64_t>(words);
+        for(auto i = 0uz; i < words; ++i)
+        {
+            a[i] = engine();
+            b[i] = engine();
+        }
+
+        auto any = proto::detail::and_not_words(a.data(), b.data(), out.data(), words);
+        for(auto i = 0uz; i < words; ++i) { REQUIRE(out[i] == (a[i] & ~b[i])); }
+        REQUIRE(any);
+
+        any = proto::detail::and_not_words(a.data(), a.data(), out.data(), words);
+        REQUIRE_FALSE(any);
+    }
+}
+
+TEST_CASE("Rules are learned from a sample", "[wfc]")
+{
+    // 0 is a hole, 5 sits left of 7 and above 9.
+    const auto sample = std::vector<uint32_t>{ 5u, 7u, 0u,
+                                               9u, 0u, 7u };
+
+    const auto rules = proto::wfc_rules::learn(sample, 3u, 2u, 0u);
+
+    REQUIRE(rules.tiles() == 3u);
+    REQUIRE(rules.value(0u) == 5u);
+    REQUIRE(rules.value(1u) == 7u);
+    REQUIRE(rules.value(2u) == 9u);
+    REQUIRE(rules.weight(1u) == 2.0);
+
+    REQUIRE(rules.allowed(0u, proto::wfc_dir::east, 1u));
+    REQUIRE(rules.allowed(1u, proto::wfc_dir::west, 0u));
+    REQUIRE(rules.allowed(0u, proto::wfc_dir::south, 2u));
+    REQUIRE(rules.allowed(2u, proto::wfc_dir::north, 0u));
+    REQUIRE_FALSE(rules.allowed(0u, proto::wfc_dir::west, 1u));
+    REQUIRE_FALSE(rules.allowed(1u, proto::wfc_dir::south, 1u));
+}
+
+TEST_CASE("Solutions follow the rules", "[wfc]")
+{
+    const auto sample = terraced_sample(15u, 5u);
+    const auto rules = proto::wfc_rules::learn(sample, 15u, 15u, 0u);
+    REQUIRE(rules.tiles() == 5u);
+
+    auto solver = proto::wfc_solver{ rules, 40u, 30u };
+    solver.fix(0u, 0u, 4u);
+    solver.fix(39u, 29u, 0u);
+
+    for(const auto seed : { 1u, 2u, 3u })
+    {
+        REQUIRE(solver.run(seed) == proto::wfc_result::solved);
+        REQUIRE(follows_rules(solver));
+        REQUIRE(solver.tile_at(0u, 0u) == 4u);
+        REQUIRE(solver.value_at(39u, 29u) == 10u);
+    }
+
+    // The same seed gives the same map.
+    REQUIRE(solver.run(7u) == proto::wfc_result::solved);
+    auto first = std::vector<uint32_t>{};
+    for(auto y = 0u; y < 30u; ++y) { for(auto x = 0u; x < 40u; ++x) { first.push_back(solver.tile_at(x, y)); } }
+
+    REQUIRE(solver.run(7u) == proto::wfc_result::solved);
+    for(auto y = 0u; y < 30u; ++y) { for(auto x = 0u; x < 40u; ++x) { REQUIRE(solver.tile_at(x, y) == first[(y * 40u) + x]); } }
+}
+
+TEST_CASE("Contradictions backtrack or fail", "[wfc]")
+{
+    // Two tiles that must alternate, fixed next to each other the same: no solution.
+    auto checker = proto::wfc_rules{ 2u };
+    checker.allow(0u, proto::wfc_dir::east, 1u);
+    checker.allow(1u, proto::wfc_dir::east, 0u);
+    checker.allow(0u, proto::wfc_dir::south, 1u);
+    checker.allow(1u, proto::wfc_dir::south, 0u);
+
+    auto solver = proto::wfc_solver{ checker, 10u, 10u };
+    REQUIRE(solver.run(1u) == proto::wfc_result::solved);
+    REQUIRE(follows_rules(solver));
+
+    solver.fix(0u, 0u, 0u);
+    solver.fix(1u, 0u, 0u);
+    REQUIRE(solver.run(1u) == proto::wfc_result::contradiction);
+
+    // Random sparse rules paint themselves into corners often, every solution still has to hold.
+    auto engine = std::mt19937{ 4u };
+    auto backtracked = 0uz, solved = 0uz;
+
+    for(auto round = 0; round < 20; ++round)
+    {
+        auto rules = proto::wfc_rules{ 12u };
+        for(auto a = 0u; a < 12u; ++a)
+        {
+            for(auto b = 0u; b < 12u; ++b)
+            {
+                if(engine() % 3u == 0u) { rules.allow(a, proto::wfc_dir::east, b); }
+                if(engine() % 3u == 0u) { rules.allow(a, proto::wfc_dir::south, b); }
+            }
+        }
+
+        auto hard = proto::wfc_solver{ rules, 24u, 24u };
+        if(hard.run(static_cast<uint64_t>(round), 500u, 4u) == proto::wfc_result::solved)
+        {
+            ++solved;
+            REQUIRE(follows_rules(hard));
+        }
+
+        backtracked += hard.stats().backtracks != 0u ? 1uz : 0uz;
+    }
+
+    REQUIRE(solved > 10uz);
+    REQUIRE(backtracked > 0uz);
+
+    auto stop = std::atomic<bool>{ true };
+    auto stopped = proto::wfc_solver{ checker, 10u, 10u };
+    REQUIRE(stopped.run(1u, 10u, 1u, &stop) == proto::wfc_result::stopped);
+}
+
+TEST_CASE("Wfc benchmark", "[wfc], [!benchmark]")
+{
+    const auto sample = terraced_sample(31u, 8u);
+    const auto rules = proto::wfc_rules::learn(sample, 31u, 31u, 0u);
+
+    auto solver = proto::wfc_solver{ rules, 256u, 256u };
+
+    BENCHMARK("solve 256^2 terraces")
+    {
+        return solver.run(1u);
+    };
+
+    auto wide = proto::wfc_rules{ 100u };
+    for(auto a = 0u; a < 100u; ++a)
+    {
+        for(auto b = 0u; b < 100u; ++b)
+        {
+            if((a + b) % 7u < 3u) { wide.allow(a, proto::wfc_dir::east, b); }
+            if((a * b) % 5u < 2u) { wide.allow(a, proto::wfc_dir::south, b); }
+        }
+    }
+
+    auto wideSolver = proto::wfc_solver{ wide, 256u, 256u };
+
+    BENCHMARK("solve 256^2 with 100 tiles")
+    {
+        return wideSolver.run(1u);
+    };
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
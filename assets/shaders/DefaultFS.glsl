@@ -9,5 +9,6 @@ out vec4 final_color;
 
 void main()
 {
-	final_color = texture(textureData, textureUV) * out_color;
+	// Textures are premultiplied, the vertex colour is not.
+	final_color = texture(textureData, textureUV) * vec4(out_color.rgb * out_color.a, out_color.a);
 }
\ No newline at end of file
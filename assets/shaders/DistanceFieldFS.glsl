@@ -0,0 +1,20 @@
+#version 430 core
+
+in vec4 out_color;
+in vec2 textureUV;
+
+uniform sampler2D textureData;
+
+out vec4 final_color;
+
+// Glyphs are baked with the outline at 0.5. Font textures are swizzled so the distance reads from alpha.
+void main()
+{
+	float dist = texture(textureData, textureUV).a;
+	float edge = fwidth(dist);
+	float alpha = smoothstep(0.5 - edge, 0.5 + edge, dist);
+
+	// Premultiplied, like everything else that is blended.
+	alpha *= out_color.a;
+	final_color = vec4(out_color.rgb * alpha, alpha);
+}
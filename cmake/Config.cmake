@@ -1,3 +1,5 @@
+option(PROTO_ENABLE_AVX2 "Build the AVX2 code paths in the stl containers (requires an AVX2 capable CPU)." OFF)
+
 if(DEFINED CLANG_TIDY_EXE)
 	find_program(clang_tidy_FOUND ${CLANG_TIDY_EXE})
 else()
@@ -35,6 +35,16 @@ if(${CMAKE_CXX_COMPILIER_ID} MATCHES GNU)
     )
 endif()
 
+if(PROTO_ENABLE_AVX2)
+    list(
+        APPEND CompilerFlags
+
+        "-mavx2"
+        "-mbmi"
+        "-mpopcnt"
+    )
+endif()
+
 #Exclude unsupported flags on Windows
 if(NOT ${CMAKE_HOST_WIN32})
     list(
@@ -6,6 +6,13 @@ if(NOT ${CMAKE_BUILD_TYPE} MATCHES Debug)
     )
 endif()
 
+if(PROTO_ENABLE_AVX2)
+    list(
+        APPEND CompilerFlags
+        "/arch:AVX2"
+    )
+endif()
+
 # Enable compiler flags for all builds
 list(
 	APPEND CompilerFlags 